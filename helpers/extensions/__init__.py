@@ -32,12 +32,17 @@ header_deps = {
     'array': (),
     'constants': (),
     'extension': ('array',),
+    'fit_plan': ('model_extension', 'native_objective', 'stats'),
     'integration': (),
-    'model_extension': ('extension', 'integration'),
+    'model_extension': ('extension', 'integration', 'parallel', 'quadrature'),
     'models': ('constants', 'utils'),
-    'stat_extension': ('extension',),
-    'stats': ('utils',),
+    'native_objective': (),
+    'parallel': (),
+    'quadrature': (),
+    'stat_extension': ('extension', 'utils'),
+    'stats': ('parallel', 'utils', 'vecmath'),
     'utils': ('constants','extension'),
+    'vecmath': (),
     'astro/models': ('constants', 'utils'),
     'astro/utils': (),
     'astro/xspec_extension': ('extension',),
@@ -202,7 +207,12 @@ utils = Extension('sherpa.utils._utils',
 modelfcts = Extension('sherpa.models._modelfcts',
                       ['sherpa/models/src/_modelfcts.cc'],
                       sherpa_inc,
-                      depends=get_deps(['model_extension', 'models']))
+                      depends=get_deps(['fit_plan', 'models']))
+
+modelcache = Extension('sherpa.models._cache',
+                       ['sherpa/models/src/_cache.cc'],
+                       sherpa_inc,
+                       depends=get_deps(['extension']))
 
 saoopt = Extension('sherpa.optmethods._saoopt',
               ['sherpa/optmethods/src/_saoopt.cc',
@@ -212,8 +222,13 @@ saoopt = Extension('sherpa.optmethods._saoopt',
                        ['sherpa/include/sherpa/fcmp.hh',
                         'sherpa/include/sherpa/MersenneTwister.h',
                         'sherpa/include/sherpa/functor.hh',
+                        'sherpa/include/sherpa/native_objective.hh',
+                        'sherpa/include/sherpa/parallel.hh',
+                        'sherpa/optmethods/src/CMAES.hh',
                         'sherpa/optmethods/src/DifEvo.hh',
                         'sherpa/optmethods/src/DifEvo.cc',
+                        'sherpa/optmethods/src/LBFGSB.hh',
+                        'sherpa/optmethods/src/MultiStart.hh',
                         'sherpa/optmethods/src/NelderMead.hh',
                         'sherpa/optmethods/src/NelderMead.cc',
                         'sherpa/optmethods/src/Opt.hh',
@@ -232,10 +247,15 @@ tstoptfct = Extension('sherpa.optmethods._tstoptfct',
                        ['sherpa/include/sherpa/fcmp.hh',
                         'sherpa/include/sherpa/MersenneTwister.h',
                         'sherpa/include/sherpa/functor.hh',
+                        'sherpa/include/sherpa/native_objective.hh',
+                        'sherpa/include/sherpa/parallel.hh',
                         'sherpa/optmethods/tests/tstopt.hh',
                         'sherpa/optmethods/tests/tstoptfct.hh',
+                        'sherpa/optmethods/src/CMAES.hh',
                         'sherpa/optmethods/src/DifEvo.hh',
                         'sherpa/optmethods/src/DifEvo.cc',
+                        'sherpa/optmethods/src/LBFGSB.hh',
+                        'sherpa/optmethods/src/MultiStart.hh',
                         'sherpa/optmethods/src/NelderMead.hh',
                         'sherpa/optmethods/src/NelderMead.cc',
                         'sherpa/optmethods/src/Opt.hh',
@@ -295,6 +315,7 @@ static_ext_modules = [
                    estmethods,
                    utils,
                    modelfcts,
+                   modelcache,
                    saoopt,
                    tstoptfct,
                    statfcts,
@@ -3950,6 +3950,13 @@ It is an integer or string.
         model = super().eval_model_to_fit(modelfunc)
         return self.apply_filter(model)
 
+    def eval_deriv_to_fit(self, modelfunc, pars):
+        deriv = super().eval_deriv_to_fit(modelfunc, pars)
+        if deriv is None:
+            return None
+
+        return np.asarray([self.apply_filter(row) for row in deriv])
+
     def sum_background_data(self,
                             get_bdata_func=(lambda key, bkg: bkg.counts)):
         """Sum up data, applying the background correction value.
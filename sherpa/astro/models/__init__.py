@@ -21,9 +21,10 @@
 
 import numpy
 
-from sherpa.models.basic import clean_kwargs1d, clean_kwargs2d
+from sherpa.models.basic import clean_kwargs1d, clean_kwargs2d, kernel_leaf
 from sherpa.models.parameter import Parameter, tinyval
-from sherpa.models.model import ArithmeticModel, RegriddableModel2D, RegriddableModel1D, modelCacher1d
+from sherpa.models.model import ArithmeticModel, RegriddableModel2D, RegriddableModel1D, modelCacher1d, \
+    modelCacher2d
 from sherpa.astro.utils import apply_pileup
 from sherpa.utils import bool_cast, lgam
 from sherpa.utils.err import ModelErr
@@ -181,6 +182,9 @@ class BBody(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.bbody(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "bbody", self, p, args, kwargs)
+
 
 class BBodyFreq(RegriddableModel1D):
     """A one-dimensional Blackbody model (frequency).
@@ -238,6 +242,9 @@ class BBodyFreq(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.bbodyfreq(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "bbodyfreq", self, p, args, kwargs)
+
 
 class Beta1D(RegriddableModel1D):
     """One-dimensional beta model function.
@@ -308,6 +315,9 @@ class Beta1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.beta1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "beta1d", self, p, args, kwargs)
+
 
 class BPL1D(RegriddableModel1D):
     """One-dimensional broken power-law function.
@@ -368,6 +378,13 @@ class BPL1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.bpl1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "bpl1d", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        return _modelfcts.bpl1d_deriv(p, *args, **kwargs)
+
 
 # TODO: what are the units of the independent axis: Angstrom?
 
@@ -433,6 +450,9 @@ class Dered(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.dered(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "dered", self, p, args, kwargs)
+
 
 class Edge(RegriddableModel1D):
     """Photoabsorption edge model.
@@ -484,6 +504,9 @@ class Edge(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.edge(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "edge", self, p, args, kwargs)
+
 
 # DOC-NOTE:
 #    The equation is different to the ahelp file, but matches the code
@@ -549,6 +572,9 @@ class LineBroad(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.linebroad(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "linebroad", self, p, args, kwargs)
+
 
 # DOC-NOTE: for some reason the division in the equation in the notes
 #           section confuses sphinx (it thinks it is a section title).
@@ -617,6 +643,13 @@ class Lorentz1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.lorentz1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "lorentz1d", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        return _modelfcts.lorentz1d_deriv(p, *args, **kwargs)
+
 
 class Voigt1D(RegriddableModel1D):
     """One dimensional Voigt profile.
@@ -733,6 +766,9 @@ class Voigt1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.wofz(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "wofz", self, p, args, kwargs)
+
 
 class PseudoVoigt1D(RegriddableModel1D):
     """A weighted sum of a Gaussian and Lorentzian distribution.
@@ -896,6 +932,9 @@ class NormBeta1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.nbeta1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "nbeta1d", self, p, args, kwargs)
+
 
 class Schechter(RegriddableModel1D):
     """One-dimensional Schechter model function.
@@ -1013,7 +1052,6 @@ class Beta2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.r0, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl, self.alpha))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1031,10 +1069,15 @@ class Beta2D(RegriddableModel2D):
         param_apply_limits(norm, self.ampl, **kwargs)
         param_apply_limits(rad, self.r0, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.beta2d(p, *args, **kwargs)
 
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs2d(self, kwargs)
+        return _modelfcts.beta2d_deriv(p, *args, **kwargs)
+
 
 class DeVaucouleurs2D(RegriddableModel2D):
     """Two-dimensional de Vaucouleurs model.
@@ -1095,7 +1138,6 @@ class DeVaucouleurs2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.r0, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1113,6 +1155,7 @@ class DeVaucouleurs2D(RegriddableModel2D):
         param_apply_limits(norm, self.ampl, **kwargs)
         param_apply_limits(rad, self.r0, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.devau(p, *args, **kwargs)
@@ -1181,7 +1224,6 @@ class HubbleReynolds(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.r0, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1199,6 +1241,7 @@ class HubbleReynolds(RegriddableModel2D):
         param_apply_limits(norm, self.ampl, **kwargs)
         param_apply_limits(rad, self.r0, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.hr(p, *args, **kwargs)
@@ -1257,7 +1300,6 @@ class Lorentz2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.fwhm, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1273,6 +1315,7 @@ class Lorentz2D(RegriddableModel2D):
         param_apply_limits(ypos, self.ypos, **kwargs)
         param_apply_limits(norm, self.ampl, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.lorentz2d(p, *args, **kwargs)
@@ -1472,7 +1515,6 @@ class Sersic2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.r0, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl, self.n))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1490,6 +1532,7 @@ class Sersic2D(RegriddableModel2D):
         param_apply_limits(norm, self.ampl, **kwargs)
         param_apply_limits(rad, self.r0, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.sersic(p, *args, **kwargs)
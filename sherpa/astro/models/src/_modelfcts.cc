@@ -20,6 +20,8 @@
 // QUESTIONL is this used anywhere?
 #define _MODELFCTPTR(name) \
   sherpa::astro::models::name< SherpaFloat, SherpaFloatArray >
+#define _MODELFCTPTR_SINGLE(name) \
+  sherpa::astro::models::name< SherpaSingle, SherpaSingleArray >
 
 #include "sherpa/model_extension.hh"
 #include "sherpa/astro/models.hh"
@@ -29,6 +31,25 @@ extern "C" {
 }
 
 
+static const sherpa::models::Kernel1D Kernels1D[] = {
+
+  KERNEL1D_NOINT( atten, 3 ),
+  KERNEL1D_NOINT( bbody, 3 ),
+  KERNEL1D_NOINT( bbodyfreq, 2 ),
+  KERNEL1D_NOINT( beta1d, 4 ),
+  KERNEL1D( bpl1d, 5 ),
+  KERNEL1D_NOINT( dered, 2 ),
+  KERNEL1D_NOINT( edge, 3 ),
+  KERNEL1D( linebroad, 3 ),
+  KERNEL1D( lorentz1d, 3 ),
+  KERNEL1D_NOINT( wofz, 4 ),
+  KERNEL1D_NOINT( nbeta1d, 4 ),
+  KERNEL1D( schechter, 3 ),
+
+  KERNEL1D_END
+
+};
+
 static PyMethodDef ModelFcts[] = {
 
   MODELFCT1D_NOINT( atten, 3 ),
@@ -50,6 +71,12 @@ static PyMethodDef ModelFcts[] = {
   MODELFCT2D_NOINT( hr, 6 ),
   MODELFCT2D_NOINT( lorentz2d, 6 ),
 
+  MODELDERIV1D( bpl1d, 5 ),
+  MODELDERIV1D( lorentz1d, 3 ),
+  MODELDERIV2D_NOINT( beta2d, 7 ),
+
+  MODELKERNELS1D( Kernels1D ),
+
   { NULL, NULL, 0, NULL }
 
 };
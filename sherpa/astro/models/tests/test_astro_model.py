@@ -182,3 +182,157 @@ def test_set_center(cls):
     model = cls()
     model.set_center(12.1)
     assert model.pos.val == 12.1
+
+
+@pytest.mark.parametrize("cls",
+                         [models.Atten, models.BBody, models.BBodyFreq,
+                          models.Beta1D, models.Dered, models.Edge,
+                          models.NormBeta1D])
+def test_intorder_matches_adaptive(cls):
+    """The Gauss-Legendre engine agrees with the adaptive integrator."""
+
+    mdl = cls()
+    mdl._use_caching = False
+    if cls == models.Edge:
+        mdl.thresh = 5
+        mdl.abs = 3
+
+    egrid = np.linspace(0.1, 11, 1101)
+    xlo, xhi = egrid[:-1], egrid[1:]
+
+    mdl.intorder = 0
+    expected = mdl(xlo, xhi)
+
+    mdl.intorder = 8
+    got = mdl(xlo, xhi)
+
+    mdl.intorder = 3
+    got3 = mdl(xlo, xhi)
+
+    if cls == models.Edge:
+        # The bin containing the edge falls back to the trapezoid
+        # rule in the adaptive integrator, which is not accurate.
+        idx = np.where((xlo < 5) & (xhi > 5))[0]
+        assert len(idx) == 1
+        expected = np.delete(expected, idx)
+        got = np.delete(got, idx)
+        got3 = np.delete(got3, idx)
+
+    assert got == pytest.approx(expected, rel=1e-7)
+    assert got3 == pytest.approx(expected, rel=1e-6)
+
+
+def test_intorder_default_is_adaptive():
+    """The Gauss-Legendre rule has to be selected.
+
+    It does not detect the edge in this bin, since the model varies
+    by less than 25% across it.
+    """
+
+    mdl = models.Edge()
+    mdl._use_caching = False
+    mdl.thresh = 2.03
+    mdl.abs = 0.2
+    xlo, xhi = np.asarray([1.9]), np.asarray([2.1])
+
+    mdl.intorder = 0
+    expected = mdl(xlo, xhi)
+
+    mdl.intorder = None
+    np.testing.assert_array_equal(mdl(xlo, xhi), expected)
+
+    mdl.intorder = 8
+    assert mdl(xlo, xhi) != pytest.approx(expected, rel=0.01)
+
+
+@pytest.mark.parametrize("cls,pars",
+                         [(models.BPL1D, [1.2, 2.3, 4.5, 1, 3]),
+                          (models.Lorentz1D, [2.1, 5.2, 7])])
+@pytest.mark.parametrize("integrate", [False, True])
+def test_calc_deriv_1d(cls, pars, integrate):
+    """The analytic derivatives match central differences."""
+
+    mdl = cls()
+    mdl.integrate = integrate
+    for par, val in zip(mdl.pars, pars):
+        par.val = val
+
+    # Avoid evaluating the broken power law exactly at the break.
+    egrid = np.linspace(0.5, 10, 38)
+    args = (egrid[:-1], egrid[1:]) if integrate else (egrid, )
+
+    pvals = np.asarray(pars, dtype=SherpaFloat)
+    expected = []
+    for idx, val in enumerate(pvals):
+        delta = 1e-6 * max(abs(val), 1)
+        hi = pvals.copy()
+        lo = pvals.copy()
+        hi[idx] += delta
+        lo[idx] -= delta
+        expected.append((mdl.calc(hi, *args) - mdl.calc(lo, *args)) / (2 * delta))
+
+    got = mdl.calc_deriv(pvals, *args)
+    assert got.shape == (len(pars), args[0].size)
+    assert got == pytest.approx(np.asarray(expected), rel=1e-5, abs=1e-8)
+
+
+def test_calc_deriv_beta2d():
+
+    mdl = models.Beta2D()
+    pvals = np.asarray([2.1, 5.2, 4.3, 0.2, 0.7, 12, 1.4])
+
+    x0, x1 = np.meshgrid(np.arange(0, 10), np.arange(1, 12))
+    x0 = x0.flatten().astype(SherpaFloat)
+    x1 = x1.flatten().astype(SherpaFloat)
+
+    expected = []
+    for idx, val in enumerate(pvals):
+        delta = 1e-6 * max(abs(val), 1)
+        hi = pvals.copy()
+        lo = pvals.copy()
+        hi[idx] += delta
+        lo[idx] -= delta
+        expected.append((mdl.calc(hi, x0, x1) - mdl.calc(lo, x0, x1)) / (2 * delta))
+
+    got = mdl.calc_deriv(pvals, x0, x1)
+    assert got.shape == (7, x0.size)
+    assert got == pytest.approx(np.asarray(expected), rel=1e-5, abs=1e-8)
+
+
+@pytest.mark.parametrize("cls",
+                         [models.Beta2D, models.DeVaucouleurs2D,
+                          models.Lorentz2D, models.Sersic2D])
+def test_integrated_2d_cubature(cls):
+    """The numerically-integrated 2D models match a fine point grid.
+
+    The pixels are integrated in blocks, so also check the result
+    does not depend on how the image is split across threads.
+    """
+
+    mdl = cls()
+    mdl._use_caching = False
+    mdl.xpos = 4.3
+    mdl.ypos = 3.6
+    mdl.ellip = 0.3
+    mdl.theta = 0.5
+
+    x0, x1 = np.meshgrid(np.arange(0, 9, dtype=SherpaFloat),
+                         np.arange(0, 7, dtype=SherpaFloat))
+    x0lo = x0.flatten()
+    x1lo = x1.flatten()
+    x0hi = x0lo + 1
+    x1hi = x1lo + 1
+
+    got = mdl(x0lo, x1lo, x0hi, x1hi)
+
+    # A midpoint sum with 80 by 80 points per pixel.
+    nsub = 80
+    offsets = (np.arange(nsub) + 0.5) / nsub
+    dx0, dx1 = np.meshgrid(offsets, offsets)
+    expected = [mdl(lo0 + dx0.flatten(), lo1 + dx1.flatten()).sum() / nsub**2
+                for lo0, lo1 in zip(x0lo, x1lo)]
+
+    assert got == pytest.approx(expected, rel=2e-4)
+
+    mdl.numcores = 3
+    assert mdl(x0lo, x1lo, x0hi, x1hi) == pytest.approx(got, rel=0, abs=0)
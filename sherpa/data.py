@@ -124,6 +124,7 @@ import warnings
 
 import numpy as np
 
+from sherpa.models.parameter import Parameter
 from sherpa.models.regrid import EvaluationSpace1D, IntegratedAxis, PointAxis
 from sherpa.utils import NoNewAttributesAfterInit, formatting, \
     print_fields, create_expr, create_expr_integrated, \
@@ -1516,6 +1517,38 @@ class Data(NoNewAttributesAfterInit, BaseData):
         self._can_apply_model(modelfunc)
         return modelfunc(*self.get_indep(filter=True))
 
+    def eval_deriv_to_fit(self,
+                          modelfunc: ModelFunc,
+                          pars: Sequence[Parameter]
+                          ) -> Optional[np.ndarray]:
+        """Evaluate the model derivatives on the independent axis after filtering.
+
+        Parameters
+        ----------
+        modelfunc : `sherpa.models.model.Model`
+            The model.
+        pars : sequence of `sherpa.models.parameter.Parameter`
+            The parameters.
+
+        Returns
+        -------
+        deriv : ndarray or None
+            The derivative of the model with respect to each parameter,
+            with shape (len(pars), nbins), or `None` if the model does
+            not provide analytic derivatives.
+
+        See Also
+        --------
+        eval_model_to_fit, sherpa.models.model.Model.eval_deriv
+        """
+
+        self._can_apply_model(modelfunc)
+        evalfunc = getattr(modelfunc, "eval_deriv", None)
+        if evalfunc is None:
+            return None
+
+        return evalfunc(pars, *self.get_indep(filter=True))
+
     def to_guess(self) -> tuple[Optional[np.ndarray], ...]:
 
         # Should this also check whether the independent and dependent
@@ -1604,13 +1637,30 @@ class DataSimulFit(NoNewAttributesAfterInit):
     def eval_model_to_fit(self,
                           modelfuncs: Sequence[ModelFunc]
                           ) -> np.ndarray:
-        if self.numcores == 1:
-            total_model = []
-            for func, data in zip(modelfuncs, self.datasets):
-                tmp_model = data.eval_model_to_fit(func)
-                total_model.append(tmp_model)
+        return np.concatenate(self.eval_model_to_fit_sets(modelfuncs))
 
-            return np.concatenate(total_model)
+    def eval_model_to_fit_sets(self,
+                               modelfuncs: Sequence[ModelFunc]
+                               ) -> list[np.ndarray]:
+        """Evaluate the models for each dataset.
+
+        Parameters
+        ----------
+        modelfuncs : sequence of callable
+            The model for each dataset.
+
+        Returns
+        -------
+        models : list of ndarray
+            The model values for each dataset, filtered to match
+            the `to_fit_sets` output. The arrays are not combined
+            (as done by `eval_model_to_fit`).
+
+        """
+
+        if self.numcores == 1:
+            return [data.eval_model_to_fit(func)
+                    for func, data in zip(modelfuncs, self.datasets)]
 
         # best to make this a different derived class
         funcs = []
@@ -1619,10 +1669,22 @@ class DataSimulFit(NoNewAttributesAfterInit):
             funcs.append(func)
             datasets.append(data.get_indep(filter=False))
         total_model = parallel_map_funcs(funcs, datasets, self.numcores)
-        all_model = []
-        for model, data in zip(total_model, self.datasets):
-            all_model.append(data.apply_filter(model))
-        return np.concatenate(all_model)
+        return [data.apply_filter(model)
+                for model, data in zip(total_model, self.datasets)]
+
+    def eval_deriv_to_fit(self,
+                          modelfuncs: Sequence[ModelFunc],
+                          pars: Sequence[Parameter]
+                          ) -> Optional[np.ndarray]:
+        total_deriv = []
+        for func, data in zip(modelfuncs, self.datasets):
+            deriv = data.eval_deriv_to_fit(func, pars)
+            if deriv is None:
+                return None
+
+            total_deriv.append(deriv)
+
+        return np.concatenate(total_deriv, axis=1)
 
     def to_fit(self,
                staterrfunc: Optional[StatErrFunc] = None
@@ -1636,8 +1698,7 @@ class DataSimulFit(NoNewAttributesAfterInit):
         no_staterror = True
         no_syserror = True
 
-        for data in self.datasets:
-            dep, staterror, syserror = data.to_fit(staterrfunc)
+        for dep, staterror, syserror in self.to_fit_sets(staterrfunc):
 
             total_dep.append(dep)
 
@@ -1668,6 +1729,31 @@ class DataSimulFit(NoNewAttributesAfterInit):
 
         return total_dep, total_staterror, total_syserror
 
+    def to_fit_sets(self,
+                    staterrfunc: Optional[StatErrFunc] = None
+                    ) -> list[tuple[np.ndarray,
+                                    Optional[np.ndarray],
+                                    Optional[np.ndarray]]]:
+        """Return the data to fit for each dataset.
+
+        Parameters
+        ----------
+        staterrfunc : callable or None, optional
+            The function used to calculate the statistical error
+            when a dataset does not contain one.
+
+        Returns
+        -------
+        fitdata : list of tuple
+            The `to_fit` output - the dependent axis, statistical
+            error, and systematic error - for each dataset. Unlike
+            `to_fit` the values are not combined, so missing errors
+            remain as `None`.
+
+        """
+
+        return [data.to_fit(staterrfunc) for data in self.datasets]
+
     # DATA-NOTE: this implementation is weird. Is this even used?
     # Typing of this is a bit hard too since Data does not have
     # a to_plot method.
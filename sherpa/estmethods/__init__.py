@@ -26,7 +26,7 @@ from numpy.linalg import LinAlgError
 
 from sherpa.utils import NoNewAttributesAfterInit, print_fields, Knuth_close, \
     is_iterable, list_to_open_interval, quad_coef, \
-    demuller, zeroin, OutOfBoundErr, FuncCounter
+    demuller, zeroin, OutOfBoundErr, FuncCounter, stat_value_func
 from sherpa.utils.parallel import multi, ncpus, context, process_tasks
 
 import sherpa.estmethods._est_funcs
@@ -157,8 +157,7 @@ class EstMethod(NoNewAttributesAfterInit):
                 report_progress, get_par_name,
                 statargs=(), statkwargs={}):
 
-        def stat_cb(pars):
-            return statfunc(pars)[0]
+        stat_cb = stat_value_func(statfunc)
 
         def fit_cb(scb, pars, parmins, parmaxes, i):
             # parameter i is a no-op usually
@@ -211,8 +210,7 @@ class Confidence(EstMethod):
                 report_progress, get_par_name,
                 statargs=(), statkwargs={}):
 
-        def stat_cb(pars):
-            return statfunc(pars)[0]
+        stat_cb = stat_value_func(statfunc)
 
         def fit_cb(pars, parmins, parmaxes, i):
             # freeze model parameter i
@@ -226,7 +224,7 @@ class Confidence(EstMethod):
             # If stat is not chi-squared, and fit method is
             # lmdif, need to recalculate stat at end, just
             # like in sherpa/sherpa/fit.py:fit()
-            stat = statfunc(fit_pars)[0]
+            stat = stat_cb(fit_pars)
             # stat = fitfunc(scb, pars, parmins, parmaxes)[2]
             # thaw model parameter i
             thaw_par(i)
@@ -280,8 +278,7 @@ class Projection(EstMethod):
         if fitfunc is None:
             raise TypeError("fitfunc should not be none")
 
-        def stat_cb(pars):
-            return statfunc(pars)[0]
+        stat_cb = stat_value_func(statfunc)
 
         def fit_cb(pars, parmins, parmaxes, i):
             # freeze model parameter i
@@ -294,7 +291,7 @@ class Projection(EstMethod):
             # If stat is not chi-squared, and fit method is
             # lmdif, need to recalculate stat at end, just
             # like in sherpa/sherpa/fit.py:fit()
-            stat = statfunc(fit_pars)[0]
+            stat = stat_cb(fit_pars)
             # stat = fitfunc(scb, pars, parmins, parmaxes)[2]
             # thaw model parameter i
             thaw_par(i)
@@ -24,17 +24,18 @@ import logging
 import os
 from pathlib import Path
 import signal
-from typing import Optional, Protocol, Sequence, Union, \
+from typing import Any, Optional, Protocol, Sequence, Union, \
     runtime_checkable
 
 import numpy as np
 
-from sherpa.data import DataSimulFit
+from sherpa.data import Data1D, Data1DInt, DataSimulFit
 from sherpa.estmethods import Covariance, EstNewMin
 from sherpa.models import SimulFitModel
+from sherpa.models.model import fit_plan
 from sherpa.optmethods import LevMar, NelderMead
 from sherpa.stats import Stat, Chi2, Chi2Gehrels, Cash, Chi2ModVar, \
-    LeastSq, Likelihood
+    LeastSq, Likelihood, PreparedStat
 from sherpa.utils import NoNewAttributesAfterInit, print_fields, erf, \
     bool_cast, is_iterable, list_to_open_interval, sao_fcmp, formatting
 from sherpa.utils.err import DataErr, EstErr, FitErr, SherpaErr
@@ -588,13 +589,14 @@ class IterCallback:
 
     """
 
-    __slots__ = ("data", "model", "stat", "fh", "nfev")
+    __slots__ = ("data", "model", "stat", "fh", "nfev", "prepared")
 
     def __init__(self,
                  data: DataSimulFit,
                  model: SimulFitModel,
                  stat: Stat,
-                 fh: Optional[WriteableTextFile] = None
+                 fh: Optional[WriteableTextFile] = None,
+                 prepared: Optional[PreparedStat] = None
                  ) -> None:
         self.data = data
         self.model = model
@@ -602,6 +604,15 @@ class IterCallback:
         self.fh = fh
         self.nfev = 0
 
+        # The statistic is evaluated with the prepared object, when
+        # set, so that the values which only depend on the data are
+        # not recalculated for each call.
+        #
+        if prepared is None:
+            prepared = PreparedStat(stat, data, model)
+
+        self.prepared = prepared
+
     def __call__(self,
                  pars: np.ndarray
                  ) -> tuple[float, np.ndarray]:
@@ -611,7 +622,7 @@ class IterCallback:
         self.model.thawedpars = pars
 
         # The return value
-        output = self.stat.calc_stat(self.data, self.model)
+        output = self.prepared.calc_stat()
 
         # Write out the data, if requested. This is done before nfev
         # is updated.
@@ -625,6 +636,104 @@ class IterCallback:
         self.nfev += 1
         return output
 
+    def value(self,
+              pars: np.ndarray
+              ) -> float:
+        """Evaluate just the statistic value.
+
+        This acts like calling the object, but the per-bin statistic
+        values are not calculated, for those optimizers and
+        estimators that do not use them.
+        """
+
+        self.model.thawedpars = pars
+        statval = self.prepared.calc_stat_value()
+
+        if self.fh is not None:
+            vals = [f'{self.nfev:5e}', f'{statval:5e}']
+            vals.extend([f'{val:5e}' for val in self.model.thawedpars])
+            self.fh.write(' '.join(vals) + '\n')
+
+        self.nfev += 1
+        return statval
+
+    def jacobian(self,
+                 pars: np.ndarray
+                 ) -> Optional[np.ndarray]:
+        """Return the derivatives of the per-bin statistic values.
+
+        The return value has shape (npars, nbins), or is None if the
+        statistic or model does not support analytic derivatives.
+        """
+
+        self.model.thawedpars = pars
+        return self.stat.calc_deriv(self.data, self.model)
+
+    def gradient(self,
+                 pars: np.ndarray
+                 ) -> Optional[tuple[float, np.ndarray]]:
+        """Return the statistic and its derivatives with respect to pars.
+
+        The return value is None if the statistic or model does not
+        support analytic derivatives. Otherwise nfev is increased, and
+        the fh written to, as for a call.
+        """
+
+        self.model.thawedpars = pars
+        out = self.stat.calc_stat_grad(self.data, self.model)
+        if out is None:
+            return None
+
+        deriv = self.data.eval_deriv_to_fit(self.model,
+                                            self.model.get_thawed_pars())
+        if deriv is None:
+            return None
+
+        statval = out[0]
+        if self.fh is not None:
+            vals = [f'{self.nfev:5e}', f'{statval:5e}']
+            vals.extend([f'{val:5e}' for val in self.model.thawedpars])
+            self.fh.write(' '.join(vals) + '\n')
+
+        self.nfev += 1
+        return statval, deriv @ out[1]
+
+    def native(self,
+               numcores: int = 1
+               ) -> Optional[Any]:
+        """Return a compiled form of the callback, if possible.
+
+        The optimizers which accept a native objective (see
+        `sherpa.optmethods.optfcts`) use it in place of the callback.
+        It is only created for a single `~sherpa.data.Data1D` or
+        `~sherpa.data.Data1DInt` data set, fit with an expression of
+        compiled 1D models (see `sherpa.models.model.fit_plan`) and a
+        statistic which supports it, when the parameter values are
+        not written out. The evaluations it makes are not included in
+        nfev.
+
+        Parameters
+        ----------
+        numcores : int, optional
+            The number of threads which may use the objective at the
+            same time.
+        """
+
+        if self.fh is not None or len(self.data.datasets) != 1:
+            return None
+
+        data = self.data.datasets[0]
+        if type(data) not in (Data1D, Data1DInt):
+            return None
+
+        statargs = self.prepared.fitplan_args()
+        if statargs is None:
+            return None
+
+        return fit_plan(self.model.parts[0], self.model.get_thawed_pars(),
+                        *data.get_indep(filter=True),
+                        nworkspaces=numcores, **statargs)
+
 
 # Since this is an internal class, it's not derived from
 # NoNewAttributesAfterInit.
@@ -674,6 +783,7 @@ class IterFit:
         # self.extra_args = None
         self._staterror = None
         self._syserror = None
+        self._prepared: Optional[PreparedStat] = None
 
         # Options to send to iterative fitting method
         self.itermethod_opts = itermethod_opts
@@ -722,11 +832,24 @@ class IterFit:
         except ValueError as e:
             warning(e)
 
-        self._dep, self._staterror, self._syserror = self.data.to_fit(
-            self.stat.calc_staterror)
+        self._prepared = None
+        self._update_fit_data()
+        self._prepared = self.stat.prepare(self.data, self.model)
 
         return IterCallback(data=self.data, model=self.model,
-                            stat=self.stat, fh=fh)
+                            stat=self.stat, fh=fh,
+                            prepared=self._prepared)
+
+    def _update_fit_data(self) -> None:
+        """Store the data values used by the callback.
+
+        This must be called whenever the data filter changes.
+        """
+
+        self._dep, self._staterror, self._syserror = self.data.to_fit(
+            self.stat.calc_staterror)
+        if self._prepared is not None:
+            self._prepared.update()
 
     def sigmarej(self, statfunc, pars, parmins, parmaxes, statargs=(),
                  statkwargs=None, cache=True):
@@ -842,13 +965,17 @@ class IterFit:
             while rejected and iters < maxiters:
                 # Update stored y, staterror and syserror values
                 # from data, so callback function will work properly
-                self._dep, self._staterror, self._syserror = self.data.to_fit(
-                    self.stat.calc_staterror)
+                self._update_fit_data()
                 self.model.startup(cache)
                 final_fit_results = self.method.fit(statfunc,
                                                     self.model.thawedpars,
                                                     parmins, parmaxes,
                                                     statargs, statkwargs)
+
+                # A native objective does not change the model, so set
+                # the best-fit values before calculating the residuals.
+                #
+                self.model.thawedpars = final_fit_results[1]
                 model_iterator = iter(self.model())
                 rejected = False
 
@@ -914,13 +1041,11 @@ class IterFit:
 
             # Update stored y, staterror and syserror values
             # from data, so callback function will work properly
-            self._dep, self._staterror, self._syserror = self.data.to_fit(
-                self.stat.calc_staterror)
+            self._update_fit_data()
             self.model.startup(cache)
             raise
 
-        self._dep, self._staterror, self._syserror = self.data.to_fit(
-            self.stat.calc_staterror)
+        self._update_fit_data()
 
         # QUS: shouldn't this be teardown, not startup?
         self.model.startup(cache)
@@ -1132,7 +1257,7 @@ class Fit(NoNewAttributesAfterInit):
 
         """
 
-        return self._calc_stat()[0]
+        return self.stat.calc_stat_value(self.data, self.model)
 
     def calc_chisqr(self):
         """Calculate the per-bin chi-squared statistic.
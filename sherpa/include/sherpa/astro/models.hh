@@ -38,7 +38,8 @@ namespace sherpa { namespace astro { namespace models {
     const DataType fwhm_l = p[1];
     const DataType gamma = fwhm_l / 2;
     double sigma = fwhm_g / std::sqrt(8 * log(2));
-    std::complex<double> arg = (x - p[2]) + gamma * std::complex<double>(0,1);
+    std::complex<double> arg = double(x - p[2]) +
+      double(gamma) * std::complex<double>(0,1);
     arg /= sigma * std::sqrt(2);
     val = p[3] * Faddeeva::w(arg).real() / (sigma * std::sqrt(2 * PI));
     return EXIT_SUCCESS;
@@ -286,19 +287,19 @@ namespace sherpa { namespace astro { namespace models {
 	return EXIT_FAILURE;
       }
       DataType tauh_val;
-      if ( EXIT_SUCCESS != tauh( wav, heiicol, 2.0, tauh_val ) ) {
+      if ( EXIT_SUCCESS != tauh( wav, heiicol, DataType(2), tauh_val ) ) {
 	val = SMP_MAX;
 	return EXIT_FAILURE;
       }
       tau = hcol * mmcross_val + tauhe_val + tauh_val;
     } else {
       DataType tauh_val1;
-      if ( EXIT_SUCCESS != tauh( wav, hcol, 1.0, tauh_val1 ) ) {
+      if ( EXIT_SUCCESS != tauh( wav, hcol, DataType(1), tauh_val1 ) ) {
 	val = SMP_MAX;
 	return EXIT_FAILURE;
       }
       DataType tauh_val2;
-      if ( EXIT_SUCCESS != tauh( wav, heiicol, 2.0, tauh_val2 ) ) {
+      if ( EXIT_SUCCESS != tauh( wav, heiicol, DataType(2), tauh_val2 ) ) {
 	val = SMP_MAX;
 	return EXIT_FAILURE;
       }
@@ -410,11 +411,11 @@ namespace sherpa { namespace astro { namespace models {
     DataType wave;
     DataType energy;
 
-    if( EXIT_SUCCESS != bbody_wave(x, 0.0, p[1], false, wave)) {
+    if( EXIT_SUCCESS != bbody_wave(x, DataType(0), DataType(p[1]), false, wave)) {
       return EXIT_FAILURE;
     }
 
-    if( EXIT_SUCCESS != bbody_energy(x, 0.0, p[1], false, energy)) {
+    if( EXIT_SUCCESS != bbody_energy(x, DataType(0), DataType(p[1]), false, energy)) {
       return EXIT_FAILURE;
     }
 
@@ -558,6 +559,108 @@ namespace sherpa { namespace astro { namespace models {
   }
 
 
+  //
+  // Add the derivatives of the integral of bpl1d over [lo, hi], which
+  // lies entirely below (upper is false) or above the break, to grad.
+  // The model is ampl * norm * the integral of x^-gamma, where norm is
+  // ref^gamma1 below the break and ref^gamma1 * eb^(gamma2-gamma1)
+  // above it.
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int bpl1d_segment_deriv( const ConstArrayType& p, bool upper,
+				  DataType lo, DataType hi, DataType* grad )
+  {
+
+    DataType seg, dseg;
+    if ( EXIT_SUCCESS !=
+	 sherpa::utils::powlaw_segment( upper ? p[1] : p[0], lo, hi,
+					seg, dseg ) )
+      return EXIT_FAILURE;
+
+    DataType norm = POW( p[3], p[0] );
+    if ( upper )
+      norm *= POW( p[2], p[1] - p[0] );
+
+    DataType val = p[4] * norm * seg;
+    DataType dindex = p[4] * norm * dseg;
+    if ( upper ) {
+      grad[0] += val * ( LOG(p[3]) - LOG(p[2]) );
+      grad[1] += val * LOG(p[2]) + dindex;
+      grad[2] += val * ( p[1] - p[0] ) / p[2];
+    } else
+      grad[0] += val * LOG(p[3]) + dindex;
+    grad[3] += p[0] * val / p[3];
+    grad[4] += norm * seg;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int bpl1d_point_deriv( const ConstArrayType& p, DataType x,
+				DataType* grad )
+  {
+
+    for ( int ii = 0; ii < 5; ii++ )
+      grad[ii] = 0.0;
+
+    if ( x < 0.0 )
+      return EXIT_SUCCESS;
+
+    if ( 0.0 == p[3] )
+      return EXIT_FAILURE;
+
+    if ( x <= p[2] ) {
+      DataType shape = POW( x / p[3], -p[0] );
+      DataType val = p[4] * shape;
+      if ( x > 0.0 )
+	grad[0] = - val * LOG( x / p[3] );
+      grad[3] = p[0] * val / p[3];
+      grad[4] = shape;
+    } else {
+      DataType shape = POW( p[2] / p[3], p[1] - p[0] ) * POW( x / p[3], -p[1] );
+      DataType val = p[4] * shape;
+      grad[0] = - val * LOG( p[2] / p[3] );
+      grad[1] = val * LOG( p[2] / x );
+      grad[2] = val * ( p[1] - p[0] ) / p[2];
+      grad[3] = p[0] * val / p[3];
+      grad[4] = shape;
+    }
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int bpl1d_integrated_deriv( const ConstArrayType& p,
+				     DataType xlo, DataType xhi,
+				     DataType* grad )
+  {
+
+    for ( int ii = 0; ii < 5; ii++ )
+      grad[ii] = 0.0;
+
+    if ( xlo < 0.0 )
+      return EXIT_SUCCESS;
+
+    if ( xhi <= p[2] )
+      return bpl1d_segment_deriv( p, false, xlo, xhi, grad );
+
+    if ( 0.0 == p[3] )
+      return EXIT_FAILURE;
+
+    if ( xlo >= p[2] )
+      return bpl1d_segment_deriv( p, true, xlo, xhi, grad );
+
+    // The model is continuous at the break, so the terms from moving
+    // the shared edge cancel.
+    if ( EXIT_SUCCESS != bpl1d_segment_deriv( p, false, xlo, p[2], grad ) )
+      return EXIT_FAILURE;
+    return bpl1d_segment_deriv( p, true, p[2], xhi, grad );
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int dered_point( const ConstArrayType& p, DataType x, DataType& val )
   {
@@ -888,6 +991,54 @@ namespace sherpa { namespace astro { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int lorentz1d_point_deriv( const ConstArrayType& p, DataType x,
+				    DataType* grad )
+  {
+
+    DataType hwhm = p[0] / 2;
+    DataType dx = x - p[1];
+    DataType denom = hwhm * hwhm + dx * dx;
+    grad[2] = hwhm / ( PI * denom );
+    grad[1] = (p[2]/PI) * 2.0 * hwhm * dx / ( denom * denom );
+    grad[0] = (p[2]/PI) * 0.5 * ( dx * dx - hwhm * hwhm ) / ( denom * denom );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int lorentz1d_integrated_deriv( const ConstArrayType& p,
+					 DataType xlo, DataType xhi,
+					 DataType* grad )
+  {
+
+    // the angles, and their derivatives, at each edge
+    DataType hwhm = p[0] / 2.0;
+    DataType dlo = xlo - p[1];
+    DataType dhi = xhi - p[1];
+    DataType anglelo = dlo != 0.0 ? atan2( hwhm, dlo ) : PI / 2.0;
+    DataType anglehi = dhi != 0.0 ? atan2( hwhm, dhi ) : PI / 2.0;
+    DataType denlo = hwhm * hwhm + dlo * dlo;
+    DataType denhi = hwhm * hwhm + dhi * dhi;
+    DataType dwlo = 0.0, dwhi = 0.0, dplo = 0.0, dphi = 0.0;
+    if ( denlo != 0.0 ) {
+      dwlo = dlo / denlo;
+      dplo = hwhm / denlo;
+    }
+    if ( denhi != 0.0 ) {
+      dwhi = dhi / denhi;
+      dphi = hwhm / denhi;
+    }
+
+    grad[0] = -0.5 * p[2] * ( dwhi - dwlo ) / PI;
+    grad[1] = - p[2] * ( dphi - dplo ) / PI;
+    grad[2] = - ( anglehi - anglelo ) / PI;
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int nbeta1d_point( const ConstArrayType& p, DataType x,
 			    DataType& val )
@@ -962,6 +1113,34 @@ namespace sherpa { namespace astro { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int beta2d_point_deriv( const ConstArrayType& p,
+				 DataType x0, DataType x1, DataType* grad )
+  {
+
+    DataType r;
+
+    if ( 0 == p[0] ||
+	 EXIT_SUCCESS != sherpa::utils::radius2(p, x0, x1, r) ||
+	 EXIT_SUCCESS != sherpa::utils::radius2_deriv(p, x0, x1, grad + 1) )
+      return EXIT_FAILURE;
+
+    DataType base = 1.0 + r/(p[0]*p[0]);
+    DataType shape = POW(base, -p[6]);
+    DataType val = p[5] * shape;
+
+    // the derivative of the model with respect to r^2
+    DataType scale = - p[6] * val / ( base * p[0] * p[0] );
+    grad[0] = - 2.0 * scale * r / p[0];
+    for ( int ii = 1; ii < 5; ii++ )
+      grad[ii] *= scale;
+    grad[5] = shape;
+    grad[6] = - val * LOG(base);
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int devau_point( const ConstArrayType& p,
 			  DataType x0, DataType x1, DataType& val )
@@ -32,6 +32,11 @@ typedef double SherpaFloat;
 typedef sherpa::Array< double, NPY_DOUBLE > DoubleArray;
 typedef DoubleArray SherpaFloatArray;
 
+// Used by the optional single-precision model evaluation
+typedef float SherpaSingle;
+typedef sherpa::Array< float, NPY_FLOAT > FloatArray;
+typedef FloatArray SherpaSingleArray;
+
 typedef sherpa::Array< int, NPY_INT > IntArray;
 typedef sherpa::Array< std::complex<double>, NPY_COMPLEX128 > ComplexArray;
 
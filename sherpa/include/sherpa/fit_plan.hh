@@ -0,0 +1,398 @@
+//
+//  Copyright (C) 2024  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef __sherpa_fit_plan_hh__
+#define __sherpa_fit_plan_hh__
+
+#include <sherpa/model_extension.hh>
+#include <sherpa/native_objective.hh>
+#include <sherpa/stats.hh>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace sherpa { namespace models {
+
+  // The statistics a fit plan can calculate.
+  enum FitPlanStat { FITPLAN_CHI2, FITPLAN_CASH, FITPLAN_CSTAT };
+
+  //
+  // The memory used by one evaluation of a fit plan: the leaves, with
+  // their own parameter arrays, and the model values.
+  //
+  struct FitPlanWorkspace {
+
+    FitPlanWorkspace( npy_intp nleaves, npy_intp nelem )
+      : leaves( nleaves ), model( nelem ) { }
+
+    std::vector< FusedLeaf > leaves;
+    std::vector< double > model;
+
+  };
+
+
+  //
+  // A fit of a fused1d expression to a single 1D data set, which can
+  // be evaluated without the GIL: the thawed parameters are copied
+  // into the kernel parameters, the model is evaluated over the
+  // filtered grid, and then the statistic is calculated with the same
+  // routines as sherpa.stats.
+  //
+  // Each evaluation needs its own copy of the kernel parameters, and
+  // the arrays can only be created with the GIL held, so a workspace
+  // is created for each of the threads that may call the plan at the
+  // same time. A thread waits when they are all in use.
+  //
+  class FitPlan {
+
+  public:
+
+    FitPlan()
+      : stat( FITPLAN_CHI2 ), trunc_value( 0.0 ), depth( 0 ), npar( 0 ) { }
+
+    ~FitPlan() {
+      for ( std::size_t ii = 0; ii < workspaces.size(); ii++ )
+	delete workspaces[ ii ];
+    }
+
+    //
+    // Set up the plan. This must be called with the GIL held, and it
+    // sets a Python exception on failure.
+    //
+    int init( PyObject* lobj, const IntArray& parmap, int nthawed,
+	      int nworkspaces ) {
+
+      npar = nthawed;
+
+      npy_intp nelem = xlo.get_size();
+      if ( 0 == nelem ) {
+	PyErr_SetString( PyExc_ValueError,
+			 (char*)"the fit plan has no bins" );
+	return EXIT_FAILURE;
+      }
+
+      if ( ( xhi && xhi.get_size() != nelem ) ||
+	   data.get_size() != nelem ||
+	   ( scale && scale.get_size() != nelem ) ) {
+	PyErr_SetString( PyExc_TypeError,
+			 (char*)"the fit plan arrays do not match in size" );
+	return EXIT_FAILURE;
+      }
+
+      if ( FITPLAN_CHI2 == stat && !scale ) {
+	PyErr_SetString( PyExc_TypeError,
+			 (char*)"the chi2 statistic needs the scale" );
+	return EXIT_FAILURE;
+      }
+
+      PyObject* seq = PySequence_Fast( lobj, "leaves must be a sequence" );
+      if ( NULL == seq )
+	return EXIT_FAILURE;
+
+      npy_intp nleaves = PySequence_Fast_GET_SIZE( seq );
+      std::vector< FusedLeaf > initial( nleaves );
+      for ( npy_intp ii = 0; ii < nleaves; ii++ ) {
+	PyObject* item = PySequence_Fast_GET_ITEM( seq, ii );
+	if ( EXIT_SUCCESS != initial[ ii ].convert( item, nelem ) ) {
+	  Py_DECREF( seq );
+	  return EXIT_FAILURE;
+	}
+      }
+      Py_DECREF( seq );
+
+      if ( EXIT_SUCCESS != check_leaves( initial, parmap ) )
+	return EXIT_FAILURE;
+
+      depth = check_fused_program( program, nleaves );
+      if ( 0 == depth ) {
+	PyErr_SetString( PyExc_ValueError, (char*)"invalid fused program" );
+	return EXIT_FAILURE;
+      }
+
+      for ( npy_intp ii = 0; ii < parmap.get_size(); ii++ )
+	map.push_back( parmap[ ii ] );
+
+      // Each workspace starts with the parameter values sent in, so
+      // the frozen values never need to be written again.
+      for ( int nn = 0; nn < std::max( nworkspaces, 1 ); nn++ ) {
+
+	FitPlanWorkspace* ws = new FitPlanWorkspace( nleaves, nelem );
+	workspaces.push_back( ws );
+
+	for ( npy_intp ii = 0; ii < nleaves; ii++ ) {
+	  const FusedLeaf& from = initial[ ii ];
+	  FusedLeaf& to = ws->leaves[ ii ];
+	  to.kernel = from.kernel;
+	  to.integrate = from.integrate;
+	  to.value = from.value;
+	  if ( NULL == from.kernel )
+	    continue;
+	  if ( EXIT_SUCCESS != to.pars.create( from.pars.get_ndim(),
+					       from.pars.get_dims() ) )
+	    return EXIT_FAILURE;
+	  for ( npy_intp jj = 0; jj < from.pars.get_size(); jj++ )
+	    to.pars[ jj ] = from.pars[ jj ];
+	}
+
+      }
+
+      idle = workspaces;
+      return EXIT_SUCCESS;
+
+    }
+
+    int operator()( int np, const double* pars, int mfct, double* fvec,
+		    double& fval ) {
+
+      if ( np != npar || ( fvec && mfct != data.get_size() ) )
+	return EXIT_FAILURE;
+
+      FitPlanWorkspace* ws = acquire();
+      int status = evaluate( *ws, pars, fvec, fval );
+      release( ws );
+      return status;
+
+    }
+
+    // The values set up by fitplan1d before init is called.
+    IntArray program;
+    DoubleArray xlo;
+    DoubleArray xhi;
+    DoubleArray data;
+    DoubleArray scale;
+    FitPlanStat stat;
+    double trunc_value;
+
+  private:
+
+    // Only kernels and constants can be used, as the array leaves do
+    // not change with the parameters, and parmap has an entry for each
+    // kernel parameter which is either -1, for a frozen value, or the
+    // index of the thawed parameter.
+    int check_leaves( const std::vector< FusedLeaf >& leaves,
+		      const IntArray& parmap ) const {
+
+      npy_intp nmap = 0;
+      for ( std::size_t ii = 0; ii < leaves.size(); ii++ ) {
+
+	if ( leaves[ ii ].values ) {
+	  PyErr_SetString( PyExc_TypeError,
+			   (char*)"fit plan leaves must be kernels or numbers" );
+	  return EXIT_FAILURE;
+	}
+
+	const Kernel1D* kernel = leaves[ ii ].kernel;
+	if ( NULL == kernel )
+	  continue;
+
+	if ( xhi && leaves[ ii ].integrate && NULL == kernel->integrated ) {
+	  std::ostringstream err;
+	  err << kernel->name << ": the model has no integrated form";
+	  PyErr_SetString( PyExc_ValueError, err.str().c_str() );
+	  return EXIT_FAILURE;
+	}
+
+	nmap += kernel->npars;
+
+      }
+
+      if ( parmap.get_size() != nmap ) {
+	std::ostringstream err;
+	err << "parmap has " << parmap.get_size() << " elements, expected "
+	    << nmap;
+	PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+	return EXIT_FAILURE;
+      }
+
+      for ( npy_intp ii = 0; ii < nmap; ii++ )
+	if ( parmap[ ii ] < -1 || parmap[ ii ] >= npar ) {
+	  PyErr_SetString( PyExc_ValueError,
+			   (char*)"parmap refers to an unknown parameter" );
+	  return EXIT_FAILURE;
+	}
+
+      return EXIT_SUCCESS;
+
+    }
+
+    FitPlanWorkspace* acquire() {
+      std::unique_lock< std::mutex > guard( lock );
+      while ( idle.empty() )
+	ready.wait( guard );
+      FitPlanWorkspace* ws = idle.back();
+      idle.pop_back();
+      return ws;
+    }
+
+    void release( FitPlanWorkspace* ws ) {
+      {
+	std::lock_guard< std::mutex > guard( lock );
+	idle.push_back( ws );
+      }
+      ready.notify_one();
+    }
+
+    int evaluate( FitPlanWorkspace& ws, const double* pars, double* fvec,
+		  double& fval ) const {
+
+      std::size_t jj = 0;
+      for ( std::size_t ii = 0; ii < ws.leaves.size(); ii++ ) {
+	FusedLeaf& leaf = ws.leaves[ ii ];
+	if ( NULL == leaf.kernel )
+	  continue;
+	for ( npy_intp kk = 0; kk < leaf.kernel->npars; kk++, jj++ )
+	  if ( map[ jj ] >= 0 )
+	    leaf.pars[ kk ] = pars[ map[ jj ] ];
+      }
+
+      npy_intp nelem = data.get_size();
+      FusedBlock1D eval( program, ws.leaves, depth, &xlo[ 0 ],
+			 xhi ? &xhi[ 0 ] : NULL, &ws.model[ 0 ] );
+      if ( EXIT_SUCCESS != eval( 0, nelem ) )
+	return EXIT_FAILURE;
+
+      // The statistic is calculated by the calling thread, since the
+      // optimizer decides how many evaluations run at once.
+      const double* yraw = &data[ 0 ];
+      const double* model = &ws.model[ 0 ];
+      const double* weight = scale ? &scale[ 0 ] : NULL;
+      double trunc = trunc_value;
+      switch ( stat ) {
+      case FITPLAN_CHI2:
+	if ( fvec )
+	  return sherpa::stats::calc_chi2_stat_prepared
+	    ( nelem, yraw, model, weight, fvec, fval, 0 );
+	return sherpa::stats::calc_chi2_stat_prepared_value
+	  ( nelem, yraw, model, weight, fval, 0 );
+      case FITPLAN_CASH:
+	if ( fvec )
+	  return sherpa::stats::calc_cash_stat
+	    ( nelem, yraw, model, weight, fvec, fval, trunc, 0 );
+	return sherpa::stats::calc_cash_stat_value
+	  ( nelem, yraw, model, weight, fval, trunc, 0 );
+      case FITPLAN_CSTAT:
+	if ( fvec )
+	  return sherpa::stats::calc_cstat_stat
+	    ( nelem, yraw, model, weight, fvec, fval, trunc, 0 );
+	return sherpa::stats::calc_cstat_stat_value
+	  ( nelem, yraw, model, weight, fval, trunc, 0 );
+      }
+
+      return EXIT_FAILURE;
+
+    }
+
+    npy_intp depth;
+    int npar;
+    std::vector< int > map;
+    std::vector< FitPlanWorkspace* > workspaces;
+    std::vector< FitPlanWorkspace* > idle;
+    std::mutex lock;
+    std::condition_variable ready;
+
+  };
+
+
+  inline int fitplan_objective( void* ctx, int npar, const double* pars,
+				int mfct, double* fvec, double& fval ) {
+    return ( *static_cast< FitPlan* >( ctx ) )( npar, pars, mfct, fvec,
+						fval );
+  }
+
+  inline void fitplan_free( void* ctx ) {
+    delete static_cast< FitPlan* >( ctx );
+  }
+
+
+  //
+  // Create the native objective (see sherpa/native_objective.hh) for
+  // fitting a fused1d expression of compiled models to the data. The
+  // leaves are (kernel, pars, integrate) tuples or numbers, and parmap
+  // gives, for each kernel parameter in turn, the index of the thawed
+  // parameter it is set to, or -1 to keep the value in pars. The xhi
+  // array is only given for an integrated grid, and the scale is
+  // 1 / error for the chi2 statistic and the (optional) weight for
+  // cash and cstat. The objective can be called from nworkspaces
+  // threads at once without waiting.
+  //
+  inline PyObject* fitplan1d( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    FitPlan* plan = new FitPlan();
+
+    PyObject* lobj = NULL;
+    IntArray parmap;
+    int npar = 0;
+    const char* statname = NULL;
+    int nworkspaces = 1;
+
+    static char *kwlist[] = {(char*)"program", (char*)"leaves",
+			     (char*)"parmap", (char*)"npar", (char*)"stat",
+			     (char*)"data", (char*)"xlo", (char*)"xhi",
+			     (char*)"scale", (char*)"trunc_value",
+			     (char*)"nworkspaces", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds,
+				       (char*)"O&OO&isO&O&|O&O&di", kwlist,
+				       CONVERTME( IntArray ), &plan->program,
+				       &lobj,
+				       CONVERTME( IntArray ), &parmap,
+				       &npar, &statname,
+				       CONVERTME( DoubleArray ), &plan->data,
+				       CONVERTME( DoubleArray ), &plan->xlo,
+				       CONVERTME( DoubleArray ), &plan->xhi,
+				       CONVERTME( DoubleArray ), &plan->scale,
+				       &plan->trunc_value, &nworkspaces ) ) {
+      delete plan;
+      return NULL;
+    }
+
+    if ( 0 == std::strcmp( statname, "chi2" ) )
+      plan->stat = FITPLAN_CHI2;
+    else if ( 0 == std::strcmp( statname, "cash" ) )
+      plan->stat = FITPLAN_CASH;
+    else if ( 0 == std::strcmp( statname, "cstat" ) )
+      plan->stat = FITPLAN_CSTAT;
+    else {
+      std::ostringstream err;
+      err << "unknown fit plan statistic: " << statname;
+      PyErr_SetString( PyExc_ValueError, err.str().c_str() );
+      delete plan;
+      return NULL;
+    }
+
+    if ( EXIT_SUCCESS != plan->init( lobj, parmap, npar, nworkspaces ) ) {
+      delete plan;
+      return NULL;
+    }
+
+    return sherpa::native_objective_capsule( fitplan_objective, plan,
+					     int( plan->data.get_size() ),
+					     fitplan_free );
+
+  }
+
+
+}  }  /* namespace models, namespace sherpa */
+
+
+#define MODELFITPLAN1D KWSPEC(fitplan1d, sherpa::models::fitplan1d)
+
+
+#endif /* __sherpa_fit_plan_hh__ */
@@ -27,30 +27,99 @@ extern "C" {
   typedef double (*integrand_Nd)( unsigned int ndim, const double* x,
 				  void* params );
   typedef int (*integrand_1d_vec)( double* x, int len, void* params );
+  // Evaluate the npt points in x, with point i at x[i * ndim], and
+  // write the values to fval. The return value is 0 on success.
+  typedef int (*integrand_Nd_vec)( unsigned int ndim, unsigned int npt,
+				   const double* x, void* params,
+				   double* fval );
 }
 
 
+namespace sherpa { namespace integration {
+
+//
+// The settings and diagnostics of a set of integrations. The routines
+// read the tolerances and evaluation budget and add to the counters,
+// so a context can be shared by the bins of a model evaluation, but
+// it must only be used by one thread at a time. The integration
+// routines keep no other state, so they can be called from several
+// threads as long as each has its own context.
+//
+struct Context {
+
+  Context( double abs, double rel, unsigned int budget )
+    : epsabs( abs ), epsrel( rel ), maxeval( budget ), neval( 0 ),
+      nfail( 0 ), ntrapezoid( 0 ) { }
+
+  double epsabs;
+  double epsrel;
+  unsigned int maxeval;
+
+  // The number of integrand evaluations
+  unsigned long neval;
+  // The number of intervals which did not meet the tolerance and
+  // were retried with a lower tolerance
+  unsigned long nfail;
+  // The number of those which then used the trapezoid rule
+  unsigned long ntrapezoid;
+
+};
+
+}  }  /* namespace integration, namespace sherpa */
+
+
 #if defined(_INTEGRATIONMODULE) || !defined(Py_PYTHON_H)
 
 namespace sherpa { namespace integration {
 
 int integrate_1d( integrand_1d fct, void* params,
-		  double xlo, double xhi,
-		  unsigned int maxeval, double epsabs, double epsrel,
+		  double xlo, double xhi, Context& ctx,
 		  double& result, double& abserr );
 
 
 int integrate_Nd( integrand_Nd fct, void* params,
 		  unsigned int ndim, const double* xlo, const double* xhi,
-		  unsigned int maxeval, double epsabs, double epsrel,
-		  double& result, double& abserr );
+		  Context& ctx, double& result, double& abserr );
+
+
+//
+// integrate_Nd with an integrand which is sent all the cubature
+// points of one or more regions at once. ndim must be at least 2.
+//
+int integrate_Nd_vec( integrand_Nd_vec fct, void* params,
+		      unsigned int ndim, const double* xlo, const double* xhi,
+		      Context& ctx, double& result, double& abserr );
+
+
+//
+// Integrate npix boxes, where box i runs from xlo[i * ndim] to
+// xhi[i * ndim], writing the integrals to result. The first cubature
+// estimate of a set of boxes is made with a single call to fct, and
+// only the boxes which do not meet the tolerance are then refined
+// with integrate_Nd_vec. The return value is EXIT_FAILURE if any box
+// fails to converge.
+//
+int integrate_Nd_image( integrand_Nd_vec fct, void* params,
+			unsigned int ndim, int npix,
+			const double* xlo, const double* xhi,
+			Context& ctx, double* result );
 
 
 int py_integrate_1d( integrand_1d_vec fct, void* params,
-		     const double xlo, const double xhi,
-		     unsigned int maxeval, double epsabs, double epsrel,
-		     double &result, double& abserr, int errflag,
-		     std::ostringstream& err);
+		     const double xlo, const double xhi, Context& ctx,
+		     double &result, double& abserr );
+
+
+//
+// Integrate over nbins intervals, calling fct with the 21-point
+// Gauss-Kronrod nodes of batchsize intervals at a time (all of them
+// when batchsize is 0). Intervals where the 21-point estimate does not
+// meet the tolerance are integrated with py_integrate_1d.
+//
+int py_integrate_1d_batch( integrand_1d_vec fct, void* params,
+			   const double* xlo, const double* xhi,
+			   int nbins, int batchsize, Context& ctx,
+			   double* result );
 
 
 }  }  /* namespace integration, namespace sherpa */
@@ -63,29 +132,47 @@ int py_integrate_1d( integrand_1d_vec fct, void* params,
 
 typedef int (*_integrate_1d)( integrand_1d fct,
 			      void* params, double xlo, double xhi,
-			      unsigned int maxeval,
-			      double epsabs, double epsrel,
+			      sherpa::integration::Context& ctx,
 			      double& result, double& abserr );
 
 typedef int (*_integrate_Nd)( integrand_Nd fct,
 			      void* params, unsigned int ndim,
 			      const double* xlo, const double* xhi,
-			      unsigned int maxeval,
-			      double epsabs, double epsrel,
+			      sherpa::integration::Context& ctx,
 			      double& result, double& abserr );
 
 typedef int (*_py_integrate_1d)( integrand_1d_vec fct, void* params,
 				 const double xlo, const double xhi,
-				 unsigned int maxeval,
-				 double epsabs, double epsrel,
-				 double &result, double& abserr, int errflag,
-				 std::ostringstream& err );
+				 sherpa::integration::Context& ctx,
+				 double &result, double& abserr );
+
+typedef int (*_py_integrate_1d_batch)( integrand_1d_vec fct, void* params,
+				       const double* xlo, const double* xhi,
+				       int nbins, int batchsize,
+				       sherpa::integration::Context& ctx,
+				       double* result );
+
+typedef int (*_integrate_Nd_vec)( integrand_Nd_vec fct,
+				  void* params, unsigned int ndim,
+				  const double* xlo, const double* xhi,
+				  sherpa::integration::Context& ctx,
+				  double& result, double& abserr );
+
+typedef int (*_integrate_Nd_image)( integrand_Nd_vec fct,
+				    void* params, unsigned int ndim, int npix,
+				    const double* xlo, const double* xhi,
+				    sherpa::integration::Context& ctx,
+				    double* result );
 
 static void **Integration_API;
 
 #define integrate_1d ((_integrate_1d)Integration_API[0])
 #define integrate_Nd ((_integrate_Nd)Integration_API[1])
 #define py_integrate_1d ((_py_integrate_1d)Integration_API[2])
+#define py_integrate_1d_batch \
+  ((_py_integrate_1d_batch)Integration_API[3])
+#define integrate_Nd_vec ((_integrate_Nd_vec)Integration_API[4])
+#define integrate_Nd_image ((_integrate_Nd_image)Integration_API[5])
 
 #define PTR( obj ) PyCapsule_GetPointer( obj, NULL )
 
@@ -23,11 +23,18 @@
 
 #include <sherpa/extension.hh>
 #include <sherpa/integration.hh>
+#include <sherpa/parallel.hh>
+#include <sherpa/quadrature.hh>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <sstream>
 #include <iostream>
 #include <limits>
+#include <vector>
 
-#define TOL (std::numeric_limits< float >::epsilon());
+#define TOL (std::numeric_limits< float >::epsilon())
 
 template <typename ArrayType>
 class FunctionWithParams {
@@ -99,18 +106,20 @@ namespace sherpa { namespace models {
 
   static int py_integrated_1d(const double xlo, const double xhi, double &val,
 		       FunctionWithParams<DoubleArray> *funcAndPars,
-		       int errflag, double epsabs, double epsrel,
-		       unsigned int maxeval, std::ostringstream& err)
+		       sherpa::integration::Context& ctx)
   {
     double abserr;
     
     return py_integrate_1d( (integrand_1d_vec)(integrand_1d_cb),
-			    (void*)funcAndPars, xlo, xhi,
-			    maxeval, epsabs, epsrel, val, abserr, errflag,
-			    err);
+			    (void*)funcAndPars, xlo, xhi, ctx, val, abserr );
     
   }
 
+  // The number of bins whose Gauss-Kronrod nodes are sent to a Python
+  // model in a single call by py_modelfct1d_int. A value of 0 calls the
+  // model separately for each bin.
+  const int PY_INTEGRATE_BATCHSIZE = 1024;
+
   template <typename ArrayType>
   PyObject* py_modelfct1d_int( PyObject* self, PyObject* args, PyObject *kwds )
   {
@@ -121,27 +130,33 @@ namespace sherpa { namespace models {
     PyObject* model_func = NULL;
     PyObject* logger = NULL;
     int errflag = 0, maxeval = 10000;
+    int batchsize = PY_INTEGRATE_BATCHSIZE;
+    int full_output = 0;
     double epsabs = TOL;
     double epsrel = 0.0;
 
     static char *kwlist[] = {(char*)"model", (char*)"pars", (char*)"xlo",
 			     (char*)"xhi", (char*)"errflag", (char*)"epsabs",
 			     (char*)"epsrel", (char*)"maxeval", (char*)"logger",
-			     NULL};
+			     (char*)"batchsize", (char*)"full_output", NULL};
 
     if ( !PyArg_ParseTupleAndKeywords( args, kwds,
-				       (char*)"OO&O&O&|iddiO:pymodelfct1d_int",
+				       (char*)"OO&O&O&|iddiOii:pymodelfct1d_int",
 				       kwlist,
 				       &model_func,
 				       (converter)convert_to_array< ArrayType >,
 				       &pars,
-				       (converter)convert_to_array< ArrayType >,
-				       &xlo,
-				       (converter)convert_to_array< ArrayType >,
-				       &xhi,
+				       CONVERTME( ArrayType ), &xlo,
+				       CONVERTME( ArrayType ), &xhi,
 				       &errflag, &epsabs, &epsrel, &maxeval,
-				       &logger) )
+				       &logger, &batchsize, &full_output) )
+      return NULL;
+
+    if ( batchsize < 0 ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"batchsize must be 0 or a positive integer" );
       return NULL;
+    }
 
     npy_intp nelem = xlo.get_size();
     std::ostringstream err;
@@ -163,31 +178,63 @@ namespace sherpa { namespace models {
       return NULL;
     }
     
-    FunctionWithParams<ArrayType> *funcAndPars =		\
-      new FunctionWithParams<ArrayType>(&pars, model_func);
-    
-    for ( npy_intp ii = 0; ii < nelem; ii++ )
-      if ( EXIT_SUCCESS != py_integrated_1d( xlo[ii], xhi[ii],
-					     result[ii], funcAndPars,
-					     errflag, epsabs, epsrel,
-					     (unsigned int)maxeval,
-					     err) ) {
-	PyErr_SetString( PyExc_ValueError,
-			 (char*)"model evaluation failed" );
-	return NULL;
-      }
+    FunctionWithParams<ArrayType> funcAndPars( &pars, model_func );
+    sherpa::integration::Context ctx( epsabs, epsrel,
+				      (unsigned int)maxeval );
+
+    int status = EXIT_SUCCESS;
+    if ( batchsize > 0 && nelem > 0 ) {
+      status = py_integrate_1d_batch( (integrand_1d_vec)(integrand_1d_cb),
+				      (void*)&funcAndPars, &xlo[0], &xhi[0],
+				      int( nelem ), batchsize, ctx,
+				      &result[0] );
+    } else {
+      for ( npy_intp ii = 0; ii < nelem; ii++ )
+	if ( EXIT_SUCCESS != py_integrated_1d( xlo[ii], xhi[ii],
+					       result[ii], &funcAndPars,
+					       ctx ) ) {
+	  status = EXIT_FAILURE;
+	  break;
+	}
+    }
 
-    delete funcAndPars;
-    
-    
-    if( logger && err.str() != "" ) {
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model evaluation failed" );
+      return NULL;
+    }
+
+    // Report the intervals that needed a lower tolerance once per call,
+    // rather than separately for each bin.
+    if( logger && ctx.nfail > 0 ) {
+
+      err << "Gauss-Kronrod integration failed with tolerance " << epsabs
+	  << " for " << ctx.nfail << " of " << nelem
+	  << " bins, trying lower tolerance..." << std::endl
+	  << "integration ";
+      if ( ctx.ntrapezoid > 0 )
+	err << "failed with tolerance "
+	    << std::numeric_limits< float >::epsilon() << " for "
+	    << ctx.ntrapezoid << " bins, resorting to trapezoid method";
+      else
+	err << "succeeded with tolerance "
+	    << std::numeric_limits< float >::epsilon();
 
       PyObject *rv = PyObject_CallFunction( logger, (char*)"s",
 					    err.str().c_str() );
-      (void)rv;
+      if ( NULL == rv )
+	return NULL;
+      Py_DECREF( rv );
 
     }
-    
+
+    if ( full_output )
+      return Py_BuildValue( (char*)"N{s:k,s:k,s:k}",
+			    result.return_new_ref(),
+			    "neval", ctx.neval,
+			    "nfail", ctx.nfail,
+			    "ntrapezoid", ctx.ntrapezoid );
+
     return result.return_new_ref();
 
   }
@@ -214,33 +261,33 @@ namespace sherpa { namespace models {
   {
 
     // FIXME: make these user-settable function args!
-    double epsabs = TOL;
-    double epsrel = 0.0;
-    unsigned int maxeval = 10000;
+    sherpa::integration::Context ctx( TOL, 0.0, 10000 );
 
     double abserr = 0.0;
 
     return integrate_1d( (integrand_1d)(integrand_model1d< PtFunc >),
-			 (void*)&p, xlo, xhi, maxeval,
-			 epsabs, epsrel, val, abserr );
+			 (void*)&p, xlo, xhi, ctx, val, abserr );
 
   }
 
 
   template <int (*PtFunc)( const DoubleArray& p, double x0, double x1,
 			   double& val )>
-  double integrand_model2d( unsigned int ndim, const double* x, void* params )
+  int integrand_model2d( unsigned int ndim, unsigned int npt,
+			 const double* x, void* params, double* fval )
   {
 
-    DoubleArray& p = *( static_cast< DoubleArray* >( params ) );
-    double val = 0.0;
+    const DoubleArray& p = *( static_cast< DoubleArray* >( params ) );
 
     // FIXME: throw error if ndim != 2
 
     // FIXME: do something with function return value
-    PtFunc( p, x[0], x[1], val );
+    for ( unsigned int ii = 0; ii < npt; ii++, x += 2 ) {
+      fval[ ii ] = 0.0;
+      PtFunc( p, x[0], x[1], fval[ ii ] );
+    }
 
-    return val;
+    return EXIT_SUCCESS;
 
   }
 
@@ -252,9 +299,7 @@ namespace sherpa { namespace models {
   {
 
     // FIXME: make these user-settable function args!
-    double epsabs = TOL;
-    double epsrel = 0.0;
-    unsigned int maxeval = 100000;
+    sherpa::integration::Context ctx( TOL, 0.0, 100000 );
 
     double xlo[2];
     double xhi[2];
@@ -265,9 +310,641 @@ namespace sherpa { namespace models {
 
     double abserr = 0.0;
 
-    return integrate_Nd( (integrand_Nd)(integrand_model2d< PtFunc >),
-			 (void*)&p, 2, xlo, xhi, maxeval,
-			 epsabs, epsrel, val, abserr );
+    return integrate_Nd_vec( (integrand_Nd_vec)(integrand_model2d< PtFunc >),
+			     (void*)&p, 2, xlo, xhi, ctx, val, abserr );
+
+  }
+
+
+  //
+  // Integrate the npix pixels of an image with integrate_Nd_image, so
+  // that the first cubature estimate of many pixels is made in one
+  // call, using the same settings as integrated_model2d.
+  //
+  template <int (*PtFunc)( const DoubleArray& p, double x0, double x1,
+			   double& val )>
+  int integrated_image2d( const DoubleArray& p,
+			  const double* x0lo, const double* x0hi,
+			  const double* x1lo, const double* x1hi,
+			  npy_intp npix, double* val )
+  {
+
+    if ( 0 == npix )
+      return EXIT_SUCCESS;
+
+    sherpa::integration::Context ctx( TOL, 0.0, 100000 );
+
+    std::vector< double > xlo( 2 * npix );
+    std::vector< double > xhi( 2 * npix );
+    for ( npy_intp ii = 0; ii < npix; ii++ ) {
+      xlo[ 2 * ii ] = x0lo[ ii ];
+      xlo[ 2 * ii + 1 ] = x1lo[ ii ];
+      xhi[ 2 * ii ] = x0hi[ ii ];
+      xhi[ 2 * ii + 1 ] = x1hi[ ii ];
+    }
+
+    return integrate_Nd_image( (integrand_Nd_vec)(integrand_model2d< PtFunc >),
+			       (void*)&p, 2, int( npix ), &xlo[0], &xhi[0],
+			       ctx, val );
+
+  }
+
+
+  //
+  // Evaluate a point-wise model over a contiguous array. This is used
+  // for models which do not provide a dedicated *_point_vec kernel.
+  //
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*PtFunc)( const ArrayType& p, DataType x, DataType& val )>
+  int point_vec( const ArrayType& p, const DataType* x, DataType* val,
+		 std::size_t n )
+  {
+
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      if ( EXIT_SUCCESS != PtFunc( p, x[ii], val[ii] ) )
+	return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*IntFunc)( const ArrayType& p, DataType xlo, DataType xhi,
+			    DataType& val )>
+  int integrated_vec( const ArrayType& p, const DataType* xlo,
+		      const DataType* xhi, DataType* val, std::size_t n )
+  {
+
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      if ( EXIT_SUCCESS != IntFunc( p, xlo[ii], xhi[ii], val[ii] ) )
+	return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // Integrate over a grid with the scaled antiderivative F of a model,
+  // as norm * ( F(xhi) - F(xlo) ). Contiguous bins, where xlo[i] equals xhi[i-1],
+  // share the evaluation at their common edge, so a grid with no gaps
+  // needs n + 1 evaluations rather than 2n. When no bins are
+  // contiguous the IntVecFunc kernel is used instead.
+  //
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*AntiVecFunc)( const ArrayType& p, const DataType* x,
+				DataType* val, std::size_t n,
+				DataType& norm ),
+	    int (*IntVecFunc)( const ArrayType& p, const DataType* xlo,
+			       const DataType* xhi, DataType* val,
+			       std::size_t n )>
+  int integrated_antideriv( const ArrayType& p, const DataType* xlo,
+			    const DataType* xhi, DataType* val,
+			    std::size_t n )
+  {
+
+    std::size_t nshared = 0;
+    for ( std::size_t ii = 1; ii < n; ii++ )
+      nshared += ( xlo[ii] == xhi[ii - 1] );
+
+    if ( 0 == nshared )
+      return IntVecFunc( p, xlo, xhi, val, n );
+
+    std::vector< DataType > edges( 2 * n - nshared );
+    std::size_t nedges = 0;
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      if ( 0 == ii || xlo[ii] != xhi[ii - 1] )
+	edges[ nedges++ ] = xlo[ii];
+      edges[ nedges++ ] = xhi[ii];
+    }
+
+    std::vector< DataType > anti( nedges );
+    DataType norm = 1.0;
+    if ( EXIT_SUCCESS != AntiVecFunc( p, &edges[0], &anti[0], nedges,
+				      norm ) )
+      return EXIT_FAILURE;
+
+    // Repeat the walk over the edges, where edge is the index of the
+    // upper edge of the current bin.
+    std::size_t edge = 0;
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      if ( 0 == ii || xlo[ii] != xhi[ii - 1] )
+	edge++;
+      val[ii] = norm * ( anti[ edge ] - anti[ edge - 1 ] );
+      edge++;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+
+  // The smallest number of elements given to a thread when a model
+  // evaluation is split up with the numcores argument.
+  const npy_intp MODEL_MIN_BLOCK = 256;
+
+  // The default intorder setting for models without an analytic
+  // integral. The adaptive integrator (integrated_model1d) is used for
+  // every bin when it is 0; a positive value selects a Gauss-Legendre
+  // rule with that many points (see GaussLegendreBlock1D).
+  const int MODEL_DEFAULT_INTORDER = 0;
+
+  // The order of the Gauss-Legendre rule used to integrate the
+  // derivatives of a 2D model over a pixel.
+  const int MODEL_DERIV2D_INTORDER = 8;
+
+  static int check_numcores( int numcores )
+  {
+
+    if ( numcores < 0 ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"numcores must be 0 or a positive integer" );
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // Evaluate the elements [begin, end) of a 1D grid. The grids must be
+  // contiguous and xhi is NULL for a point (non-integrated) grid.
+  //
+  template <typename ArrayType, typename DataType>
+  class ModelBlock1D {
+
+  public:
+
+    typedef int (*PtVec)( const ArrayType& p, const DataType* x,
+			  DataType* val, std::size_t n );
+    typedef int (*IntVec)( const ArrayType& p, const DataType* xlo,
+			   const DataType* xhi, DataType* val, std::size_t n );
+
+    ModelBlock1D( PtVec pf, IntVec intf, const ArrayType& p,
+		  const DataType* lo, const DataType* hi, DataType* out )
+      : ptfunc( pf ), intfunc( intf ), pars( &p ), xlo( lo ), xhi( hi ),
+	result( out ) { }
+
+    // A copy which uses a different parameter set and output array.
+    ModelBlock1D with( const ArrayType& p, DataType* out ) const {
+      ModelBlock1D block( *this );
+      block.pars = &p;
+      block.result = out;
+      return block;
+    }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+      if ( begin >= end )
+	return EXIT_SUCCESS;
+      std::size_t n = std::size_t( end - begin );
+      if ( NULL == xhi )
+	return ptfunc( *pars, xlo + begin, result + begin, n );
+      return intfunc( *pars, xlo + begin, xhi + begin, result + begin, n );
+    }
+
+  private:
+
+    PtVec ptfunc;
+    IntVec intfunc;
+    const ArrayType* pars;
+    const DataType* xlo;
+    const DataType* xhi;
+    DataType* result;
+
+  };
+
+
+  //
+  // Integrate a model which has no analytic integral over the bins
+  // [begin, end) of a contiguous grid with a fixed-order Gauss-Legendre
+  // rule. The nodes of GL_CHUNK bins are evaluated with a single call
+  // to the point kernel. Only bins where the point values vary by more
+  // than GL_VARIATION of their largest magnitude are checked, by
+  // comparing against the rule applied to each half of the bin; if the
+  // two disagree, or the point kernel fails, the bin is handed to the
+  // adaptive integrator instead. A discontinuity in an otherwise slowly
+  // varying bin is therefore not detected, which is why the rule has
+  // to be selected with intorder.
+  //
+  const npy_intp GL_CHUNK = 64;
+  const double GL_VARIATION = 0.25;
+
+  template <typename ArrayType, typename DataType>
+  class GaussLegendreBlock1D {
+
+  public:
+
+    typedef int (*PtVec)( const ArrayType& p, const DataType* x,
+			  DataType* val, std::size_t n );
+    typedef int (*Int)( const ArrayType& p, DataType xlo, DataType xhi,
+			DataType& val );
+
+    GaussLegendreBlock1D( PtVec pf, Int intf, const ArrayType& p,
+			  const std::vector< double >& t,
+			  const std::vector< double >& w,
+			  const DataType* lo, const DataType* hi,
+			  DataType* out )
+      : ptfunc( pf ), intfunc( intf ), pars( &p ), nodes( &t ),
+	weights( &w ), xlo( lo ), xhi( hi ), result( out ) { }
+
+    // A copy which uses a different parameter set and output array.
+    GaussLegendreBlock1D with( const ArrayType& p, DataType* out ) const {
+      GaussLegendreBlock1D block( *this );
+      block.pars = &p;
+      block.result = out;
+      return block;
+    }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+
+      std::size_t order = nodes->size();
+      std::vector< DataType > x( GL_CHUNK * order );
+      std::vector< DataType > f( GL_CHUNK * order );
+      std::vector< DataType > xfine( 2 * order );
+      std::vector< DataType > ffine( 2 * order );
+
+      for ( npy_intp start = begin; start < end; start += GL_CHUNK ) {
+
+	npy_intp nbins = std::min( end - start, GL_CHUNK );
+	for ( npy_intp ii = 0; ii < nbins; ii++ )
+	  fill_nodes( xlo[ start + ii ], xhi[ start + ii ], &x[ ii * order ] );
+
+	if ( EXIT_SUCCESS != ptfunc( *pars, &x[0], &f[0], nbins * order ) ) {
+	  for ( npy_intp bin = start; bin < start + nbins; bin++ )
+	    if ( EXIT_SUCCESS != intfunc( *pars, xlo[ bin ], xhi[ bin ],
+					  result[ bin ] ) )
+	      return EXIT_FAILURE;
+	  continue;
+	}
+
+	for ( npy_intp ii = 0; ii < nbins; ii++ ) {
+	  npy_intp bin = start + ii;
+	  const DataType* fbin = &f[ ii * order ];
+	  DataType fmin = fbin[ 0 ];
+	  DataType fmax = fbin[ 0 ];
+	  for ( std::size_t jj = 1; jj < order; jj++ ) {
+	    fmin = std::min( fmin, fbin[ jj ] );
+	    fmax = std::max( fmax, fbin[ jj ] );
+	  }
+
+	  DataType coarse = sum( xlo[ bin ], xhi[ bin ], fbin );
+
+	  // The negated test also sends NaN values to the check.
+	  if ( !( fmax - fmin > GL_VARIATION *
+		  std::max( std::fabs( fmin ), std::fabs( fmax ) ) ) ) {
+	    result[ bin ] = coarse;
+	    continue;
+	  }
+
+	  if ( EXIT_SUCCESS != refine( xlo[ bin ], xhi[ bin ], coarse,
+				       &xfine[0], &ffine[0], result[ bin ] ) )
+	    return EXIT_FAILURE;
+	}
+
+      }
+
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    void fill_nodes( DataType lo, DataType hi, DataType* x ) const {
+      DataType mid = ( lo + hi ) / 2.0;
+      DataType half = ( hi - lo ) / 2.0;
+      for ( std::size_t jj = 0; jj < nodes->size(); jj++ )
+	x[ jj ] = mid + half * (*nodes)[ jj ];
+    }
+
+    DataType sum( DataType lo, DataType hi, const DataType* f ) const {
+      DataType total = 0.0;
+      for ( std::size_t jj = 0; jj < weights->size(); jj++ )
+	total += (*weights)[ jj ] * f[ jj ];
+      return total * ( hi - lo ) / 2.0;
+    }
+
+    // Compare the estimate with the rule applied to each half of the
+    // bin, using the same tolerance as integrated_model1d. The x and f
+    // buffers must hold at least 2 * order values.
+    int refine( DataType lo, DataType hi, DataType coarse,
+		DataType* x, DataType* f, DataType& val ) const {
+
+      std::size_t order = nodes->size();
+      DataType mid = ( lo + hi ) / 2.0;
+      fill_nodes( lo, mid, x );
+      fill_nodes( mid, hi, x + order );
+      if ( EXIT_SUCCESS != ptfunc( *pars, x, f, 2 * order ) )
+	return intfunc( *pars, lo, hi, val );
+
+      DataType fine = sum( lo, mid, f ) + sum( mid, hi, f + order );
+      double tol = std::numeric_limits< float >::epsilon();
+      if ( std::fabs( fine - coarse ) <=
+	   std::max( tol, tol * std::fabs( fine ) ) ) {
+	val = fine;
+	return EXIT_SUCCESS;
+      }
+
+      return intfunc( *pars, lo, hi, val );
+
+    }
+
+    PtVec ptfunc;
+    Int intfunc;
+    const ArrayType* pars;
+    const std::vector< double >* nodes;
+    const std::vector< double >* weights;
+    const DataType* xlo;
+    const DataType* xhi;
+    DataType* result;
+
+  };
+
+
+  //
+  // Evaluate the elements [begin, end) of a 2D grid. The grids must be
+  // contiguous and x0hi and x1hi are NULL for a point (non-integrated)
+  // grid.
+  //
+  template <typename ArrayType, typename DataType>
+  class ModelBlock2D {
+
+  public:
+
+    typedef int (*Pt)( const ArrayType& p, DataType x0, DataType x1,
+		       DataType& val );
+    typedef int (*Int)( const ArrayType& p, DataType x0lo, DataType x0hi,
+			DataType x1lo, DataType x1hi, DataType& val );
+    typedef int (*IntImage)( const ArrayType& p,
+			     const DataType* x0lo, const DataType* x0hi,
+			     const DataType* x1lo, const DataType* x1hi,
+			     npy_intp npix, DataType* val );
+
+    // When intimagef is not NULL it is used, instead of intf, to
+    // integrate all the pixels of a block in one call.
+    ModelBlock2D( Pt pf, Int intf, const ArrayType& p,
+		  const DataType* lo0, const DataType* lo1,
+		  const DataType* hi0, const DataType* hi1,
+		  DataType* out, IntImage intimagef=NULL )
+      : ptfunc( pf ), intfunc( intf ), intimage( intimagef ), pars( &p ),
+	x0lo( lo0 ), x1lo( lo1 ), x0hi( hi0 ), x1hi( hi1 ), result( out ) { }
+
+    // A copy which uses a different parameter set and output array.
+    ModelBlock2D with( const ArrayType& p, DataType* out ) const {
+      ModelBlock2D block( *this );
+      block.pars = &p;
+      block.result = out;
+      return block;
+    }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+      if ( NULL == x0hi ) {
+	for ( npy_intp ii = begin; ii < end; ii++ )
+	  if ( EXIT_SUCCESS != ptfunc( *pars, x0lo[ii], x1lo[ii],
+				       result[ii] ) )
+	    return EXIT_FAILURE;
+      } else if ( NULL != intimage ) {
+	return intimage( *pars, x0lo + begin, x0hi + begin, x1lo + begin,
+			 x1hi + begin, end - begin, result + begin );
+      } else {
+	for ( npy_intp ii = begin; ii < end; ii++ )
+	  if ( EXIT_SUCCESS != intfunc( *pars, x0lo[ii], x0hi[ii],
+					x1lo[ii], x1hi[ii], result[ii] ) )
+	    return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
+
+  private:
+
+    Pt ptfunc;
+    Int intfunc;
+    IntImage intimage;
+    const ArrayType* pars;
+    const DataType* x0lo;
+    const DataType* x1lo;
+    const DataType* x0hi;
+    const DataType* x1hi;
+    DataType* result;
+
+  };
+
+
+  //
+  // The parameter values sent to a model. This is either a single set
+  // (a 0 or 1 dimensional array) or, for batch evaluation, a 2D array
+  // of nsets rows, each of which is a complete set of parameters.
+  //
+  template <typename ArrayType>
+  class ParamSets {
+
+  public:
+
+    ParamSets() : batch( false ), nsets( 1 ) { }
+
+    static int convert( PyObject* obj, void* dest_addr ) {
+
+      ParamSets& sets = *( static_cast< ParamSets* >( dest_addr ) );
+
+      PyObject* arr = PyArray_FROM_O( obj );
+      if ( NULL == arr )
+	return 0;
+
+      int ndim = PyArray_NDIM( (PyArrayObject*) arr );
+      if ( ndim < 2 ) {
+	Py_DECREF( arr );
+	return convert_to_array< ArrayType >( obj, &sets.flat );
+      }
+
+      if ( ndim > 2 ) {
+	Py_DECREF( arr );
+	PyErr_SetString( PyExc_TypeError,
+			 (char*)"pars must have 1 or 2 dimensions" );
+	return 0;
+      }
+
+      npy_intp npars = PyArray_DIM( (PyArrayObject*) arr, 1 );
+      sets.batch = true;
+      sets.nsets = PyArray_DIM( (PyArrayObject*) arr, 0 );
+
+      PyObject* flat = PyArray_Ravel( (PyArrayObject*) arr, NPY_CORDER );
+      Py_DECREF( arr );
+      if ( NULL == flat )
+	return 0;
+
+      int rv = convert_to_contig_array< ArrayType >( flat, &sets.flat );
+      Py_DECREF( flat );
+      if ( !rv )
+	return 0;
+
+      // Each row is a view into the contiguous copy of the parameters;
+      // the vector is not resized after this so the rows never move.
+      std::vector< ArrayType >( sets.nsets ).swap( sets.rows );
+      for ( npy_intp ii = 0; ii < sets.nsets; ii++ )
+	if ( EXIT_SUCCESS !=
+	     sets.rows[ ii ].create( 1, &npars,
+				     npars ? &sets.flat[ ii * npars ] : NULL ) )
+	  return 0;
+
+      sets.npars = npars;
+      return 1;
+
+    }
+
+    bool is_batch() const { return batch; }
+
+    npy_intp size() const { return nsets; }
+
+    // The number of parameters in each set.
+    npy_intp get_npars() const {
+      return batch ? npars : flat.get_size();
+    }
+
+    const ArrayType& operator[]( npy_intp index ) const {
+      return batch ? rows[ index ] : flat;
+    }
+
+  private:
+
+    ArrayType flat;
+    std::vector< ArrayType > rows;
+    bool batch;
+    npy_intp nsets;
+    npy_intp npars;
+
+  };
+
+
+  //
+  // Evaluate the parameter sets [begin, end), each over the full grid
+  // of nelem elements, writing set i to out + i * nelem.
+  //
+  template <typename ArrayType, typename DataType, typename Block>
+  class ParamSetBlock {
+
+  public:
+
+    ParamSetBlock( const Block& b, const ParamSets< ArrayType >& s,
+		   npy_intp n, DataType* out )
+      : block( b ), sets( s ), nelem( n ), result( out ) { }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+      for ( npy_intp ii = begin; ii < end; ii++ ) {
+	Block eval( block.with( sets[ ii ], result + ii * nelem ) );
+	if ( EXIT_SUCCESS != eval( npy_intp( 0 ), nelem ) )
+	  return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
+
+  private:
+
+    const Block& block;
+    const ParamSets< ArrayType >& sets;
+    npy_intp nelem;
+    DataType* result;
+
+  };
+
+
+  //
+  // Run a block evaluator over nelem elements. With numcores of 0 the
+  // evaluation happens on the calling thread with the GIL held,
+  // otherwise the GIL is released and the elements are split across
+  // numcores threads, with at least minblock elements per thread.
+  //
+  template <typename Func>
+  int run_model( Func& func, npy_intp nelem, int numcores,
+		 npy_intp minblock=MODEL_MIN_BLOCK )
+  {
+
+    if ( 0 == numcores )
+      return func( npy_intp( 0 ), nelem );
+
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = sherpa::parallel::parallel_for( nelem, numcores, func,
+					     minblock );
+    Py_END_ALLOW_THREADS
+    return status;
+
+  }
+
+
+  //
+  // Evaluate block for every parameter set. A single set is split
+  // over the grid, while a batch of sets is split over the sets so
+  // that each thread evaluates complete grids.
+  //
+  template <typename ArrayType, typename DataType, typename Block>
+  int run_model_sets( const Block& block, const ParamSets< ArrayType >& sets,
+		      npy_intp nelem, DataType* out, int numcores )
+  {
+
+    if ( !sets.is_batch() ) {
+      Block eval( block.with( sets[ 0 ], out ) );
+      return run_model( eval, nelem, numcores );
+    }
+
+    if ( 0 == nelem )
+      return EXIT_SUCCESS;
+
+    ParamSetBlock< ArrayType, DataType, Block > eval( block, sets, nelem,
+						      out );
+    npy_intp minsets = ( MODEL_MIN_BLOCK + nelem - 1 ) / nelem;
+    return run_model( eval, sets.size(), numcores, minsets );
+
+  }
+
+
+  //
+  // Check the number of parameters and create the output array, which
+  // has shape (nsets, nelem) for a batch of parameter sets and nelem
+  // otherwise.
+  //
+  template <typename ArrayType>
+  int create_result( const ParamSets< ArrayType >& pars, npy_intp numpars,
+		     const ArrayType& grid, ArrayType& result )
+  {
+
+    npy_intp npars = pars.get_npars();
+
+    if ( numpars != npars ) {
+      std::ostringstream err;
+      err << "expected " << numpars << " parameters, got " << npars;
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return EXIT_FAILURE;
+    }
+
+    if ( !pars.is_batch() )
+      return result.create( grid.get_ndim(), grid.get_dims() );
+
+    npy_intp size = pars.size() * grid.get_size();
+    return result.create( 1, &size );
+
+  }
+
+
+  //
+  // Return the result, reshaped to (nsets, nelem) for a batch of
+  // parameter sets.
+  //
+  template <typename ArrayType>
+  PyObject* return_result( const ParamSets< ArrayType >& pars,
+			   npy_intp nelem, ArrayType& result )
+  {
+
+    if ( !pars.is_batch() )
+      return result.return_new_ref();
+
+    npy_intp dims[2] = { pars.size(), nelem };
+    PyArray_Dims shape = { dims, 2 };
+    return PyArray_Newshape( (PyArrayObject*) result.borrowed_ref(), &shape,
+			     NPY_CORDER );
 
   }
 
@@ -277,30 +954,43 @@ namespace sherpa { namespace models {
 	    npy_intp NumPars,
 	    int (*PtFunc)( const ArrayType& p, DataType x, DataType& val ),
 	    int (*IntFunc)( const ArrayType& p, DataType xlo, DataType xhi,
-			    DataType& val )>
+			    DataType& val ),
+	    int (*PtVecFunc)( const ArrayType& p, const DataType* x,
+			      DataType* val, std::size_t n ) =
+	      point_vec< ArrayType, DataType, PtFunc >,
+	    int (*IntVecFunc)( const ArrayType& p, const DataType* xlo,
+			       const DataType* xhi, DataType* val,
+			       std::size_t n ) =
+	      integrated_vec< ArrayType, DataType, IntFunc >,
+	    bool NoIntegral = false >
   PyObject* modelfct1d( PyObject* self, PyObject* args, PyObject *kwds)
   {
 
-    ArrayType pars;
+    ParamSets< ArrayType > pars;
     ArrayType xlo;
     ArrayType xhi;
     int integrate = 1;
+    int numcores = 0;
+    int intorder = MODEL_DEFAULT_INTORDER;
+
+    static char *kwlist[] = {(char*)"pars",(char*)"xlo",(char*)"xhi",(char*)"integrate",
+			     (char*)"numcores", (char*)"intorder", NULL};
+
+    // The grids are converted to contiguous arrays so that they can be
+    // handed directly to the vectorized kernels.
+    if ( !PyArg_ParseTupleAndKeywords(args, kwds, (char*)"O&O&|O&iii", kwlist,
+			   (converter)ParamSets< ArrayType >::convert, &pars,
+			   CONVERTME( ArrayType ), &xlo,
+			   CONVERTME( ArrayType ), &xhi,
+			   &integrate, &numcores, &intorder) )
+      return NULL;
 
-    static char *kwlist[] = {(char*)"pars",(char*)"xlo",(char*)"xhi",(char*)"integrate", NULL};
-
-    if ( !PyArg_ParseTupleAndKeywords(args, kwds, (char*)"O&O&|O&i", kwlist,
-			   (converter)convert_to_array< ArrayType >, &pars,
-			   (converter)convert_to_array< ArrayType >, &xlo,
-			   (converter)convert_to_array< ArrayType >, &xhi,
-			   &integrate) )
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
       return NULL;
-    
-    npy_intp npars = pars.get_size();
 
-    if ( NumPars != npars ) {
-      std::ostringstream err;
-      err << "expected " << NumPars << " parameters, got " << npars;
-      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+    if ( intorder < 0 ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"intorder must be 0 or a positive integer" );
       return NULL;
     }
 
@@ -315,32 +1005,37 @@ namespace sherpa { namespace models {
     }
 
     ArrayType result;
-    if ( EXIT_SUCCESS != result.create( xlo.get_ndim(), xlo.get_dims() ) )
+    if ( EXIT_SUCCESS != create_result( pars, NumPars, xlo, result ) )
       return NULL;
 
+    if ( 0 == nelem || 0 == result.get_size() )
+      return return_result( pars, nelem, result );
 
-    if ( !(xhi && integrate) ) {
-
-      for ( npy_intp ii = 0; ii < nelem; ii++ )
-	if ( EXIT_SUCCESS != PtFunc( pars, xlo[ii], result[ii] ) ) {
-	  PyErr_SetString( PyExc_ValueError,
-			   (char*)"model evaluation failed" );
-	  return NULL;
-	}
+    const DataType* xhiptr = (xhi && integrate) ? &xhi[0] : NULL;
 
+    int status;
+    if ( NoIntegral && xhiptr && intorder > 0 ) {
+      std::vector< double > nodes, weights;
+      sherpa::quadrature::gauss_legendre( intorder, nodes, weights );
+      GaussLegendreBlock1D< ArrayType, DataType > eval( PtVecFunc, IntFunc,
+							pars[ 0 ], nodes,
+							weights, &xlo[0],
+							xhiptr, &result[0] );
+      status = run_model_sets( eval, pars, nelem, &result[0], numcores );
     } else {
-
-      for ( npy_intp ii = 0; ii < nelem; ii++ )
-	if ( EXIT_SUCCESS != IntFunc( pars, xlo[ii], xhi[ii], result[ii] ) ) {
-	  PyErr_SetString( PyExc_ValueError,
-			   (char*)"model evaluation failed" );
-	  return NULL;
-	}
-
+      ModelBlock1D< ArrayType, DataType > eval( PtVecFunc, IntVecFunc,
+						pars[ 0 ], &xlo[0], xhiptr,
+						&result[0] );
+      status = run_model_sets( eval, pars, nelem, &result[0], numcores );
     }
 
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model evaluation failed" );
+      return NULL;
+    }
 
-    return result.return_new_ref();
+    return return_result( pars, nelem, result );
 
   }
 
@@ -352,35 +1047,33 @@ namespace sherpa { namespace models {
 			   DataType& val ),
 	    int (*IntFunc)( const ArrayType& p, DataType x0lo, DataType x0hi,
 			    DataType x1lo, DataType x1hi, DataType& val )>
-  PyObject* modelfct2d( PyObject* self, PyObject* args, PyObject *kwds )
+  PyObject* modelfct2d_eval( PyObject* self, PyObject* args, PyObject *kwds,
+			     typename ModelBlock2D< ArrayType,
+						    DataType >::IntImage intimage )
   {
 
-    ArrayType pars;
+    ParamSets< ArrayType > pars;
     ArrayType x0lo;
     ArrayType x1lo;
     ArrayType x0hi;
     ArrayType x1hi;
 
     int integrate = 1;
+    int numcores = 0;
     static char *kwlist[] = {(char*)"pars", (char*)"x0lo", (char*)"x1lo",
-			     (char*)"x0hi", (char*)"x1hi", (char*)"integrate", NULL};
-    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&|O&O&i", kwlist,
-			    (converter)convert_to_array< ArrayType >, &pars,
-			    (converter)convert_to_array< ArrayType >, &x0lo,
-			    (converter)convert_to_array< ArrayType >, &x1lo,
-			    (converter)convert_to_array< ArrayType >, &x0hi,
-			    (converter)convert_to_array< ArrayType >, &x1hi,
-			    &integrate) )
+			     (char*)"x0hi", (char*)"x1hi", (char*)"integrate",
+			     (char*)"numcores", NULL};
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&|O&O&ii", kwlist,
+			    (converter)ParamSets< ArrayType >::convert, &pars,
+			    CONVERTME( ArrayType ), &x0lo,
+			    CONVERTME( ArrayType ), &x1lo,
+			    CONVERTME( ArrayType ), &x0hi,
+			    CONVERTME( ArrayType ), &x1hi,
+			    &integrate, &numcores) )
       return NULL;
 
-    npy_intp npars = pars.get_size();
-
-    if ( NumPars != npars ) {
-      std::ostringstream err;
-      err << "expected " << NumPars << " parameters, got " << npars;
-      PyErr_SetString( PyExc_TypeError, err.str().c_str() );      
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
       return NULL;
-    }
 
     if ( x0hi && !x1hi )  {
       PyErr_SetString( PyExc_TypeError, (char*)"expected 3 or 5 arguments, got 4");
@@ -399,40 +1092,875 @@ namespace sherpa { namespace models {
     }
 
     ArrayType result;
-    if ( EXIT_SUCCESS != result.create( x0lo.get_ndim(), x0lo.get_dims() ) )
+    if ( EXIT_SUCCESS != create_result( pars, NumPars, x0lo, result ) )
       return NULL;
 
-    if ( !(x0hi && integrate) ) {
-
-      for ( npy_intp ii = 0; ii < nelem; ii++ )
-	if ( EXIT_SUCCESS != PtFunc( pars, x0lo[ii], x1lo[ii], result[ii] ) ) {
-	  PyErr_SetString( PyExc_ValueError,
-			   (char*)"model evaluation failed" );
-	  return NULL;
-	}
-
-    } else {
+    if ( 0 == nelem || 0 == result.get_size() )
+      return return_result( pars, nelem, result );
 
-      for ( npy_intp ii = 0; ii < nelem; ii++ )
-	if ( EXIT_SUCCESS != IntFunc( pars, x0lo[ii], x0hi[ii], x1lo[ii],
-				      x1hi[ii], result[ii] ) ) {
-	  PyErr_SetString( PyExc_ValueError,
-			   (char*)"model evaluation failed" );
-	  return NULL;
-	}
+    bool use_int = (x0hi && integrate);
+    ModelBlock2D< ArrayType, DataType > eval( PtFunc, IntFunc, pars[ 0 ],
+					      &x0lo[0], &x1lo[0],
+					      use_int ? &x0hi[0] : NULL,
+					      use_int ? &x1hi[0] : NULL,
+					      &result[0], intimage );
 
+    if ( EXIT_SUCCESS != run_model_sets( eval, pars, nelem, &result[0],
+					 numcores ) ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model evaluation failed" );
+      return NULL;
     }
 
-    return result.return_new_ref();
+    return return_result( pars, nelem, result );
 
   }
 
 
-}  }  /* namespace models, namespace sherpa */
-
-#define SHERPAMODELMOD(name, fctlist) \
-static struct PyModuleDef module##name = {\
-PyModuleDef_HEAD_INIT, \
+  template <typename ArrayType,
+	    typename DataType,
+	    npy_intp NumPars,
+	    int (*PtFunc)( const ArrayType& p, DataType x0, DataType x1,
+			   DataType& val ),
+	    int (*IntFunc)( const ArrayType& p, DataType x0lo, DataType x0hi,
+			    DataType x1lo, DataType x1hi, DataType& val )>
+  PyObject* modelfct2d( PyObject* self, PyObject* args, PyObject *kwds )
+  {
+    return modelfct2d_eval< ArrayType, DataType, NumPars, PtFunc,
+			    IntFunc >( self, args, kwds, NULL );
+  }
+
+
+  //
+  // A 2D model whose integrated form is calculated numerically, where
+  // IntImageFunc integrates a block of pixels at a time.
+  //
+  template <typename ArrayType,
+	    typename DataType,
+	    npy_intp NumPars,
+	    int (*PtFunc)( const ArrayType& p, DataType x0, DataType x1,
+			   DataType& val ),
+	    int (*IntFunc)( const ArrayType& p, DataType x0lo, DataType x0hi,
+			    DataType x1lo, DataType x1hi, DataType& val ),
+	    int (*IntImageFunc)( const ArrayType& p,
+				 const DataType* x0lo, const DataType* x0hi,
+				 const DataType* x1lo, const DataType* x1hi,
+				 npy_intp npix, DataType* val )>
+  PyObject* modelfct2d_image( PyObject* self, PyObject* args,
+			      PyObject *kwds )
+  {
+    return modelfct2d_eval< ArrayType, DataType, NumPars, PtFunc,
+			    IntFunc >( self, args, kwds, IntImageFunc );
+  }
+
+
+  //
+  // The single-precision versions of models without an analytic
+  // integral are only used for point grids (the adaptive integrators
+  // work in double precision), so these stand in for the integral.
+  //
+  template <typename ArrayType, typename DataType>
+  int no_integrated1d( const ArrayType& p, DataType xlo, DataType xhi,
+		       DataType& val )
+  {
+    return EXIT_FAILURE;
+  }
+
+  template <typename ArrayType, typename DataType>
+  int no_integrated2d( const ArrayType& p, DataType x0lo, DataType x0hi,
+		       DataType x1lo, DataType x1hi, DataType& val )
+  {
+    return EXIT_FAILURE;
+  }
+
+
+  //
+  // Is a model call for an integrated grid? The upper edges are the
+  // argument at position hiindex, or the hiname keyword, and are only
+  // used when the integrate keyword is not false.
+  //
+  static int is_integrated( PyObject* args, PyObject* kwds,
+			    Py_ssize_t hiindex, const char* hiname )
+  {
+
+    bool hasgrid = PyTuple_GET_SIZE( args ) > hiindex;
+    PyObject* integrate = NULL;
+    if ( kwds ) {
+      PyObject* hi = PyDict_GetItemString( kwds, hiname );
+      hasgrid = hasgrid || ( hi && Py_None != hi );
+      integrate = PyDict_GetItemString( kwds, "integrate" );
+    }
+
+    if ( !hasgrid || NULL == integrate )
+      return hasgrid;
+
+    return PyObject_IsTrue( integrate );
+
+  }
+
+
+  //
+  // Evaluate a model with SingleFunc when the single keyword is set,
+  // otherwise DoubleFunc. The keyword is removed before the call. The
+  // single-precision version converts the parameters and grids to
+  // float and returns a float32 array; any accumulation (such as the
+  // statistic) is left to the caller. When hiindex is not negative the
+  // single-precision version only supports point grids and the double
+  // version is used for integrated grids (see is_integrated).
+  //
+  template <PyObject* (*DoubleFunc)( PyObject*, PyObject*, PyObject* ),
+	    PyObject* (*SingleFunc)( PyObject*, PyObject*, PyObject* ),
+	    Py_ssize_t HiIndex = -1>
+  PyObject* modelfct_precision( PyObject* self, PyObject* args,
+				PyObject* kwds )
+  {
+
+    PyObject* flag = kwds ? PyDict_GetItemString( kwds, "single" ) : NULL;
+    if ( NULL == flag )
+      return DoubleFunc( self, args, kwds );
+
+    int single = PyObject_IsTrue( flag );
+    if ( single < 0 )
+      return NULL;
+
+    PyObject* rest = PyDict_Copy( kwds );
+    if ( NULL == rest )
+      return NULL;
+
+    if ( 0 != PyDict_DelItemString( rest, "single" ) ) {
+      Py_DECREF( rest );
+      return NULL;
+    }
+
+    if ( single && HiIndex >= 0 ) {
+      int integrated = is_integrated( args, rest, HiIndex,
+				      ( 2 == HiIndex ) ? "xhi" : "x0hi" );
+      if ( integrated < 0 ) {
+	Py_DECREF( rest );
+	return NULL;
+      }
+      single = !integrated;
+    }
+
+    PyObject* rv = single ? SingleFunc( self, args, rest ) :
+      DoubleFunc( self, args, rest );
+    Py_DECREF( rest );
+    return rv;
+
+  }
+
+
+  //
+  // Integrate the derivatives of a 2D model, which has no analytic
+  // form for them, over a pixel with the tensor product of a
+  // MODEL_DERIV2D_INTORDER-point Gauss-Legendre rule.
+  //
+  class GaussLegendreRule {
+
+  public:
+
+    GaussLegendreRule( int order ) {
+      sherpa::quadrature::gauss_legendre( order, nodes, weights );
+    }
+
+    std::vector< double > nodes;
+    std::vector< double > weights;
+
+  };
+
+  template <typename ArrayType,
+	    typename DataType,
+	    npy_intp NumPars,
+	    int (*PtDeriv)( const ArrayType& p, DataType x0, DataType x1,
+			    DataType* grad )>
+  int integrated_deriv2d( const ArrayType& p, DataType x0lo, DataType x0hi,
+			  DataType x1lo, DataType x1hi, DataType* grad )
+  {
+
+    static const GaussLegendreRule rule( MODEL_DERIV2D_INTORDER );
+
+    DataType half0 = 0.5 * ( x0hi - x0lo );
+    DataType mid0 = 0.5 * ( x0hi + x0lo );
+    DataType half1 = 0.5 * ( x1hi - x1lo );
+    DataType mid1 = 0.5 * ( x1hi + x1lo );
+
+    DataType node[ NumPars ];
+    for ( npy_intp kk = 0; kk < NumPars; kk++ )
+      grad[ kk ] = 0.0;
+
+    for ( std::size_t ii = 0; ii < rule.nodes.size(); ii++ ) {
+      DataType x0 = mid0 + half0 * rule.nodes[ ii ];
+      for ( std::size_t jj = 0; jj < rule.nodes.size(); jj++ ) {
+	DataType x1 = mid1 + half1 * rule.nodes[ jj ];
+	if ( EXIT_SUCCESS != PtDeriv( p, x0, x1, node ) )
+	  return EXIT_FAILURE;
+	DataType weight = rule.weights[ ii ] * rule.weights[ jj ];
+	for ( npy_intp kk = 0; kk < NumPars; kk++ )
+	  grad[ kk ] += weight * node[ kk ];
+      }
+    }
+
+    for ( npy_intp kk = 0; kk < NumPars; kk++ )
+      grad[ kk ] *= half0 * half1;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // Evaluate the derivatives of a model with respect to its NumPars
+  // parameters for the elements [begin, end) of a grid of nelem
+  // elements. The derivative with respect to parameter k of element i
+  // is written to result[k * nelem + i]. The grids must be contiguous
+  // and the hi grids are NULL for a point (non-integrated) grid.
+  //
+  template <typename ArrayType, typename DataType, npy_intp NumPars>
+  class DerivBlock1D {
+
+  public:
+
+    typedef int (*Pt)( const ArrayType& p, DataType x, DataType* grad );
+    typedef int (*Int)( const ArrayType& p, DataType xlo, DataType xhi,
+			DataType* grad );
+
+    DerivBlock1D( Pt pf, Int intf, const ArrayType& p, const DataType* lo,
+		  const DataType* hi, npy_intp n, DataType* out )
+      : ptfunc( pf ), intfunc( intf ), pars( p ), xlo( lo ), xhi( hi ),
+	nelem( n ), result( out ) { }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+      DataType grad[ NumPars ];
+      for ( npy_intp ii = begin; ii < end; ii++ ) {
+	int status = ( NULL == xhi ) ? ptfunc( pars, xlo[ii], grad ) :
+	  intfunc( pars, xlo[ii], xhi[ii], grad );
+	if ( EXIT_SUCCESS != status )
+	  return EXIT_FAILURE;
+	for ( npy_intp kk = 0; kk < NumPars; kk++ )
+	  result[ kk * nelem + ii ] = grad[ kk ];
+      }
+      return EXIT_SUCCESS;
+    }
+
+  private:
+
+    Pt ptfunc;
+    Int intfunc;
+    const ArrayType& pars;
+    const DataType* xlo;
+    const DataType* xhi;
+    npy_intp nelem;
+    DataType* result;
+
+  };
+
+
+  template <typename ArrayType, typename DataType, npy_intp NumPars>
+  class DerivBlock2D {
+
+  public:
+
+    typedef int (*Pt)( const ArrayType& p, DataType x0, DataType x1,
+		       DataType* grad );
+    typedef int (*Int)( const ArrayType& p, DataType x0lo, DataType x0hi,
+			DataType x1lo, DataType x1hi, DataType* grad );
+
+    DerivBlock2D( Pt pf, Int intf, const ArrayType& p,
+		  const DataType* lo0, const DataType* lo1,
+		  const DataType* hi0, const DataType* hi1,
+		  npy_intp n, DataType* out )
+      : ptfunc( pf ), intfunc( intf ), pars( p ), x0lo( lo0 ),
+	x1lo( lo1 ), x0hi( hi0 ), x1hi( hi1 ), nelem( n ), result( out ) { }
+
+    int operator()( npy_intp begin, npy_intp end ) {
+      DataType grad[ NumPars ];
+      for ( npy_intp ii = begin; ii < end; ii++ ) {
+	int status = ( NULL == x0hi ) ?
+	  ptfunc( pars, x0lo[ii], x1lo[ii], grad ) :
+	  intfunc( pars, x0lo[ii], x0hi[ii], x1lo[ii], x1hi[ii], grad );
+	if ( EXIT_SUCCESS != status )
+	  return EXIT_FAILURE;
+	for ( npy_intp kk = 0; kk < NumPars; kk++ )
+	  result[ kk * nelem + ii ] = grad[ kk ];
+      }
+      return EXIT_SUCCESS;
+    }
+
+  private:
+
+    Pt ptfunc;
+    Int intfunc;
+    const ArrayType& pars;
+    const DataType* x0lo;
+    const DataType* x1lo;
+    const DataType* x0hi;
+    const DataType* x1hi;
+    npy_intp nelem;
+    DataType* result;
+
+  };
+
+
+  //
+  // Check the parameters and create the (NumPars, nelem) array used to
+  // return the model derivatives.
+  //
+  template <typename ArrayType>
+  int create_deriv_result( const ArrayType& pars, npy_intp numpars,
+			   npy_intp nelem, ArrayType& result )
+  {
+
+    if ( numpars != pars.get_size() ) {
+      std::ostringstream err;
+      err << "expected " << numpars << " parameters, got "
+	  << pars.get_size();
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return EXIT_FAILURE;
+    }
+
+    npy_intp size = numpars * nelem;
+    return result.create( 1, &size );
+
+  }
+
+
+  template <typename ArrayType>
+  PyObject* return_deriv_result( npy_intp numpars, npy_intp nelem,
+				 ArrayType& result )
+  {
+
+    npy_intp dims[2] = { numpars, nelem };
+    PyArray_Dims shape = { dims, 2 };
+    return PyArray_Newshape( (PyArrayObject*) result.borrowed_ref(), &shape,
+			     NPY_CORDER );
+
+  }
+
+
+  //
+  // Return the derivative of a 1D model with respect to each parameter
+  // as a (NumPars, nelem) array. The arguments match modelfct1d, except
+  // that only a single set of parameters is accepted; intorder is
+  // accepted for compatibility but is not used, since the derivatives
+  // are analytic.
+  //
+  template <typename ArrayType,
+	    typename DataType,
+	    npy_intp NumPars,
+	    int (*PtDeriv)( const ArrayType& p, DataType x, DataType* grad ),
+	    int (*IntDeriv)( const ArrayType& p, DataType xlo, DataType xhi,
+			     DataType* grad )>
+  PyObject* modelderiv1d( PyObject* self, PyObject* args, PyObject *kwds )
+  {
+
+    ArrayType pars;
+    ArrayType xlo;
+    ArrayType xhi;
+    int integrate = 1;
+    int numcores = 0;
+    int intorder = MODEL_DEFAULT_INTORDER;
+
+    static char *kwlist[] = {(char*)"pars",(char*)"xlo",(char*)"xhi",(char*)"integrate",
+			     (char*)"numcores", (char*)"intorder", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords(args, kwds, (char*)"O&O&|O&iii", kwlist,
+			   CONVERTME( ArrayType ), &pars,
+			   CONVERTME( ArrayType ), &xlo,
+			   CONVERTME( ArrayType ), &xhi,
+			   &integrate, &numcores, &intorder) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    npy_intp nelem = xlo.get_size();
+
+    if ( xhi && ( xhi.get_size() != nelem ) ) {
+      std::ostringstream err;
+      err << "1D model evaluation input array sizes do not match, "
+	  << "xlo: " << nelem << " vs xhi: " << xhi.get_size();
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return NULL;
+    }
+
+    ArrayType result;
+    if ( EXIT_SUCCESS != create_deriv_result( pars, NumPars, nelem, result ) )
+      return NULL;
+
+    if ( 0 == nelem )
+      return return_deriv_result( NumPars, nelem, result );
+
+    const DataType* xhiptr = (xhi && integrate) ? &xhi[0] : NULL;
+    DerivBlock1D< ArrayType, DataType, NumPars > eval( PtDeriv, IntDeriv,
+						       pars, &xlo[0], xhiptr,
+						       nelem, &result[0] );
+    if ( EXIT_SUCCESS != run_model( eval, nelem, numcores ) ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model derivative evaluation failed" );
+      return NULL;
+    }
+
+    return return_deriv_result( NumPars, nelem, result );
+
+  }
+
+
+  template <typename ArrayType,
+	    typename DataType,
+	    npy_intp NumPars,
+	    int (*PtDeriv)( const ArrayType& p, DataType x0, DataType x1,
+			    DataType* grad ),
+	    int (*IntDeriv)( const ArrayType& p, DataType x0lo, DataType x0hi,
+			     DataType x1lo, DataType x1hi, DataType* grad )>
+  PyObject* modelderiv2d( PyObject* self, PyObject* args, PyObject *kwds )
+  {
+
+    ArrayType pars;
+    ArrayType x0lo;
+    ArrayType x1lo;
+    ArrayType x0hi;
+    ArrayType x1hi;
+
+    int integrate = 1;
+    int numcores = 0;
+    static char *kwlist[] = {(char*)"pars", (char*)"x0lo", (char*)"x1lo",
+			     (char*)"x0hi", (char*)"x1hi", (char*)"integrate",
+			     (char*)"numcores", NULL};
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&|O&O&ii", kwlist,
+			    CONVERTME( ArrayType ), &pars,
+			    CONVERTME( ArrayType ), &x0lo,
+			    CONVERTME( ArrayType ), &x1lo,
+			    CONVERTME( ArrayType ), &x0hi,
+			    CONVERTME( ArrayType ), &x1hi,
+			    &integrate, &numcores) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    if ( x0hi && !x1hi )  {
+      PyErr_SetString( PyExc_TypeError, (char*)"expected 3 or 5 arguments, got 4");
+      return NULL;
+    }
+
+    npy_intp nelem = x0lo.get_size();
+
+    if ( ( x1lo.get_size() != nelem ) ||
+	 ( x0hi &&
+	   ( ( x0hi.get_size() != nelem ) ||
+	     ( x1hi.get_size() != nelem ) ) ) ) {
+      PyErr_SetString( PyExc_TypeError,
+		       (char*)"2D model evaluation input array sizes do not match" );
+      return NULL;
+    }
+
+    ArrayType result;
+    if ( EXIT_SUCCESS != create_deriv_result( pars, NumPars, nelem, result ) )
+      return NULL;
+
+    if ( 0 == nelem )
+      return return_deriv_result( NumPars, nelem, result );
+
+    bool use_int = (x0hi && integrate);
+    DerivBlock2D< ArrayType, DataType, NumPars > eval( PtDeriv, IntDeriv, pars,
+						       &x0lo[0], &x1lo[0],
+						       use_int ? &x0hi[0] : NULL,
+						       use_int ? &x1hi[0] : NULL,
+						       nelem, &result[0] );
+    if ( EXIT_SUCCESS != run_model( eval, nelem, numcores ) ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model derivative evaluation failed" );
+      return NULL;
+    }
+
+    return return_deriv_result( NumPars, nelem, result );
+
+  }
+
+
+  //
+  // A compiled 1D model, in double precision, which can be evaluated
+  // over part of a grid without the GIL. Each model module lists the
+  // kernels it provides in a table, terminated by an entry with a NULL
+  // name, which kernel1d hands out as capsules for use by fused1d. The
+  // integrated kernel is NULL for models without an analytic integral.
+  //
+  struct Kernel1D {
+
+    typedef int (*PtVec)( const DoubleArray& p, const double* x,
+			  double* val, std::size_t n );
+    typedef int (*IntVec)( const DoubleArray& p, const double* xlo,
+			   const double* xhi, double* val, std::size_t n );
+
+    const char* name;
+    npy_intp npars;
+    PtVec point;
+    IntVec integrated;
+
+  };
+
+  static const char* const KERNEL1D_CAPSULE = "sherpa.models.Kernel1D";
+
+
+  //
+  // Return the kernel for the named model as a capsule, or None if
+  // the integrated form was requested and the model has none.
+  //
+  template <const Kernel1D* Table>
+  PyObject* kernel1d( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    const char* name = NULL;
+    int integrated = 0;
+
+    static char *kwlist[] = {(char*)"name", (char*)"integrated", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"s|i", kwlist,
+				       &name, &integrated ) )
+      return NULL;
+
+    for ( const Kernel1D* kernel = Table; kernel->name; kernel++ ) {
+      if ( std::strcmp( kernel->name, name ) )
+	continue;
+      if ( integrated && NULL == kernel->integrated )
+	Py_RETURN_NONE;
+      return PyCapsule_New( (void*)kernel, KERNEL1D_CAPSULE, NULL );
+    }
+
+    std::ostringstream err;
+    err << "unknown model kernel: " << name;
+    PyErr_SetString( PyExc_ValueError, err.str().c_str() );
+    return NULL;
+
+  }
+
+
+  // The number of elements fused1d evaluates at a time, chosen so
+  // that the values on the stack of a typical expression stay in the
+  // L1 cache.
+  const npy_intp FUSED_BLOCK = 512;
+
+  // The operations of a fused1d program. The program is in postfix
+  // order: a non-negative entry pushes the values of that leaf and
+  // the operations replace their operands with the result.
+  enum FusedOp { FUSED_ADD = -1, FUSED_SUBTRACT = -2, FUSED_MULTIPLY = -3,
+		 FUSED_DIVIDE = -4, FUSED_NEGATIVE = -5, FUSED_ABSOLUTE = -6 };
+
+  //
+  // A leaf of a fused1d expression: a compiled model, a constant, or
+  // an array of values which has already been evaluated.
+  //
+  class FusedLeaf {
+
+  public:
+
+    FusedLeaf() : kernel( NULL ), integrate( false ), value( 0.0 ) { }
+
+    int convert( PyObject* obj, npy_intp nelem ) {
+
+      PyObject* capsule = NULL;
+      PyObject* pobj = NULL;
+      PyObject* iobj = NULL;
+
+      if ( PyTuple_Check( obj ) ) {
+
+	if ( !PyArg_ParseTuple( obj, (char*)"OOO", &capsule, &pobj, &iobj ) )
+	  return EXIT_FAILURE;
+
+	kernel = static_cast< const Kernel1D* >
+	  ( PyCapsule_GetPointer( capsule, KERNEL1D_CAPSULE ) );
+	if ( NULL == kernel )
+	  return EXIT_FAILURE;
+
+	if ( !convert_to_contig_array< DoubleArray >( pobj, &pars ) )
+	  return EXIT_FAILURE;
+
+	if ( kernel->npars != pars.get_size() ) {
+	  std::ostringstream err;
+	  err << kernel->name << ": expected " << kernel->npars
+	      << " parameters, got " << pars.get_size();
+	  PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+	  return EXIT_FAILURE;
+	}
+
+	int flag = PyObject_IsTrue( iobj );
+	if ( flag < 0 )
+	  return EXIT_FAILURE;
+	integrate = ( 1 == flag );
+	return EXIT_SUCCESS;
+
+      }
+
+      if ( PyFloat_Check( obj ) || PyLong_Check( obj ) ) {
+	value = PyFloat_AsDouble( obj );
+	return PyErr_Occurred() ? EXIT_FAILURE : EXIT_SUCCESS;
+      }
+
+      if ( !convert_to_contig_array< DoubleArray >( obj, &values ) )
+	return EXIT_FAILURE;
+
+      if ( values.get_size() != nelem ) {
+	std::ostringstream err;
+	err << "fused model leaf has " << values.get_size()
+	    << " elements, expected " << nelem;
+	PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+	return EXIT_FAILURE;
+      }
+
+      return EXIT_SUCCESS;
+
+    }
+
+    // Write the n values starting at element begin into out. The
+    // grids are contiguous and xhi is NULL for a point grid.
+    int eval( const double* xlo, const double* xhi, npy_intp begin,
+	      std::size_t n, double* out ) const {
+
+      if ( kernel ) {
+	if ( xhi && integrate )
+	  return kernel->integrated( pars, xlo + begin, xhi + begin, out, n );
+	return kernel->point( pars, xlo + begin, out, n );
+      }
+
+      if ( values )
+	std::copy( &values[0] + begin, &values[0] + begin + n, out );
+      else
+	std::fill( out, out + n, value );
+
+      return EXIT_SUCCESS;
+
+    }
+
+    const Kernel1D* kernel;
+    DoubleArray pars;
+    bool integrate;
+    double value;
+    DoubleArray values;
+
+  };
+
+
+  //
+  // Evaluate a fused1d program over the elements [begin, end) in
+  // chunks of FUSED_BLOCK elements. The bottom of the stack is the
+  // output array, so the only memory used besides the result is
+  // depth - 1 chunks per thread.
+  //
+  class FusedBlock1D {
+
+  public:
+
+    FusedBlock1D( const IntArray& prog, const std::vector< FusedLeaf >& l,
+		  npy_intp maxdepth, const double* lo, const double* hi,
+		  double* out )
+      : program( prog ), leaves( l ), depth( maxdepth ), xlo( lo ),
+	xhi( hi ), result( out ) { }
+
+    int operator()( npy_intp begin, npy_intp end ) const {
+
+      std::vector< double > stack( ( depth - 1 ) * FUSED_BLOCK );
+      std::vector< double* > slots( depth );
+
+      for ( npy_intp start = begin; start < end; start += FUSED_BLOCK ) {
+
+	std::size_t n = std::size_t( std::min( end - start, FUSED_BLOCK ) );
+	slots[ 0 ] = result + start;
+	for ( npy_intp ii = 1; ii < depth; ii++ )
+	  slots[ ii ] = &stack[ ( ii - 1 ) * FUSED_BLOCK ];
+
+	npy_intp top = 0;
+	for ( npy_intp ii = 0; ii < program.get_size(); ii++ ) {
+
+	  int op = program[ ii ];
+	  if ( op >= 0 ) {
+	    if ( EXIT_SUCCESS != leaves[ op ].eval( xlo, xhi, start, n,
+						    slots[ top ] ) )
+	      return EXIT_FAILURE;
+	    top++;
+	    continue;
+	  }
+
+	  double* rhs = slots[ top - 1 ];
+	  double* lhs = slots[ top - 2 ];
+	  switch ( op ) {
+	  case FUSED_NEGATIVE:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      rhs[ jj ] = -rhs[ jj ];
+	    continue;
+	  case FUSED_ABSOLUTE:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      rhs[ jj ] = std::fabs( rhs[ jj ] );
+	    continue;
+	  case FUSED_ADD:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      lhs[ jj ] += rhs[ jj ];
+	    break;
+	  case FUSED_SUBTRACT:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      lhs[ jj ] -= rhs[ jj ];
+	    break;
+	  case FUSED_MULTIPLY:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      lhs[ jj ] *= rhs[ jj ];
+	    break;
+	  case FUSED_DIVIDE:
+	    for ( std::size_t jj = 0; jj < n; jj++ )
+	      lhs[ jj ] /= rhs[ jj ];
+	    break;
+	  }
+	  top--;
+
+	}
+
+      }
+
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    const IntArray& program;
+    const std::vector< FusedLeaf >& leaves;
+    npy_intp depth;
+    const double* xlo;
+    const double* xhi;
+    double* result;
+
+  };
+
+
+  //
+  // Check that a fused1d program only refers to the nleaves leaves,
+  // uses known operations, and leaves a single value on the stack.
+  // The maximum stack depth is returned, or 0 if the program is
+  // invalid.
+  //
+  inline npy_intp check_fused_program( const IntArray& program,
+				       npy_intp nleaves )
+  {
+
+    npy_intp top = 0;
+    npy_intp depth = 0;
+
+    for ( npy_intp ii = 0; ii < program.get_size(); ii++ ) {
+
+      int op = program[ ii ];
+      if ( op >= nleaves || op < FUSED_ABSOLUTE )
+	return 0;
+
+      if ( op >= 0 )
+	top++;
+      else if ( op >= FUSED_DIVIDE )
+	top--;
+
+      // Every operation needs its operands on the stack
+      if ( top < 1 )
+	return 0;
+
+      depth = std::max( depth, top );
+
+    }
+
+    return ( 1 == top ) ? depth : 0;
+
+  }
+
+
+  //
+  // Evaluate an expression of compiled 1D models, constants, and
+  // arrays in a single pass over the grid, without creating an array
+  // for each term. The leaves are (kernel, pars, integrate) tuples,
+  // where kernel is returned by kernel1d, floats, or arrays matching
+  // the grid.
+  //
+  inline PyObject* fused1d( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    IntArray program;
+    PyObject* lobj = NULL;
+    DoubleArray xlo;
+    DoubleArray xhi;
+    int numcores = 0;
+
+    static char *kwlist[] = {(char*)"program", (char*)"leaves", (char*)"xlo",
+			     (char*)"xhi", (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&OO&|O&i", kwlist,
+				       CONVERTME( IntArray ), &program,
+				       &lobj,
+				       CONVERTME( DoubleArray ), &xlo,
+				       CONVERTME( DoubleArray ), &xhi,
+				       &numcores ) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    npy_intp nelem = xlo.get_size();
+
+    if ( xhi && ( xhi.get_size() != nelem ) ) {
+      std::ostringstream err;
+      err << "1D model evaluation input array sizes do not match, "
+	  << "xlo: " << nelem << " vs xhi: " << xhi.get_size();
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return NULL;
+    }
+
+    PyObject* seq = PySequence_Fast( lobj, "leaves must be a sequence" );
+    if ( NULL == seq )
+      return NULL;
+
+    npy_intp nleaves = PySequence_Fast_GET_SIZE( seq );
+    std::vector< FusedLeaf > leaves( nleaves );
+    for ( npy_intp ii = 0; ii < nleaves; ii++ ) {
+      PyObject* item = PySequence_Fast_GET_ITEM( seq, ii );
+      if ( EXIT_SUCCESS != leaves[ ii ].convert( item, nelem ) ) {
+	Py_DECREF( seq );
+	return NULL;
+      }
+      const Kernel1D* kernel = leaves[ ii ].kernel;
+      if ( kernel && xhi && leaves[ ii ].integrate &&
+	   NULL == kernel->integrated ) {
+	std::ostringstream err;
+	err << kernel->name << ": the model has no integrated form";
+	PyErr_SetString( PyExc_ValueError, err.str().c_str() );
+	Py_DECREF( seq );
+	return NULL;
+      }
+    }
+    Py_DECREF( seq );
+
+    npy_intp depth = check_fused_program( program, nleaves );
+    if ( 0 == depth ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"invalid fused program" );
+      return NULL;
+    }
+
+    DoubleArray result;
+    if ( EXIT_SUCCESS != result.create( xlo.get_ndim(), xlo.get_dims() ) )
+      return NULL;
+
+    if ( 0 == nelem )
+      return result.return_new_ref();
+
+    FusedBlock1D eval( program, leaves, depth, &xlo[0],
+		       xhi ? &xhi[0] : NULL, &result[0] );
+    if ( EXIT_SUCCESS != run_model( eval, nelem, numcores ) ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"model evaluation failed" );
+      return NULL;
+    }
+
+    return result.return_new_ref();
+
+  }
+
+
+}  }  /* namespace models, namespace sherpa */
+
+#define SHERPAMODELMOD(name, fctlist) \
+static struct PyModuleDef module##name = {\
+PyModuleDef_HEAD_INIT, \
 #name, \
 NULL, \
 -1, \
@@ -453,24 +1981,158 @@ PyMODINIT_FUNC PyInit_##name(void) { \
   sherpa::models::name< SherpaFloat, SherpaFloatArray >
 #endif
 
-#define _MODELFCTSPEC(name, ftype, npars) \
-  KWSPEC(name, (sherpa::models::ftype< SherpaFloatArray, SherpaFloat, npars, \
-                                       _MODELFCTPTR(name##_point), \
-                                       _MODELFCTPTR(name##_integrated) >))
+// The single-precision version of a kernel
+#ifndef _MODELFCTPTR_SINGLE
+#define _MODELFCTPTR_SINGLE(name) \
+  sherpa::models::name< SherpaSingle, SherpaSingleArray >
+#endif
+
+// Each model is registered with a double- and a single-precision
+// version, selected by the single keyword (see modelfct_precision).
+#define _MODELFCTPREC(name, dfunc, sfunc, hiindex) \
+  KWSPEC(name, (sherpa::models::modelfct_precision< dfunc, sfunc, \
+                                                    hiindex >))
 
-#define _MODELFCTSPEC_NOINT(name, ftype, intftype, npars) \
-  KWSPEC(name, \
-         (sherpa::models::ftype< SherpaFloatArray, SherpaFloat, npars, \
-                                 _MODELFCTPTR(name##_point), \
-                                 sherpa::models::intftype \
-                                   < _MODELFCTPTR(name##_point) > >))
+#define _MODELFCTINST(ftype, atype, dtype, ptr, name, npars) \
+  sherpa::models::ftype< atype, dtype, npars, ptr(name##_point), \
+                         ptr(name##_integrated) >
+
+#define _MODELFCTSPEC(name, ftype, npars) \
+  _MODELFCTPREC(name, \
+    (_MODELFCTINST(ftype, SherpaFloatArray, SherpaFloat, _MODELFCTPTR, \
+                   name, npars)), \
+    (_MODELFCTINST(ftype, SherpaSingleArray, SherpaSingle, \
+                   _MODELFCTPTR_SINGLE, name, npars)), -1)
+
+// 2D models without an analytic integral use the adaptive cubature,
+// integrating a block of pixels at a time (see integrated_image2d)
+#define _MODELFCTSPEC2D_NOINT(name, npars) \
+  _MODELFCTPREC(name, \
+    (sherpa::models::modelfct2d_image< SherpaFloatArray, SherpaFloat, npars, \
+       _MODELFCTPTR(name##_point), \
+       sherpa::models::integrated_model2d< _MODELFCTPTR(name##_point) >, \
+       sherpa::models::integrated_image2d< _MODELFCTPTR(name##_point) > >), \
+    (sherpa::models::modelfct2d< SherpaSingleArray, SherpaSingle, npars, \
+       _MODELFCTPTR_SINGLE(name##_point), \
+       sherpa::models::no_integrated2d< SherpaSingleArray, SherpaSingle > >), \
+    3)
+
+// Models which provide *_point_vec and *_integrated_vec kernels
+#define _MODELFCTINST_VEC(atype, dtype, ptr, name, npars) \
+  sherpa::models::modelfct1d< atype, dtype, npars, ptr(name##_point), \
+                              ptr(name##_integrated), \
+                              ptr(name##_point_vec), \
+                              ptr(name##_integrated_vec) >
+
+#define _MODELFCTSPEC_VEC(name, ftype, npars) \
+  _MODELFCTPREC(name, \
+    (_MODELFCTINST_VEC(SherpaFloatArray, SherpaFloat, _MODELFCTPTR, \
+                       name, npars)), \
+    (_MODELFCTINST_VEC(SherpaSingleArray, SherpaSingle, \
+                       _MODELFCTPTR_SINGLE, name, npars)), -1)
+
+// Models which also provide an *_antideriv_vec kernel, which is used to
+// integrate contiguous grids (see integrated_antideriv)
+#define _INTEGRATEDANTIDERIV(atype, dtype, ptr, name) \
+  sherpa::models::integrated_antideriv< atype, dtype, \
+                                        ptr(name##_antideriv_vec), \
+                                        ptr(name##_integrated_vec) >
+
+#define _MODELFCTINST_ANTIDERIV(atype, dtype, ptr, name, npars) \
+  sherpa::models::modelfct1d< atype, dtype, npars, ptr(name##_point), \
+                              ptr(name##_integrated), \
+                              ptr(name##_point_vec), \
+                              _INTEGRATEDANTIDERIV(atype, dtype, ptr, name) >
+
+// The single-precision version integrates each bin separately, since
+// the difference of the stored antiderivatives would lose too much
+// precision in the tails of the model.
+#define _MODELFCTSPEC_ANTIDERIV(name, npars) \
+  _MODELFCTPREC(name, \
+    (_MODELFCTINST_ANTIDERIV(SherpaFloatArray, SherpaFloat, _MODELFCTPTR, \
+                             name, npars)), \
+    (_MODELFCTINST_VEC(SherpaSingleArray, SherpaSingle, \
+                       _MODELFCTPTR_SINGLE, name, npars)), -1)
 
 #define MODELFCT1D(name, npars)		_MODELFCTSPEC(name, modelfct1d, npars)
+#define MODELFCT1D_VEC(name, npars)	_MODELFCTSPEC_VEC(name, modelfct1d, npars)
+#define MODELFCT1D_ANTIDERIV(name, npars) _MODELFCTSPEC_ANTIDERIV(name, npars)
 #define MODELFCT2D(name, npars)		_MODELFCTSPEC(name, modelfct2d, npars)
-#define MODELFCT1D_NOINT(name, npars) \
-  _MODELFCTSPEC_NOINT(name, modelfct1d, integrated_model1d, npars)
-#define MODELFCT2D_NOINT(name, npars) \
-  _MODELFCTSPEC_NOINT(name, modelfct2d, integrated_model2d, npars)
+// 1D models without an analytic integral can also be integrated with
+// a Gauss-Legendre rule, selected with intorder (see GaussLegendreBlock1D)
+#define _MODELFCTSPEC1D_NOINT(name, npars) \
+  _MODELFCTPREC(name, \
+    (sherpa::models::modelfct1d< SherpaFloatArray, SherpaFloat, npars, \
+       _MODELFCTPTR(name##_point), \
+       sherpa::models::integrated_model1d< _MODELFCTPTR(name##_point) >, \
+       sherpa::models::point_vec< SherpaFloatArray, SherpaFloat, \
+                                  _MODELFCTPTR(name##_point) >, \
+       sherpa::models::integrated_vec< SherpaFloatArray, SherpaFloat, \
+         sherpa::models::integrated_model1d< _MODELFCTPTR(name##_point) > >, \
+       true >), \
+    (sherpa::models::modelfct1d< SherpaSingleArray, SherpaSingle, npars, \
+       _MODELFCTPTR_SINGLE(name##_point), \
+       sherpa::models::no_integrated1d< SherpaSingleArray, SherpaSingle > >), \
+    2)
+
+#define MODELFCT1D_NOINT(name, npars)	_MODELFCTSPEC1D_NOINT(name, npars)
+#define MODELFCT2D_NOINT(name, npars)	_MODELFCTSPEC2D_NOINT(name, npars)
+
+// The derivatives of a model with respect to its parameters, which
+// are provided by the *_point_deriv and *_integrated_deriv kernels,
+// are made available as <name>_deriv. They are always calculated in
+// double precision.
+#define _MODELDERIVINST(name, ftype, npars) \
+  sherpa::models::ftype< SherpaFloatArray, SherpaFloat, npars, \
+                         _MODELFCTPTR(name##_point_deriv), \
+                         _MODELFCTPTR(name##_integrated_deriv) >
+
+#define _MODELDERIVSPEC(name, ftype, npars) \
+  _MODELFCTPREC(name##_deriv, (_MODELDERIVINST(name, ftype, npars)), \
+                (_MODELDERIVINST(name, ftype, npars)), -1)
+
+#define MODELDERIV1D(name, npars)	_MODELDERIVSPEC(name, modelderiv1d, npars)
+#define MODELDERIV2D(name, npars)	_MODELDERIVSPEC(name, modelderiv2d, npars)
+// 2D models which only provide *_point_deriv (see integrated_deriv2d)
+#define _MODELDERIVINST2D_NOINT(name, npars) \
+  sherpa::models::modelderiv2d< SherpaFloatArray, SherpaFloat, npars, \
+    _MODELFCTPTR(name##_point_deriv), \
+    sherpa::models::integrated_deriv2d< SherpaFloatArray, SherpaFloat, \
+      npars, _MODELFCTPTR(name##_point_deriv) > >
+
+#define MODELDERIV2D_NOINT(name, npars) \
+  _MODELFCTPREC(name##_deriv, (_MODELDERIVINST2D_NOINT(name, npars)), \
+                (_MODELDERIVINST2D_NOINT(name, npars)), -1)
+
+// The double-precision kernels of the 1D models which can be used by
+// fused1d are listed in a table of sherpa::models::Kernel1D entries,
+// which ends with KERNEL1D_END, and made available with MODELKERNELS1D.
+#define KERNEL1D(name, npars) \
+  { #name, npars, \
+    sherpa::models::point_vec< SherpaFloatArray, SherpaFloat, \
+                               _MODELFCTPTR(name##_point) >, \
+    sherpa::models::integrated_vec< SherpaFloatArray, SherpaFloat, \
+                                    _MODELFCTPTR(name##_integrated) > }
+
+#define KERNEL1D_VEC(name, npars) \
+  { #name, npars, _MODELFCTPTR(name##_point_vec), \
+    _MODELFCTPTR(name##_integrated_vec) }
+
+#define KERNEL1D_ANTIDERIV(name, npars) \
+  { #name, npars, _MODELFCTPTR(name##_point_vec), \
+    _INTEGRATEDANTIDERIV(SherpaFloatArray, SherpaFloat, _MODELFCTPTR, name) }
+
+#define KERNEL1D_NOINT(name, npars) \
+  { #name, npars, \
+    sherpa::models::point_vec< SherpaFloatArray, SherpaFloat, \
+                               _MODELFCTPTR(name##_point) >, NULL }
+
+#define KERNEL1D_END { NULL, 0, NULL, NULL }
+
+#define MODELKERNELS1D(table) \
+  KWSPEC(kernel1d, sherpa::models::kernel1d< table >)
+
+#define MODELFUSED1D KWSPEC(fused1d, sherpa::models::fused1d)
 
 #define MODSPEC_INT(name, func, doc) \
   { (char*)name, (PyCFunction)((PyCFunctionWithKeywords)func), METH_VARARGS|METH_KEYWORDS, \
@@ -21,6 +21,7 @@
 #define __sherpa_models_hh__
 
 #include <algorithm>
+#include <cstddef>
 #include <sherpa/utils.hh>
 #include <sherpa/constants.hh>
 
@@ -93,6 +94,72 @@ namespace sherpa { namespace models {
   }
 
 
+  //
+  // The *_vec kernels evaluate a model over n contiguous elements in
+  // one call. The parameters are checked once, before the loop, and
+  // the loop bodies are kept free of branches and function-pointer
+  // calls so that the compiler is able to vectorize them. They
+  // return EXIT_FAILURE if any element could not be evaluated, in
+  // which case the contents of val are undefined.
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int const1d_point_vec( const ConstArrayType& p, const DataType* x,
+				DataType* val, std::size_t n )
+  {
+
+    const DataType c0 = p[0];
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = c0;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int const1d_integrated_vec( const ConstArrayType& p,
+				     const DataType* xlo, const DataType* xhi,
+				     DataType* val, std::size_t n )
+  {
+
+    const DataType c0 = p[0];
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = c0 * ( xhi[ii] - xlo[ii] );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // The *_deriv kernels calculate the derivative of the model with
+  // respect to each parameter, in the order of p, storing them in
+  // grad. They fail for the same parameter values as the model.
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int const1d_point_deriv( const ConstArrayType& p, DataType x,
+				  DataType* grad )
+  {
+
+    (void)p;
+    (void)x;
+    grad[0] = 1.0;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int const1d_integrated_deriv( const ConstArrayType& p,
+				       DataType xlo, DataType xhi,
+				       DataType* grad )
+  {
+
+    (void)p;
+    grad[0] = xhi - xlo;
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int cos_point( const ConstArrayType& p, DataType x, DataType& val )
   {
@@ -340,6 +407,119 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int exp_point_vec( const ConstArrayType& p, const DataType* x,
+			    DataType* val, std::size_t n )
+  {
+
+    const DataType offset = p[0];
+    const DataType coeff = p[1];
+    const DataType ampl = p[2];
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = ampl * EXP( coeff * ( x[ii] - offset ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int exp_integrated_vec( const ConstArrayType& p,
+				 const DataType* xlo, const DataType* xhi,
+				 DataType* val, std::size_t n )
+  {
+
+    const DataType offset = p[0];
+    const DataType coeff = p[1];
+    const DataType ampl = p[2];
+
+    if ( coeff == 0.0 ) {
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = ampl * ( xhi[ii] - xlo[ii] );
+      return EXIT_SUCCESS;
+    }
+
+    const DataType scale = ampl / coeff;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = scale * ( EXP( coeff * ( xhi[ii] - offset ) ) -
+			  EXP( coeff * ( xlo[ii] - offset ) ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // The *_antideriv_vec kernels evaluate a scaled antiderivative F of
+  // the model, so that the integral over a bin is
+  // norm * ( F(xhi) - F(xlo) ). This lets contiguous grids share the
+  // evaluation at each bin edge (see integrated_antideriv in
+  // model_extension.hh). The scaling is applied after the difference,
+  // as in the *_integrated_vec kernels, so the results match them.
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int exp_antideriv_vec( const ConstArrayType& p, const DataType* x,
+				DataType* val, std::size_t n,
+				DataType& norm )
+  {
+
+    const DataType offset = p[0];
+    const DataType coeff = p[1];
+    const DataType ampl = p[2];
+
+    if ( coeff == 0.0 ) {
+      norm = ampl;
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = x[ii];
+      return EXIT_SUCCESS;
+    }
+
+    norm = ampl / coeff;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = EXP( coeff * ( x[ii] - offset ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int exp_point_deriv( const ConstArrayType& p, DataType x,
+			      DataType* grad )
+  {
+
+    DataType ex = EXP( p[1] * (x - p[0]) );
+    grad[0] = - p[2] * p[1] * ex;
+    grad[1] = p[2] * (x - p[0]) * ex;
+    grad[2] = ex;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int exp_integrated_deriv( const ConstArrayType& p,
+				   DataType xlo, DataType xhi,
+				   DataType* grad )
+  {
+
+    DataType dlo = xlo - p[0];
+    DataType dhi = xhi - p[0];
+
+    if ( p[1] == 0.0 ) {
+      grad[0] = 0.0;
+      grad[1] = 0.5 * p[2] * ( dhi * dhi - dlo * dlo );
+      grad[2] = xhi - xlo;
+      return EXIT_SUCCESS;
+    }
+
+    DataType e1 = EXP( p[1] * dlo );
+    DataType e2 = EXP( p[1] * dhi );
+    grad[0] = - p[2] * ( e2 - e1 );
+    grad[1] = p[2] * ( ( dhi * e2 - dlo * e1 ) - ( e2 - e1 ) / p[1] ) / p[1];
+    grad[2] = ( e2 - e1 ) / p[1];
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int exp10_point( const ConstArrayType& p, DataType x,
 			  DataType& val )
@@ -351,6 +531,71 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int exp10_point_vec( const ConstArrayType& p, const DataType* x,
+			      DataType* val, std::size_t n )
+  {
+
+    const DataType offset = p[0];
+    const DataType coeff = LOGTEN * p[1];
+    const DataType ampl = p[2];
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = ampl * EXP( coeff * ( x[ii] - offset ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int exp10_integrated_vec( const ConstArrayType& p,
+				   const DataType* xlo, const DataType* xhi,
+				   DataType* val, std::size_t n )
+  {
+
+    const DataType offset = p[0];
+    const DataType ampl = p[2];
+
+    if ( p[1] == 0.0 ) {
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = ampl * ( xhi[ii] - xlo[ii] );
+      return EXIT_SUCCESS;
+    }
+
+    const DataType coeff = LOGTEN * p[1];
+    const DataType scale = ampl / coeff;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = scale * ( EXP( coeff * ( xhi[ii] - offset ) ) -
+			  EXP( coeff * ( xlo[ii] - offset ) ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int exp10_antideriv_vec( const ConstArrayType& p, const DataType* x,
+				  DataType* val, std::size_t n,
+				  DataType& norm )
+  {
+
+    const DataType offset = p[0];
+    const DataType ampl = p[2];
+
+    if ( p[1] == 0.0 ) {
+      norm = ampl;
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = x[ii];
+      return EXIT_SUCCESS;
+    }
+
+    const DataType coeff = LOGTEN * p[1];
+    norm = ampl / coeff;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = EXP( coeff * ( x[ii] - offset ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int exp10_integrated( const ConstArrayType& p,
 			       DataType xlo, DataType xhi, DataType& val )
@@ -414,6 +659,114 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss1d_point_vec( const ConstArrayType& p, const DataType* x,
+				DataType* val, std::size_t n )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = - GFACTOR / ( p[0] * p[0] );
+    const DataType pos = p[1];
+    const DataType ampl = p[2];
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      DataType dx = x[ii] - pos;
+      val[ii] = ampl * EXP( scale * dx * dx );
+    }
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss1d_integrated_vec( const ConstArrayType& p,
+				     const DataType* xlo, const DataType* xhi,
+				     DataType* val, std::size_t n )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = SQRT_GFACTOR / p[0];
+    const DataType pos = p[1];
+    const DataType norm = p[2] * p[0] * SQRT_PI / ( 2. * SQRT_GFACTOR );
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = norm * ( ERF( scale * ( xhi[ii] - pos ) ) -
+			 ERF( scale * ( xlo[ii] - pos ) ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss1d_antideriv_vec( const ConstArrayType& p,
+				    const DataType* x, DataType* val,
+				    std::size_t n, DataType& norm )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = SQRT_GFACTOR / p[0];
+    const DataType pos = p[1];
+    norm = p[2] * p[0] * SQRT_PI / ( 2. * SQRT_GFACTOR );
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = ERF( scale * ( x[ii] - pos ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss1d_point_deriv( const ConstArrayType& p, DataType x,
+				  DataType* grad )
+  {
+
+    if ( p[0] == 0.0 )
+      return EXIT_FAILURE;
+
+    DataType dx = x - p[1];
+    DataType ex = EXP( - GFACTOR * dx * dx / p[0] / p[0] );
+    DataType scale = 2.0 * GFACTOR * p[2] * ex / ( p[0] * p[0] );
+    grad[0] = scale * dx * dx / p[0];
+    grad[1] = scale * dx;
+    grad[2] = ex;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss1d_integrated_deriv( const ConstArrayType& p,
+				       DataType xlo, DataType xhi,
+				       DataType* grad )
+  {
+
+    if ( p[0] == 0.0 )
+      return EXIT_FAILURE;
+
+    DataType z2 = SQRT_GFACTOR * ( xhi - p[1] ) / p[0];
+    DataType z1 = SQRT_GFACTOR * ( xlo - p[1] ) / p[0];
+    DataType e2 = EXP( - z2 * z2 );
+    DataType e1 = EXP( - z1 * z1 );
+    DataType norm = SQRT_PI / ( 2. * SQRT_GFACTOR );
+    DataType diff = ERF(z2) - ERF(z1);
+
+    grad[0] = p[2] * norm * ( diff - 2.0 * ( z2 * e2 - z1 * e1 ) / SQRT_PI );
+    grad[1] = p[2] * ( e1 - e2 );
+    grad[2] = p[0] * norm * diff;
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int log_point( const ConstArrayType& p, DataType x, DataType& val )
   {
@@ -528,6 +881,71 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int ngauss1d_point_vec( const ConstArrayType& p, const DataType* x,
+				 DataType* val, std::size_t n )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = - GFACTOR / ( p[0] * p[0] );
+    const DataType pos = p[1];
+    const DataType ampl = p[2] / ( SQRT(PI/GFACTOR) * p[0] );
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      DataType dx = x[ii] - pos;
+      val[ii] = ampl * EXP( scale * dx * dx );
+    }
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int ngauss1d_integrated_vec( const ConstArrayType& p,
+				      const DataType* xlo, const DataType* xhi,
+				      DataType* val, std::size_t n )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = SQRT_GFACTOR / p[0];
+    const DataType pos = p[1];
+    const DataType norm = p[2] / 2.0;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = norm * ( ERF( scale * ( xhi[ii] - pos ) ) -
+			 ERF( scale * ( xlo[ii] - pos ) ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int ngauss1d_antideriv_vec( const ConstArrayType& p,
+				     const DataType* x, DataType* val,
+				     std::size_t n, DataType& norm )
+  {
+
+    if ( p[0] == 0.0 ) {
+      // val = NAN;
+      return EXIT_FAILURE;
+    }
+
+    const DataType scale = SQRT_GFACTOR / p[0];
+    const DataType pos = p[1];
+    norm = p[2] / 2.0;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = ERF( scale * ( x[ii] - pos ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int poisson_point( const ConstArrayType& p, DataType x,
 			    DataType& val )
@@ -592,6 +1010,57 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int poly1d_point_vec( const ConstArrayType& p, const DataType* x,
+			       DataType* val, std::size_t n )
+  {
+
+    DataType c[9];
+    for ( int ii = 0; ii < 9; ii++ )
+      c[ii] = p[ii];
+    const DataType offset = p[9];
+
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      DataType xtemp = x[ii] - offset;
+      DataType retval = c[8];
+      for ( int jj = 7; jj >= 0; jj-- )
+	retval = retval*xtemp + c[jj];
+      val[ii] = retval;
+    }
+    return EXIT_SUCCESS;
+
+  }
+
+
+  // The integral is evaluated as the difference of the antiderivative,
+  // using Horner's rule rather than a POW call per term.
+  template <typename DataType, typename ConstArrayType>
+  inline int poly1d_integrated_vec( const ConstArrayType& p,
+				    const DataType* xlo, const DataType* xhi,
+				    DataType* val, std::size_t n )
+  {
+
+    DataType c[9];
+    for ( int ii = 0; ii < 9; ii++ )
+      c[ii] = p[ii] / DataType(ii + 1);
+    const DataType offset = p[9];
+
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      DataType xtemp1 = xlo[ii] - offset;
+      DataType xtemp2 = xhi[ii] - offset;
+      DataType retval1 = c[8];
+      DataType retval2 = c[8];
+      for ( int jj = 7; jj >= 0; jj-- ) {
+	retval1 = retval1*xtemp1 + c[jj];
+	retval2 = retval2*xtemp2 + c[jj];
+      }
+      val[ii] = retval2*xtemp2 - retval1*xtemp1;
+    }
+    return EXIT_SUCCESS;
+
+  }
+
+
   //
   //                                    /  x \(- p[0])
   //                               p[2] |----|
@@ -647,6 +1116,139 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int powlaw_point_vec( const ConstArrayType& p, const DataType* x,
+			       DataType* val, std::size_t n )
+  {
+
+    const DataType gamma = - p[0];
+    const DataType ref = p[1];
+    const DataType ampl = p[2];
+
+    // x must be zero or greater; count the failures rather than
+    // branching so the loop can still be vectorized.
+    std::size_t nbad = 0;
+    for ( std::size_t ii = 0; ii < n; ii++ ) {
+      nbad += ( x[ii] < 0.0 );
+      val[ii] = ampl * POW( x[ii] / ref, gamma );
+    }
+
+    return ( 0 == nbad ) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int powlaw_integrated_vec( const ConstArrayType& p,
+				    const DataType* xlo, const DataType* xhi,
+				    DataType* val, std::size_t n )
+  {
+
+    std::size_t nbad = 0;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      nbad += ( xlo[ii] < 0.0 );
+    if ( 0 != nbad )
+      return EXIT_FAILURE;
+
+    // A gamma within 1e-10 of 1 is treated as 1, as PowLaw1D does, to
+    // avoid the loss of precision in pow( x, 1 - gamma ).
+    const DataType ampl = p[2];
+    if ( 0 == sao_fcmp( p[0], 1.0, 1.0e-10 ) ) {
+      // Stub in Sherpa minimum value for xlo == 0 so we can take its log
+      const DataType norm = ampl * p[1];
+      const DataType xmin = SMP_MIN;
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = norm * ( LOG(xhi[ii]) - LOG(std::max(xlo[ii], xmin)) );
+      return EXIT_SUCCESS;
+    }
+
+    const DataType index = 1.0 - p[0];
+    const DataType norm = ampl / POW( p[1], -p[0] ) / index;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = norm * ( POW( xhi[ii], index ) - POW( xlo[ii], index ) );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int powlaw_antideriv_vec( const ConstArrayType& p, const DataType* x,
+				   DataType* val, std::size_t n,
+				   DataType& norm )
+  {
+
+    std::size_t nbad = 0;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      nbad += ( x[ii] < 0.0 );
+    if ( 0 != nbad )
+      return EXIT_FAILURE;
+
+    const DataType ampl = p[2];
+    if ( 0 == sao_fcmp( p[0], 1.0, 1.0e-10 ) ) {
+      // Use the same minimum value as powlaw_integrated_vec
+      norm = ampl * p[1];
+      const DataType xmin = SMP_MIN;
+      for ( std::size_t ii = 0; ii < n; ii++ )
+	val[ii] = LOG( std::max( x[ii], xmin ) );
+      return EXIT_SUCCESS;
+    }
+
+    const DataType index = 1.0 - p[0];
+    norm = ampl / POW( p[1], -p[0] ) / index;
+    for ( std::size_t ii = 0; ii < n; ii++ )
+      val[ii] = POW( x[ii], index );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int powlaw_point_deriv( const ConstArrayType& p, DataType x,
+				 DataType* grad )
+  {
+
+    if ( x < 0.0 )
+      return EXIT_FAILURE;
+
+    DataType shape = POW( x / p[1], - p[0] );
+    DataType val = p[2] * shape;
+    grad[0] = x > 0.0 ? - val * LOG( x / p[1] ) : 0.0;
+    grad[1] = p[0] * val / p[1];
+    grad[2] = shape;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  template <typename DataType, typename ConstArrayType>
+  inline int powlaw_integrated_deriv( const ConstArrayType& p,
+				      DataType xlo, DataType xhi,
+				      DataType* grad )
+  {
+
+    if ( xlo < 0.0 )
+      return EXIT_FAILURE;
+
+    // Use the same minimum value for xlo as powlaw_integrated
+    if ( p[0] == 1.0 && xlo == 0.0 )
+      xlo = SMP_MIN;
+
+    DataType seg, dseg;
+    if ( EXIT_SUCCESS != sherpa::utils::powlaw_segment( p[0], xlo, xhi,
+							 seg, dseg ) )
+      return EXIT_FAILURE;
+
+    // model = ampl * ref^gamma * seg
+    DataType norm = POW( p[1], p[0] );
+    DataType val = p[2] * norm * seg;
+    grad[0] = val * LOG( p[1] ) + p[2] * norm * dseg;
+    grad[1] = p[0] * val / p[1];
+    grad[2] = norm * seg;
+    return EXIT_SUCCESS;
+
+  }
+
+
   //
   //                                    /  x \ - p[1] - p[2] * log10(x/p[0])
   //                               p[3] |----|
@@ -959,6 +1561,31 @@ namespace sherpa { namespace models {
 
   }
 
+
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss2d_point_deriv( const ConstArrayType& p,
+				  DataType x0, DataType x1, DataType* grad )
+  {
+
+    DataType r = 0.0;
+
+    if ( p[0] == 0.0 ||
+	 EXIT_SUCCESS != sherpa::utils::radius2(p, x0, x1, r) ||
+	 EXIT_SUCCESS != sherpa::utils::radius2_deriv(p, x0, x1, grad + 1) )
+      return EXIT_FAILURE;
+
+    DataType scale = GFACTOR / ( p[0] * p[0] );
+    DataType ex = EXP( - r * scale );
+    DataType val = p[5] * ex;
+    grad[0] = 2.0 * val * r * scale / p[0];
+    for ( int ii = 1; ii < 5; ii++ )
+      grad[ii] *= - val * scale;
+    grad[5] = ex;
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int sigmagauss2d_point( const ConstArrayType& p,
 				 DataType x0, DataType x1, DataType& val ) {
@@ -977,63 +1604,173 @@ namespace sherpa { namespace models {
   }
 
 
-  // FIXME: work the analytic part of this back in
-  /*
+  //
+  // erf(z2) - erf(z1), switching to erfc when both arguments lie in
+  // the same tail so that the difference does not cancel.
+  //
+  template <typename DataType>
+  inline DataType erf_diff( DataType z1, DataType z2 )
+  {
+
+    if ( z1 > 0.0 && z2 > 0.0 )
+      return ERFC(z1) - ERFC(z2);
+    if ( z1 < 0.0 && z2 < 0.0 )
+      return ERFC(-z2) - ERFC(-z1);
+    return ERF(z2) - ERF(z1);
+
+  }
+
+
+  //
+  // The integral of exp(-(a*dx^2 + 2*b*dx*dy + c*dy^2)) over the
+  // rectangle [dx1,dx2] x [dy1,dy2], where a > 0, c > 0 and a*c > b^2.
+  //
+  // When the quadratic form is separable (b == 0) this is the product
+  // of two erf differences. Otherwise the dy integral is done
+  // analytically, leaving a smooth one-dimensional integrand in dx
+  // which is evaluated with an 8-point Gauss-Legendre rule on panels no
+  // wider than the scale over which the integrand changes. The dx
+  // range is first clipped to GAUSS2D_NSIGMA times the width of the
+  // marginal Gaussian, beyond which the integrand is below 1e-16 of its
+  // peak.
+  //
+  const double GAUSS2D_NSIGMA = 6.0;
+  const int GAUSS2D_MAX_PANELS = 64;
+
+  template <typename DataType>
+  inline DataType gauss2d_rect( DataType a, DataType b, DataType c,
+				DataType dx1, DataType dx2,
+				DataType dy1, DataType dy2 )
+  {
+
+    static const DataType nodes[] = { 0.1834346424956498,
+				      0.5255324099163290,
+				      0.7966664774136267,
+				      0.9602898564975363 };
+    static const DataType weights[] = { 0.3626837833783620,
+					0.3137066458778873,
+					0.2223810344533745,
+					0.1012285362903763 };
+
+    DataType sqrta = SQRT(a);
+    DataType sqrtc = SQRT(c);
+    DataType yscale = SQRT_PI / ( 2.0 * sqrtc );
+
+    // rotations by a multiple of pi/2 leave rounding noise in b
+    if ( std::fabs( b ) <= 1e-14 * sqrta * sqrtc )
+      return SQRT_PI / ( 2.0 * sqrta ) * erf_diff( sqrta * dx1, sqrta * dx2 )
+	* yscale * erf_diff( sqrtc * dy1, sqrtc * dy2 );
+
+    // exp(-Q) = exp(-c*(dy + b*dx/c)^2) * exp(-d*dx^2)
+    DataType d = a - b * b / c;
+    DataType sqrtd = SQRT(d);
+    DataType shift = b / c;
+
+    DataType lim = GAUSS2D_NSIGMA / sqrtd;
+    DataType lo = std::max( std::min( dx1, dx2 ), -lim );
+    DataType hi = std::min( std::max( dx1, dx2 ), lim );
+    if ( !( lo < hi ) )
+      return 0.0;
+
+    DataType scale = std::max( sqrtd, std::fabs( b ) / sqrtc );
+    int npanels = int( std::ceil( ( hi - lo ) * scale ) );
+    npanels = std::max( 1, std::min( npanels, GAUSS2D_MAX_PANELS ) );
+    DataType half = ( hi - lo ) / ( 2.0 * npanels );
+
+    DataType sum = 0.0;
+    for ( int ii = 0; ii < npanels; ii++ ) {
+      DataType mid = lo + ( 2 * ii + 1 ) * half;
+      for ( int jj = 0; jj < 4; jj++ ) {
+	for ( int sign = -1; sign <= 1; sign += 2 ) {
+	  DataType dx = mid + sign * half * nodes[ jj ];
+	  DataType off = shift * dx;
+	  sum += weights[ jj ] * EXP( -d * dx * dx ) *
+	    erf_diff( sqrtc * ( dy1 + off ), sqrtc * ( dy2 + off ) );
+	}
+      }
+    }
+
+    if ( dx2 < dx1 )
+      sum = -sum;
+    return sum * half * yscale;
+
+  }
+
+
+  //
+  // Convert the gauss2d/ngauss2d parameters into the coefficients of
+  // GFACTOR*r^2/fwhm^2 written as a*dx^2 + 2*b*dx*dy + c*dy^2 (see
+  // sherpa::utils::radius2).
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int gauss2d_coeffs( const ConstArrayType& p,
+			     DataType& a, DataType& b, DataType& c )
+  {
+
+    if ( 0.0 == p[0] )
+      return EXIT_FAILURE;
+
+    DataType scale = GFACTOR / ( p[0] * p[0] );
+    if ( 0.0 == p[3] ) {
+      a = c = scale;
+      b = 0.0;
+      return EXIT_SUCCESS;
+    }
+    if ( 1.0 == p[3] )
+      return EXIT_FAILURE;
+
+    DataType ellip2 = ( 1.0 - p[3] ) * ( 1.0 - p[3] );
+    DataType cosTheta = COS(p[4]);
+    DataType sinTheta = SIN(p[4]);
+    a = scale * ( cosTheta * cosTheta + sinTheta * sinTheta / ellip2 );
+    c = scale * ( sinTheta * sinTheta + cosTheta * cosTheta / ellip2 );
+    b = scale * cosTheta * sinTheta * ( 1.0 - 1.0 / ellip2 );
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int gauss2d_integrated( const ConstArrayType& p,
 				 DataType x0lo, DataType x0hi,
 				 DataType x1lo, DataType x1hi, DataType& val )
   {
 
-    if ( p[3] == 0 ) {
-      if ( 0 == p[0] ) {
-	return EXIT_FAILURE;
-      } else {
-	DataType prefix = p[5]*p[0]*p[0]*PI/(4.0*GFACTOR);
-	DataType zx2 = SQRT_GFACTOR*((x0hi-p[1])/p[0]);
-	DataType zx1 = SQRT_GFACTOR*((x0lo-p[1])/p[0]);
-	DataType zy2 = SQRT_GFACTOR*((x1hi-p[2])/p[0]);
-	DataType zy1 = SQRT_GFACTOR*((x1lo-p[2])/p[0]);
-	val = prefix*(ERF(zx2)-ERF(zx1))*(ERF(zy2)-ERF(zy1));
-	return EXIT_SUCCESS;
-      }
-    } else {
-      DataType lolft;
-      DataType lorgt;
-      DataType hilft;
-      DataType hirgt;
+    DataType a, b, c;
+    if ( EXIT_SUCCESS != gauss2d_coeffs( p, a, b, c ) )
+      return EXIT_FAILURE;
 
-      if( EXIT_SUCCESS != gauss2d_point(p,x0lo,x1lo, lolft)) {
-	return EXIT_FAILURE;
-      }
+    val = p[5] * gauss2d_rect( a, b, c, x0lo - p[1], x0hi - p[1],
+			       x1lo - p[2], x1hi - p[2] );
+    return EXIT_SUCCESS;
 
-      if( EXIT_SUCCESS != gauss2d_point(p,x0hi,x1lo, lorgt)) {
-	return EXIT_FAILURE;
-      }
+  }
 
-      if( EXIT_SUCCESS != gauss2d_point(p,x0lo,x1hi, hilft)) {
-	return EXIT_FAILURE;
-      }
 
-      if( EXIT_SUCCESS != gauss2d_point(p,x0hi,x1hi, hirgt)) {
-	return EXIT_FAILURE;
-      }
-      if( EXIT_SUCCESS !=
-	  sherpa::utils::numerical_integration2d
-	  ( gauss2d_point< DataType, ConstArrayType >,
-	    p, x0lo, x0hi, x1lo, x1hi, lolft, lorgt,
-	    hilft, hirgt, val )) {
-	return EXIT_FAILURE;
-      }
-      else
-	return EXIT_SUCCESS;
-    }
+  template <typename DataType, typename ConstArrayType>
+  inline int sigmagauss2d_integrated( const ConstArrayType& p,
+				      DataType x0lo, DataType x0hi,
+				      DataType x1lo, DataType x1hi,
+				      DataType& val )
+  {
 
-    val = 0.0;
+    if ( 0 == p[0] || 0 == p[1] )
+      return EXIT_FAILURE;
+
+    // r^2 / 2, with r^2 from sherpa::utils::sigmaradius2
+    DataType ia = 0.5 / ( p[0] * p[0] );
+    DataType ib = 0.5 / ( p[1] * p[1] );
+    DataType cosTheta = COS(p[4]);
+    DataType sinTheta = SIN(p[4]);
+    DataType a = cosTheta * cosTheta * ia + sinTheta * sinTheta * ib;
+    DataType c = sinTheta * sinTheta * ia + cosTheta * cosTheta * ib;
+    DataType b = cosTheta * sinTheta * ( ia - ib );
+
+    val = p[5] * gauss2d_rect( a, b, c, x0lo - p[2], x0hi - p[2],
+			       x1lo - p[3], x1hi - p[3] );
     return EXIT_SUCCESS;
 
   }
-  */
 
 
   template <typename DataType, typename ConstArrayType>
@@ -1057,6 +1794,24 @@ namespace sherpa { namespace models {
   }
 
 
+  template <typename DataType, typename ConstArrayType>
+  inline int ngauss2d_integrated( const ConstArrayType& p,
+				  DataType x0lo, DataType x0hi,
+				  DataType x1lo, DataType x1hi, DataType& val )
+  {
+
+    DataType a, b, c;
+    if ( EXIT_SUCCESS != gauss2d_coeffs( p, a, b, c ) )
+      return EXIT_FAILURE;
+
+    DataType norm = (PI/GFACTOR)*p[0]*p[0]*SQRT(1.0 - (p[3]*p[3]));
+    val = (p[5]/norm) * gauss2d_rect( a, b, c, x0lo - p[1], x0hi - p[1],
+				      x1lo - p[2], x1hi - p[2] );
+    return EXIT_SUCCESS;
+
+  }
+
+
   template <typename DataType, typename ConstArrayType>
   inline int poly2d_point( const ConstArrayType& p,
 			   DataType x0, DataType x1, DataType& val )
@@ -0,0 +1,137 @@
+//
+//  Copyright (C) 2024  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef __sherpa_native_objective_hh__
+#define __sherpa_native_objective_hh__
+
+#include <Python.h>
+
+#include <cstdlib>
+
+//
+// The name of the capsules that hold a NativeObjective.
+//
+#define SHERPA_NATIVE_OBJECTIVE "sherpa.native_objective"
+
+namespace sherpa {
+
+  //
+  // An objective function that the optimizers in
+  // sherpa.optmethods._saoopt can call directly, rather than calling
+  // back into Python for each evaluation. It sets fval to the
+  // statistic for the npar parameter values in pars and, when fvec is
+  // not NULL, fills in the mfct per-bin values (the residuals used by
+  // the Levenberg-Marquardt methods). It returns EXIT_SUCCESS or
+  // EXIT_FAILURE.
+  //
+  // The function is called with the GIL released, so it must not use
+  // the Python C API, and it may be called from several threads at
+  // once, so any change to the data pointed to by ctx must be
+  // synchronized.
+  //
+  typedef int (*native_objective_fct)( void* ctx, int npar,
+                                       const double* pars, int mfct,
+                                       double* fvec, double& fval );
+
+  struct NativeObjective {
+
+    native_objective_fct fct;
+    void* ctx;
+    int mfct;
+    void (*free_ctx)( void* ctx );
+
+  };
+
+  inline void native_objective_destructor( PyObject* capsule ) {
+
+    NativeObjective* obj = static_cast< NativeObjective* >
+      ( PyCapsule_GetPointer( capsule, SHERPA_NATIVE_OBJECTIVE ) );
+    if ( NULL == obj )
+      return;
+
+    if ( obj->free_ctx )
+      obj->free_ctx( obj->ctx );
+    delete obj;
+
+  }
+
+  //
+  // Wrap the objective in a capsule, for use from Python. The capsule
+  // owns ctx, which is released with free_ctx (when not NULL) once the
+  // capsule is deleted.
+  //
+  inline PyObject* native_objective_capsule( native_objective_fct fct,
+                                             void* ctx, int mfct,
+                                             void (*free_ctx)( void* ) ) {
+
+    NativeObjective* obj = new NativeObjective;
+    obj->fct = fct;
+    obj->ctx = ctx;
+    obj->mfct = mfct;
+    obj->free_ctx = free_ctx;
+
+    PyObject* capsule = PyCapsule_New( obj, SHERPA_NATIVE_OBJECTIVE,
+                                       native_objective_destructor );
+    if ( NULL == capsule ) {
+      if ( free_ctx )
+        free_ctx( ctx );
+      delete obj;
+    }
+    return capsule;
+
+  }
+
+  //
+  // The objective held by obj, or NULL (with no error set) when obj is
+  // not a native-objective capsule.
+  //
+  inline NativeObjective* get_native_objective( PyObject* obj ) {
+
+    if ( !PyCapsule_IsValid( obj, SHERPA_NATIVE_OBJECTIVE ) )
+      return NULL;
+
+    return static_cast< NativeObjective* >
+      ( PyCapsule_GetPointer( obj, SHERPA_NATIVE_OBJECTIVE ) );
+
+  }
+
+  //
+  // Release the GIL for the lifetime of the object.
+  //
+  class NativeThreads {
+
+  public:
+
+    NativeThreads() : save( PyEval_SaveThread() ) { }
+
+    ~NativeThreads() { PyEval_RestoreThread( save ); }
+
+  private:
+
+    PyThreadState* save;
+
+    NativeThreads( NativeThreads const& );
+    NativeThreads& operator=( NativeThreads const& );
+
+  };
+
+}  /* namespace sherpa */
+
+
+#endif /* __sherpa_native_objective_hh__ */
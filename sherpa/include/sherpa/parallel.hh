@@ -0,0 +1,127 @@
+//
+//  Copyright (C) 2024
+//  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef __sherpa_parallel_hh__
+#define __sherpa_parallel_hh__
+
+#include <algorithm>
+#include <cstdlib>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace sherpa { namespace parallel {
+
+  //
+  // Run func( begin, end ) for a single block, recording the return
+  // value. Exceptions must not escape a std::thread, so they are
+  // reported as a failure.
+  //
+  template <typename IndexType, typename Func>
+  class Block {
+
+  public:
+
+    Block( Func& f, IndexType b, IndexType e, int& s )
+      : func( f ), begin( b ), end( e ), status( s ) { }
+
+    void operator()() {
+      try {
+	status = func( begin, end );
+      } catch ( ... ) {
+	status = EXIT_FAILURE;
+      }
+    }
+
+  private:
+
+    Func& func;
+    IndexType begin;
+    IndexType end;
+    int& status;
+
+  };
+
+
+  //
+  // Split the range [0, nelem) into at most nthreads contiguous blocks
+  // of at least minblock elements, and call func( begin, end ) on each
+  // block in its own thread. The calling thread evaluates the first
+  // block. The blocks depend only on nelem, nthreads, and minblock, so
+  // the same inputs always produce the same partition.
+  //
+  // func must return EXIT_SUCCESS or EXIT_FAILURE, must not touch any
+  // Python object (the caller is expected to have released the GIL),
+  // and must be safe to call concurrently on disjoint blocks. If a
+  // thread can not be started the block is evaluated by the calling
+  // thread instead.
+  //
+  template <typename IndexType, typename Func>
+  int parallel_for( IndexType nelem, int nthreads, Func& func,
+		    IndexType minblock=1 )
+  {
+
+    if ( minblock < 1 )
+      minblock = 1;
+
+    if ( IndexType( nthreads ) > nelem / minblock )
+      nthreads = int( nelem / minblock );
+
+    if ( nthreads < 2 )
+      return func( IndexType( 0 ), nelem );
+
+    IndexType blocksize = ( nelem + nthreads - 1 ) / nthreads;
+
+    std::vector< int > status( nthreads, EXIT_SUCCESS );
+    std::vector< std::thread > workers;
+    workers.reserve( nthreads - 1 );
+
+    for ( int ii = 1; ii < nthreads; ii++ ) {
+      IndexType begin = std::min( ii * blocksize, nelem );
+      IndexType end = std::min( begin + blocksize, nelem );
+      Block< IndexType, Func > block( func, begin, end, status[ ii ] );
+      try {
+	workers.push_back( std::thread( block ) );
+      } catch ( std::system_error& ) {
+	block();
+      }
+    }
+
+    Block< IndexType, Func > first( func, IndexType( 0 ),
+				    std::min( blocksize, nelem ),
+				    status[ 0 ] );
+    first();
+
+    for ( std::size_t ii = 0; ii < workers.size(); ii++ )
+      workers[ ii ].join();
+
+    for ( int ii = 0; ii < nthreads; ii++ )
+      if ( EXIT_SUCCESS != status[ ii ] )
+	return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+
+  }
+
+
+}  }  /* namespace parallel, namespace sherpa */
+
+
+#endif /* __sherpa_parallel_hh__ */
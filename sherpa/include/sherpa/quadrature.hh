@@ -0,0 +1,93 @@
+//
+//  Copyright (C) 2024
+//  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#ifndef __sherpa_quadrature_hh__
+#define __sherpa_quadrature_hh__
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace sherpa { namespace quadrature {
+
+  //
+  // Fill nodes and weights with the order-point Gauss-Legendre rule on
+  // [-1, 1], in increasing order of the node. The nodes are found by
+  // Newton iteration on the Legendre polynomial, starting from the
+  // Tricomi approximation, so any order can be used.
+  //
+  inline int gauss_legendre( int order, std::vector< double >& nodes,
+			     std::vector< double >& weights )
+  {
+
+    if ( order < 1 )
+      return EXIT_FAILURE;
+
+    nodes.resize( order );
+    weights.resize( order );
+
+    const double pi = 3.14159265358979323846;
+    const double eps = 4.0 * std::numeric_limits< double >::epsilon();
+
+    // The rule is symmetric, so only half the roots are needed.
+    int nroots = ( order + 1 ) / 2;
+    for ( int ii = 0; ii < nroots; ii++ ) {
+
+      double x = std::cos( pi * ( ii + 0.75 ) / ( order + 0.5 ) );
+      double deriv = 1.0;
+
+      for ( int iter = 0; iter < 100; iter++ ) {
+
+	// P_n(x) by the three-term recurrence
+	double p0 = 1.0;
+	double p1 = 0.0;
+	for ( int jj = 1; jj <= order; jj++ ) {
+	  double p2 = p1;
+	  p1 = p0;
+	  p0 = ( ( 2.0 * jj - 1.0 ) * x * p1 - ( jj - 1.0 ) * p2 ) / jj;
+	}
+
+	deriv = order * ( x * p0 - p1 ) / ( x * x - 1.0 );
+	double dx = p0 / deriv;
+	x -= dx;
+	if ( std::fabs( dx ) <= eps )
+	  break;
+
+      }
+
+      double w = 2.0 / ( ( 1.0 - x * x ) * deriv * deriv );
+      nodes[ ii ] = -x;
+      nodes[ order - 1 - ii ] = x;
+      weights[ ii ] = weights[ order - 1 - ii ] = w;
+
+    }
+
+    if ( order % 2 )
+      nodes[ order / 2 ] = 0.0;
+
+    return EXIT_SUCCESS;
+
+  }
+
+}  }  /* namespace quadrature, namespace sherpa */
+
+
+#endif /* __sherpa_quadrature_hh__ */
@@ -21,8 +21,10 @@
 #define __sherpa_stat_extension_hh__
 
 #include <sherpa/extension.hh>
+#include <sherpa/utils.hh>
 
 #include <sstream>
+#include <vector>
 
 namespace sherpa { namespace stats {
 
@@ -53,6 +55,218 @@ namespace sherpa { namespace stats {
 
   }
 
+  static int check_numcores( int numcores )
+  {
+
+    if ( numcores < 0 ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"numcores must be 0 or a positive integer" );
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+  //
+  // With numcores of 0 the statistic is calculated on the calling
+  // thread with the GIL held, otherwise the GIL is released while the
+  // object exists and the bins are split across numcores threads.
+  //
+  class StatThreads {
+
+  public:
+
+    explicit StatThreads( int numcores )
+      : save( numcores > 0 ? PyEval_SaveThread() : NULL ) { }
+
+    ~StatThreads() {
+      if ( save )
+	PyEval_RestoreThread( save );
+    }
+
+  private:
+
+    PyThreadState* save;
+
+  };
+
+  //
+  // The per-dataset arrays for the *_sets routines: a sequence with an
+  // array for each data set. With convert_or_none the argument, or an
+  // element of the sequence, can be None (the array is then not set).
+  //
+  template <typename ArrayType>
+  class ArraySets {
+
+  public:
+
+    ArraySets() : given( false ) { }
+
+    static int convert( PyObject* obj, void* dest_addr ) {
+      return static_cast< ArraySets* >( dest_addr )->init( obj, false );
+    }
+
+    static int convert_or_none( PyObject* obj, void* dest_addr ) {
+      return static_cast< ArraySets* >( dest_addr )->init( obj, true );
+    }
+
+    // Does the number of arrays match nsets? When the argument was
+    // None nsets unset arrays are created.
+    bool check_size( npy_intp nsets ) {
+      if ( !given )
+	std::vector< ArrayType >( nsets ).swap( arrays );
+      return npy_intp( arrays.size() ) == nsets;
+    }
+
+    npy_intp size() const { return npy_intp( arrays.size() ); }
+
+    const ArrayType& operator[]( npy_intp index ) const {
+      return arrays[ index ];
+    }
+
+    const std::vector< ArrayType >& get() const { return arrays; }
+
+  private:
+
+    int init( PyObject* obj, bool allow_none ) {
+
+      if ( allow_none && Py_None == obj )
+	return 1;
+
+      PyObject* seq = PySequence_Fast( obj, "expected a sequence of arrays" );
+      if ( NULL == seq )
+	return 0;
+
+      // The arrays are converted in place, as they can not be copied.
+      npy_intp nsets = PySequence_Fast_GET_SIZE( seq );
+      std::vector< ArrayType >( nsets ).swap( arrays );
+      for ( npy_intp ii = 0; ii < nsets; ii++ ) {
+	PyObject* item = PySequence_Fast_GET_ITEM( seq, ii );
+	if ( allow_none && Py_None == item )
+	  continue;
+	if ( !convert_to_array< ArrayType >( item, &arrays[ ii ] ) ) {
+	  Py_DECREF( seq );
+	  return 0;
+	}
+      }
+
+      Py_DECREF( seq );
+      given = true;
+      return 1;
+
+    }
+
+    std::vector< ArrayType > arrays;
+    bool given;
+
+  };
+
+  static int sets_mismatch()
+  {
+
+    PyErr_SetString( PyExc_TypeError,
+		     (char*)"statistic input sequences do not match" );
+    return EXIT_FAILURE;
+
+  }
+
+  //
+  // Create the per-set statistic array and, when with_fvec is set, the
+  // array for the per-bin values of all nelem bins.
+  //
+  template <typename ArrayType>
+  int create_stat_sets( npy_intp nsets, npy_intp nelem, bool with_fvec,
+			ArrayType& stats, ArrayType& fvec )
+  {
+
+    if ( EXIT_SUCCESS != stats.create( 1, &nsets ) )
+      return EXIT_FAILURE;
+
+    if ( with_fvec && EXIT_SUCCESS != fvec.create( 1, &nelem ) )
+      return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+
+  }
+
+  //
+  // The return value of the *_sets routines: the statistic (the sum
+  // of the per-set values) and the per-set values, followed by the
+  // per-bin values when with_fvec is set.
+  //
+  template <typename ArrayType, typename DataType>
+  PyObject* return_stat_sets( ArrayType& stats, ArrayType& fvec,
+			      bool with_fvec )
+  {
+
+    DataType val = sherpa::utils::pairwise_sum( stats.get_size(),
+						&stats[ 0 ] );
+
+    if ( with_fvec )
+      return Py_BuildValue( (char*)"(dNN)", val, stats.return_new_ref(),
+			    fvec.return_new_ref() );
+
+    return Py_BuildValue( (char*)"(dN)", val, stats.return_new_ref() );
+
+  }
+
+  template <typename ArrayType>
+  int check_statfct_sizes( const ArrayType& yraw, const ArrayType& model,
+                           const ArrayType& staterror,
+                           const ArrayType& syserror,
+                           const ArrayType& weight )
+  {
+
+    npy_intp nelem = yraw.get_size();
+
+    if ( ( model.get_size() != nelem ) ||
+	 ( staterror.get_size() != nelem ) ||
+	 ( syserror && ( syserror.get_size() != nelem ) ) ||
+	 ( weight && ( weight.get_size() != nelem ) ) ) {
+      PyErr_SetString( PyExc_TypeError,
+		       (char*)"statistic input array sizes do not match" );
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ArrayType, typename DataType>
+  int parse_statfct_args( PyObject* args, PyObject* kwds, ArrayType& yraw,
+                          ArrayType& model, ArrayType& staterror,
+                          ArrayType& syserror, ArrayType& weight,
+                          DataType& trunc_value, int& numcores )
+  {
+
+    static char *kwlist[] = {(char*)"data", (char*)"model",
+			     (char*)"staterror", (char*)"syserror",
+			     (char*)"weight", (char*)"trunc_value",
+			     (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&O&O&d|i",
+				       kwlist,
+				       (converter)convert_to_array< ArrayType >,
+				       &yraw,
+				       (converter)convert_to_array< ArrayType >,
+				       &model,
+				       (converter)convert_to_array< ArrayType >,
+				       &staterror,
+				       (converter)array_or_none< ArrayType >,
+				       &syserror,
+				       (converter)array_or_none< ArrayType >,
+				       &weight,
+				       &trunc_value, &numcores) )
+      return EXIT_FAILURE;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return EXIT_FAILURE;
+
+    return check_statfct_sizes( yraw, model, staterror, syserror, weight );
+
+  }
+
   template <typename ArrayType,
 	    typename DataType,
 	    int (*StatFunc)( npy_intp num, const ArrayType& yraw,
@@ -61,8 +275,8 @@ namespace sherpa { namespace stats {
 			     const ArrayType& syserror,
 			     const ArrayType& weight,
 			     ArrayType& fvec, DataType& val, 
-			     DataType& trunc_value )>
-  PyObject* statfct( PyObject* self, PyObject* args )
+			     DataType& trunc_value, int numcores )>
+  PyObject* statfct( PyObject* self, PyObject* args, PyObject* kwds )
   {
 
     ArrayType yraw;
@@ -71,36 +285,28 @@ namespace sherpa { namespace stats {
     ArrayType syserror;
     ArrayType weight;
     DataType trunc_value = 1.0e-25;
+    int numcores = 0;
 
-    if ( !PyArg_ParseTuple( args, (char*)"O&O&O&O&O&d",
-			    (converter)convert_to_array< ArrayType >, &yraw,
-			    (converter)convert_to_array< ArrayType >, &model,
-			    (converter)convert_to_array< ArrayType >,
-			    &staterror,
-			    (converter)array_or_none< ArrayType >, &syserror,
-			    (converter)array_or_none< ArrayType >, &weight,
-			    &trunc_value) )
+    if ( EXIT_SUCCESS != parse_statfct_args( args, kwds, yraw, model,
+                                             staterror, syserror, weight,
+                                             trunc_value, numcores ) )
       return NULL;
 
     npy_intp nelem = yraw.get_size();
 
-    if ( ( model.get_size() != nelem ) ||
-	 ( staterror.get_size() != nelem ) ||
-	 ( syserror && ( syserror.get_size() != nelem ) ) ||
-	 ( weight && ( weight.get_size() != nelem ) ) ) {
-      PyErr_SetString( PyExc_TypeError,
-		       (char*)"statistic input array sizes do not match" );
-      return NULL;
-    }
-
     ArrayType fvec;
     if ( EXIT_SUCCESS != fvec.create( yraw.get_ndim(), yraw.get_dims() ) )
       return NULL;
 
     DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( nelem, yraw, model, staterror, syserror, weight,
+                         fvec, val, trunc_value, numcores );
+    }
 
-    if ( EXIT_SUCCESS != StatFunc( nelem, yraw, model, staterror, syserror,
-				   weight, fvec, val, trunc_value ) ) {
+    if ( EXIT_SUCCESS != status ) {
       PyErr_SetString( PyExc_ValueError, (char*)"statistic calculation failed");
       return NULL;
     }
@@ -109,37 +315,56 @@ namespace sherpa { namespace stats {
 
   }
 
-    template <typename ArrayType, typename DataType, typename iArrayType,
-              int (*StatFunc)( npy_intp num, const ArrayType& yraw,
-                               const ArrayType& model,
-                               const iArrayType& data_size,
-                               const ArrayType& exposure_src,
-                               const ArrayType& exposure_bkg,
-                               const ArrayType& bkg,
-                               const ArrayType& backscale_ratio,
-                               ArrayType& fvec, DataType& val,
-                               DataType trunc_value  )>
-    PyObject* wstatfct( PyObject* self, PyObject* args ) {
+  // As statfct but only the statistic value is returned, so there is
+  // no per-bin array to allocate.
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+			     const ArrayType& model,
+			     const ArrayType& staterror,
+			     const ArrayType& syserror,
+			     const ArrayType& weight,
+			     DataType& val, DataType& trunc_value,
+			     int numcores )>
+  PyObject* statvalfct( PyObject* self, PyObject* args, PyObject* kwds )
+  {
 
-      ArrayType yraw;
-      ArrayType model;
-      iArrayType data_size;
-      ArrayType exposure_src;
-      ArrayType exposure_bkg;
-      ArrayType bkg;
-      ArrayType backscale_ratio;
-      DataType trunc_value = 1.0e-25;
+    ArrayType yraw;
+    ArrayType model;
+    ArrayType staterror;
+    ArrayType syserror;
+    ArrayType weight;
+    DataType trunc_value = 1.0e-25;
+    int numcores = 0;
 
-      if ( !PyArg_ParseTuple( args, (char*)"O&O&O&O&O&O&O&d",
-                              CONVERTME( ArrayType ), &yraw,
-                              CONVERTME( ArrayType ), &model,
-                              CONVERTME( iArrayType ), &data_size,
-                              CONVERTME( ArrayType ), &exposure_src,
-                              CONVERTME( ArrayType ), &exposure_bkg,
-                              CONVERTME( ArrayType ), &bkg,
-                              CONVERTME( ArrayType ), &backscale_ratio,
-                              &trunc_value ) )
-        return NULL;
+    if ( EXIT_SUCCESS != parse_statfct_args( args, kwds, yraw, model,
+                                             staterror, syserror, weight,
+                                             trunc_value, numcores ) )
+      return NULL;
+
+    DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( yraw.get_size(), yraw, model, staterror, syserror,
+                         weight, val, trunc_value, numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"statistic calculation failed");
+      return NULL;
+    }
+
+    return PyFloat_FromDouble( val );
+
+  }
+
+    template <typename ArrayType>
+    int check_wstatfct_sizes( const ArrayType& yraw, const ArrayType& model,
+                              const ArrayType& exposure_src,
+                              const ArrayType& exposure_bkg,
+                              const ArrayType& bkg,
+                              const ArrayType& backscale_ratio ) {
 
       const npy_intp nelem = yraw.get_size();
 
@@ -148,7 +373,7 @@ namespace sherpa { namespace stats {
         err << "statistic array mismatch: data size=" << nelem <<
           " model size=" << model.get_size();
         PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-        return NULL;
+        return EXIT_FAILURE;
       }
 
       if ( bkg.get_size() != nelem ) {
@@ -156,7 +381,7 @@ namespace sherpa { namespace stats {
         err << "statistic array mismatch: data size=" << nelem <<
           " background size=" << bkg.get_size();
         PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-        return NULL;
+        return EXIT_FAILURE;
       }
 
       if ( backscale_ratio.get_size() != nelem ) {
@@ -164,7 +389,7 @@ namespace sherpa { namespace stats {
         err << "statistic array mismatch: data size=" << nelem <<
           " backscale ratio size=" << backscale_ratio.get_size();
         PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-        return NULL;
+        return EXIT_FAILURE;
       }
 
       if ( exposure_src.get_size() != nelem ) {
@@ -172,7 +397,7 @@ namespace sherpa { namespace stats {
         err << "statistic array mismatch: data size=" << nelem <<
           " exposure size (src)=" << exposure_src.get_size();
         PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-        return NULL;
+        return EXIT_FAILURE;
       }
       
       if ( exposure_bkg.get_size() != nelem ) {
@@ -180,26 +405,111 @@ namespace sherpa { namespace stats {
         err << "statistic array mismatch: data size=" << nelem <<
           " exposure size (bkg)=" << exposure_bkg.get_size();
         PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-        return NULL;
+        return EXIT_FAILURE;
       }
-      
+
+      return EXIT_SUCCESS;
+
+    }
+
+    template <typename ArrayType, typename iArrayType, typename DataType>
+    int parse_wstatfct_args( PyObject* args, PyObject* kwds,
+                             ArrayType& yraw, ArrayType& model,
+                             iArrayType& data_size,
+                             ArrayType& exposure_src,
+                             ArrayType& exposure_bkg, ArrayType& bkg,
+                             ArrayType& backscale_ratio,
+                             DataType& trunc_value, int& numcores ) {
+
+      static char *kwlist[] = {(char*)"data", (char*)"model",
+                               (char*)"data_size", (char*)"exposure_src",
+                               (char*)"exposure_bkg", (char*)"bkg",
+                               (char*)"backscale_ratio",
+                               (char*)"trunc_value", (char*)"numcores",
+                               NULL};
+
+      if ( !PyArg_ParseTupleAndKeywords( args, kwds,
+                                         (char*)"O&O&O&O&O&O&O&d|i", kwlist,
+                                         CONVERTME( ArrayType ), &yraw,
+                                         CONVERTME( ArrayType ), &model,
+                                         CONVERTME( iArrayType ), &data_size,
+                                         CONVERTME( ArrayType ),
+                                         &exposure_src,
+                                         CONVERTME( ArrayType ),
+                                         &exposure_bkg,
+                                         CONVERTME( ArrayType ), &bkg,
+                                         CONVERTME( ArrayType ),
+                                         &backscale_ratio,
+                                         &trunc_value, &numcores ) )
+        return EXIT_FAILURE;
+
+      if ( EXIT_SUCCESS != check_numcores( numcores ) )
+        return EXIT_FAILURE;
+
+      if ( EXIT_SUCCESS != check_wstatfct_sizes( yraw, model, exposure_src,
+                                                 exposure_bkg, bkg,
+                                                 backscale_ratio ) )
+        return EXIT_FAILURE;
+
+      const npy_intp nelem = yraw.get_size();
+
       npy_intp sum_data_size = 0;
       for ( npy_intp ii = 0; ii < data_size.get_size( ); ++ii )
         sum_data_size += data_size[ ii ];
       if ( nelem != sum_data_size ) {
         PyErr_SetString( PyExc_TypeError,
                          (char*)"data size do not match" );
-        return NULL;
+        return EXIT_FAILURE;
       }
 
+      return EXIT_SUCCESS;
+
+    }
+
+    template <typename ArrayType, typename DataType, typename iArrayType,
+              int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+                               const ArrayType& model,
+                               const iArrayType& data_size,
+                               const ArrayType& exposure_src,
+                               const ArrayType& exposure_bkg,
+                               const ArrayType& bkg,
+                               const ArrayType& backscale_ratio,
+                               ArrayType& fvec, DataType& val,
+                               DataType trunc_value, int numcores )>
+    PyObject* wstatfct( PyObject* self, PyObject* args, PyObject* kwds ) {
+
+      ArrayType yraw;
+      ArrayType model;
+      iArrayType data_size;
+      ArrayType exposure_src;
+      ArrayType exposure_bkg;
+      ArrayType bkg;
+      ArrayType backscale_ratio;
+      DataType trunc_value = 1.0e-25;
+      int numcores = 0;
+
+      if ( EXIT_SUCCESS != parse_wstatfct_args( args, kwds, yraw, model,
+                                                data_size, exposure_src,
+                                                exposure_bkg, bkg,
+                                                backscale_ratio,
+                                                trunc_value, numcores ) )
+        return NULL;
+
+      const npy_intp nelem = yraw.get_size();
+
       ArrayType fvec;
       if ( EXIT_SUCCESS != fvec.create( yraw.get_ndim(), yraw.get_dims() ) )
         return NULL;
       DataType val = 0.0;
-      if ( EXIT_SUCCESS != StatFunc( nelem, yraw, model, data_size, 
-                                     exposure_src, exposure_bkg,
-                                     bkg, backscale_ratio,
-                                     fvec, val, trunc_value ) ) {
+      int status;
+      {
+        StatThreads threads( numcores );
+        status = StatFunc( nelem, yraw, model, data_size, exposure_src,
+                           exposure_bkg, bkg, backscale_ratio, fvec, val,
+                           trunc_value, numcores );
+      }
+
+      if ( EXIT_SUCCESS != status ) {
         PyErr_SetString( PyExc_ValueError,
                          (char*)"statistic calculation failed");
         return NULL;
@@ -209,6 +519,111 @@ namespace sherpa { namespace stats {
 
     }
 
+    template <typename ArrayType, typename DataType, typename iArrayType,
+              int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+                               const ArrayType& model,
+                               const iArrayType& data_size,
+                               const ArrayType& exposure_src,
+                               const ArrayType& exposure_bkg,
+                               const ArrayType& bkg,
+                               const ArrayType& backscale_ratio,
+                               DataType& val, DataType trunc_value,
+                               int numcores )>
+    PyObject* wstatvalfct( PyObject* self, PyObject* args, PyObject* kwds ) {
+
+      ArrayType yraw;
+      ArrayType model;
+      iArrayType data_size;
+      ArrayType exposure_src;
+      ArrayType exposure_bkg;
+      ArrayType bkg;
+      ArrayType backscale_ratio;
+      DataType trunc_value = 1.0e-25;
+      int numcores = 0;
+
+      if ( EXIT_SUCCESS != parse_wstatfct_args( args, kwds, yraw, model,
+                                                data_size, exposure_src,
+                                                exposure_bkg, bkg,
+                                                backscale_ratio,
+                                                trunc_value, numcores ) )
+        return NULL;
+
+      DataType val = 0.0;
+      int status;
+      {
+        StatThreads threads( numcores );
+        status = StatFunc( yraw.get_size(), yraw, model, data_size,
+                           exposure_src, exposure_bkg, bkg, backscale_ratio,
+                           val, trunc_value, numcores );
+      }
+
+      if ( EXIT_SUCCESS != status ) {
+        PyErr_SetString( PyExc_ValueError,
+                         (char*)"statistic calculation failed");
+        return NULL;
+      }
+
+      return PyFloat_FromDouble( val );
+
+    }
+
+
+  template <typename ArrayType>
+  int check_lklhd_statfct_sizes( const ArrayType& yraw,
+                                 const ArrayType& model,
+                                 const ArrayType& weight )
+  {
+
+    npy_intp nelem = yraw.get_size();
+
+    if ( model.get_size() != nelem ) {
+      std::ostringstream err;
+      err << "statistic array mismatch: data size=" << nelem <<
+        " model size=" << model.get_size();
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return EXIT_FAILURE;
+    }
+
+    if ( weight && ( weight.get_size() != nelem ) ) {
+      std::ostringstream err;
+      err << "statistic array mismatch: data size=" << nelem <<
+        " weight size=" << model.get_size();
+      PyErr_SetString( PyExc_TypeError, err.str().c_str() );
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ArrayType, typename DataType>
+  int parse_lklhd_statfct_args( PyObject* args, PyObject* kwds,
+                                ArrayType& yraw, ArrayType& model,
+                                ArrayType& weight, DataType& trunc_value,
+                                int& numcores )
+  {
+
+    static char *kwlist[] = {(char*)"data", (char*)"model",
+			     (char*)"weight", (char*)"trunc_value",
+			     (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&d|i",
+				       kwlist,
+				       (converter)convert_to_array< ArrayType >,
+				       &yraw,
+				       (converter)convert_to_array< ArrayType >,
+				       &model,
+				       (converter)array_or_none< ArrayType >,
+				       &weight,
+				       &trunc_value, &numcores) )
+      return EXIT_FAILURE;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return EXIT_FAILURE;
+
+    return check_lklhd_statfct_sizes( yraw, model, weight );
+
+  }
 
   template <typename ArrayType,
 	    typename DataType,
@@ -216,49 +631,164 @@ namespace sherpa { namespace stats {
 			     const ArrayType& model,
 			     const ArrayType& weight,
 			     ArrayType& fvec, DataType& val, 
-			     DataType& trunc_value )>
-  PyObject* lklhd_statfct( PyObject* self, PyObject* args )
+			     DataType& trunc_value, int numcores )>
+  PyObject* lklhd_statfct( PyObject* self, PyObject* args, PyObject* kwds )
   {
 
     ArrayType yraw;
     ArrayType model;
     ArrayType weight;
     DataType trunc_value = 1.0e-25;
+    int numcores = 0;
 
-    if ( !PyArg_ParseTuple( args, (char*)"O&O&O&d",
-			    (converter)convert_to_array< ArrayType >, &yraw,
-			    (converter)convert_to_array< ArrayType >, &model,
-			    (converter)array_or_none< ArrayType >, &weight,
-			    &trunc_value) )
+    if ( EXIT_SUCCESS != parse_lklhd_statfct_args( args, kwds, yraw, model,
+                                                   weight, trunc_value,
+                                                   numcores ) )
       return NULL;
 
     npy_intp nelem = yraw.get_size();
 
+    ArrayType fvec;
+    if ( EXIT_SUCCESS != fvec.create( yraw.get_ndim(), yraw.get_dims() ) )
+      return NULL;
+
+    DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( nelem, yraw, model, weight, fvec, val, trunc_value,
+                         numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"likelihood calculation failed");
+      return NULL;
+    }
+
+    return Py_BuildValue( (char*)"(dN)", val, fvec.return_new_ref() );
+
+  }
+
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+			     const ArrayType& model,
+			     const ArrayType& weight,
+			     DataType& val, DataType& trunc_value,
+			     int numcores )>
+  PyObject* lklhd_statvalfct( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    ArrayType yraw;
+    ArrayType model;
+    ArrayType weight;
+    DataType trunc_value = 1.0e-25;
+    int numcores = 0;
+
+    if ( EXIT_SUCCESS != parse_lklhd_statfct_args( args, kwds, yraw, model,
+                                                   weight, trunc_value,
+                                                   numcores ) )
+      return NULL;
+
+    DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( yraw.get_size(), yraw, model, weight, val,
+                         trunc_value, numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"likelihood calculation failed");
+      return NULL;
+    }
+
+    return PyFloat_FromDouble( val );
+
+  }
+
+
+
+  //
+  // The prepared statistics take the data, the model, and the per-bin
+  // scale factors calculated at the start of the fit (see
+  // calc_chi2_stat_prepared).
+  //
+  template <typename ArrayType>
+  int parse_preparedstatfct_args( PyObject* args, PyObject* kwds,
+                                  ArrayType& yraw, ArrayType& model,
+                                  ArrayType& scale, int& numcores )
+  {
+
+    static char *kwlist[] = {(char*)"data", (char*)"model", (char*)"scale",
+			     (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&|i",
+				       kwlist,
+				       (converter)convert_to_array< ArrayType >,
+				       &yraw,
+				       (converter)convert_to_array< ArrayType >,
+				       &model,
+				       (converter)convert_to_array< ArrayType >,
+				       &scale,
+				       &numcores) )
+      return EXIT_FAILURE;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return EXIT_FAILURE;
+
+    npy_intp nelem = yraw.get_size();
     if ( model.get_size() != nelem ) {
       std::ostringstream err;
-      err << "statistic array mismatch: data size=" << nelem <<
-        " model size=" << model.get_size();
+      err << "statistic array mismatch: data size=" << nelem
+	  << " model size=" << model.get_size();
       PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-      return NULL;
+      return EXIT_FAILURE;
     }
-
-    if ( weight && ( weight.get_size() != nelem ) ) {
+    if ( scale.get_size() != nelem ) {
       std::ostringstream err;
-      err << "statistic array mismatch: data size=" << nelem <<
-        " weight size=" << model.get_size();
+      err << "statistic array mismatch: data size=" << nelem
+	  << " scale size=" << scale.get_size();
       PyErr_SetString( PyExc_TypeError, err.str().c_str() );
-      return NULL;
+      return EXIT_FAILURE;
     }
 
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+			     const ArrayType& model,
+			     const ArrayType& scale,
+			     ArrayType& fvec, DataType& val, int numcores )>
+  PyObject* preparedstatfct( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    ArrayType yraw;
+    ArrayType model;
+    ArrayType scale;
+    int numcores = 0;
+
+    if ( EXIT_SUCCESS != parse_preparedstatfct_args( args, kwds, yraw, model,
+						     scale, numcores ) )
+      return NULL;
+
     ArrayType fvec;
     if ( EXIT_SUCCESS != fvec.create( yraw.get_ndim(), yraw.get_dims() ) )
       return NULL;
 
     DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( yraw.get_size(), yraw, model, scale, fvec, val,
+			 numcores );
+    }
 
-    if ( EXIT_SUCCESS != StatFunc( nelem, yraw, model, weight,
-				   fvec, val, trunc_value ) ) {
-      PyErr_SetString( PyExc_ValueError, (char*)"likelihood calculation failed");
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"statistic calculation failed");
       return NULL;
     }
 
@@ -266,8 +796,306 @@ namespace sherpa { namespace stats {
 
   }
 
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( npy_intp num, const ArrayType& yraw,
+			     const ArrayType& model,
+			     const ArrayType& scale,
+			     DataType& val, int numcores )>
+  PyObject* preparedstatvalfct( PyObject* self, PyObject* args,
+				PyObject* kwds )
+  {
+
+    ArrayType yraw;
+    ArrayType model;
+    ArrayType scale;
+    int numcores = 0;
+
+    if ( EXIT_SUCCESS != parse_preparedstatfct_args( args, kwds, yraw, model,
+						     scale, numcores ) )
+      return NULL;
+
+    DataType val = 0.0;
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( yraw.get_size(), yraw, model, scale, val,
+			 numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"statistic calculation failed");
+      return NULL;
+    }
+
+    return PyFloat_FromDouble( val );
+
+  }
+
+  //
+  // The multi-dataset forms of statfct, lklhd_statfct, and wstatfct:
+  // each array argument is replaced by a sequence with an array for
+  // each data set, and the data sets are calculated in one call (and
+  // with numcores > 0 the bins of all the sets are shared out between
+  // the threads). The return value is (stat, stats, fvec), where stats
+  // contains the statistic for each set and fvec the per-bin values
+  // of all the sets, or (stat, stats) when WithFvec is false.
+  //
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( const std::vector< npy_intp >& num,
+			     const std::vector< ArrayType >& yraw,
+			     const std::vector< ArrayType >& model,
+			     const std::vector< ArrayType >& staterror,
+			     const std::vector< ArrayType >& syserror,
+			     const std::vector< ArrayType >& weight,
+			     DataType* fvec, DataType* stat,
+			     DataType& trunc_value, int numcores ),
+	    bool WithFvec>
+  PyObject* statsetsfct( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    ArraySets< ArrayType > yraw;
+    ArraySets< ArrayType > model;
+    ArraySets< ArrayType > staterror;
+    ArraySets< ArrayType > syserror;
+    ArraySets< ArrayType > weight;
+    DataType trunc_value = 1.0e-25;
+    int numcores = 0;
+
+    static char *kwlist[] = {(char*)"data", (char*)"model",
+			     (char*)"staterror", (char*)"syserror",
+			     (char*)"weight", (char*)"trunc_value",
+			     (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&O&O&d|i",
+				       kwlist,
+				       ArraySets< ArrayType >::convert, &yraw,
+				       ArraySets< ArrayType >::convert, &model,
+				       ArraySets< ArrayType >::convert,
+				       &staterror,
+				       ArraySets< ArrayType >::convert_or_none,
+				       &syserror,
+				       ArraySets< ArrayType >::convert_or_none,
+				       &weight,
+				       &trunc_value, &numcores) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    npy_intp nsets = yraw.size();
+    if ( !model.check_size( nsets ) || !staterror.check_size( nsets ) ||
+	 !syserror.check_size( nsets ) || !weight.check_size( nsets ) ) {
+      sets_mismatch();
+      return NULL;
+    }
+
+    std::vector< npy_intp > num( nsets );
+    npy_intp nelem = 0;
+    for ( npy_intp ii = 0; ii < nsets; ii++ ) {
+      if ( EXIT_SUCCESS != check_statfct_sizes( yraw[ ii ], model[ ii ],
+						staterror[ ii ],
+						syserror[ ii ], weight[ ii ] ) )
+	return NULL;
+      num[ ii ] = yraw[ ii ].get_size();
+      nelem += num[ ii ];
+    }
+
+    ArrayType stats;
+    ArrayType fvec;
+    if ( EXIT_SUCCESS != create_stat_sets( nsets, nelem, WithFvec, stats,
+					   fvec ) )
+      return NULL;
+
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( num, yraw.get(), model.get(), staterror.get(),
+			 syserror.get(), weight.get(),
+			 WithFvec && nelem > 0 ? &fvec[ 0 ] : NULL,
+			 nsets > 0 ? &stats[ 0 ] : NULL, trunc_value,
+			 numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"statistic calculation failed");
+      return NULL;
+    }
+
+    return return_stat_sets< ArrayType, DataType >( stats, fvec, WithFvec );
+
+  }
+
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( const std::vector< npy_intp >& num,
+			     const std::vector< ArrayType >& yraw,
+			     const std::vector< ArrayType >& model,
+			     const std::vector< ArrayType >& weight,
+			     DataType* fvec, DataType* stat,
+			     DataType& trunc_value, int numcores ),
+	    bool WithFvec>
+  PyObject* lklhd_statsetsfct( PyObject* self, PyObject* args,
+			       PyObject* kwds )
+  {
+
+    ArraySets< ArrayType > yraw;
+    ArraySets< ArrayType > model;
+    ArraySets< ArrayType > weight;
+    DataType trunc_value = 1.0e-25;
+    int numcores = 0;
+
+    static char *kwlist[] = {(char*)"data", (char*)"model",
+			     (char*)"weight", (char*)"trunc_value",
+			     (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&d|i",
+				       kwlist,
+				       ArraySets< ArrayType >::convert, &yraw,
+				       ArraySets< ArrayType >::convert, &model,
+				       ArraySets< ArrayType >::convert_or_none,
+				       &weight,
+				       &trunc_value, &numcores) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    npy_intp nsets = yraw.size();
+    if ( !model.check_size( nsets ) || !weight.check_size( nsets ) ) {
+      sets_mismatch();
+      return NULL;
+    }
+
+    std::vector< npy_intp > num( nsets );
+    npy_intp nelem = 0;
+    for ( npy_intp ii = 0; ii < nsets; ii++ ) {
+      if ( EXIT_SUCCESS != check_lklhd_statfct_sizes( yraw[ ii ], model[ ii ],
+						      weight[ ii ] ) )
+	return NULL;
+      num[ ii ] = yraw[ ii ].get_size();
+      nelem += num[ ii ];
+    }
+
+    ArrayType stats;
+    ArrayType fvec;
+    if ( EXIT_SUCCESS != create_stat_sets( nsets, nelem, WithFvec, stats,
+					   fvec ) )
+      return NULL;
+
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( num, yraw.get(), model.get(), weight.get(),
+			 WithFvec && nelem > 0 ? &fvec[ 0 ] : NULL,
+			 nsets > 0 ? &stats[ 0 ] : NULL, trunc_value,
+			 numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError, (char*)"likelihood calculation failed");
+      return NULL;
+    }
+
+    return return_stat_sets< ArrayType, DataType >( stats, fvec, WithFvec );
+
+  }
+
+  // The data_size argument of wstatfct is not needed, since the data
+  // sets are given separately.
+  template <typename ArrayType,
+	    typename DataType,
+	    int (*StatFunc)( const std::vector< npy_intp >& num,
+			     const std::vector< ArrayType >& yraw,
+			     const std::vector< ArrayType >& model,
+			     const std::vector< ArrayType >& exposure_src,
+			     const std::vector< ArrayType >& exposure_bkg,
+			     const std::vector< ArrayType >& bkg,
+			     const std::vector< ArrayType >& backscale_ratio,
+			     DataType* fvec, DataType* stat,
+			     DataType trunc_value, int numcores ),
+	    bool WithFvec>
+  PyObject* wstatsetsfct( PyObject* self, PyObject* args, PyObject* kwds )
+  {
+
+    ArraySets< ArrayType > yraw;
+    ArraySets< ArrayType > model;
+    ArraySets< ArrayType > exposure_src;
+    ArraySets< ArrayType > exposure_bkg;
+    ArraySets< ArrayType > bkg;
+    ArraySets< ArrayType > backscale_ratio;
+    DataType trunc_value = 1.0e-25;
+    int numcores = 0;
+
+    static char *kwlist[] = {(char*)"data", (char*)"model",
+			     (char*)"exposure_src", (char*)"exposure_bkg",
+			     (char*)"bkg", (char*)"backscale_ratio",
+			     (char*)"trunc_value", (char*)"numcores", NULL};
+
+    if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"O&O&O&O&O&O&d|i",
+				       kwlist,
+				       ArraySets< ArrayType >::convert, &yraw,
+				       ArraySets< ArrayType >::convert, &model,
+				       ArraySets< ArrayType >::convert,
+				       &exposure_src,
+				       ArraySets< ArrayType >::convert,
+				       &exposure_bkg,
+				       ArraySets< ArrayType >::convert, &bkg,
+				       ArraySets< ArrayType >::convert,
+				       &backscale_ratio,
+				       &trunc_value, &numcores) )
+      return NULL;
+
+    if ( EXIT_SUCCESS != check_numcores( numcores ) )
+      return NULL;
+
+    npy_intp nsets = yraw.size();
+    if ( !model.check_size( nsets ) || !exposure_src.check_size( nsets ) ||
+	 !exposure_bkg.check_size( nsets ) || !bkg.check_size( nsets ) ||
+	 !backscale_ratio.check_size( nsets ) ) {
+      sets_mismatch();
+      return NULL;
+    }
+
+    std::vector< npy_intp > num( nsets );
+    npy_intp nelem = 0;
+    for ( npy_intp ii = 0; ii < nsets; ii++ ) {
+      if ( EXIT_SUCCESS != check_wstatfct_sizes( yraw[ ii ], model[ ii ],
+						 exposure_src[ ii ],
+						 exposure_bkg[ ii ], bkg[ ii ],
+						 backscale_ratio[ ii ] ) )
+	return NULL;
+      num[ ii ] = yraw[ ii ].get_size();
+      nelem += num[ ii ];
+    }
+
+    ArrayType stats;
+    ArrayType fvec;
+    if ( EXIT_SUCCESS != create_stat_sets( nsets, nelem, WithFvec, stats,
+					   fvec ) )
+      return NULL;
+
+    int status;
+    {
+      StatThreads threads( numcores );
+      status = StatFunc( num, yraw.get(), model.get(), exposure_src.get(),
+			 exposure_bkg.get(), bkg.get(), backscale_ratio.get(),
+			 WithFvec && nelem > 0 ? &fvec[ 0 ] : NULL,
+			 nsets > 0 ? &stats[ 0 ] : NULL, trunc_value,
+			 numcores );
+    }
+
+    if ( EXIT_SUCCESS != status ) {
+      PyErr_SetString( PyExc_ValueError,
+		       (char*)"statistic calculation failed");
+      return NULL;
+    }
+
+    return return_stat_sets< ArrayType, DataType >( stats, fvec, WithFvec );
+
+  }
 
-    
 }  }  /* namespace stats, namespace sherpa */
 
 
@@ -282,21 +1110,79 @@ namespace sherpa { namespace stats {
   sherpa::stats::name< SherpaFloatArray, SherpaFloatArray, SherpaFloat, \
                        npy_intp >
 
-#define _STATFCTSPEC(name, ftype) \
+#define _STATVALFCTPTR(name) \
+  sherpa::stats::name< SherpaFloatArray, SherpaFloat, npy_intp >
+#define _WSTATVALFCTPTR(name) \
+  sherpa::stats::name< SherpaFloatArray, SherpaFloat, npy_intp, IntArray >
+
+#define _STATERRFCTSPEC(name, ftype) \
   FCTSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
                                        _STATFCTPTR(name) >))
+#define _STATFCTSPEC(name, ftype) \
+  KWSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+                                      _STATFCTPTR(name) >))
 #define _WSTATFCTSPEC(name, ftype) \
-  FCTSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+  KWSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
                  IntArray, _WSTATFCTPTR(name) >))
 
 #define _LKLHD_STATFCTSPEC(name, ftype) \
-  FCTSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+  KWSPEC(name, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
                  _LKLHD_STATFCTPTR(name) >))
 
-#define STATERRFCT(name)	_STATFCTSPEC(name, staterrfct)
+#define _STATVALFCTSPEC(name, ftype) \
+  KWSPEC(name##_value, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+                         _STATVALFCTPTR(name##_value) >))
+#define _WSTATVALFCTSPEC(name, ftype) \
+  KWSPEC(name##_value, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+                         IntArray, _WSTATVALFCTPTR(name##_value) >))
+
+#define _STATSETSFCTPTR(name) \
+  sherpa::stats::name##_sets< SherpaFloatArray, SherpaFloat, npy_intp >
+
+#define _STATSETSFCTSPEC(name, ftype, suffix, with_fvec) \
+  KWSPEC(name##suffix, (sherpa::stats::ftype< SherpaFloatArray, SherpaFloat, \
+                        _STATSETSFCTPTR(name), with_fvec >))
+
+#define STATERRFCT(name)	_STATERRFCTSPEC(name, staterrfct)
 #define STATFCT(name)		_STATFCTSPEC(name, statfct)
 #define WSTATFCT(name)		_WSTATFCTSPEC(name, wstatfct)
 
 #define LKLHD_STATFCT(name)	_LKLHD_STATFCTSPEC(name, lklhd_statfct)
 
+// The value-only form of a statistic, registered as <name>_value.
+#define STATVALFCT(name)	_STATVALFCTSPEC(name, statvalfct)
+#define WSTATVALFCT(name)	_WSTATVALFCTSPEC(name, wstatvalfct)
+#define LKLHD_STATVALFCT(name)	_STATVALFCTSPEC(name, lklhd_statvalfct)
+
+// The statistic and its derivative with respect to the model values,
+// registered as <name>_grad. These take the same arguments as <name>
+// and return ( stat, grad ).
+#define STATGRADFCT(name)	_STATFCTSPEC(name##_grad, statfct)
+#define WSTATGRADFCT(name)	_WSTATFCTSPEC(name##_grad, wstatfct)
+#define LKLHD_STATGRADFCT(name)	_LKLHD_STATFCTSPEC(name##_grad, lklhd_statfct)
+
+// The prepared form of a statistic, registered as <name>_prepared and
+// <name>_prepared_value.
+#define PREPAREDSTATFCT(name) \
+  KWSPEC(name##_prepared, \
+         (sherpa::stats::preparedstatfct< SherpaFloatArray, SherpaFloat, \
+          _STATFCTPTR(name##_prepared) >))
+#define PREPAREDSTATVALFCT(name) \
+  KWSPEC(name##_prepared_value, \
+         (sherpa::stats::preparedstatvalfct< SherpaFloatArray, SherpaFloat, \
+          _STATVALFCTPTR(name##_prepared_value) >))
+
+// The multi-dataset forms, registered as <name>_sets and
+// <name>_value_sets.
+#define STATSETSFCT(name)	_STATSETSFCTSPEC(name, statsetsfct, _sets, true)
+#define WSTATSETSFCT(name)	_STATSETSFCTSPEC(name, wstatsetsfct, _sets, true)
+#define LKLHD_STATSETSFCT(name) \
+  _STATSETSFCTSPEC(name, lklhd_statsetsfct, _sets, true)
+#define STATVALSETSFCT(name) \
+  _STATSETSFCTSPEC(name, statsetsfct, _value_sets, false)
+#define WSTATVALSETSFCT(name) \
+  _STATSETSFCTSPEC(name, wstatsetsfct, _value_sets, false)
+#define LKLHD_STATVALSETSFCT(name) \
+  _STATSETSFCTSPEC(name, lklhd_statsetsfct, _value_sets, false)
+
 #endif /* __sherpa_stat_extension_hh__ */
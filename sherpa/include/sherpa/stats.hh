@@ -20,10 +20,14 @@
 #ifndef __sherpa_stats_hh__
 #define __sherpa_stats_hh__
 
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
+#include <vector>
 
+#include <sherpa/parallel.hh>
 #include <sherpa/utils.hh>
+#include <sherpa/vecmath.hh>
 
 
 namespace sherpa { namespace stats {
@@ -32,98 +36,598 @@ namespace sherpa { namespace stats {
   //#define MODELFUDGEVAL 1.0e-25
 
   //
-  // fvec is needed for chi square and lmdif, it is not needed for cStat
+  // The per-bin terms of the statistics. These are shared by the
+  // calc_*_stat routines, which store the terms in fvec, and the
+  // calc_*_stat_value routines, which only sum them.
   //
-  template <typename ArrayType, typename ConstArrayType, typename DataType,
-	    typename IndexType>
-  inline int calc_cstat_stat( IndexType num, const ConstArrayType& yraw,
-                              const ConstArrayType& model,
-                              const ConstArrayType& weight,
-                              ArrayType& fvec, DataType& stat,
-                              DataType& trunc_value ) {
+  template <typename DataType>
+  inline int truncate_model( DataType model, DataType trunc_value,
+                             DataType& mymodel ) {
+
+    if ( model > 0.0 )
+      mymodel = model;
+    else {
+      if ( trunc_value > 0 )
+	mymodel = trunc_value;
+      else
+	return EXIT_FAILURE;
+    }
 
-    DataType mymodel;
-    for ( IndexType ii = num - 1; ii >= 0; --ii ) {
+    return EXIT_SUCCESS;
 
-      if ( model[ ii ] > 0.0)
-	mymodel = model[ ii ];
-      else {
-	if (trunc_value > 0)
-	  mymodel = trunc_value;
-	else
-	  return EXIT_FAILURE;
-      }
+  }
+
+  //
+  // The statistics are calculated STAT_BLOCKSIZE bins at a time. The
+  // terms of a block are summed in order, and the block sums are then
+  // added with pairwise_sum (see sum_stat_blocks).
+  //
+  const long STAT_BLOCKSIZE = 256;
+
+  // The smallest number of blocks given to a thread.
+  const long STAT_MIN_BLOCKS = 32;
+
+  //
+  // The likelihood statistics evaluate the logarithms of a block with
+  // log_vec. The *_block routines fill in val[0] to val[n-1] with the
+  // (weighted) terms for bins start to start + n - 1, where
+  // n <= STAT_BLOCKSIZE. The log_vec input arrays are cleared first,
+  // only because the compiler can not tell that the first n elements
+  // are always set.
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int cstat_block( IndexType start, IndexType n,
+                          const ConstArrayType& yraw,
+                          const ConstArrayType& model,
+                          const ConstArrayType& weight,
+                          DataType trunc_value, DataType* val ) {
+
+    DataType mymodel[ STAT_BLOCKSIZE ];
+    DataType ratio[ STAT_BLOCKSIZE ] = { 0 };
+    DataType logratio[ STAT_BLOCKSIZE ];
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      DataType y = yraw[ start + ii ];
+      if ( !( y >= 0.0 ) )
+        return EXIT_FAILURE;
+
+      if ( EXIT_SUCCESS != truncate_model( model[ start + ii ], trunc_value,
+                                           mymodel[ ii ] ) )
+        return EXIT_FAILURE;
 
-      if( yraw[ ii ] > 0.0 )
-	fvec[ ii ] = mymodel - yraw[ ii ] +
-	  yraw[ ii ] * ( std::log( yraw[ ii ] / mymodel ) );
-      else if ( yraw[ ii ] == 0.0 )
-	fvec[ ii ] = mymodel;
+      ratio[ ii ] = y > 0.0 ? y / mymodel[ ii ] : 1.0;
+
+    }
+
+    sherpa::utils::log_vec( n, ratio, logratio );
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      DataType y = yraw[ start + ii ];
+      if ( y > 0.0 )
+	val[ ii ] = mymodel[ ii ] - y + y * logratio[ ii ];
       else
-	return EXIT_FAILURE;
+	val[ ii ] = mymodel[ ii ];
 
       // weight is not given in the following url
       // https://heasarc.gsfc.nasa.gov/xanadu/xspec/manual/XSappendixStatistics.html
       if ( weight )
-	fvec[ ii ] *= weight[ ii ];
+	val[ ii ] *= weight[ start + ii ];
 
     }
 
-    stat = 2.0 *
-      sherpa::utils::kahan_sum< ArrayType, DataType, IndexType >( num, fvec );
+    return EXIT_SUCCESS;
 
-    DataType sqrt2 = std::sqrt( 2.0 );
-    for ( IndexType ii = num - 1; ii >= 0; --ii )
-      fvec[ ii ] = sqrt2 * std::sqrt( std::fabs(fvec[ii]) );
+  }
+
+  // Negative data values are rejected, as calc_cash_stat has always
+  // done (when it calculates fvec with calc_cstat_stat).
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int cash_block( IndexType start, IndexType n,
+                         const ConstArrayType& yraw,
+                         const ConstArrayType& model,
+                         const ConstArrayType& weight,
+                         DataType trunc_value, DataType* val ) {
+
+    DataType mymodel[ STAT_BLOCKSIZE ] = { 0 };
+    DataType logmodel[ STAT_BLOCKSIZE ];
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      if ( !( yraw[ start + ii ] >= 0.0 ) )
+        return EXIT_FAILURE;
+
+      if ( EXIT_SUCCESS != truncate_model( model[ start + ii ], trunc_value,
+                                           mymodel[ ii ] ) )
+        return EXIT_FAILURE;
+
+    }
+
+    sherpa::utils::log_vec( n, mymodel, logmodel );
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      DataType y = yraw[ start + ii ];
+      if ( 0.0 == y )
+	val[ ii ] = mymodel[ ii ];
+      else
+	val[ ii ] = mymodel[ ii ] - ( y * logmodel[ ii ] );
+
+      if ( weight )
+	val[ ii ] *= weight[ start + ii ];
+
+    }
 
     return EXIT_SUCCESS;
 
   }
 
+  //
+  // The per-bin values of the chi-square and least-squares statistics.
+  // When deriv is not NULL it is set to the derivative of the value
+  // with respect to the model.
+  //
+
+  // ( model - data ) / error, with the error including any systematic
+  // term; a zero error leaves the difference unscaled.
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline DataType chi2_bin( IndexType ii, const ConstArrayType& yraw,
+                            const ConstArrayType& model,
+                            const ConstArrayType& error,
+                            const ConstArrayType& syserror,
+                            DataType* deriv ) {
+
+    DataType val = model[ ii ] - yraw[ ii ];
+
+    DataType err = error[ ii ];
+
+    if ( syserror ) {
+      err *= error[ ii ];
+      err += syserror[ ii ] * syserror[ ii ];
+      err = std::sqrt( err );
+    }
+
+    // the error for Chi2 is 0, so a sanity check is required.
+    if ( 0.0 != err )
+      val /= err;
+
+    if ( deriv )
+      *deriv = 0.0 != err ? 1.0 / err : 1.0;
+
+    return val;
+
+  }
+
+  // ( data - model ) / sqrt( max( model, 1 ) + syserror^2 ); the error
+  // argument is not used.
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline DataType chi2modvar_bin( IndexType ii, const ConstArrayType& yraw,
+                                  const ConstArrayType& model,
+                                  const ConstArrayType& error,
+                                  const ConstArrayType& syserror,
+                                  DataType* deriv ) {
+
+    DataType val = yraw[ ii ] - model[ ii ];
+
+    DataType err_sqr = model[ ii ];
+    if ( err_sqr < 1.0 )
+      err_sqr = 1.0;
+    // err_sqr is guaranteed to be >= 1.0
+
+    if ( syserror )
+      err_sqr += syserror[ ii ] * syserror[ ii ];
+
+    // syserror^2 is always >= 0.0, so need to check if err_sqr < 0.0
+    DataType err = std::sqrt( err_sqr );
+
+    // the error is guaranteed to be > 0.0 so err could never be equal to 0.0
+    val /= err;
+
+    // The variance only depends on the model when it is >= 1.
+    if ( deriv ) {
+      *deriv = -1.0 / err;
+      if ( model[ ii ] >= 1.0 )
+	*deriv -= 0.5 * val / err_sqr;
+    }
+
+    return val;
+
+  }
+
+  // model - data; the errors are not used.
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline DataType lsq_bin( IndexType ii, const ConstArrayType& yraw,
+                           const ConstArrayType& model,
+                           const ConstArrayType& error,
+                           const ConstArrayType& syserror,
+                           DataType* deriv ) {
+
+    if ( deriv )
+      *deriv = 1.0;
+
+    return model[ ii ] - yraw[ ii ];
+
+  }
+
 
   //
-  // fvec is needed for chi square and lmdif, it is not needed for Cash
+  // Call blocks( start, n, sum ) for each block in [begin, end),
+  // storing the sums in sums[begin] to sums[end - 1].
   //
-  template <typename ArrayType, typename ConstArrayType, typename DataType,
-	    typename IndexType>
-  inline int calc_cash_stat( IndexType num, const ConstArrayType& yraw,
-                             const ConstArrayType& model,
-                             const ConstArrayType& weight, ArrayType& fvec,
-                             DataType& stat, DataType& trunc_value ) {
+  template <typename DataType, typename IndexType, typename Blocks>
+  class StatBlockRange {
 
-    DataType mymodel, d;
-    for ( IndexType ii = num - 1; ii >= 0; --ii ) {
+  public:
 
-      if ( model[ ii ] > 0.0)
-	mymodel = model[ ii ];
-      else {
-	if (trunc_value > 0)
-	  mymodel = trunc_value;
-	else
+    StatBlockRange( const Blocks& b, IndexType n, DataType* s )
+      : blocks( b ), num( n ), sums( s ) { }
+
+    int operator()( IndexType begin, IndexType end ) {
+      for ( IndexType bb = begin; bb < end; ++bb ) {
+	IndexType start = bb * STAT_BLOCKSIZE;
+	IndexType n = std::min< IndexType >( STAT_BLOCKSIZE, num - start );
+	if ( EXIT_SUCCESS != blocks( start, n, sums[ bb ] ) )
 	  return EXIT_FAILURE;
       }
+      return EXIT_SUCCESS;
+    }
 
-      if ( 0.0 == yraw[ ii ] )
-      	d = mymodel;
-      else
-	d = mymodel - ( yraw[ ii ] * std::log( mymodel ) );
+  private:
+
+    const Blocks& blocks;
+    IndexType num;
+    DataType* sums;
+
+  };
+
+  //
+  // Sum a statistic over num bins, where blocks( start, n, sum ) sets
+  // sum to the total of the n terms starting at bin start. With
+  // numcores > 1 the blocks are shared out between the threads (so
+  // blocks must be safe to call concurrently), but since the block
+  // sums are always added in the same way the statistic does not
+  // depend on the number of threads.
+  //
+  template <typename DataType, typename IndexType, typename Blocks>
+  inline int sum_stat_blocks( IndexType num, const Blocks& blocks,
+                              int numcores, DataType& stat ) {
+
+    IndexType nblocks = ( num + STAT_BLOCKSIZE - 1 ) / STAT_BLOCKSIZE;
+    std::vector< DataType > sums( nblocks );
+
+    StatBlockRange< DataType, IndexType, Blocks > range( blocks, num,
+                                                         sums.data() );
+    if ( EXIT_SUCCESS !=
+         sherpa::parallel::parallel_for( nblocks, numcores, range,
+                                         IndexType( STAT_MIN_BLOCKS ) ) )
+      return EXIT_FAILURE;
+
+    stat = sherpa::utils::pairwise_sum( nblocks, sums.data() );
+    return EXIT_SUCCESS;
+
+  }
+
+  //
+  // The multi-dataset version of StatBlockRange: the blocks of all the
+  // data sets are numbered one after the other, with those of set ii
+  // starting at first[ ii ], and block bb of set ii is calculated by
+  // blocks[ ii ].
+  //
+  template <typename DataType, typename IndexType, typename Blocks>
+  class StatSetsBlockRange {
+
+  public:
+
+    StatSetsBlockRange( const std::vector< Blocks >& b,
+                        const std::vector< IndexType >& n,
+                        const std::vector< IndexType >& f, DataType* s )
+      : blocks( b ), num( n ), first( f ), sums( s ) { }
+
+    int operator()( IndexType begin, IndexType end ) {
+
+      // The last set which starts at or before block begin; this
+      // skips over sets with no bins.
+      std::size_t set = std::upper_bound( first.begin(), first.end(),
+                                          begin ) - first.begin() - 1;
+
+      for ( IndexType bb = begin; bb < end; ++bb ) {
+	while ( bb >= first[ set + 1 ] )
+	  ++set;
+	IndexType start = ( bb - first[ set ] ) * STAT_BLOCKSIZE;
+	IndexType n = std::min< IndexType >( STAT_BLOCKSIZE,
+					     num[ set ] - start );
+	if ( EXIT_SUCCESS != blocks[ set ]( start, n, sums[ bb ] ) )
+	  return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    const std::vector< Blocks >& blocks;
+    const std::vector< IndexType >& num;
+    const std::vector< IndexType >& first;
+    DataType* sums;
+
+  };
+
+  //
+  // sum_stat_blocks for several data sets, where set ii has num[ ii ]
+  // bins and its terms are calculated by blocks[ ii ]. The blocks of
+  // all the sets are shared out between the threads, and stat[ ii ]
+  // is set to the value sum_stat_blocks returns for set ii on its own.
+  //
+  template <typename DataType, typename IndexType, typename Blocks>
+  inline int sum_stat_blocks_sets( const std::vector< IndexType >& num,
+                                   const std::vector< Blocks >& blocks,
+                                   int numcores, DataType* stat ) {
+
+    std::size_t nsets = num.size();
+    std::vector< IndexType > first( nsets + 1, 0 );
+    for ( std::size_t ii = 0; ii < nsets; ++ii )
+      first[ ii + 1 ] = first[ ii ] +
+        ( num[ ii ] + STAT_BLOCKSIZE - 1 ) / STAT_BLOCKSIZE;
+
+    std::vector< DataType > sums( first[ nsets ] );
+
+    StatSetsBlockRange< DataType, IndexType, Blocks >
+      range( blocks, num, first, sums.data() );
+    if ( EXIT_SUCCESS !=
+         sherpa::parallel::parallel_for( first[ nsets ], numcores, range,
+                                         IndexType( STAT_MIN_BLOCKS ) ) )
+      return EXIT_FAILURE;
+
+    for ( std::size_t ii = 0; ii < nsets; ++ii )
+      stat[ ii ] = sherpa::utils::pairwise_sum( first[ ii + 1 ] - first[ ii ],
+                                                sums.data() + first[ ii ] );
+
+    return EXIT_SUCCESS;
+
+  }
 
+  //
+  // The derivative of the cash and cstat statistics with respect to
+  // the model, 2 weight ( 1 - data / model ), for bins start to
+  // start + n - 1. Where the model is truncated the term does not
+  // depend on the model, so the derivative is 0.
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline void likelihood_grad_block( IndexType start, IndexType n,
+                                     const ConstArrayType& yraw,
+                                     const ConstArrayType& model,
+                                     const ConstArrayType& weight,
+                                     DataType* grad ) {
+
+    for ( IndexType ii = start; ii < start + n; ++ii ) {
+      if ( model[ ii ] > 0.0 )
+        grad[ ii ] = 2.0 * ( 1.0 - yraw[ ii ] / model[ ii ] );
+      else
+        grad[ ii ] = 0.0;
       if ( weight )
-	d *= weight[ ii ];
+        grad[ ii ] *= weight[ ii ];
+    }
 
-      fvec[ ii ] = d;
+  }
+
+  // The per-bin value returned by the likelihood statistics.
+  template <typename DataType, typename IndexType>
+  inline void likelihood_fvec( IndexType n, DataType* val ) {
+
+    const DataType sqrt2 = std::sqrt( 2.0 );
+    for ( IndexType ii = 0; ii < n; ++ii )
+      val[ ii ] = sqrt2 * std::sqrt( std::fabs( val[ ii ] ) );
+
+  }
+
+  //
+  // The blocks of the cstat and cash statistics: the terms of a block
+  // are added with Kahan summation. If fvec is not NULL then the
+  // per-bin values are also stored in it; for both statistics these
+  // are calculated from the cstat terms. If grad is not NULL then it
+  // is set to the derivative of the statistic with respect to the
+  // model.
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  class CStatBlocks {
+
+  public:
+
+    CStatBlocks( const ConstArrayType& y, const ConstArrayType& m,
+                 const ConstArrayType& w, DataType t, DataType* f,
+                 DataType* g = NULL )
+      : yraw( y ), model( m ), weight( w ), trunc_value( t ), fvec( f ),
+        grad( g ) { }
+
+    int operator()( IndexType start, IndexType n, DataType& sum ) const {
+
+      DataType buf[ STAT_BLOCKSIZE ];
+      DataType* val = fvec ? fvec + start : buf;
+      if ( EXIT_SUCCESS != cstat_block( start, n, yraw, model, weight,
+                                        trunc_value, val ) )
+        return EXIT_FAILURE;
+
+      sum = sherpa::utils::kahan_sum< const DataType*, DataType, IndexType >
+        ( n, val );
+
+      if ( fvec )
+        likelihood_fvec( n, val );
+
+      if ( grad )
+        likelihood_grad_block( start, n, yraw, model, weight, grad );
+
+      return EXIT_SUCCESS;
 
     }
 
-    stat = 2.0 *
-      sherpa::utils::kahan_sum< ArrayType, DataType, IndexType >( num, fvec );
+  private:
+
+    const ConstArrayType& yraw;
+    const ConstArrayType& model;
+    const ConstArrayType& weight;
+    DataType trunc_value;
+    DataType* fvec;
+    DataType* grad;
+
+  };
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  class CashBlocks {
+
+  public:
+
+    CashBlocks( const ConstArrayType& y, const ConstArrayType& m,
+                const ConstArrayType& w, DataType t, DataType* f,
+                DataType* g = NULL )
+      : yraw( y ), model( m ), weight( w ), trunc_value( t ), fvec( f ),
+        grad( g ) { }
+
+    int operator()( IndexType start, IndexType n, DataType& sum ) const {
+
+      DataType val[ STAT_BLOCKSIZE ];
+      if ( EXIT_SUCCESS != cash_block( start, n, yraw, model, weight,
+                                       trunc_value, val ) )
+        return EXIT_FAILURE;
+
+      sum = sherpa::utils::kahan_sum< const DataType*, DataType, IndexType >
+        ( n, val );
+
+      if ( fvec ) {
+        if ( EXIT_SUCCESS != cstat_block( start, n, yraw, model, weight,
+                                          trunc_value, fvec + start ) )
+          return EXIT_FAILURE;
+        likelihood_fvec( n, fvec + start );
+      }
+
+      if ( grad )
+        likelihood_grad_block( start, n, yraw, model, weight, grad );
+
+      return EXIT_SUCCESS;
 
-    {
-      DataType junkcstat;
-      return calc_cstat_stat( num, yraw, model, weight, fvec,
-                              junkcstat, trunc_value );
     }
 
+  private:
+
+    const ConstArrayType& yraw;
+    const ConstArrayType& model;
+    const ConstArrayType& weight;
+    DataType trunc_value;
+    DataType* fvec;
+    DataType* grad;
+
+  };
+
+  //
+  // The blocks of the chi-square and least-squares statistics: the
+  // statistic is the sum of the squares of the per-bin values, which
+  // are BinFunc multiplied by sqrt( weight ) when weight is set. The
+  // squares are added as enorm2 does, using the total number of bins
+  // to pick the scaling, and the per-bin values are stored in fvec
+  // when it is not NULL. When grad is not NULL it is set to the
+  // derivative of the statistic with respect to the model, which is
+  // 2 val d(val)/d(model).
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType,
+            DataType (*BinFunc)( IndexType ii, const ConstArrayType& yraw,
+                                 const ConstArrayType& model,
+                                 const ConstArrayType& error,
+                                 const ConstArrayType& syserror,
+                                 DataType* deriv )>
+  class Chi2Blocks {
+
+  public:
+
+    Chi2Blocks( IndexType n, const ConstArrayType& y,
+                const ConstArrayType& m, const ConstArrayType& e,
+                const ConstArrayType& s, const ConstArrayType* w,
+                DataType* f, DataType* g = NULL )
+      : num( n ), yraw( y ), model( m ), error( e ), syserror( s ),
+        weight( w ), fvec( f ), grad( g ) { }
+
+    int operator()( IndexType start, IndexType n, DataType& sum ) const {
+
+      sherpa::utils::Enorm2Sum< DataType, IndexType > sum2( num );
+      for ( IndexType ii = start; ii < start + n; ++ii ) {
+
+        DataType deriv;
+        DataType val = BinFunc( ii, yraw, model, error, syserror,
+                                grad ? &deriv : NULL );
+
+        if ( weight && *weight ) {
+          if ( !( ( *weight )[ ii ] >= 0.0 ) )
+            return EXIT_FAILURE;
+          DataType sqrtw = std::sqrt( ( *weight )[ ii ] );
+          val *= sqrtw;
+          if ( grad )
+            deriv *= sqrtw;
+        }
+
+        if ( fvec )
+          fvec[ ii ] = val;
+        if ( grad )
+          grad[ ii ] = 2.0 * val * deriv;
+        sum2.add( val );
+
+      }
+
+      sum = sum2.result();
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    IndexType num;
+    const ConstArrayType& yraw;
+    const ConstArrayType& model;
+    const ConstArrayType& error;
+    const ConstArrayType& syserror;
+    const ConstArrayType* weight;
+    DataType* fvec;
+    DataType* grad;
+
+  };
+
+  //
+  // fvec is needed for chi square and lmdif, it is not needed for cStat
+  //
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_cstat_stat( IndexType num, const ConstArrayType& yraw,
+                              const ConstArrayType& model,
+                              const ConstArrayType& weight,
+                              ArrayType& fvec, DataType& stat,
+                              DataType& trunc_value, int numcores ) {
+
+    CStatBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, num > 0 ? &fvec[ 0 ] : NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // fvec is needed for chi square and lmdif, it is not needed for Cash
+  //
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_cash_stat( IndexType num, const ConstArrayType& yraw,
+                             const ConstArrayType& model,
+                             const ConstArrayType& weight, ArrayType& fvec,
+                             DataType& stat, DataType& trunc_value,
+                             int numcores ) {
+
+    CashBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, num > 0 ? &fvec[ 0 ] : NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
     return EXIT_SUCCESS;
 
   }
@@ -152,31 +656,6 @@ namespace sherpa { namespace stats {
 
   }
 
-  template <typename ArrayType, typename ConstArrayType, typename DataType,
-	    typename IndexType>
-  inline int calc_stat( IndexType num, const ConstArrayType& weight,
-                        ArrayType& fvec, DataType& stat ) {
-
-    if ( weight ) {
-      for ( IndexType ii = num - 1; ii >= 0; --ii )
-	if ( weight[ ii ] >= 0.0 ) {
-	  fvec[ ii ] *= std::sqrt( weight[ ii ] );
-	} else {
-	  return EXIT_FAILURE;
-        }
-    }
-
-    stat = sherpa::utils::enorm2< ArrayType, DataType, IndexType >( num, fvec );
-    /*
-    stat = 0.0;
-    for ( IndexType ii = num - 1; ii >= 0; --ii )
-      stat += fvec[ ii ] * fvec[ ii ];
-    */
-
-    return EXIT_SUCCESS;
-
-  }
-
   //
   // upon return from the function calculate_chi2_stat, fvec
   // (an array of length num) shall contain the following values:
@@ -194,27 +673,14 @@ namespace sherpa { namespace stats {
                              const ConstArrayType& error,
                              const ConstArrayType& syserror,
                              const ConstArrayType& weight, ArrayType& fvec,
-                             DataType& stat, DataType& trunc_value ) {
-
-    for ( IndexType ii = num - 1; ii >= 0; --ii ) {
+                             DataType& stat, DataType& trunc_value,
+                             int numcores ) {
 
-      fvec[ ii ] = model[ ii ] - yraw[ ii ];
-
-      DataType err = error[ ii ];
-
-      if ( syserror ) {
-	err *= error[ ii ];
-	err += syserror[ ii ] * syserror[ ii ];
-	err = std::sqrt( err );
-      }
-
-      // the error for Chi2 is 0, so a sanity check is required.
-      if ( 0.0 != err )
-	fvec[ ii ] /= err;
-
-    }
-
-    return sherpa::stats::calc_stat< ArrayType, ConstArrayType, DataType, IndexType >( num, weight, fvec, stat );
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight,
+              num > 0 ? &fvec[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
 
   }
 
@@ -273,29 +739,13 @@ namespace sherpa { namespace stats {
                                    const ConstArrayType& syserror,
                                    const ConstArrayType& weight,
                                    ArrayType& fvec, DataType& stat,
-                                   DataType& trunc_value ) {
-
-    for ( IndexType ii = num - 1; ii >= 0; --ii ) {
+                                   DataType& trunc_value, int numcores ) {
 
-      fvec[ ii ] = yraw[ ii ] - model[ ii ];
-
-      DataType err_sqr = model[ ii ];
-      if ( err_sqr < 1.0 )
-	err_sqr = 1.0;
-      // err_sqr is guaranteed to be >= 1.0
-
-      if ( syserror )
-	err_sqr += syserror[ ii ] * syserror[ ii ];
-
-      // syserror^2 is always >= 0.0, so need to check if err_sqr < 0.0
-      DataType err = std::sqrt( err_sqr );
-
-      // the error is guaranteed to be > 0.0 so err could never be equal to 0.0
-      fvec[ ii ] /= err;
-
-    }
-
-    return sherpa::stats::calc_stat< ArrayType, ConstArrayType, DataType, IndexType >( num, weight, fvec, stat );
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2modvar_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight,
+              num > 0 ? &fvec[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
 
   }
 
@@ -329,35 +779,38 @@ namespace sherpa { namespace stats {
 		      const ConstArrayType& error,
 		      const ConstArrayType& syserror,
 		      const ConstArrayType& weight, ArrayType& fvec,
-		      DataType& stat, DataType& trunc_value ) {
+		      DataType& stat, DataType& trunc_value,
+		      int numcores ) {
 
-    for ( IndexType ii = num - 1; ii >= 0; --ii )
-      fvec[ ii ] = model[ ii ] - yraw[ ii ];
-
-    stat = sherpa::utils::enorm2< ArrayType, DataType, IndexType >( num, fvec );
-    return EXIT_SUCCESS;
+    // The weights are not used by the least-squares statistic.
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                lsq_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, NULL,
+              num > 0 ? &fvec[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
 
   }
 
 
-  template <typename DataType, typename IndexType>
-  inline int my_calc_w_stat( IndexType num, const DataType* src_raw,
-                             const DataType* src_model,
-                             const DataType* bkg_raw,
-                             const DataType* backscale_ratio,
-                             DataType* fvec,
-                             const DataType* src_exp_time,
-                             const DataType* my_bkg_exp_time,
-                             const DataType trunc_value ) {
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline void w_stat_block( IndexType start, IndexType n,
+                            const ConstArrayType& src_raw,
+                            const ConstArrayType& src_model,
+                            const ConstArrayType& bkg_raw,
+                            const ConstArrayType& backscale_ratio,
+                            const ConstArrayType& src_exp_time,
+                            const ConstArrayType& my_bkg_exp_time,
+                            const DataType trunc_value, DataType* val,
+                            DataType* grad = NULL ) {
 
     //
     // heasarc.gsfc.nasa.gov/xanadu/xspec/manual/XSappendixStatistics.html
     //
     //
-    // S     = src_raw[ ii ]
+    // S     = src_raw
     //  i
     //
-    // B     = bkg_raw[ ii ]
+    // B     = bkg_raw
     //  i
     //
     // t     = src_exp_time
@@ -366,7 +819,7 @@ namespace sherpa { namespace stats {
     // t     = bkg_exp_time
     //  b
     //
-    // t  m  = src_model[ ii ]
+    // t  m  = src_model
     //  s  i
     //
     // The exposure times may be "corrected" by multiplying by
@@ -374,21 +827,85 @@ namespace sherpa { namespace stats {
     // "specification" but appears to be how XSPEC handles the
     // AREASCAL correction (private communication with Keith Arnaud).
     //
-    for ( IndexType ii = num - 1; ii >= 0; --ii ) {
+    // Each bin needs at most four logarithms; the first pass sets up
+    // their arguments (unused slots are left at 1) and the second
+    // combines them once log_vec has been applied.
+    //
+    // When grad is not NULL then grad[0] to grad[n-1] are set to the
+    // derivatives of the terms with respect to the model. Since f
+    // minimises W  for the given model, this is just the partial
+    //            i
+    // derivative with f fixed: 1 - S  / ( t  m  + t  f ).
+    //                               i      s  i    s  i
+    //
+    DataType fsubi[ STAT_BLOCKSIZE ];
+    DataType arg1[ STAT_BLOCKSIZE ] = { 0 }, arg2[ STAT_BLOCKSIZE ] = { 0 };
+    DataType arg3[ STAT_BLOCKSIZE ] = { 0 }, arg4[ STAT_BLOCKSIZE ] = { 0 };
+    DataType log1[ STAT_BLOCKSIZE ], log2[ STAT_BLOCKSIZE ];
+    DataType log3[ STAT_BLOCKSIZE ], log4[ STAT_BLOCKSIZE ];
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      const IndexType jj = start + ii;
 
       //
       // Must scale the background area to the source area
       //
-      DataType bkg_exp_time = my_bkg_exp_time[ ii ] * backscale_ratio[ ii ];
-      DataType src_bkg_time = src_exp_time[ ii ] + bkg_exp_time;
-      DataType ln_ts_div_src_bkg_time =
-        std::log( src_exp_time[ ii ] / src_bkg_time );
-      DataType ln_tb_div_src_bkg_time =
-        std::log( bkg_exp_time / src_bkg_time );
+      DataType bkg_exp_time = my_bkg_exp_time[ jj ] * backscale_ratio[ jj ];
+      DataType src_bkg_time = src_exp_time[ jj ] + bkg_exp_time;
+
+      fsubi[ ii ] = 0.0;
+      arg1[ ii ] = arg2[ ii ] = arg3[ ii ] = arg4[ ii ] = 1.0;
+
+      if ( 0 == src_raw[ jj ] ) {
+
+        arg1[ ii ] = bkg_exp_time / src_bkg_time;
+
+      } else if ( 0 == bkg_raw[ jj ] ) {
 
-      DataType msubi = src_model[ ii ] / src_exp_time[ ii ];
-      DataType tb_msubi = bkg_exp_time * msubi;
-      DataType ts_msubi = src_exp_time[ ii ] * msubi;
+        if ( !( src_model[ jj ] <= 0 ) )
+          arg1[ ii ] = src_model[ jj ];
+        arg2[ ii ] = src_raw[ jj ];
+
+      } else {
+
+        DataType msubi = src_model[ jj ] / src_exp_time[ jj ];
+        DataType raw_data = src_raw[ jj ] + bkg_raw[ jj ];
+        DataType src_bkg_time_msubi = src_bkg_time * msubi;
+        DataType tmp1 = src_bkg_time_msubi - raw_data;
+        DataType tmp2 = src_bkg_time * bkg_raw[ jj ] * msubi;
+        DataType dsubi = std::sqrt( tmp1 * tmp1 + 4.0 * tmp2 );
+        DataType f = ( raw_data - src_bkg_time_msubi + dsubi ) /
+          ( 2.0 * src_bkg_time );
+        fsubi[ ii ] = f;
+
+        DataType model_srcexptime_fsubi = src_model[ jj ] +
+          src_exp_time[ jj ] * f;
+        DataType bkgexptime_fsubi = bkg_exp_time * f;
+        if ( !( model_srcexptime_fsubi <= 0 ) )
+          arg1[ ii ] = model_srcexptime_fsubi;
+        if ( !( bkgexptime_fsubi <= 0 ) )
+          arg2[ ii ] = bkgexptime_fsubi;
+        arg3[ ii ] = src_raw[ jj ];
+        arg4[ ii ] = bkg_raw[ jj ];
+
+      }
+
+    }
+
+    sherpa::utils::log_vec( n, arg1, log1 );
+    sherpa::utils::log_vec( n, arg2, log2 );
+    sherpa::utils::log_vec( n, arg3, log3 );
+    sherpa::utils::log_vec( n, arg4, log4 );
+
+    for ( IndexType ii = 0; ii < n; ++ii ) {
+
+      const IndexType jj = start + ii;
+      const DataType src = src_raw[ jj ];
+      const DataType bkg = bkg_raw[ jj ];
+
+      DataType bkg_exp_time = my_bkg_exp_time[ jj ] * backscale_ratio[ jj ];
+      DataType src_bkg_time = src_exp_time[ jj ] + bkg_exp_time;
 
       //
       // If any bin has S and/or B  zero then its contribution to W (W )
@@ -396,9 +913,13 @@ namespace sherpa { namespace stats {
       //
       // is calculated as a special case.
       //
-      if ( 0 == src_raw[ ii ] ) {
+      if ( 0 == src ) {
 
-        fvec[ ii ] = ts_msubi - bkg_raw[ ii ] * ln_tb_div_src_bkg_time;
+        DataType msubi = src_model[ jj ] / src_exp_time[ jj ];
+        DataType ts_msubi = src_exp_time[ jj ] * msubi;
+        val[ ii ] = ts_msubi - bkg * log1[ ii ];
+        if ( grad )
+          grad[ ii ] = 1.0;
         //
         // So, if S is zero then:
         //         i
@@ -410,17 +931,15 @@ namespace sherpa { namespace stats {
         // W_i = t_sm_i-B_i\ln{(t_b/(t_s+t_b))}
         //
 
+      } else if ( 0 == bkg ) {
 
-      } else if ( 0 == bkg_raw[ ii ] ) {
-
-        //if ( msubi < src_raw[ ii ] / src_bkg_time )
-        //  fvec[ ii ] = - tb_msubi - src_raw[ ii ] * ln_ts_div_src_bkg_time;
-        //else {
-          DataType log_src_model =
-            src_model[ ii ] <= 0 ? trunc_value : std::log( src_model[ ii ] );
-          fvec[ ii ] = src_model[ ii ] +
-            src_raw[ ii ] * ( std::log( src_raw[ ii ] ) - log_src_model - 1 );
-        //}
+        DataType log_src_model =
+          src_model[ jj ] <= 0 ? trunc_value : log1[ ii ];
+        val[ ii ] = src_model[ jj ] +
+          src * ( log2[ ii ] - log_src_model - 1 );
+        if ( grad )
+          grad[ ii ] = src_model[ jj ] <= 0 ? 1.0 :
+            1.0 - src / src_model[ jj ];
 
         //
         // If B is zero then there are two special cases.
@@ -448,24 +967,21 @@ namespace sherpa { namespace stats {
 
       } else {
 
-        DataType raw_data = src_raw[ ii ] + bkg_raw[ ii ];
-        DataType src_bkg_time_msubi = src_bkg_time * msubi;
-        DataType tmp1 = src_bkg_time_msubi - raw_data;
-        DataType tmp2 = src_bkg_time * bkg_raw[ ii ] * msubi;
-        DataType dsubi = std::sqrt( tmp1 * tmp1 + 4.0 * tmp2 );
-        DataType fsubi = ( raw_data - src_bkg_time_msubi + dsubi ) /
-          ( 2.0 * src_bkg_time );
+        DataType f = fsubi[ ii ];
+        DataType model_srcexptime_fsubi =
+          src_model[ jj ] + src_exp_time[ jj ] * f;
         DataType log_model_srcexptime_fsubi =
-          src_model[ ii ] + src_exp_time[ ii ] * fsubi <= 0 ? trunc_value :
-          std::log( src_model[ ii ] + src_exp_time[ ii ] * fsubi );
+          model_srcexptime_fsubi <= 0 ? trunc_value : log1[ ii ];
+        if ( grad )
+          grad[ ii ] = model_srcexptime_fsubi <= 0 ? 1.0 :
+            1.0 - src / model_srcexptime_fsubi;
         DataType log_bkgexptime_fsubi =
-          bkg_exp_time * fsubi <= 0 ? trunc_value :
-          std::log( bkg_exp_time * fsubi );
-        fvec[ ii ] = src_model[ ii ] + src_bkg_time * fsubi -
-          src_raw[ ii ] * log_model_srcexptime_fsubi -
-          bkg_raw[ ii ] * log_bkgexptime_fsubi -
-          src_raw[ ii ] * ( 1.0 - std::log( src_raw[ ii ] ) ) -
-          bkg_raw[ ii ] * ( 1.0 - std::log( bkg_raw[ ii ] ) );
+          bkg_exp_time * f <= 0 ? trunc_value : log2[ ii ];
+        val[ ii ] = src_model[ jj ] + src_bkg_time * f -
+          src * log_model_srcexptime_fsubi -
+          bkg * log_bkgexptime_fsubi -
+          src * ( 1.0 - log3[ ii ] ) -
+          bkg * ( 1.0 - log4[ ii ] );
 
         //
         //  W   =  t  m  + ( t  + t ) f - S ln( t  m + t  f ) - B ln( t  f ) -
@@ -504,10 +1020,58 @@ namespace sherpa { namespace stats {
 
     }
 
-    return EXIT_SUCCESS;
-
   }
 
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  class WStatBlocks {
+
+  public:
+
+    WStatBlocks( const ConstArrayType& s, const ConstArrayType& m,
+                 const ConstArrayType& b, const ConstArrayType& r,
+                 const ConstArrayType& es, const ConstArrayType& eb,
+                 DataType t, DataType* f, DataType* g = NULL )
+      : src_raw( s ), src_model( m ), bkg_raw( b ), backscale_ratio( r ),
+        src_exp_time( es ), bkg_exp_time( eb ), trunc_value( t ),
+        fvec( f ), grad( g ) { }
+
+    int operator()( IndexType start, IndexType n, DataType& sum ) const {
+
+      DataType buf[ STAT_BLOCKSIZE ];
+      DataType* val = fvec ? fvec + start : buf;
+      w_stat_block( start, n, src_raw, src_model, bkg_raw, backscale_ratio,
+                    src_exp_time, bkg_exp_time, trunc_value, val,
+                    grad ? grad + start : NULL );
+
+      sum = sherpa::utils::kahan_sum< const DataType*, DataType, IndexType >
+        ( n, val );
+
+      if ( fvec )
+        likelihood_fvec( n, val );
+
+      // The statistic is twice the sum of the terms.
+      if ( grad )
+        for ( IndexType ii = start; ii < start + n; ++ii )
+          grad[ ii ] *= 2.0;
+
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    const ConstArrayType& src_raw;
+    const ConstArrayType& src_model;
+    const ConstArrayType& bkg_raw;
+    const ConstArrayType& backscale_ratio;
+    const ConstArrayType& src_exp_time;
+    const ConstArrayType& bkg_exp_time;
+    DataType trunc_value;
+    DataType* fvec;
+    DataType* grad;
+
+  };
+
 template <typename ArrayType, typename ConstArrayType, typename DataType,
           typename IndexType, typename iArrayType>
   inline int calc_wstat_stat( IndexType num, const ConstArrayType& yraw,
@@ -518,44 +1082,517 @@ template <typename ArrayType, typename ConstArrayType, typename DataType,
                               const ConstArrayType& bkg,
                               const ConstArrayType& backscale_ratio,
                               ArrayType& fvec, DataType& stat,
-                              const DataType trunc_value ) {
+                              const DataType trunc_value, int numcores ) {
 
   /* The initial attempt at including the areascal correction replaces
      the exposure_time array (expected to have 2 * ndata elements,
      alternating source and background values) with exposure_src
      and exposure_bg arrays (each containing a value for each channel).
   */
-  const IndexType num_data_sets = data_size.get_size( );
 
-  int offset = 0;
+  // The data sets are stored one after the other, and the per-bin
+  // term does not depend on which set a bin belongs to, so the bins
+  // can be processed as one array.
+  //
+  WStatBlocks< ConstArrayType, DataType, IndexType >
+    blocks( yraw, model, bkg, backscale_ratio, exposure_src, exposure_bkg,
+            trunc_value, num > 0 ? &fvec[ 0 ] : NULL );
+  if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+    return EXIT_FAILURE;
+
+  stat *= 2.0;
+  return EXIT_SUCCESS;
+}
+
+  //
+  // The calc_*_stat_value routines return the same statistic as the
+  // matching calc_*_stat routine, using the same blocks, but do not
+  // store the per-bin values, so no fvec is needed.
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_cstat_stat_value( IndexType num, const ConstArrayType& yraw,
+                                    const ConstArrayType& model,
+                                    const ConstArrayType& weight,
+                                    DataType& stat,
+                                    DataType& trunc_value, int numcores ) {
+
+    CStatBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
 
-  for ( IndexType ii = 0; ii < num_data_sets; ++ii ) {
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_cash_stat_value( IndexType num, const ConstArrayType& yraw,
+                                   const ConstArrayType& model,
+                                   const ConstArrayType& weight,
+                                   DataType& stat,
+                                   DataType& trunc_value, int numcores ) {
 
-    const double* src_raw = &yraw[ offset ];
-    const double* src_model = &model[ offset ];
-    const double* bkg_raw = &bkg[ offset ];
-    const double* ratio_backscale = &backscale_ratio[ offset ];
+    CashBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
 
-    const double* resp_exp_time = &exposure_src[ offset ];
-    const double* bkg_exp_time  = &exposure_bkg[ offset ];
+    stat *= 2.0;
+    return EXIT_SUCCESS;
 
-    my_calc_w_stat( data_size[ ii ], src_raw,
-                    src_model, bkg_raw, ratio_backscale, &fvec[ offset ],
-                    resp_exp_time, bkg_exp_time, trunc_value );
+  }
 
-    offset += data_size[ ii ];
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_chi2_stat_value( IndexType num, const ConstArrayType& yraw,
+                                   const ConstArrayType& model,
+                                   const ConstArrayType& error,
+                                   const ConstArrayType& syserror,
+                                   const ConstArrayType& weight,
+                                   DataType& stat, DataType& trunc_value,
+                                   int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight, NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
 
   }
 
-  stat = 2.0 *
-    sherpa::utils::kahan_sum< ArrayType, DataType, IndexType >( num, fvec );
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_chi2modvar_stat_value( IndexType num,
+                                         const ConstArrayType& yraw,
+                                         const ConstArrayType& model,
+                                         const ConstArrayType& error,
+                                         const ConstArrayType& syserror,
+                                         const ConstArrayType& weight,
+                                         DataType& stat,
+                                         DataType& trunc_value,
+                                         int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2modvar_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight, NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
 
-  DataType sqrt2 = std::sqrt( 2.0 );
-  for ( IndexType ii = num - 1; ii >= 0; --ii )
-    fvec[ ii ] = sqrt2 * std::sqrt( std::fabs(fvec[ii]) );
+  }
 
-  return EXIT_SUCCESS;
-}
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_lsq_stat_value( IndexType num, const ConstArrayType& yraw,
+                                  const ConstArrayType& model,
+                                  const ConstArrayType& error,
+                                  const ConstArrayType& syserror,
+                                  const ConstArrayType& weight,
+                                  DataType& stat, DataType& trunc_value,
+                                  int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                lsq_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, NULL, NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType,
+            typename iArrayType>
+  inline int calc_wstat_stat_value( IndexType num, const ConstArrayType& yraw,
+                                    const ConstArrayType& model,
+                                    const iArrayType& data_size,
+                                    const ConstArrayType& exposure_src,
+                                    const ConstArrayType& exposure_bkg,
+                                    const ConstArrayType& bkg,
+                                    const ConstArrayType& backscale_ratio,
+                                    DataType& stat,
+                                    const DataType trunc_value,
+                                    int numcores ) {
+
+    WStatBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, bkg, backscale_ratio, exposure_src, exposure_bkg,
+              trunc_value, NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
+
+  //
+  // The calc_*_stat_grad routines return the same statistic as the
+  // matching calc_*_stat routine, but instead of the per-bin values
+  // grad is set to the derivative of the statistic with respect to
+  // each model value, d(stat) / d(model[ ii ]), which is calculated
+  // in the same pass over the bins. Combined with the derivatives of
+  // the model this gives the gradient of the statistic with respect
+  // to the parameters.
+  //
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_cstat_stat_grad( IndexType num, const ConstArrayType& yraw,
+                                   const ConstArrayType& model,
+                                   const ConstArrayType& weight,
+                                   ArrayType& grad, DataType& stat,
+                                   DataType& trunc_value, int numcores ) {
+
+    CStatBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, NULL,
+              num > 0 ? &grad[ 0 ] : NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_cash_stat_grad( IndexType num, const ConstArrayType& yraw,
+                                  const ConstArrayType& model,
+                                  const ConstArrayType& weight,
+                                  ArrayType& grad, DataType& stat,
+                                  DataType& trunc_value, int numcores ) {
+
+    CashBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, weight, trunc_value, NULL,
+              num > 0 ? &grad[ 0 ] : NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_chi2_stat_grad( IndexType num, const ConstArrayType& yraw,
+                                  const ConstArrayType& model,
+                                  const ConstArrayType& error,
+                                  const ConstArrayType& syserror,
+                                  const ConstArrayType& weight,
+                                  ArrayType& grad, DataType& stat,
+                                  DataType& trunc_value, int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight, NULL,
+              num > 0 ? &grad[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_chi2modvar_stat_grad( IndexType num,
+                                        const ConstArrayType& yraw,
+                                        const ConstArrayType& model,
+                                        const ConstArrayType& error,
+                                        const ConstArrayType& syserror,
+                                        const ConstArrayType& weight,
+                                        ArrayType& grad, DataType& stat,
+                                        DataType& trunc_value,
+                                        int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                chi2modvar_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, &weight, NULL,
+              num > 0 ? &grad[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_lsq_stat_grad( IndexType num, const ConstArrayType& yraw,
+                                 const ConstArrayType& model,
+                                 const ConstArrayType& error,
+                                 const ConstArrayType& syserror,
+                                 const ConstArrayType& weight,
+                                 ArrayType& grad, DataType& stat,
+                                 DataType& trunc_value, int numcores ) {
+
+    Chi2Blocks< ConstArrayType, DataType, IndexType,
+                lsq_bin< ConstArrayType, DataType, IndexType > >
+      blocks( num, yraw, model, error, syserror, NULL, NULL,
+              num > 0 ? &grad[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+            typename IndexType, typename iArrayType>
+  inline int calc_wstat_stat_grad( IndexType num, const ConstArrayType& yraw,
+                                   const ConstArrayType& model,
+                                   const iArrayType& data_size,
+                                   const ConstArrayType& exposure_src,
+                                   const ConstArrayType& exposure_bkg,
+                                   const ConstArrayType& bkg,
+                                   const ConstArrayType& backscale_ratio,
+                                   ArrayType& grad, DataType& stat,
+                                   const DataType trunc_value,
+                                   int numcores ) {
+
+    WStatBlocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, bkg, backscale_ratio, exposure_src, exposure_bkg,
+              trunc_value, NULL, num > 0 ? &grad[ 0 ] : NULL );
+    if ( EXIT_SUCCESS != sum_stat_blocks( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    stat *= 2.0;
+    return EXIT_SUCCESS;
+
+  }
+
+  //
+  // The chi-square statistic when the data and errors do not change,
+  // as in a fit: scale[ ii ] is sqrt( weight[ ii ] ) / error[ ii ],
+  // the square root of the inverse variance (with the error including
+  // any systematic term), which only has to be calculated once. The
+  // per-bin value is then ( model - data ) * scale, and the statistic
+  // is the sum of the squares of these values (without the scaling
+  // Enorm2Sum uses to avoid overflow).
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  class PreparedChi2Blocks {
+
+  public:
+
+    PreparedChi2Blocks( const ConstArrayType& y, const ConstArrayType& m,
+                        const ConstArrayType& s, DataType* f )
+      : yraw( y ), model( m ), scale( s ), fvec( f ) { }
+
+    int operator()( IndexType start, IndexType n, DataType& sum ) const {
+
+      DataType buf[ STAT_BLOCKSIZE ];
+      DataType* val = fvec ? fvec + start : buf;
+      for ( IndexType ii = 0; ii < n; ++ii )
+        val[ ii ] = ( model[ start + ii ] - yraw[ start + ii ] ) *
+          scale[ start + ii ];
+
+      sum = sherpa::utils::sum_squares_vec( n, val );
+      return EXIT_SUCCESS;
+
+    }
+
+  private:
+
+    const ConstArrayType& yraw;
+    const ConstArrayType& model;
+    const ConstArrayType& scale;
+    DataType* fvec;
+
+  };
+
+  template <typename ArrayType, typename ConstArrayType, typename DataType,
+	    typename IndexType>
+  inline int calc_chi2_stat_prepared( IndexType num,
+                                      const ConstArrayType& yraw,
+                                      const ConstArrayType& model,
+                                      const ConstArrayType& scale,
+                                      ArrayType& fvec, DataType& stat,
+                                      int numcores ) {
+
+    PreparedChi2Blocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, scale, num > 0 ? &fvec[ 0 ] : NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_chi2_stat_prepared_value( IndexType num,
+                                            const ConstArrayType& yraw,
+                                            const ConstArrayType& model,
+                                            const ConstArrayType& scale,
+                                            DataType& stat, int numcores ) {
+
+    PreparedChi2Blocks< ConstArrayType, DataType, IndexType >
+      blocks( yraw, model, scale, NULL );
+    return sum_stat_blocks( num, blocks, numcores, stat );
+
+  }
+
+  //
+  // The calc_*_stat_sets routines calculate a statistic for several
+  // data sets without combining their arrays: set ii has num[ ii ]
+  // bins, stored in yraw[ ii ], model[ ii ], and so on, and stat[ ii ]
+  // is set to the statistic for the set, which is the value the
+  // matching calc_*_stat routine returns for it. Unless fvec is NULL
+  // the per-bin values of the sets are written to it one after the
+  // other.
+  //
+  template <typename ConstArrayType, typename DataType, typename IndexType,
+            DataType (*BinFunc)( IndexType ii, const ConstArrayType& yraw,
+                                 const ConstArrayType& model,
+                                 const ConstArrayType& error,
+                                 const ConstArrayType& syserror,
+                                 DataType* deriv )>
+  inline int chi2_stat_sets( const std::vector< IndexType >& num,
+                             const std::vector< ConstArrayType >& yraw,
+                             const std::vector< ConstArrayType >& model,
+                             const std::vector< ConstArrayType >& error,
+                             const std::vector< ConstArrayType >& syserror,
+                             const std::vector< ConstArrayType >* weight,
+                             DataType* fvec, DataType* stat,
+                             int numcores ) {
+
+    typedef Chi2Blocks< ConstArrayType, DataType, IndexType, BinFunc > Blocks;
+
+    std::vector< Blocks > blocks;
+    blocks.reserve( num.size() );
+    IndexType offset = 0;
+    for ( std::size_t ii = 0; ii < num.size(); ++ii ) {
+      blocks.push_back( Blocks( num[ ii ], yraw[ ii ], model[ ii ],
+                                error[ ii ], syserror[ ii ],
+                                weight ? &( *weight )[ ii ] : NULL,
+                                fvec ? fvec + offset : NULL ) );
+      offset += num[ ii ];
+    }
+
+    return sum_stat_blocks_sets( num, blocks, numcores, stat );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_chi2_stat_sets( const std::vector< IndexType >& num,
+                                  const std::vector< ConstArrayType >& yraw,
+                                  const std::vector< ConstArrayType >& model,
+                                  const std::vector< ConstArrayType >& error,
+                                  const std::vector< ConstArrayType >& syserror,
+                                  const std::vector< ConstArrayType >& weight,
+                                  DataType* fvec, DataType* stat,
+                                  DataType& trunc_value, int numcores ) {
+
+    return chi2_stat_sets< ConstArrayType, DataType, IndexType,
+                           chi2_bin< ConstArrayType, DataType, IndexType > >
+      ( num, yraw, model, error, syserror, &weight, fvec, stat, numcores );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int
+  calc_chi2modvar_stat_sets( const std::vector< IndexType >& num,
+                             const std::vector< ConstArrayType >& yraw,
+                             const std::vector< ConstArrayType >& model,
+                             const std::vector< ConstArrayType >& error,
+                             const std::vector< ConstArrayType >& syserror,
+                             const std::vector< ConstArrayType >& weight,
+                             DataType* fvec, DataType* stat,
+                             DataType& trunc_value, int numcores ) {
+
+    return chi2_stat_sets< ConstArrayType, DataType, IndexType,
+                           chi2modvar_bin< ConstArrayType, DataType,
+                                           IndexType > >
+      ( num, yraw, model, error, syserror, &weight, fvec, stat, numcores );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_lsq_stat_sets( const std::vector< IndexType >& num,
+                                 const std::vector< ConstArrayType >& yraw,
+                                 const std::vector< ConstArrayType >& model,
+                                 const std::vector< ConstArrayType >& error,
+                                 const std::vector< ConstArrayType >& syserror,
+                                 const std::vector< ConstArrayType >& weight,
+                                 DataType* fvec, DataType* stat,
+                                 DataType& trunc_value, int numcores ) {
+
+    // The weights are not used by the least-squares statistic.
+    return chi2_stat_sets< ConstArrayType, DataType, IndexType,
+                           lsq_bin< ConstArrayType, DataType, IndexType > >
+      ( num, yraw, model, error, syserror, NULL, fvec, stat, numcores );
+
+  }
+
+  // Blocks is CStatBlocks or CashBlocks.
+  template <typename Blocks, typename ConstArrayType, typename DataType,
+            typename IndexType>
+  inline int lklhd_stat_sets( const std::vector< IndexType >& num,
+                              const std::vector< ConstArrayType >& yraw,
+                              const std::vector< ConstArrayType >& model,
+                              const std::vector< ConstArrayType >& weight,
+                              DataType* fvec, DataType* stat,
+                              DataType trunc_value, int numcores ) {
+
+    std::vector< Blocks > blocks;
+    blocks.reserve( num.size() );
+    IndexType offset = 0;
+    for ( std::size_t ii = 0; ii < num.size(); ++ii ) {
+      blocks.push_back( Blocks( yraw[ ii ], model[ ii ], weight[ ii ],
+                                trunc_value, fvec ? fvec + offset : NULL ) );
+      offset += num[ ii ];
+    }
+
+    if ( EXIT_SUCCESS != sum_stat_blocks_sets( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    for ( std::size_t ii = 0; ii < num.size(); ++ii )
+      stat[ ii ] *= 2.0;
+
+    return EXIT_SUCCESS;
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_cash_stat_sets( const std::vector< IndexType >& num,
+                                  const std::vector< ConstArrayType >& yraw,
+                                  const std::vector< ConstArrayType >& model,
+                                  const std::vector< ConstArrayType >& weight,
+                                  DataType* fvec, DataType* stat,
+                                  DataType& trunc_value, int numcores ) {
+
+    return lklhd_stat_sets< CashBlocks< ConstArrayType, DataType, IndexType > >
+      ( num, yraw, model, weight, fvec, stat, trunc_value, numcores );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int calc_cstat_stat_sets( const std::vector< IndexType >& num,
+                                   const std::vector< ConstArrayType >& yraw,
+                                   const std::vector< ConstArrayType >& model,
+                                   const std::vector< ConstArrayType >& weight,
+                                   DataType* fvec, DataType* stat,
+                                   DataType& trunc_value, int numcores ) {
+
+    return lklhd_stat_sets< CStatBlocks< ConstArrayType, DataType, IndexType > >
+      ( num, yraw, model, weight, fvec, stat, trunc_value, numcores );
+
+  }
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline int
+  calc_wstat_stat_sets( const std::vector< IndexType >& num,
+                        const std::vector< ConstArrayType >& yraw,
+                        const std::vector< ConstArrayType >& model,
+                        const std::vector< ConstArrayType >& exposure_src,
+                        const std::vector< ConstArrayType >& exposure_bkg,
+                        const std::vector< ConstArrayType >& bkg,
+                        const std::vector< ConstArrayType >& backscale_ratio,
+                        DataType* fvec, DataType* stat,
+                        const DataType trunc_value, int numcores ) {
+
+    typedef WStatBlocks< ConstArrayType, DataType, IndexType > Blocks;
+
+    std::vector< Blocks > blocks;
+    blocks.reserve( num.size() );
+    IndexType offset = 0;
+    for ( std::size_t ii = 0; ii < num.size(); ++ii ) {
+      blocks.push_back( Blocks( yraw[ ii ], model[ ii ], bkg[ ii ],
+                                backscale_ratio[ ii ], exposure_src[ ii ],
+                                exposure_bkg[ ii ], trunc_value,
+                                fvec ? fvec + offset : NULL ) );
+      offset += num[ ii ];
+    }
+
+    if ( EXIT_SUCCESS != sum_stat_blocks_sets( num, blocks, numcores, stat ) )
+      return EXIT_FAILURE;
+
+    for ( std::size_t ii = 0; ii < num.size(); ++ii )
+      stat[ ii ] *= 2.0;
+
+    return EXIT_SUCCESS;
+
+  }
 
 }  }  /* namespace stats, namespace sherpa */
 
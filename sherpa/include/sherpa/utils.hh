@@ -113,85 +113,104 @@ namespace sherpa { namespace utils {
    *
    *     **********
    */
-  template <typename ConstArrayType, typename DataType, typename IndexType>
-  inline DataType enorm2( IndexType n, const ConstArrayType& x ) {
+  //
+  // Enorm2Sum accumulates the values one at a time, so that callers
+  // which compute the values on the fly do not need to store them;
+  // adding x[0], ..., x[n-1] in order gives the same answer as enorm2.
+  //
+  template <typename DataType, typename IndexType>
+  class Enorm2Sum {
+
+  public:
 
-    // int i;
-    DataType agiant, floatn, s1, s2, s3, xabs, x1max, x3max;
-    DataType ans, temp;
-    static DataType rdwarf = 3.834e-20;
-    static DataType rgiant = 1.304e19;
-    static DataType zero = 0.0;
-    static DataType one = 1.0;
-    /*double fabs(), sqrt();*/
-
-    s1 = zero;
-    s2 = zero;
-    s3 = zero;
-    x1max = zero;
-    x3max = zero;
-    floatn = n;
-    agiant = rgiant / floatn;
-
-    for (IndexType i = 0; i < n; i++) {
-      xabs = std::fabs(x[i]);
-      if ((xabs > rdwarf) && (xabs < agiant)) {
+    explicit Enorm2Sum( IndexType n )
+      : s1( 0.0 ), s2( 0.0 ), s3( 0.0 ), x1max( 0.0 ), x3max( 0.0 ),
+        agiant( rgiant() / DataType( n ) ) { }
+
+    inline void add( DataType x ) {
+
+      DataType xabs = std::fabs(x);
+      DataType temp;
+      if ((xabs > rdwarf()) && (xabs < agiant)) {
 	/*
 	 *	    sum for intermediate components.
 	 */
 	s2 += xabs * xabs;
-	continue;
+	return;
       }
 
-      if (xabs > rdwarf) {
+      if (xabs > rdwarf()) {
 	/*
 	 *	       sum for large components.
 	 */
 	if (xabs > x1max) {
 	  temp = x1max / xabs;
-	  s1 = one + s1 * temp * temp;
+	  s1 = 1.0 + s1 * temp * temp;
 	  x1max = xabs;
 	} else {
 	  temp = xabs / x1max;
 	  s1 += temp * temp;
 	}
-	continue;
+	return;
       }
       /*
        *	       sum for small components.
        */
       if (xabs > x3max) {
 	temp = x3max / xabs;
-	s3 = one + s3 * temp * temp;
+	s3 = 1.0 + s3 * temp * temp;
 	x3max = xabs;
       } else {
-	if (xabs != zero) {
+	if (xabs != 0.0) {
 	  temp = xabs / x3max;
 	  s3 += temp * temp;
 	}
       }
+
     }
-    /*
-     *     calculation of norm.
-     */
-    if (s1 != zero) {
-      temp = s1 + (s2 / x1max) / x1max;
-      // ans = x1max * sqrt(temp);
-      ans = x1max * temp;
-      return (ans);
-    }
-    if (s2 != zero) {
-      if (s2 >= x3max)
-	temp = s2 * (one + (x3max / s2) * (x3max * s3));
-      else
-	temp = x3max * ((s2 / x3max) + (x3max * s3));
-      // ans = sqrt(temp);
-      ans = temp;
-    } else {
+
+    inline DataType result() const {
+
+      DataType temp;
+      /*
+       *     calculation of norm.
+       */
+      if (s1 != 0.0) {
+	temp = s1 + (s2 / x1max) / x1max;
+	// ans = x1max * sqrt(temp);
+	return x1max * temp;
+      }
+      if (s2 != 0.0) {
+	if (s2 >= x3max)
+	  temp = s2 * (1.0 + (x3max / s2) * (x3max * s3));
+	else
+	  temp = x3max * ((s2 / x3max) + (x3max * s3));
+	// ans = sqrt(temp);
+	return temp;
+      }
       // ans = x3max * sqrt(s3);
-      ans = x3max * s3;
+      return x3max * s3;
+
     }
-    return (ans);
+
+  private:
+
+    static DataType rdwarf() { return 3.834e-20; }
+    static DataType rgiant() { return 1.304e19; }
+
+    DataType s1, s2, s3, x1max, x3max;
+    const DataType agiant;
+
+  };
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline DataType enorm2( IndexType n, const ConstArrayType& x ) {
+
+    Enorm2Sum< DataType, IndexType > sum( n );
+    for (IndexType i = 0; i < n; i++)
+      sum.add( x[i] );
+    return sum.result();
+
     /*
      *     last card of function enorm2.
      */
@@ -211,22 +230,70 @@ namespace sherpa { namespace utils {
   }
 
 
-  template <typename ConstArrayType, typename DataType, typename IndexType>
-  inline DataType kahan_sum( IndexType num, const ConstArrayType& vals ) {
+  //
+  // The running form of kahan_sum: the first value starts the sum and
+  // the rest are compensated, exactly as kahan_sum does for an array.
+  //
+  template <typename DataType>
+  class KahanSum {
+
+  public:
 
-    DataType sum = vals[ 0 ];
-    DataType correction = 0.0;
+    KahanSum() : sum( 0.0 ), correction( 0.0 ), empty( true ) { }
 
-    for ( IndexType ii = 1; ii < num; ii++ ) {
+    inline void add( DataType val ) {
+
+      if ( empty ) {
+        sum = val;
+        empty = false;
+        return;
+      }
 
-      DataType y = vals[ ii ] - correction;
+      DataType y = val - correction;
       DataType t = sum + y;
       correction = t - sum - y;
       sum = t;
 
     }
 
-    return sum;
+    inline DataType result() const { return sum; }
+
+  private:
+
+    DataType sum;
+    DataType correction;
+    bool empty;
+
+  };
+
+  template <typename ConstArrayType, typename DataType, typename IndexType>
+  inline DataType kahan_sum( IndexType num, const ConstArrayType& vals ) {
+
+    KahanSum< DataType > sum;
+    for ( IndexType ii = 0; ii < num; ii++ )
+      sum.add( vals[ ii ] );
+    return sum.result();
+
+  }
+
+  //
+  // Pairwise (cascade) summation: the array is split in two, each half
+  // is summed, and the two results added, so the rounding error grows
+  // with log(num) rather than num. The order of the additions depends
+  // only on num.
+  //
+  template <typename DataType, typename IndexType>
+  inline DataType pairwise_sum( IndexType num, const DataType* vals ) {
+
+    if ( num <= 8 ) {
+      DataType sum = 0.0;
+      for ( IndexType ii = 0; ii < num; ii++ )
+	sum += vals[ ii ];
+      return sum;
+    }
+
+    IndexType half = num / 2;
+    return pairwise_sum( half, vals ) + pairwise_sum( num - half, vals + half );
 
   }
 
@@ -314,6 +381,68 @@ namespace sherpa { namespace utils {
 
   }
 
+
+  //
+  // The derivatives of radius2 with respect to p[1] to p[4] (xpos,
+  // ypos, ellip, theta), stored in grad[0] to grad[3].
+  //
+  template <typename DataType, typename ConstArrayType>
+  inline int radius2_deriv( const ConstArrayType& p,
+			    DataType x0, DataType x1, DataType* grad )
+  {
+
+    if ( p[3] == 1 )
+      return EXIT_FAILURE;
+
+    DataType deltaX = x0 - p[1];
+    DataType deltaY = x1 - p[2];
+    DataType cosTheta = COS(p[4]);
+    DataType sinTheta = SIN(p[4]);
+    DataType newX = deltaX * cosTheta + deltaY * sinTheta;
+    DataType newY = deltaY * cosTheta - deltaX * sinTheta;
+    DataType ellip = 1. - p[3];
+    DataType ellip2 = ellip * ellip;
+
+    grad[0] = 2.0 * ( newY * sinTheta / ellip2 - newX * cosTheta );
+    grad[1] = - 2.0 * ( newX * sinTheta + newY * cosTheta / ellip2 );
+    grad[2] = 2.0 * newY * newY / ( ellip2 * ellip );
+    grad[3] = 2.0 * newX * newY * ( 1.0 - 1.0 / ellip2 );
+    return EXIT_SUCCESS;
+
+  }
+
+
+  //
+  // The integral of x^-gamma over [xlo, xhi], where 0 <= xlo <= xhi,
+  // and its derivative with respect to gamma.
+  //
+  template <typename DataType>
+  inline int powlaw_segment( DataType gamma, DataType xlo, DataType xhi,
+			     DataType& val, DataType& dgamma )
+  {
+
+    if ( gamma == 1.0 ) {
+      if ( xlo <= 0.0 )
+	return EXIT_FAILURE;
+      DataType loglo = LOG(xlo);
+      DataType loghi = LOG(xhi);
+      val = loghi - loglo;
+      dgamma = - 0.5 * ( loghi * loghi - loglo * loglo );
+      return EXIT_SUCCESS;
+    }
+
+    // x^s log(x) tends to 0 as x tends to 0 when s > 0
+    DataType index = 1.0 - gamma;
+    DataType plo = POW( xlo, index );
+    DataType phi = POW( xhi, index );
+    DataType tlo = xlo > 0.0 ? plo * LOG(xlo) : 0.0;
+    DataType thi = xhi > 0.0 ? phi * LOG(xhi) : 0.0;
+    val = ( phi - plo ) / index;
+    dgamma = ( val - ( thi - tlo ) ) / index;
+    return EXIT_SUCCESS;
+
+  }
+
   // {
 
   //   DataType deltaX = x0 - p[1];
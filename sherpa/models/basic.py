@@ -30,7 +30,7 @@ from sherpa.utils.guess import get_position, guess_amplitude, \
     guess_fwhm, guess_position, guess_reference, param_apply_limits
 
 from .parameter import Parameter, tinyval
-from .model import ArithmeticModel, modelCacher1d, CompositeModel, \
+from .model import ArithmeticModel, modelCacher1d, modelCacher2d, CompositeModel, \
     ArithmeticFunctionModel, RegriddableModel2D, RegriddableModel1D
 from . import _modelfcts  # type: ignore
 
@@ -49,8 +49,10 @@ DBL_EPSILON = numpy.finfo(float).eps
 
 # This relies on the PyArg_ParseTypleAndKeywords calls in model_extension.hh
 #
-ALLOWED_KEYWORDS_1D = set(["pars", "xlo", "xhi", "integrate"])
-ALLOWED_KEYWORDS_2D = set(["pars", "x0lo", "x1lo", "x0hi", "x1hi", "integrate"])
+ALLOWED_KEYWORDS_1D = set(["pars", "xlo", "xhi", "integrate", "numcores",
+                           "intorder", "single"])
+ALLOWED_KEYWORDS_2D = set(["pars", "x0lo", "x1lo", "x0hi", "x1hi", "integrate",
+                           "numcores", "single"])
 
 
 def clean_kwargs(allowed, model, kwargs):
@@ -59,7 +61,10 @@ def clean_kwargs(allowed, model, kwargs):
     Parameters
     ----------
     model : Model instance
-        It must have an integrate field.
+        It must have an integrate field. If it has numcores or
+        intorder fields that are not None then they are also included
+        (intorder only for 1D models), and a precision field of
+        "single" adds the single keyword.
     kwargs : dict
         The input keyword arguments
     allowed : set of str
@@ -75,6 +80,19 @@ def clean_kwargs(allowed, model, kwargs):
     # TODO: remove the use of bool_cast here.
     #
     out = {"integrate": bool_cast(model.integrate)}
+    for name in ["numcores", "intorder"]:
+        value = getattr(model, name, None)
+        if value is not None and name in allowed:
+            out[name] = int(value)
+
+    precision = getattr(model, "precision", None)
+    if precision not in (None, "double", "single"):
+        raise ValueError("precision must be None, 'double', or 'single', "
+                         f"not '{precision}'")
+
+    if precision == "single":
+        out["single"] = True
+
     for key in [k for k in kwargs.keys() if k in allowed]:
         out[key] = kwargs[key]
 
@@ -91,6 +109,42 @@ def clean_kwargs1d(model, kwargs):
     return clean_kwargs(ALLOWED_KEYWORDS_1D, model, kwargs)
 
 
+def kernel_leaf(module, name, model, p, args, kwargs):
+    """The compiled kernel of a 1D model, used by calc_kernel.
+
+    Parameters
+    ----------
+    module : module
+        The extension module which contains the kernel.
+    name : str
+        The name of the kernel.
+    model : Model instance
+        The model.
+    p : sequence of number
+        The parameter values.
+    args, kwargs
+        The arguments sent to the calc method.
+
+    Returns
+    -------
+    kernel : tuple or None
+        The (kernel, pars, integrate) values, or None if the model is
+        evaluated in single precision or has no analytic integral.
+
+    """
+
+    kwargs = clean_kwargs1d(model, kwargs)
+    if kwargs.get("single", False):
+        return None
+
+    integrate = bool(kwargs["integrate"]) and len(args) > 1
+    kernel = module.kernel1d(name, integrate)
+    if kernel is None:
+        return None
+
+    return (kernel, p, integrate)
+
+
 def clean_kwargs2d(model, kwargs):
     """Remove un-supported keywords for these models.
 
@@ -163,6 +217,9 @@ class Box1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.box1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "box1d", self, p, args, kwargs)
+
 
 class Const(ArithmeticModel):
     def __init__(self, name='const'):
@@ -218,6 +275,13 @@ class Const1D(RegriddableModel1D, Const):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.const1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "const1d", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        return _modelfcts.const1d_deriv(p, *args, **kwargs)
+
 
 class Cos(RegriddableModel1D):
     """One-dimensional cosine function.
@@ -261,6 +325,9 @@ class Cos(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.cos(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "cos", self, p, args, kwargs)
+
 
 class Delta1D(RegriddableModel1D):
     """One-dimensional delta function.
@@ -317,6 +384,9 @@ class Delta1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.delta1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "delta1d", self, p, args, kwargs)
+
 
 class Erf(RegriddableModel1D):
     """One-dimensional error function.
@@ -370,6 +440,9 @@ class Erf(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.erf(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "erf", self, p, args, kwargs)
+
 
 class Erfc(RegriddableModel1D):
     """One-dimensional complementary error function.
@@ -423,6 +496,9 @@ class Erfc(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.erfc(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "erfc", self, p, args, kwargs)
+
 
 class Exp(RegriddableModel1D):
     """One-dimensional exponential function.
@@ -462,6 +538,13 @@ class Exp(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.exp(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "exp", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        return _modelfcts.exp_deriv(p, *args, **kwargs)
+
 
 class Exp10(RegriddableModel1D):
     """One-dimensional exponential function, base 10.
@@ -501,6 +584,9 @@ class Exp10(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.exp10(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "exp10", self, p, args, kwargs)
+
 
 class Gauss1D(RegriddableModel1D):
     """One-dimensional gaussian function.
@@ -590,6 +676,13 @@ class Gauss1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.gauss1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "gauss1d", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        return _modelfcts.gauss1d_deriv(p, *args, **kwargs)
+
 
 class Log(RegriddableModel1D):
     """One-dimensional natural logarithm function.
@@ -629,6 +722,9 @@ class Log(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.log(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "log", self, p, args, kwargs)
+
 
 class Log10(RegriddableModel1D):
     """One-dimensional logarithm function, base 10.
@@ -668,6 +764,9 @@ class Log10(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.log10(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "log10", self, p, args, kwargs)
+
 
 class LogParabola(RegriddableModel1D):
     """One-dimensional log-parabolic function.
@@ -718,6 +817,9 @@ class LogParabola(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.logparabola(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "logparabola", self, p, args, kwargs)
+
 
 _gfactor = numpy.sqrt(numpy.pi / (4 * numpy.log(2)))
 
@@ -784,6 +886,9 @@ class NormGauss1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.ngauss1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "ngauss1d", self, p, args, kwargs)
+
 
 class Poisson(RegriddableModel1D):
     """One-dimensional Poisson function.
@@ -833,6 +938,9 @@ class Poisson(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.poisson(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "poisson", self, p, args, kwargs)
+
 
 class Polynom1D(RegriddableModel1D):
     """One-dimensional polynomial function of order 8.
@@ -949,6 +1057,9 @@ class Polynom1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.poly1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "poly1d", self, p, args, kwargs)
+
 
 class PowLaw1D(RegriddableModel1D):
     """One-dimensional power-law function.
@@ -1007,6 +1118,20 @@ class PowLaw1D(RegriddableModel1D):
 
         return _modelfcts.powlaw(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        if kwargs['integrate'] and sao_fcmp(p[0], 1.0, 1.e-10) == 0:
+            p = [1.0] + list(p[1:])
+
+        return kernel_leaf(_modelfcts, "powlaw", self, p, args, kwargs)
+
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs1d(self, kwargs)
+        if kwargs['integrate'] and sao_fcmp(p[0], 1.0, 1.e-10) == 0:
+            p = [1.0] + list(p[1:])
+
+        return _modelfcts.powlaw_deriv(p, *args, **kwargs)
+
 
 class Scale1D(Const1D):
     """A constant model for one-dimensional data.
@@ -1084,6 +1209,9 @@ class Sin(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.sin(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "sin", self, p, args, kwargs)
+
 
 class Sqrt(RegriddableModel1D):
     """One-dimensional square root function.
@@ -1119,6 +1247,9 @@ class Sqrt(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.sqrt(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "sqrt", self, p, args, kwargs)
+
 
 class StepHi1D(RegriddableModel1D):
     """One-dimensional step function.
@@ -1168,6 +1299,9 @@ class StepHi1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.stephi1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "stephi1d", self, p, args, kwargs)
+
 
 class StepLo1D(RegriddableModel1D):
     """One-dimensional step function.
@@ -1217,6 +1351,9 @@ class StepLo1D(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.steplo1d(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "steplo1d", self, p, args, kwargs)
+
 
 class Tan(RegriddableModel1D):
     """One-dimensional tan function.
@@ -1260,6 +1397,9 @@ class Tan(RegriddableModel1D):
         kwargs = clean_kwargs1d(self, kwargs)
         return _modelfcts.tan(p, *args, **kwargs)
 
+    def calc_kernel(self, p, *args, **kwargs):
+        return kernel_leaf(_modelfcts, "tan", self, p, args, kwargs)
+
 
 class Box2D(RegriddableModel2D):
     """Two-dimensional box function.
@@ -1313,7 +1453,6 @@ class Box2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.xlow, self.xhi, self.ylow, self.yhi,
                                   self.ampl))
-        self.cache = 0
 
     def guess(self, dep, *args, **kwargs):
         xlo, xhi = guess_bounds(args[0])
@@ -1325,6 +1464,7 @@ class Box2D(RegriddableModel2D):
         param_apply_limits(yhi, self.yhi, **kwargs)
         param_apply_limits(norm, self.ampl, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.box2d(p, *args, **kwargs)
@@ -1357,8 +1497,8 @@ class Const2D(RegriddableModel2D, Const):
 
     def __init__(self, name='const2d'):
         Const.__init__(self, name)
-        self.cache = 0
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.const2d(p, *args, **kwargs)
@@ -1397,7 +1537,6 @@ class Scale2D(Const2D):
     def __init__(self, name='scale2d'):
         Const2D.__init__(self, name)
         self.integrate = False
-        self.cache = 0
 
 
 class Delta2D(RegriddableModel2D):
@@ -1441,7 +1580,6 @@ class Delta2D(RegriddableModel2D):
         self.ypos = Parameter(name, 'ypos', 0)
         self.ampl = Parameter(name, 'ampl', 1)
         ArithmeticModel.__init__(self, name, (self.xpos, self.ypos, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1457,6 +1595,7 @@ class Delta2D(RegriddableModel2D):
         param_apply_limits(ypos, self.ypos, **kwargs)
         param_apply_limits(norm, self.ampl, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.delta2d(p, *args, **kwargs)
@@ -1501,18 +1640,11 @@ class Gauss2D(RegriddableModel2D):
 
         yoff(x0,x1) = (x1 - ypos) * cos(theta) - (x0 - xpos) * sin(theta)
 
-    The grid version is evaluated by adaptive multidimensional
-    integration scheme on hypercubes using cubature rules, based
-    on code from HIntLib ([1]_) and GSL ([2]_).
-
-    References
-    ----------
-
-    .. [1] HIntLib - High-dimensional Integration Library
-           http://mint.sbg.ac.at/HIntLib/
-
-    .. [2] GSL - GNU Scientific Library
-           http://www.gnu.org/software/gsl/
+    The grid version is integrated over each pixel. When the axes
+    of the model are aligned with the grid (``theta`` is a multiple
+    of pi/2, or the model is circular) this is the product of two
+    error-function differences; otherwise one axis is integrated
+    analytically and the other with Gauss-Legendre quadrature.
 
     """
 
@@ -1529,7 +1661,6 @@ class Gauss2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.fwhm, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1547,10 +1678,15 @@ class Gauss2D(RegriddableModel2D):
         param_apply_limits(norm, self.ampl, **kwargs)
         param_apply_limits(fwhm, self.fwhm, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.gauss2d(p, *args, **kwargs)
 
+    def calc_deriv(self, p, *args, **kwargs):
+        kwargs = clean_kwargs2d(self, kwargs)
+        return _modelfcts.gauss2d_deriv(p, *args, **kwargs)
+
 
 class SigmaGauss2D(Gauss2D):
     """Two-dimensional gaussian function (varying sigma).
@@ -1589,18 +1725,11 @@ class SigmaGauss2D(Gauss2D):
 
         yoff(x0,x1) = (x1 - ypos) * cos(theta) - (x0 - xpos) * sin(theta)
 
-    The grid version is evaluated by adaptive multidimensional
-    integration scheme on hypercubes using cubature rules, based
-    on code from HIntLib ([1]_) and GSL ([2]_).
-
-    References
-    ----------
-
-    .. [1] HIntLib - High-dimensional Integration Library
-           http://mint.sbg.ac.at/HIntLib/
-
-    .. [2] GSL - GNU Scientific Library
-           http://www.gnu.org/software/gsl/
+    The grid version is integrated over each pixel. When the axes
+    of the model are aligned with the grid (``theta`` is a multiple
+    of pi/2, or the model is circular) this is the product of two
+    error-function differences; otherwise one axis is integrated
+    analytically and the other with Gauss-Legendre quadrature.
 
     """
 
@@ -1616,7 +1745,6 @@ class SigmaGauss2D(Gauss2D):
         ArithmeticModel.__init__(self, name,
                                  (self.sigma_a, self.sigma_b, self.xpos,
                                   self.ypos, self.theta, self.ampl))
-        self.cache = 0
 
     def guess(self, dep, *args, **kwargs):
         xpos, ypos = guess_position(dep, *args)
@@ -1628,6 +1756,7 @@ class SigmaGauss2D(Gauss2D):
         param_apply_limits(fwhm, self.sigma_b, **kwargs)
         param_apply_limits(norm, self.ampl, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.sigmagauss2d(p, *args, **kwargs)
@@ -1675,18 +1804,11 @@ class NormGauss2D(RegriddableModel2D):
 
         yoff(x0,x1) = (x1 - ypos) * cos(theta) - (x0 - xpos) * sin(theta)
 
-    The grid version is evaluated by adaptive multidimensional
-    integration scheme on hypercubes using cubature rules, based
-    on code from HIntLib ([1]_) and GSL ([2]_).
-
-    References
-    ----------
-
-    .. [1] HIntLib - High-dimensional Integration Library
-           http://mint.sbg.ac.at/HIntLib/
-
-    .. [2] GSL - GNU Scientific Library
-           http://www.gnu.org/software/gsl/
+    The grid version is integrated over each pixel. When the axes
+    of the model are aligned with the grid (``theta`` is a multiple
+    of pi/2, or the model is circular) this is the product of two
+    error-function differences; otherwise one axis is integrated
+    analytically and the other with Gauss-Legendre quadrature.
 
     """
 
@@ -1703,7 +1825,6 @@ class NormGauss2D(RegriddableModel2D):
         ArithmeticModel.__init__(self, name,
                                  (self.fwhm, self.xpos, self.ypos, self.ellip,
                                   self.theta, self.ampl))
-        self.cache = 0
 
     def get_center(self):
         return (self.xpos.val, self.ypos.val)
@@ -1728,6 +1849,7 @@ class NormGauss2D(RegriddableModel2D):
                 ampl[key] *= norm
         param_apply_limits(ampl, self.ampl, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.ngauss2d(p, *args, **kwargs)
@@ -1792,7 +1914,6 @@ class Polynom2D(RegriddableModel2D):
                                  (self.c, self.cy1, self.cy2, self.cx1,
                                   self.cx1y1, self.cx1y2, self.cx2,
                                   self.cx2y1, self.cx2y2))
-        self.cache = 0
 
     def guess(self, dep, *args, **kwargs):
         x0min = args[0].min()
@@ -1838,6 +1959,7 @@ class Polynom2D(RegriddableModel2D):
         param_apply_limits(c22, self.cx2y1, **kwargs)
         param_apply_limits(c22, self.cx2y2, **kwargs)
 
+    @modelCacher2d
     def calc(self, p, *args, **kwargs):
         kwargs = clean_kwargs2d(self, kwargs)
         return _modelfcts.poly2d(p, *args, **kwargs)
@@ -2206,7 +2328,8 @@ class Integrator1D(CompositeModel, RegriddableModel1D):
         Currently unused.
     otherkwargs
         Used to pass extra parameters to the integrator (currently
-        `epsabs`, `epsrel`, `maxeval`, `errflag`, and `logger`).
+        `epsabs`, `epsrel`, `maxeval`, `errflag`, `logger`, and
+        `batchsize`).
 
     Raises
     ------
@@ -2217,6 +2340,19 @@ class Integrator1D(CompositeModel, RegriddableModel1D):
     --------
     Integrate1D
 
+    Notes
+    -----
+    The model is evaluated at the 21-point Gauss-Kronrod nodes of up
+    to `batchsize` bins (default 1024) at a time, so that it is called
+    a small number of times. Only bins which do not meet the tolerance
+    with this rule are refined, which requires separate calls for each
+    such bin. Setting `batchsize` to 0 evaluates the model separately
+    for each bin.
+
+    Bins which need the lower tolerance are reported through the
+    `logger` the first time this happens for the instance, and then
+    at most once for each fit.
+
     Examples
     --------
 
@@ -2251,6 +2387,7 @@ class Integrator1D(CompositeModel, RegriddableModel1D):
         self.otherargs = otherargs
         self.otherkwargs = otherkwargs
         self._errflag = 0
+        self._reported = False
         CompositeModel.__init__(self,
                                 f'integrate1d({self.model.name})',
                                 (self.model,))
@@ -2258,6 +2395,7 @@ class Integrator1D(CompositeModel, RegriddableModel1D):
     def startup(self, cache=False):
         self.model.startup(cache)
         self._errflag = 1
+        self._reported = False
         CompositeModel.startup(self, cache)
 
     def teardown(self):
@@ -2268,8 +2406,21 @@ class Integrator1D(CompositeModel, RegriddableModel1D):
         if xhi is None:
             raise ModelErr('needsint')
 
+        # The integration problems are reported once per instance, or
+        # once per fit (the flag is reset by startup), rather than for
+        # every evaluation.
+        #
+        kwargs = dict(self.otherkwargs)
+        logger = kwargs.pop('logger', None)
+        if logger is not None and not self._reported:
+            def report(msg):
+                self._reported = True
+                logger(msg)
+
+            kwargs['logger'] = report
+
         return _modelfcts.integrate1d(self.model.calc,
-                                      p, xlo, xhi, **self.otherkwargs)
+                                      p, xlo, xhi, **kwargs)
 
 
 # DOC note: we do not expose Integrator1D by default so it is not
@@ -277,13 +277,17 @@ expression:
 Model cache
 ===========
 
-The `ArithmeticModel` class and `modelCacher1d` decorator provide basic
-support for caching one-dimensional model evaluations - that is, to
+The `ArithmeticModel` class and the `modelCacher1d` and `modelCacher2d`
+decorators provide support for caching model evaluations - that is, to
 avoid re-calculating the model. The idea is to save the results of the
 latest calls to a model and return the values from the cache,
 hopefully saving time at the expense of using more memory. This is
 most effective when the same model is used with multiple datasets
-which all have the same grid.
+which all have the same grid, or when only some components of a
+model expression change, such as when calculating derivatives
+numerically. The ``cache`` attribute of the model sets the number of
+evaluations that are kept, with the least-recently used evaluation
+removed when the cache is full.
 
 The `_use_caching` attribute of the model is used to determine whether
 the cache is used, but this setting can be over-ridden by the startup
@@ -332,20 +336,11 @@ from sherpa.utils import NoNewAttributesAfterInit, formatting
 from sherpa.utils.err import ModelErr, ParameterErr
 from sherpa.utils.numeric_types import SherpaFloat
 
+from . import _modelfcts  # type: ignore
+from ._cache import ModelCache  # type: ignore
 from .op import get_precedences_op, get_precedence_expr, \
     get_precedence_lhs, get_precedence_rhs
-from .parameter import Parameter, expand_par
-
-# What routine do we use for the hash in modelCacher1d?  As we do not
-# need cryptographic security go for a "quick" algorithm, but md5 is
-# not guaranteed to always be present.  There has been no attempt to
-# check the run times of these routines for the expected data sizes
-# they will be used with.
-#
-try:
-    from hashlib import md5 as hashfunc
-except ImportError:
-    from hashlib import sha256 as hashfunc
+from .parameter import CompositeParameter, Parameter, expand_par
 
 info = logging.getLogger(__name__).info
 warning = logging.getLogger(__name__).warning
@@ -354,6 +349,7 @@ warning = logging.getLogger(__name__).warning
 __all__ = ('Model', 'CompositeModel', 'SimulFitModel',
            'ArithmeticConstantModel', 'ArithmeticModel', 'RegriddableModel1D', 'RegriddableModel2D',
            'UnaryOpModel', 'BinaryOpModel', 'FilterModel', 'modelCacher1d',
+           'modelCacher2d',
            'ArithmeticFunctionModel', 'NestedModel', 'MultigridSumModel')
 
 
@@ -385,39 +381,18 @@ def boolean_to_byte(boolean_value: bool) -> bytes:
     return bmap.get(boolean_value, b'0')
 
 
-def modelCacher1d(func: Callable) -> Callable:
-    """A decorator to cache 1D ArithmeticModel evaluations.
-
-    Apply to the `calc` method of a 1D model to allow the model
-    evaluation to be cached. The decision is based on the
-    `_use_caching` attribute of the cache along with the `integrate`
-    setting, the evaluation grid, parameter values, and the keywords
-    sent to the model.
-
-    Notes
-    -----
-    The keywords are included in the hash calculation even if they are
-    not relevant for the model (as there's no easy way to find this
-    out).
-
-    Example
-    -------
-
-    Allow `MyModel` model evaluations to be cached::
-
-        def MyModel(ArithmeticModel):
-            ...
-            @modelCacher1d
-            def calc(self, p, *args, **kwargs):
-                ...
+def _cache_model(func: Callable) -> Callable:
+    """Wrap calc so that it uses the model cache.
 
+    The positional arguments after the parameter values are the
+    grid, and are identified by their contents.
     """
 
     @functools.wraps(func)
     def cache_model(cls, pars, xlo, *args, **kwargs):
         # Counts all accesses, even those that do not use the cache.
-        cache_ctr = cls._cache_ctr
-        cache_ctr['check'] += 1
+        cache = cls._cache
+        cache.checks += 1
 
         # Short-cut if the cache is not being used.
         #
@@ -446,46 +421,94 @@ def modelCacher1d(func: Callable) -> Callable:
             #
             integrate = kwargs.get('integrate', False)
 
-        data = [np.array(pars).tobytes(),
-                boolean_to_byte(integrate),
-                np.asarray(xlo).tobytes()]
-        if args:
-            data.append(np.asarray(args[0]).tobytes())
-
-        # Add any keyword arguments to the list. This will
-        # include the xhi named argument if given. Can the
-        # value field fail here?
+        # Add any keyword arguments to the key. This will include the
+        # xhi named argument if given. Can the value field fail here?
         #
+        data = []
         for k, v in kwargs.items():
             data.extend([k.encode(), np.asarray(v).tobytes()])
 
+        # The intorder and precision settings change the values of
+        # some models.
+        intorder = getattr(cls, "intorder", None)
+        if intorder is not None:
+            data.extend([b"intorder", str(intorder).encode()])
+
+        precision = getattr(cls, "precision", None)
+        if precision is not None:
+            data.extend([b"precision", str(precision).encode()])
+
         # Is the value cached?
         #
-        token = b''.join(data)
-        digest = hashfunc(token).digest()
-        cache = cls._cache
-        if digest in cache:
-            cache_ctr['hits'] += 1
-            return cache[digest].copy()
-
-        # Evaluate the model.
+        key = cache.key(pars, (xlo,) + args,
+                        boolean_to_byte(integrate) == b'1',
+                        b''.join(data))
+        vals = cache.get(key)
+        if vals is not None:
+            return vals
+
+        # Evaluate the model and store a copy, which replaces the
+        # least-recently used value if the cache is full.
         #
         vals = func(cls, pars, xlo, *args, **kwargs)
+        cache.put(key, vals)
+        return vals
 
-        # remove first item in queue and remove from cache
-        queue = cls._queue
-        key = queue.pop(0)
-        cache.pop(key, None)
+    return cache_model
 
-        # append newest model values to queue
-        queue.append(digest)
-        cache[digest] = vals.copy()
 
-        cache_ctr['misses'] += 1
+def modelCacher1d(func: Callable) -> Callable:
+    """A decorator to cache 1D ArithmeticModel evaluations.
 
-        return vals
+    Apply to the `calc` method of a 1D model to allow the model
+    evaluation to be cached. The decision is based on the
+    `_use_caching` attribute of the cache along with the `integrate`
+    setting, the evaluation grid, parameter values, and the keywords
+    sent to the model. The values are stored in the `_cache`
+    attribute, a `sherpa.models._cache.ModelCache` object, which
+    keeps the most-recently used evaluations and counts the number
+    of hits and misses.
 
-    return cache_model
+    Notes
+    -----
+    The keywords are included in the cache key even if they are
+    not relevant for the model (as there's no easy way to find this
+    out).
+
+    Example
+    -------
+
+    Allow `MyModel` model evaluations to be cached::
+
+        def MyModel(ArithmeticModel):
+            ...
+            @modelCacher1d
+            def calc(self, p, *args, **kwargs):
+                ...
+
+    See Also
+    --------
+    modelCacher2d
+
+    """
+
+    return _cache_model(func)
+
+
+def modelCacher2d(func: Callable) -> Callable:
+    """A decorator to cache 2D ArithmeticModel evaluations.
+
+    This is the 2D version of `modelCacher1d`, where the grid is
+    given by the x0 and x1 arrays (and the x0hi and x1hi arrays for
+    an integrated grid).
+
+    See Also
+    --------
+    modelCacher1d
+
+    """
+
+    return _cache_model(func)
 
 
 # It is tempting to convert the explicit class names below into calls
@@ -778,6 +801,132 @@ class Model(NoNewAttributesAfterInit):
         """
         raise NotImplementedError
 
+    def calc_deriv(self,
+                   p: Sequence[SupportsFloat],
+                   *args,
+                   **kwargs) -> Optional[np.ndarray]:
+        """Evaluate the derivatives of the model on a grid.
+
+        Parameters
+        ----------
+        p : sequence of numbers
+            The parameter values to use. The order matches the
+            ``pars`` field.
+        *args
+            The model grid, as used by `calc`.
+        **kwargs
+            Any model-specific values that are not parameters.
+
+        Returns
+        -------
+        deriv : ndarray or None
+            The derivative of the model with respect to each
+            parameter, with shape (len(p), nelem), or `None` if the
+            model does not provide analytic derivatives.
+
+        Notes
+        -----
+        A subclass which changes `calc` must also provide
+        `calc_deriv`, otherwise the inherited version is ignored by
+        `eval_deriv`.
+
+        See Also
+        --------
+        calc, eval_deriv
+        """
+        return None
+
+    def calc_kernel(self,
+                    p: Sequence[SupportsFloat],
+                    *args,
+                    **kwargs) -> Optional[tuple]:
+        """The compiled form of the model used by fused evaluation.
+
+        Model expressions of 1D models are evaluated in a single pass
+        over the grid when their components provide a compiled kernel
+        (see `BinaryOpModel.fused`).
+
+        Parameters
+        ----------
+        p : sequence of numbers
+            The parameter values to use. The order matches the
+            ``pars`` field.
+        *args
+            The model grid, as used by `calc`.
+        **kwargs
+            Any model-specific values that are not parameters.
+
+        Returns
+        -------
+        kernel : tuple or None
+            The (kernel, pars, integrate) values used by
+            `sherpa.models._modelfcts.fused1d`, or `None` if the
+            model must be evaluated with `calc`.
+
+        See Also
+        --------
+        calc
+        """
+        return None
+
+    def eval_deriv(self,
+                   pars: Optional[Sequence[Parameter]],
+                   *args,
+                   **kwargs) -> Optional[np.ndarray]:
+        """Evaluate the derivatives of the model with respect to parameters.
+
+        Parameters
+        ----------
+        pars : sequence of Parameter or None
+            The parameters, which need not belong to the model. If
+            `None` then the thawed parameters are used.
+        *args
+            The model grid, as used by `calc`.
+        **kwargs
+            Any model-specific values that are not parameters.
+
+        Returns
+        -------
+        deriv : ndarray or None
+            The derivative of the model with respect to each
+            parameter, with shape (len(pars), nelem), or `None` if
+            the model, or a component of it, does not provide analytic
+            derivatives or a parameter is linked to an expression.
+
+        Notes
+        -----
+        A parameter which is linked to another parameter contributes
+        to the derivative of that parameter.
+
+        See Also
+        --------
+        calc_deriv, get_thawed_pars
+        """
+
+        if pars is None:
+            pars = self.get_thawed_pars()
+
+        deriv = _calc_deriv(self, [p.val for p in self.pars], *args, **kwargs)
+        if deriv is None:
+            return None
+
+        out = {}
+        for par, row in zip(self.pars, deriv):
+            while par.link is not None:
+                if isinstance(par.link, CompositeParameter):
+                    return None
+                par = par.link
+
+            key = id(par)
+            if key in out:
+                out[key] = out[key] + row
+            else:
+                out[key] = row
+
+        nelem = deriv.shape[1:]
+        zero = np.zeros(nelem)
+        return np.asarray([out.get(id(par), zero) for par in pars])
+
     def guess(self, dep, *args, **kwargs):
         """Set an initial guess for the parameter values.
 
@@ -1347,6 +1496,11 @@ class ArithmeticConstantModel(Model):
     def calc(self, p, *args, **kwargs):
         return self.val
 
+    def calc_deriv(self, p, *args, **kwargs):
+        # There are no parameters, but keep an axis for the bins so
+        # the result can be combined with the other component.
+        return np.zeros((0,) + np.shape(np.atleast_1d(self.val)))
+
     def teardown(self) -> None:
         pass
 
@@ -1377,6 +1531,46 @@ class ArithmeticModel(Model):
     cache = 5
     """The maximum size of the cache."""
 
+    numcores: Optional[int] = None
+    """The number of threads used to evaluate a compiled model.
+
+    When `None` the model is evaluated on the calling thread. A
+    positive value releases the Python GIL during the evaluation and
+    splits the grid across this many threads. It is only used by the
+    compiled models, such as those in `sherpa.models.basic` and
+    `sherpa.astro.models`, and is not inherited by model expressions.
+    """
+
+    intorder: Optional[int] = None
+    """The quadrature used to integrate a compiled 1D model over a bin.
+
+    This is only used by models which have no analytic integral, such
+    as `sherpa.astro.models.BBody`. When `None` or 0 each bin is
+    integrated with the adaptive integrator. A positive value selects
+    a Gauss-Legendre rule with that many points per bin (8 is a good
+    choice for smooth models), which evaluates all the bins in a few
+    calls and is much faster. Bins where the model values vary by more
+    than 25% are checked and, if needed, passed to the adaptive
+    integrator, but a discontinuity, such as the threshold of
+    `sherpa.astro.models.Edge`, in a bin where the model otherwise
+    varies slowly is not, so it is only integrated approximately.
+    """
+
+    precision: Optional[str] = None
+    """The floating-point precision used to evaluate a compiled model.
+
+    When `None` or ``"double"`` the model is evaluated in double
+    precision. The ``"single"`` setting evaluates the compiled models,
+    such as those in `sherpa.models.basic` and `sherpa.astro.models`,
+    in single precision, which is faster and uses less memory for
+    large grids. The parameter values and grid are rounded to single
+    precision and the model values are returned as a float32 array,
+    but the statistic is still calculated in double precision.
+    Models without an analytic integral are evaluated in double
+    precision when integrated over a grid, and the derivatives are
+    always calculated in double precision.
+    """
+
     def __init__(self,
                  name: str,
                  pars: Sequence[Parameter] = ()) -> None:
@@ -1390,11 +1584,15 @@ class ArithmeticModel(Model):
 
     def cache_clear(self) -> None:
         """Clear the cache."""
-        # It is not obvious what to set the queue length to
-        self._queue = ['']
+        # It is not obvious what to set the cache size to; the startup
+        # method uses the cache setting.
+        self._cache = ModelCache(1)
 
-        self._cache: dict[bytes, np.ndarray] = {}
-        self._cache_ctr = {'hits': 0, 'misses': 0, 'check': 0}
+    @property
+    def _cache_ctr(self) -> dict[str, int]:
+        """The number of hits, misses, and checks of the cache."""
+        c = self._cache
+        return {'hits': c.hits, 'misses': c.misses, 'check': c.checks}
 
     def cache_status(self) -> None:
         """Display the cache status.
@@ -1409,10 +1607,10 @@ class ArithmeticModel(Model):
          powlaw1d.pl                size:    5  hits:   633  misses:   240  check=  873
 
         """
-        c = self._cache_ctr
-        info(f" {self.name:25s}  size: {len(self._queue):4d}  " +
-             f"hits: {c['hits']:5d}  misses: {c['misses']:5d}  " +
-             f"check: {c['check']:5d}")
+        c = self._cache
+        info(f" {self.name:25s}  size: {c.size:4d}  " +
+             f"hits: {c.hits:5d}  misses: {c.misses:5d}  " +
+             f"check: {c.checks:5d}")
 
     # Unary operations
     __neg__ = _make_unop(np.negative, '-')
@@ -1435,12 +1633,12 @@ class ArithmeticModel(Model):
         if '_use_caching' not in state:
             self.__dict__['_use_caching'] = True
 
-        if '_queue' not in state:
-            self.__dict__['_queue'] = ['']
-
-        if '_cache' not in state:
-            self.__dict__['_cache'] = {}
-            self.__dict__['_cache_ctr'] = {'hits': 0, 'misses': 0, 'check': 0}
+        # Older versions stored the cache as a dictionary, with the
+        # size set by the _queue list.
+        if not isinstance(state.get('_cache'), ModelCache):
+            queue = self.__dict__.pop('_queue', [''])
+            self.__dict__.pop('_cache_ctr', None)
+            self.__dict__['_cache'] = ModelCache(len(queue))
 
         if 'cache' not in state:
             self.__dict__['cache'] = 5
@@ -1454,7 +1652,7 @@ class ArithmeticModel(Model):
         if int(self.cache) <= 0:
             return
 
-        self._queue = [''] * int(self.cache)
+        self._cache = ModelCache(int(self.cache))
         frozen = np.array([par.frozen for par in self.pars], dtype=bool)
         if len(frozen) > 0 and frozen.all():
             self._use_caching = cache
@@ -1583,6 +1781,228 @@ class UnaryOpModel(CompositeModel, ArithmeticModel):
              *args, **kwargs) -> np.ndarray:
         return self.op(self.arg.calc(p, *args, **kwargs))
 
+    def calc_deriv(self, p: Sequence[SupportsFloat],
+                   *args, **kwargs) -> Optional[np.ndarray]:
+        deriv = _calc_deriv(self.arg, p, *args, **kwargs)
+        if deriv is None:
+            return None
+
+        if self.op is np.negative:
+            return -deriv
+        if self.op is np.positive:
+            return deriv
+        if self.op is np.absolute:
+            return np.sign(self.arg.calc(p, *args, **kwargs)) * deriv
+
+        return None
+
+
+# The fused1d codes for the operators it supports (the FusedOp values
+# in sherpa/include/sherpa/model_extension.hh).
+#
+_FUSED_BINOPS = {np.add: -1, np.subtract: -2, np.multiply: -3,
+                 np.true_divide: -4}
+_FUSED_UNOPS = {np.negative: -5, np.absolute: -6}
+
+
+class _NotFusable(Exception):
+    """The expression can not be evaluated by fused1d."""
+
+
+def _defined_with_calc(model: Model, name: str) -> bool:
+    """Is the method name defined alongside calc?
+
+    A subclass which changes calc but inherits a method which
+    depends on it, such as calc_kernel or calc_deriv, must not use
+    that method.
+    """
+
+    for cls in type(model).__mro__:
+        if name in cls.__dict__:
+            return "calc" in cls.__dict__
+
+        if "calc" in cls.__dict__:
+            return False
+
+    return False
+
+
+def _has_kernel(model: Model) -> bool:
+    """Is calc_kernel defined alongside calc?"""
+
+    return _defined_with_calc(model, "calc_kernel")
+
+
+def _calc_deriv(model: Model, p: Sequence[SupportsFloat],
+                *args, **kwargs) -> Optional[np.ndarray]:
+    """Call calc_deriv, unless it was not defined alongside calc."""
+
+    if not _defined_with_calc(model, "calc_deriv"):
+        return None
+
+    return model.calc_deriv(p, *args, **kwargs)
+
+
+def _add_fused(model: Model, p, args, kwargs,
+               program: list[int], leaves: list) -> None:
+    """Add the postfix form of model to program and leaves.
+
+    Components which can not be expressed with fused1d operations or
+    kernels are evaluated with calc and added as arrays.
+    """
+
+    if isinstance(model, BinaryOpModel) and model.op in _FUSED_BINOPS:
+        nlhs = len(model.lhs.pars)
+        _add_fused(model.lhs, p[:nlhs], args, kwargs, program, leaves)
+        _add_fused(model.rhs, p[nlhs:], args, kwargs, program, leaves)
+        program.append(_FUSED_BINOPS[model.op])
+        return
+
+    if isinstance(model, UnaryOpModel):
+        if model.op is np.positive:
+            _add_fused(model.arg, p, args, kwargs, program, leaves)
+            return
+
+        if model.op in _FUSED_UNOPS:
+            _add_fused(model.arg, p, args, kwargs, program, leaves)
+            program.append(_FUSED_UNOPS[model.op])
+            return
+
+    leaf = None
+    if _has_kernel(model):
+        leaf = model.calc_kernel(p, *args, **kwargs)
+
+    if leaf is None:
+        val = np.asarray(model.calc(p, *args, **kwargs))
+        if val.ndim == 0:
+            leaf = float(val)
+        elif val.shape == np.shape(args[0]):
+            leaf = val
+        else:
+            raise _NotFusable()
+
+    program.append(len(leaves))
+    leaves.append(leaf)
+
+
+def _add_fitplan(model: Model, pars: Sequence[Parameter], args,
+                 program: list[int], leaves: list,
+                 kpars: list[Parameter]) -> None:
+    """Add the postfix form of model to program and leaves for fit_plan.
+
+    Unlike _add_fused every component must be a kernel or a constant,
+    and the parameters of each kernel are added to kpars. The fused
+    setting is not used, since the fit plan does not use the model
+    cache.
+    """
+
+    if isinstance(model, BinaryOpModel):
+        if model.op not in _FUSED_BINOPS:
+            raise _NotFusable()
+
+        nlhs = len(model.lhs.pars)
+        _add_fitplan(model.lhs, pars[:nlhs], args, program, leaves, kpars)
+        _add_fitplan(model.rhs, pars[nlhs:], args, program, leaves, kpars)
+        program.append(_FUSED_BINOPS[model.op])
+        return
+
+    if isinstance(model, UnaryOpModel):
+        if model.op is np.positive:
+            _add_fitplan(model.arg, pars, args, program, leaves, kpars)
+            return
+
+        if model.op not in _FUSED_UNOPS:
+            raise _NotFusable()
+
+        _add_fitplan(model.arg, pars, args, program, leaves, kpars)
+        program.append(_FUSED_UNOPS[model.op])
+        return
+
+    if isinstance(model, ArithmeticConstantModel):
+        if np.ndim(model.val) != 0:
+            raise _NotFusable()
+
+        leaf = float(model.val)
+
+    else:
+        leaf = None
+        if _has_kernel(model):
+            leaf = model.calc_kernel([par.val for par in pars], *args)
+
+        if leaf is None:
+            raise _NotFusable()
+
+        kpars.extend(pars)
+
+    program.append(len(leaves))
+    leaves.append(leaf)
+
+
+def fit_plan(model: Model, thawed: Sequence[Parameter], *args,
+             **kwargs) -> Optional[Any]:
+    """Return the compiled objective for fitting a 1D model expression.
+
+    The objective evaluates the model and the statistic without
+    calling back into Python (see
+    `sherpa.models._modelfcts.fitplan1d`).
+
+    Parameters
+    ----------
+    model : Model instance
+        The model expression.
+    thawed : sequence of Parameter
+        The parameters that are varied by the fit, in order.
+    *args
+        The filtered grid of the data.
+    **kwargs
+        The stat, data, scale, trunc_value, and nworkspaces arguments
+        of fitplan1d.
+
+    Returns
+    -------
+    objective : capsule or None
+        The native objective, or `None` if a component of the model
+        is not a compiled 1D model or a constant, or a parameter is
+        linked to an expression.
+
+    """
+
+    if model.ndim != 1 or len(args) not in (1, 2):
+        return None
+
+    program: list[int] = []
+    leaves: list = []
+    kpars: list[Parameter] = []
+    try:
+        _add_fitplan(model, model.pars, args, program, leaves, kpars)
+    except _NotFusable:
+        return None
+
+    # Each kernel parameter is set to a thawed parameter or left at
+    # its current value. A parameter linked to another is treated as
+    # that parameter.
+    #
+    index = {id(par): idx for idx, par in enumerate(thawed)}
+    parmap = []
+    for par in kpars:
+        if par.link is not None:
+            par = par.link
+            if isinstance(par, CompositeParameter) or par.link is not None:
+                return None
+
+        if par.frozen:
+            parmap.append(-1)
+        elif id(par) in index:
+            parmap.append(index[id(par)])
+        else:
+            return None
+
+    if len(args) == 2:
+        kwargs["xhi"] = args[1]
+
+    return _modelfcts.fitplan1d(program, leaves, parmap, len(thawed),
+                                xlo=args[0], **kwargs)
+
 
 class BinaryOpModel(CompositeModel, RegriddableModel):
 
@@ -1625,6 +2045,19 @@ class BinaryOpModel(CompositeModel, RegriddableModel):
 
     """
 
+    fused: bool = False
+    """Evaluate 1D expressions of compiled models in a single pass.
+
+    When set, and the expression contains a model which provides a
+    compiled kernel (see `Model.calc_kernel`), the components
+    combined with +, -, *, /, unary minus, and abs are evaluated by
+    `sherpa.models._modelfcts.fused1d` in blocks over the grid,
+    rather than creating an array for each term. Any other component
+    is evaluated with its calc method and passed in as an array.
+    The components evaluated by their kernel do not use the model
+    cache, which is why this is not the default.
+    """
+
     @staticmethod
     def wrapobj(obj) -> Model:
         return _wrapobj(obj, ArithmeticConstantModel)
@@ -1672,8 +2105,41 @@ class BinaryOpModel(CompositeModel, RegriddableModel):
         self.rhs.teardown()
         CompositeModel.teardown(self)
 
+    def _calc_fused(self, p: Sequence[SupportsFloat],
+                    *args, **kwargs) -> Optional[np.ndarray]:
+        """Evaluate the expression with fused1d, if possible."""
+
+        if not self.fused or self.ndim != 1 or self.op not in _FUSED_BINOPS \
+           or len(args) not in (1, 2) or np.ndim(p) != 1:
+            return None
+
+        grid = [np.asarray(arg) for arg in args]
+        if grid[0].ndim != 1 or any(g.shape != grid[0].shape for g in grid):
+            return None
+
+        program: list[int] = []
+        leaves: list = []
+        try:
+            _add_fused(self, p, grid, kwargs, program, leaves)
+        except _NotFusable:
+            return None
+
+        if not any(isinstance(leaf, tuple) for leaf in leaves):
+            return None
+
+        # Use the largest numcores setting of the components.
+        numcores = max((int(getattr(part, "numcores", None) or 0)
+                        for part in self), default=0)
+        numcores = max(numcores, int(kwargs.get("numcores") or 0))
+
+        return _modelfcts.fused1d(program, leaves, *grid, numcores=numcores)
+
     def calc(self, p: Sequence[SupportsFloat],
              *args, **kwargs) -> np.ndarray:
+        val = self._calc_fused(p, *args, **kwargs)
+        if val is not None:
+            return val
+
         # Note that the kwargs are sent to both model components.
         #
         nlhs = len(self.lhs.pars)
@@ -1687,6 +2153,39 @@ class BinaryOpModel(CompositeModel, RegriddableModel):
                              f"'{type(self.rhs).__name__}: {len(rhs)}'") from ve
         return val
 
+    def calc_deriv(self, p: Sequence[SupportsFloat],
+                   *args, **kwargs) -> Optional[np.ndarray]:
+        # The sum, difference, product, and quotient rules are
+        # supported; other operators have no analytic derivative.
+        #
+        if self.op not in (np.add, np.subtract, np.multiply, np.true_divide):
+            return None
+
+        nlhs = len(self.lhs.pars)
+        ldrv = _calc_deriv(self.lhs, p[:nlhs], *args, **kwargs)
+        if ldrv is None:
+            return None
+
+        rdrv = _calc_deriv(self.rhs, p[nlhs:], *args, **kwargs)
+        if rdrv is None:
+            return None
+
+        if self.op is np.add:
+            pass
+        elif self.op is np.subtract:
+            rdrv = -rdrv
+        else:
+            lhs = self.lhs.calc(p[:nlhs], *args, **kwargs)
+            rhs = self.rhs.calc(p[nlhs:], *args, **kwargs)
+            if self.op is np.multiply:
+                ldrv, rdrv = ldrv * rhs, lhs * rdrv
+            else:
+                ldrv, rdrv = ldrv / rhs, -lhs * rdrv / (rhs * rhs)
+
+        nelem = np.broadcast_shapes(ldrv.shape[1:], rdrv.shape[1:])
+        return np.concatenate([np.broadcast_to(ldrv, ldrv.shape[:1] + nelem),
+                               np.broadcast_to(rdrv, rdrv.shape[:1] + nelem)])
+
 
 # TODO: do we actually make use of this functionality anywhere?
 # We only have 1 test that checks this class, and it is an existence
@@ -0,0 +1,603 @@
+//
+//  Copyright (C) 2024
+//       Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+// The extra bytes of a cache key are read with the y# format
+#define PY_SSIZE_T_CLEAN
+
+#include <sherpa/extension.hh>
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+
+#include "structmember.h"
+
+}
+
+
+//
+// A least-recently-used store of model evaluations. The key of an
+// evaluation is made from the parameter values, the integrate flag,
+// any other settings, and the id of the grid. The grids are stored
+// once, rather than in every key, and matched by their contents;
+// they are dropped once no stored evaluation refers to them.
+//
+class ModelStore {
+
+public:
+
+  explicit ModelStore( Py_ssize_t size ) : capacity( size ), nextid( 0 ) { }
+
+  ~ModelStore() { clear(); }
+
+  Py_ssize_t get_capacity() const { return capacity; }
+
+  Py_ssize_t size() const { return Py_ssize_t( entries.size() ); }
+
+  // The id of the grid whose contents (the shape and values of each
+  // array) are given by data. Unknown grids are added with no
+  // references.
+  long long grid_id( const std::string& data ) {
+
+    for ( std::vector< Grid >::iterator grid = grids.begin();
+	  grid != grids.end(); ++grid )
+      if ( grid->data == data )
+	return grid->id;
+
+    // Drop the grids which are not in use before adding a new one.
+    if ( Py_ssize_t( grids.size() ) > capacity ) {
+      std::vector< Grid > used;
+      for ( std::vector< Grid >::iterator grid = grids.begin();
+	    grid != grids.end(); ++grid )
+	if ( grid->refs > 0 )
+	  used.push_back( *grid );
+      grids.swap( used );
+    }
+
+    Grid grid = { nextid++, data, 0 };
+    grids.push_back( grid );
+    return grid.id;
+
+  }
+
+  // Return a new reference to the stored value, which is moved to the
+  // front of the list, or NULL.
+  PyObject* get( const std::string& key ) {
+
+    Index::iterator pos = index.find( key );
+    if ( index.end() == pos )
+      return NULL;
+
+    entries.splice( entries.begin(), entries, pos->second );
+    Py_INCREF( pos->second->value );
+    return pos->second->value;
+
+  }
+
+  // Store value, which is a new reference, removing the least
+  // recently used values when the store is full.
+  void put( const std::string& key, long long grid, PyObject* value ) {
+
+    Index::iterator pos = index.find( key );
+    if ( index.end() != pos ) {
+      Py_DECREF( pos->second->value );
+      pos->second->value = value;
+      entries.splice( entries.begin(), entries, pos->second );
+      return;
+    }
+
+    if ( capacity < 1 ) {
+      Py_DECREF( value );
+      return;
+    }
+
+    while ( size() >= capacity )
+      evict();
+
+    Entry entry = { key, grid, value };
+    entries.push_front( entry );
+    index[ key ] = entries.begin();
+    addref( grid, 1 );
+
+  }
+
+  bool contains( const std::string& key ) const {
+    return index.end() != index.find( key );
+  }
+
+  void clear() {
+    while ( !entries.empty() )
+      evict();
+    grids.clear();
+  }
+
+private:
+
+  struct Entry {
+    std::string key;
+    long long grid;
+    PyObject* value;
+  };
+
+  struct Grid {
+    long long id;
+    std::string data;
+    Py_ssize_t refs;
+  };
+
+  typedef std::list< Entry > Entries;
+  typedef std::unordered_map< std::string, Entries::iterator > Index;
+
+  void addref( long long id, Py_ssize_t delta ) {
+    for ( std::vector< Grid >::iterator grid = grids.begin();
+	  grid != grids.end(); ++grid )
+      if ( grid->id == id ) {
+	grid->refs += delta;
+	return;
+      }
+  }
+
+  void evict() {
+    Entry& last = entries.back();
+    addref( last.grid, -1 );
+    index.erase( last.key );
+    Py_DECREF( last.value );
+    entries.pop_back();
+  }
+
+  Py_ssize_t capacity;
+  long long nextid;
+  Entries entries;
+  Index index;
+  std::vector< Grid > grids;
+
+};
+
+
+typedef struct {
+  PyObject_HEAD
+  ModelStore* store;
+  Py_ssize_t hits;
+  Py_ssize_t misses;
+  Py_ssize_t checks;
+} PyModelCache;
+
+
+static PyObject* PyModelCache_new( PyTypeObject* type, PyObject* args,
+				   PyObject* kwds )
+{
+
+  PyModelCache* self = (PyModelCache*)type->tp_alloc( type, 0 );
+  if ( self ) {
+    self->store = NULL;
+    self->hits = 0;
+    self->misses = 0;
+    self->checks = 0;
+  }
+  return (PyObject*)self;
+
+}
+
+
+static int PyModelCache_init( PyModelCache* self, PyObject* args,
+			      PyObject* kwds )
+{
+
+  Py_ssize_t size = 1;
+  static char *kwlist[] = {(char*)"size", NULL};
+  if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"|n", kwlist,
+				     &size ) )
+    return -1;
+
+  if ( size < 0 ) {
+    PyErr_SetString( PyExc_ValueError,
+		     (char*)"size must be 0 or a positive integer" );
+    return -1;
+  }
+
+  delete self->store;
+  self->store = new ModelStore( size );
+  self->hits = 0;
+  self->misses = 0;
+  self->checks = 0;
+  return 0;
+
+}
+
+
+static void PyModelCache_dealloc( PyModelCache* self )
+{
+
+  delete self->store;
+  Py_TYPE( self )->tp_free( (PyObject*)self );
+
+}
+
+
+static int check_store( PyModelCache* self )
+{
+
+  if ( NULL == self->store ) {
+    PyErr_SetString( PyExc_RuntimeError,
+		     (char*)"ModelCache has not been initialized" );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+
+}
+
+
+// Append the shape and values of obj, as a C-contiguous double array,
+// to data.
+static int append_array( PyObject* obj, std::string& data )
+{
+
+  PyArrayObject* arr = (PyArrayObject*)
+    PyArray_FROMANY( obj, NPY_DOUBLE, 0, 0, NPY_ARRAY_CARRAY );
+  if ( NULL == arr )
+    return EXIT_FAILURE;
+
+  npy_intp ndim = PyArray_NDIM( arr );
+  data.append( (const char*)&ndim, sizeof( ndim ) );
+  data.append( (const char*)PyArray_DIMS( arr ), ndim * sizeof( npy_intp ) );
+  data.append( (const char*)PyArray_DATA( arr ), PyArray_NBYTES( arr ) );
+  Py_DECREF( arr );
+  return EXIT_SUCCESS;
+
+}
+
+
+// The grid id is stored at the start of the key.
+static const std::size_t GRID_ID_SIZE = sizeof( long long );
+
+
+static PyObject* PyModelCache_key( PyModelCache* self, PyObject* args,
+				   PyObject* kwds )
+{
+
+  PyObject* pars = NULL;
+  PyObject* grids = NULL;
+  int integrate = 0;
+  const char* extra = NULL;
+  Py_ssize_t nextra = 0;
+
+  static char *kwlist[] = {(char*)"pars", (char*)"grids", (char*)"integrate",
+			   (char*)"extra", NULL};
+  if ( !PyArg_ParseTupleAndKeywords( args, kwds, (char*)"OOp|y#", kwlist,
+				     &pars, &grids, &integrate,
+				     &extra, &nextra ) )
+    return NULL;
+
+  if ( EXIT_SUCCESS != check_store( self ) )
+    return NULL;
+
+  PyObject* seq = PySequence_Fast( grids, "grids must be a sequence" );
+  if ( NULL == seq )
+    return NULL;
+
+  std::string data;
+  Py_ssize_t ngrids = PySequence_Fast_GET_SIZE( seq );
+  for ( Py_ssize_t ii = 0; ii < ngrids; ii++ )
+    if ( EXIT_SUCCESS != append_array( PySequence_Fast_GET_ITEM( seq, ii ),
+				       data ) ) {
+      Py_DECREF( seq );
+      return NULL;
+    }
+  Py_DECREF( seq );
+
+  long long id = self->store->grid_id( data );
+
+  std::string key( (const char*)&id, GRID_ID_SIZE );
+  key.push_back( integrate ? '1' : '0' );
+  if ( EXIT_SUCCESS != append_array( pars, key ) )
+    return NULL;
+  if ( extra )
+    key.append( extra, nextra );
+
+  return PyBytes_FromStringAndSize( key.data(), key.size() );
+
+}
+
+
+static int get_key( PyObject* obj, std::string& key )
+{
+
+  char* buffer = NULL;
+  Py_ssize_t size = 0;
+  if ( -1 == PyBytes_AsStringAndSize( obj, &buffer, &size ) )
+    return EXIT_FAILURE;
+
+  if ( size < Py_ssize_t( GRID_ID_SIZE ) ) {
+    PyErr_SetString( PyExc_KeyError, (char*)"invalid model cache key" );
+    return EXIT_FAILURE;
+  }
+
+  key.assign( buffer, size );
+  return EXIT_SUCCESS;
+
+}
+
+
+static PyObject* PyModelCache_get( PyModelCache* self, PyObject* args )
+{
+
+  PyObject* kobj = NULL;
+  std::string key;
+  if ( !PyArg_ParseTuple( args, (char*)"O", &kobj ) ||
+       EXIT_SUCCESS != check_store( self ) ||
+       EXIT_SUCCESS != get_key( kobj, key ) )
+    return NULL;
+
+  PyObject* value = self->store->get( key );
+  if ( NULL == value ) {
+    self->misses++;
+    Py_RETURN_NONE;
+  }
+
+  self->hits++;
+  PyObject* copy = PyArray_NewCopy( (PyArrayObject*)value, NPY_ANYORDER );
+  Py_DECREF( value );
+  return copy;
+
+}
+
+
+static PyObject* PyModelCache_put( PyModelCache* self, PyObject* args )
+{
+
+  PyObject* kobj = NULL;
+  PyObject* vobj = NULL;
+  std::string key;
+  if ( !PyArg_ParseTuple( args, (char*)"OO", &kobj, &vobj ) ||
+       EXIT_SUCCESS != check_store( self ) ||
+       EXIT_SUCCESS != get_key( kobj, key ) )
+    return NULL;
+
+  PyArrayObject* arr = (PyArrayObject*)PyArray_FROMANY( vobj, NPY_NOTYPE, 0,
+							0, 0 );
+  if ( NULL == arr )
+    return NULL;
+
+  PyObject* copy = PyArray_NewCopy( arr, NPY_ANYORDER );
+  Py_DECREF( arr );
+  if ( NULL == copy )
+    return NULL;
+
+  long long id;
+  std::memcpy( &id, key.data(), GRID_ID_SIZE );
+  self->store->put( key, id, copy );
+  Py_RETURN_NONE;
+
+}
+
+
+static PyObject* PyModelCache_clear( PyModelCache* self,
+				     PyObject* Py_UNUSED( ignored ) )
+{
+
+  if ( EXIT_SUCCESS != check_store( self ) )
+    return NULL;
+
+  self->store->clear();
+  Py_RETURN_NONE;
+
+}
+
+
+static PyObject* PyModelCache_reduce( PyModelCache* self,
+				      PyObject* Py_UNUSED( ignored ) )
+{
+
+  // The stored values are not pickled.
+  Py_ssize_t size = self->store ? self->store->get_capacity() : 1;
+  return Py_BuildValue( "O(n)", Py_TYPE( self ), size );
+
+}
+
+
+static PyObject* PyModelCache_get_size( PyModelCache* self, void* closure )
+{
+
+  if ( EXIT_SUCCESS != check_store( self ) )
+    return NULL;
+  return PyLong_FromSsize_t( self->store->get_capacity() );
+
+}
+
+
+static Py_ssize_t PyModelCache_length( PyModelCache* self )
+{
+
+  if ( EXIT_SUCCESS != check_store( self ) )
+    return -1;
+  return self->store->size();
+
+}
+
+
+static int PyModelCache_contains( PyModelCache* self, PyObject* kobj )
+{
+
+  std::string key;
+  if ( EXIT_SUCCESS != check_store( self ) ||
+       !PyBytes_Check( kobj ) )
+    return 0;
+
+  if ( EXIT_SUCCESS != get_key( kobj, key ) ) {
+    PyErr_Clear();
+    return 0;
+  }
+
+  return self->store->contains( key ) ? 1 : 0;
+
+}
+
+
+static PyMemberDef PyModelCache_members[] = {
+
+  {(char*)"hits", T_PYSSIZET, offsetof(PyModelCache, hits), 0,
+   (char*)"The number of evaluations found in the cache."},
+
+  {(char*)"misses", T_PYSSIZET, offsetof(PyModelCache, misses), 0,
+   (char*)"The number of evaluations not found in the cache."},
+
+  {(char*)"checks", T_PYSSIZET, offsetof(PyModelCache, checks), 0,
+   (char*)"The number of model evaluations, including those made\n"
+   "when the cache is not in use."},
+
+  {NULL}  // Sentinel
+
+};
+
+
+static PyGetSetDef PyModelCache_getset[] = {
+
+  {(char*)"size", (getter)PyModelCache_get_size, NULL,
+   (char*)"The maximum number of evaluations which are stored.", NULL},
+
+  {NULL}  // Sentinel
+
+};
+
+
+static PyMethodDef PyModelCache_methods[] = {
+
+  { (char*)"key", (PyCFunction)((PyCFunctionWithKeywords)PyModelCache_key),
+    METH_VARARGS|METH_KEYWORDS,
+    (char*)"key(pars, grids, integrate, extra=b'')\n\n"
+    "The key for a model evaluation. The grids are a sequence of\n"
+    "arrays and extra contains any other settings which change the\n"
+    "model values." },
+
+  { (char*)"get", (PyCFunction)PyModelCache_get, METH_VARARGS,
+    (char*)"get(key)\n\n"
+    "Return a copy of the stored values, or None, updating the hits\n"
+    "or misses counter." },
+
+  { (char*)"put", (PyCFunction)PyModelCache_put, METH_VARARGS,
+    (char*)"put(key, values)\n\n"
+    "Store a copy of the values, removing the least-recently used\n"
+    "values if the cache is full." },
+
+  { (char*)"clear", (PyCFunction)PyModelCache_clear, METH_NOARGS,
+    (char*)"Remove the stored values. The counters are not changed." },
+
+  { (char*)"__reduce__", (PyCFunction)PyModelCache_reduce, METH_NOARGS,
+    NULL },
+
+  {NULL, NULL, 0, NULL}  // Sentinel
+
+};
+
+
+static PySequenceMethods PyModelCache_as_sequence = {
+  (lenfunc)PyModelCache_length,       // sq_length
+  0,                                  // sq_concat
+  0,                                  // sq_repeat
+  0,                                  // sq_item
+  0,                                  // was_sq_slice
+  0,                                  // sq_ass_item
+  0,                                  // was_sq_ass_slice
+  (objobjproc)PyModelCache_contains,  // sq_contains
+};
+
+
+static PyTypeObject PyModelCache_Type = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  (char*)"sherpa.models._cache.ModelCache", // tp_name
+  sizeof(PyModelCache),             // tp_basicsize
+  0,                                // tp_itemsize
+  (destructor)PyModelCache_dealloc, // tp_dealloc
+  0,                                // tp_print
+  0,                                // tp_getattr, __getattr__
+  0,                                // tp_setattr, __setattr__
+  0,                                // tp_compare
+  0,                                // tp_repr, __repr__
+  0,                                // tp_as_number
+  &PyModelCache_as_sequence,        // tp_as_sequence
+  0,                                // tp_as_mapping
+  0,                                // tp_hash
+  0,                                // tp_call, __call__
+  0,                                // tp_str, __str__
+  0,                                // tp_getattro
+  0,                                // tp_setattro
+  0,                                // tp_as_buffer
+  Py_TPFLAGS_DEFAULT,               // tp_flags
+  (char*)"ModelCache(size=1)\n\n"
+  "Store up to size model evaluations, dropping the least-recently\n"
+  "used evaluation when full.", // tp_doc, __doc__
+  0,                                // tp_traverse
+  0,                                // tp_clear
+  0,                                // tp_richcompare
+  0,                                // tp_weaklistoffset
+  0,                                // tp_iter, __iter__
+  0,                                // tp_iternext
+  PyModelCache_methods,             // tp_methods
+  PyModelCache_members,             // tp_members
+  PyModelCache_getset,              // tp_getset
+  0,                                // tp_base
+  0,                                // tp_dict, __dict__
+  0,                                // tp_descr_get
+  0,                                // tp_descr_set
+  0,                                // tp_dictoffset
+  (initproc)PyModelCache_init,      // tp_init, __init__
+  0,                                // tp_alloc
+  PyModelCache_new,                 // tp_new
+};
+
+
+static PyMethodDef CacheFcts[] = {
+  { NULL, NULL, 0, NULL }
+};
+
+
+static struct PyModuleDef cache = {
+    PyModuleDef_HEAD_INIT,
+    "_cache",
+    NULL,
+    -1,
+    CacheFcts
+};
+
+PyMODINIT_FUNC PyInit__cache(void) {
+
+  if ( PyType_Ready( &PyModelCache_Type ) < 0 )
+    return NULL;
+
+  import_array();
+
+  PyObject* m = PyModule_Create( &cache );
+  if ( NULL == m )
+    return NULL;
+
+  Py_INCREF( &PyModelCache_Type );
+  if ( PyModule_AddObject( m, (char*)"ModelCache",
+			   (PyObject*)&PyModelCache_Type ) < 0 ) {
+    Py_DECREF( &PyModelCache_Type );
+    Py_DECREF( m );
+    return NULL;
+  }
+
+  return m;
+
+}
@@ -18,6 +18,7 @@
 //  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 //
 
+#include "sherpa/fit_plan.hh"
 #include "sherpa/model_extension.hh"
 #include "sherpa/models.hh"
 
@@ -25,24 +26,52 @@ extern "C" {
   void init_modelfcts();
 }
 
+static const sherpa::models::Kernel1D Kernels1D[] = {
+
+  KERNEL1D( box1d, 3 ),
+  KERNEL1D_VEC( const1d, 1 ),
+  KERNEL1D( cos, 3 ),
+  KERNEL1D( delta1d, 2 ),
+  KERNEL1D( erf, 3 ),
+  KERNEL1D( erfc, 3 ),
+  KERNEL1D_ANTIDERIV( exp, 3 ),
+  KERNEL1D_ANTIDERIV( exp10, 3 ),
+  KERNEL1D_ANTIDERIV( gauss1d, 3 ),
+  KERNEL1D( log, 3 ),
+  KERNEL1D( log10, 3 ),
+  KERNEL1D_ANTIDERIV( ngauss1d, 3 ),
+  KERNEL1D_NOINT( poisson, 2 ),
+  KERNEL1D_VEC( poly1d, 10 ),
+  KERNEL1D_NOINT( logparabola, 4 ),
+  KERNEL1D_ANTIDERIV( powlaw, 3 ),
+  KERNEL1D( sin, 3 ),
+  KERNEL1D( sqrt, 2 ),
+  KERNEL1D( stephi1d, 2 ),
+  KERNEL1D( steplo1d, 2 ),
+  KERNEL1D( tan, 3 ),
+
+  KERNEL1D_END
+
+};
+
 static PyMethodDef ModelFcts[] = {
 
   MODELFCT1D( box1d, 3  ),
-  MODELFCT1D( const1d, 1 ),
+  MODELFCT1D_VEC( const1d, 1 ),
   MODELFCT1D( cos, 3 ),
   MODELFCT1D( delta1d, 2 ),
   MODELFCT1D( erf, 3 ),
   MODELFCT1D( erfc, 3 ),
-  MODELFCT1D( exp, 3 ),
-  MODELFCT1D( exp10, 3 ),
-  MODELFCT1D( gauss1d, 3 ),
+  MODELFCT1D_ANTIDERIV( exp, 3 ),
+  MODELFCT1D_ANTIDERIV( exp10, 3 ),
+  MODELFCT1D_ANTIDERIV( gauss1d, 3 ),
   MODELFCT1D( log, 3 ),
   MODELFCT1D( log10, 3 ),
-  MODELFCT1D( ngauss1d, 3 ),
+  MODELFCT1D_ANTIDERIV( ngauss1d, 3 ),
   MODELFCT1D_NOINT( poisson, 2 ),
-  MODELFCT1D( poly1d, 10 ),
+  MODELFCT1D_VEC( poly1d, 10 ),
   MODELFCT1D_NOINT( logparabola, 4 ),
-  MODELFCT1D( powlaw, 3 ),
+  MODELFCT1D_ANTIDERIV( powlaw, 3 ),
   MODELFCT1D( sin, 3 ),
   MODELFCT1D( sqrt, 2 ),
   MODELFCT1D( stephi1d, 2 ),
@@ -52,11 +81,21 @@ static PyMethodDef ModelFcts[] = {
   MODELFCT2D( box2d, 5 ),
   MODELFCT2D( const2d, 1 ),
   MODELFCT2D( delta2d, 3 ),
-  MODELFCT2D_NOINT( gauss2d, 6 ),
-  MODELFCT2D_NOINT( sigmagauss2d, 6 ),
-  MODELFCT2D_NOINT( ngauss2d, 6 ),
+  MODELFCT2D( gauss2d, 6 ),
+  MODELFCT2D( sigmagauss2d, 6 ),
+  MODELFCT2D( ngauss2d, 6 ),
   MODELFCT2D( poly2d, 9 ),
 
+  MODELDERIV1D( const1d, 1 ),
+  MODELDERIV1D( exp, 3 ),
+  MODELDERIV1D( gauss1d, 3 ),
+  MODELDERIV1D( powlaw, 3 ),
+  MODELDERIV2D_NOINT( gauss2d, 6 ),
+
+  MODELKERNELS1D( Kernels1D ),
+  MODELFUSED1D,
+  MODELFITPLAN1D,
+
   PY_MODELFCT1D_INT((char*)"integrate1d",
 		 (char*)"Integrate a one-dimensional model.\n\n"
 		    "Parameters\n"
@@ -268,3 +268,32 @@ def test_tablemodel_invalid_y():
     with pytest.raises(ModelErr,
                        match="Unable to treat array as numeric"):
         tbl.load([3, 4, 5], [1, 2, "x"])
+
+
+@pytest.mark.parametrize("cls", [basic.Gauss1D, basic.PowLaw1D])
+def test_precision_single(cls):
+    """The precision setting is used by the compiled models."""
+
+    mdl = cls()
+    x = np.linspace(1, 10, 21)
+
+    expected = mdl(x)
+    assert expected.dtype == SherpaFloat
+
+    mdl.precision = "single"
+    got = mdl(x)
+    assert got.dtype == np.float32
+    assert got == pytest.approx(expected, rel=1e-6)
+
+    # The cache does not return the double-precision values.
+    mdl.precision = "double"
+    assert mdl(x).dtype == SherpaFloat
+
+
+def test_precision_invalid():
+
+    mdl = basic.Gauss1D()
+    mdl.precision = "half"
+    with pytest.raises(ValueError,
+                       match="^precision must be None, 'double', or 'single', not 'half'$"):
+        mdl([1, 2, 3])
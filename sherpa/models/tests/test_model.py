@@ -21,26 +21,23 @@
 from collections import namedtuple
 import logging
 import operator
+import pickle
 import warnings
 
-# Repeat the logic from sherpa/models/model.py
-#
-try:
-    from hashlib import md5 as hashfunc
-except ImportError:
-    from hashlib import sha256 as hashfunc
-
 import numpy
 
 import pytest
 
 from sherpa.data import Data1D
+from sherpa.models import _modelfcts
+from sherpa.models._cache import ModelCache
 from sherpa.models.model import ArithmeticModel, ArithmeticConstantModel, \
     ArithmeticFunctionModel, BinaryOpModel, FilterModel, Model, NestedModel, \
     UnaryOpModel, RegridWrappedModel, modelCacher1d
 from sherpa.models.parameter import Parameter, hugeval, tinyval
 from sherpa.models.basic import Sin, Const1D, Box1D, LogParabola, Polynom1D, \
-    Scale1D, Integrate1D, Const2D, Gauss2D, Scale2D, Poisson
+    Scale1D, Integrate1D, Const2D, Gauss1D, Gauss2D, Scale2D, Poisson, \
+    SigmaGauss2D
 from sherpa.utils.err import ModelErr, ParameterErr
 
 
@@ -819,18 +816,50 @@ def test_integrate1d_basic(caplog):
     assert msg.startswith('Gauss-Kronrod integration failed with tolerance ')
 
 
+def test_integrate1d_warning_once(caplog):
+    """The lower-tolerance warning is reported once per fit."""
+
+    imdl = Integrate1D()
+    bmdl = Scale1D()
+    mdl = imdl(bmdl)
+    bmdl.c0 = 4
+
+    xlo = numpy.asarray([1.1, 1.2, 1.4, 1.8, 2.4])
+    xhi = numpy.asarray([1.2, 1.3, 1.8, 2.0, 3.0])
+
+    with caplog.at_level(logging.INFO, logger='sherpa'):
+        for _ in range(3):
+            mdl(xlo, xhi)
+
+    assert len(caplog.records) == 1
+
+    # startup is called at the start of a fit
+    mdl.startup()
+    with caplog.at_level(logging.INFO, logger='sherpa'):
+        for _ in range(3):
+            mdl(xlo, xhi)
+
+    mdl.teardown()
+    assert len(caplog.records) == 2
+    for name, lvl, msg in caplog.record_tuples:
+        assert name == 'sherpa.models.basic'
+        assert lvl == logging.WARNING
+        assert msg.startswith('Gauss-Kronrod integration failed with tolerance ')
+
+
 def test_integrate1d_basic_epsabs(caplog):
     """Check Integrate1D works
 
     This time adjust epsabs so that we don't get the Gauss-Kronrod
-    warning.
+    warning. The setting has to be made before the model is wrapped,
+    since the tolerance is copied at that point.
     """
 
     imdl = Integrate1D()
     bmdl = Scale1D()
+    imdl.epsabs = numpy.finfo(numpy.float32).eps
     mdl = imdl(bmdl)
     bmdl.c0 = 4
-    imdl.epsabs = numpy.finfo(numpy.float32).eps
 
     xlo = numpy.asarray([1.1, 1.2, 1.4, 1.8, 2.4])
     xhi = numpy.asarray([1.2, 1.3, 1.8, 2.0, 3.0])
@@ -847,6 +876,37 @@ def test_integrate1d_basic_epsabs(caplog):
     assert len(caplog.records) == 0
 
 
+@pytest.mark.parametrize("batchsize", [0, 2, 1024])
+def test_integrate1d_full_output(batchsize):
+    """The integration counters are returned for each call."""
+
+    def model(p, x):
+        return p[0] * numpy.asarray(x)
+
+    xlo = numpy.asarray([1.1, 1.2, 1.4, 1.8, 2.4])
+    xhi = numpy.asarray([1.2, 1.3, 1.8, 2.0, 3.0])
+    expected = 4 * (xhi * xhi - xlo * xlo) / 2
+
+    for _ in range(2):
+        y, info = _modelfcts.integrate1d(model, [4.0], xlo, xhi,
+                                         batchsize=batchsize,
+                                         full_output=True)
+        assert y == pytest.approx(expected)
+        assert info['nfail'] == 0
+        assert info['ntrapezoid'] == 0
+        assert info['neval'] >= 21 * xlo.size
+
+    # A tolerance which can not be met is reported for every bin
+    # and every call.
+    for _ in range(2):
+        y, info = _modelfcts.integrate1d(model, [4.0], xlo, xhi,
+                                         epsabs=0, epsrel=1e-20,
+                                         batchsize=batchsize,
+                                         full_output=True)
+        assert y == pytest.approx(expected)
+        assert info['nfail'] == xlo.size
+
+
 def check_cache(mdl, expected, x, xhi=None):
     """Check the cache contents.
 
@@ -859,16 +919,10 @@ def check_cache(mdl, expected, x, xhi=None):
     assert len(cache) == 1
 
     pars = [p.val for p in mdl.pars]
-    data = [numpy.asarray(pars).tobytes(),
-            b'1' if mdl.integrate else b'0',
-            x.tobytes()]
-    if xhi is not None:
-        data.append(xhi.tobytes())
-
-    token = b''.join(data)
-    digest = hashfunc(token).digest()
-    assert digest in cache
-    assert cache[digest] == pytest.approx(expected)
+    grid = (x, ) if xhi is None else (x, xhi)
+    key = cache.key(pars, grid, mdl.integrate)
+    assert key in cache
+    assert cache.get(key) == pytest.approx(expected)
 
 
 def test_evaluate_no_cache1d():
@@ -1068,9 +1122,7 @@ class DoNotUseModel(Model):
 
     # We need this for modelCacher1d
     _use_caching = True
-    _cache: dict[bytes, numpy.ndarray] = {}
-    _cache_ctr: dict[str, int] = {'hits': 0, 'misses': 0, 'check': 0}
-    _queue = ['']
+    _cache = ModelCache()
 
     @modelCacher1d
     def calc(self, p, *args, **kwargs):
@@ -1098,15 +1150,9 @@ def test_cache_integrate_fall_through_no_integrate():
     cache = mdl._cache
     assert len(cache) == 1
 
-    pars = []
-    data = [numpy.asarray(pars).tobytes(),
-            b'0', # not integrated
-            x.tobytes()]
-
-    token = b''.join(data)
-    digest = hashfunc(token).digest()
-    assert digest in cache
-    assert cache[digest] == pytest.approx(expected)
+    key = cache.key([], (x, ), False)  # not integrated
+    assert key in cache
+    assert cache.get(key) == pytest.approx(expected)
 
 
 def test_cache_integrate_fall_through_integrate_true():
@@ -1125,20 +1171,13 @@ def test_cache_integrate_fall_through_integrate_true():
     cache = mdl._cache
     assert len(cache) == 1
 
-    pars = []
-    data = [numpy.asarray(pars).tobytes(),
-            b'1', # integrated
-            x.tobytes(),
-            # The integrate setting is included twice because we can
-            # not guarantee it has been sent in with a keyword
-            # argument.
-            b'integrate',
-            numpy.asarray(True).tobytes()]
-
-    token = b''.join(data)
-    digest = hashfunc(token).digest()
-    assert digest in cache
-    assert cache[digest] == pytest.approx(expected)
+    # The integrate setting is included twice because we can
+    # not guarantee it has been sent in with a keyword argument.
+    #
+    extra = b'integrate' + numpy.asarray(True).tobytes()
+    key = cache.key([], (x, ), True, extra)  # integrated
+    assert key in cache
+    assert cache.get(key) == pytest.approx(expected)
 
 
 def test_cache_integrate_fall_through_integrate_false():
@@ -1157,20 +1196,13 @@ def test_cache_integrate_fall_through_integrate_false():
     cache = mdl._cache
     assert len(cache) == 1
 
-    pars = []
-    data = [numpy.asarray(pars).tobytes(),
-            b'0', # not integrated
-            x.tobytes(),
-            # The integrate setting is included twice because we can
-            # not guarantee it has been sent in with a keyword
-            # argument.
-            b'integrate',
-            numpy.asarray(False).tobytes()]
-
-    token = b''.join(data)
-    digest = hashfunc(token).digest()
-    assert digest in cache
-    assert cache[digest] == pytest.approx(expected)
+    # The integrate setting is included twice because we can
+    # not guarantee it has been sent in with a keyword argument.
+    #
+    extra = b'integrate' + numpy.asarray(False).tobytes()
+    key = cache.key([], (x, ), False, extra)  # not integrated
+    assert key in cache
+    assert cache.get(key) == pytest.approx(expected)
 
 
 def test_cache_status_single(caplog):
@@ -2138,3 +2170,218 @@ def test_model_linked_par_outside_limit():
     with pytest.raises(ParameterErr,
                        match="parameter mdl.ampl has a minimum of 0"):
         mdl.thawedpars = [12, 6]
+
+
+def check_eval_deriv(mdl, x, step=1e-6):
+    """Compare eval_deriv against central differences."""
+
+    pars = mdl.get_thawed_pars()
+    got = mdl.eval_deriv(pars, x)
+    assert got.shape == (len(pars), x.size)
+
+    for par, row in zip(pars, got):
+        orig = par.val
+        delta = step * max(abs(orig), 1)
+        par.val = orig + delta
+        hi = mdl(x)
+        par.val = orig - delta
+        lo = mdl(x)
+        par.val = orig
+        assert row == pytest.approx((hi - lo) / (2 * delta),
+                                    rel=1e-5, abs=1e-8)
+
+
+def test_eval_deriv_composite():
+    g1 = Gauss1D("g1")
+    g2 = Gauss1D("g2")
+    c1 = Const1D("c1")
+    g1.fwhm = 2.1
+    g1.pos = 3.2
+    g1.ampl = 4
+    g2.fwhm = 1.4
+    g2.pos = 6.1
+    g2.ampl = 2
+    c1.c0 = 1.5
+    g2.ampl.freeze()
+
+    mdl = -(g1 + 2 * g2) * c1 - g1 / c1
+    x = numpy.linspace(0, 10, 51)
+    check_eval_deriv(mdl, x)
+
+
+def test_eval_deriv_link():
+    """A simple link adds to the derivative of the linked parameter."""
+
+    g1 = Gauss1D("g1")
+    g2 = Gauss1D("g2")
+    g1.pos = 3
+    g2.pos = 5
+    g2.fwhm = g1.fwhm
+
+    mdl = g1 + g2
+    x = numpy.linspace(0, 10, 51)
+    check_eval_deriv(mdl, x)
+
+
+def test_eval_deriv_unsupported():
+    """Models without derivatives, or complex links, return None."""
+
+    g1 = Gauss1D("g1")
+    x = numpy.linspace(0, 10, 51)
+    assert (g1 * Sin()).eval_deriv(None, x) is None
+    assert (g1 ** 2).eval_deriv(None, x) is None
+
+    g2 = Gauss1D("g2")
+    g2.fwhm = 2 * g1.fwhm
+    assert (g1 + g2).eval_deriv(None, x) is None
+
+
+class ShiftedGauss1D(Gauss1D):
+    """calc is changed so the compiled kernel can not be used."""
+
+    def calc(self, p, *args, **kwargs):
+        return Gauss1D.calc(self, p, *args, **kwargs) + 1
+
+
+def test_eval_deriv_inherited():
+    """calc_deriv is not used when calc has been changed."""
+
+    x = numpy.linspace(0, 10, 51)
+    assert ShiftedGauss1D().eval_deriv(None, x) is None
+    assert (Gauss1D() + ShiftedGauss1D()).eval_deriv(None, x) is None
+    assert (-ShiftedGauss1D()).eval_deriv(None, x) is None
+
+    x0, x1 = numpy.meshgrid(numpy.arange(5), numpy.arange(4))
+    assert Gauss2D().eval_deriv(None, x0.ravel(), x1.ravel()) is not None
+    assert SigmaGauss2D().eval_deriv(None, x0.ravel(), x1.ravel()) is None
+
+
+@pytest.mark.parametrize("integrated", [False, True])
+def test_calc_fused(integrated, monkeypatch):
+    """The fused evaluation matches the Python evaluation."""
+
+    g1 = Gauss1D("g1")
+    g2 = ShiftedGauss1D("g2")
+    c1 = Const1D("c1")
+    g1.pos = 3.2
+    g2.pos = 6.1
+    c1.c0 = 1.5
+    c1.integrate = False
+
+    mdl = abs(-(g1 + 2 * g2) * c1 - g1 / c1) + g1 ** 2 + Sin() \
+        + numpy.linspace(1, 2, 50)
+    x = numpy.linspace(0, 10, 51)
+    args = (x[:-1], x[1:]) if integrated else (x[:-1], )
+
+    calls = []
+    fused1d = _modelfcts.fused1d
+
+    def spy(program, leaves, *args, **kwargs):
+        calls.append(program)
+        return fused1d(program, leaves, *args, **kwargs)
+
+    monkeypatch.setattr(_modelfcts, "fused1d", spy)
+    monkeypatch.setattr(BinaryOpModel, "fused", True)
+    got = mdl(*args)
+    assert len(calls) == 1
+
+    # g2, g1 ** 2, and the array are evaluated by Python.
+    assert len([code for code in calls[0] if code >= 0]) == 9
+
+    monkeypatch.setattr(BinaryOpModel, "fused", False)
+    expected = mdl(*args)
+    assert len(calls) == 1
+    assert got == pytest.approx(expected, rel=1e-14)
+
+
+def test_calc_fused_not_used(monkeypatch):
+    """Expressions without a compiled kernel, or 2D, are not fused."""
+
+    def fail(*args, **kwargs):
+        raise AssertionError("fused1d should not be called")
+
+    monkeypatch.setattr(_modelfcts, "fused1d", fail)
+    monkeypatch.setattr(BinaryOpModel, "fused", True)
+
+    g1 = ShiftedGauss1D()
+    x = numpy.linspace(0, 10, 51)
+    assert (g1 + 2)(x) == pytest.approx(g1(x) + 2)
+
+    g1 = Gauss1D()
+    g1.precision = "single"
+    (g1 * 2)(x)
+    (Gauss1D() ** 2)(x)
+    (Gauss2D() + Gauss2D())(x, x)
+
+
+def test_cache_lru():
+    """The least-recently used evaluation is removed."""
+
+    mdl = Polynom1D()
+    mdl.cache = 2
+    mdl.startup(cache=True)
+    assert mdl._cache.size == 2
+
+    x = numpy.asarray([1, 2, 3])
+    for c0 in [1, 2, 1, 3, 1, 2]:
+        mdl.c0 = c0
+        assert mdl(x) == pytest.approx(c0 * numpy.ones(3))
+
+    # c0=2 was dropped when c0=3 was added so it is evaluated again,
+    # whereas c0=1 is kept as it was used more recently.
+    assert mdl._cache_ctr == {'hits': 2, 'misses': 4, 'check': 6}
+    assert len(mdl._cache) == 2
+
+    mdl.teardown()
+
+
+def test_cache_grid():
+    """Evaluations are matched by the grid contents, not the object."""
+
+    mdl = Polynom1D()
+    x = numpy.asarray([1, 2, 3])
+    y1 = mdl(x)
+    y1[0] = 20
+    y2 = mdl(x.copy())
+    y3 = mdl([1.0, 2.0, 3.0])
+    assert y2 == pytest.approx([1, 1, 1])
+    assert y3 == pytest.approx([1, 1, 1])
+    assert mdl._cache_ctr == {'hits': 2, 'misses': 1, 'check': 3}
+
+    x[2] = 4
+    mdl(x)
+    assert mdl._cache_ctr == {'hits': 2, 'misses': 2, 'check': 4}
+
+
+def test_cache_2d():
+    """2D models are cached."""
+
+    mdl = Gauss2D()
+    mdl.startup(cache=True)
+
+    x0, x1 = numpy.mgrid[0:4, 0:5]
+    x0 = x0.flatten()
+    x1 = x1.flatten()
+    y1 = mdl(x0, x1)
+    y2 = mdl(x0, x1)
+    mdl(x1, x0)
+    assert y2 == pytest.approx(y1)
+    assert mdl._cache_ctr == {'hits': 1, 'misses': 2, 'check': 3}
+    assert len(mdl._cache) == 2
+
+    mdl.teardown()
+
+
+def test_cache_pickle():
+    """The cache size is kept but not the values."""
+
+    mdl = Polynom1D()
+    mdl.cache = 3
+    mdl.startup(cache=True)
+    mdl([1, 2, 3])
+    assert len(mdl._cache) == 1
+
+    new = pickle.loads(pickle.dumps(mdl))
+    assert new._cache.size == 3
+    assert len(new._cache) == 0
+    assert new([1, 2, 3]) == pytest.approx([1, 1, 1])
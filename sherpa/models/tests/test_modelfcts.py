@@ -0,0 +1,896 @@
+#
+#  Copyright (C) 2024
+#  Smithsonian Astrophysical Observatory
+#
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License along
+#  with this program; if not, write to the Free Software Foundation, Inc.,
+#  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+
+"""Low-level checks of the compiled model functions."""
+
+import math
+
+import numpy as np
+
+import pytest
+
+from sherpa.models import _modelfcts
+from sherpa.utils.numeric_types import SherpaFloat
+
+
+GFACTOR = 4 * np.log(2)
+
+erf = np.vectorize(math.erf)
+erfc = np.vectorize(math.erfc)
+
+
+def gauss1d(pars, x):
+    fwhm, pos, ampl = pars
+    return ampl * np.exp(-GFACTOR * (x - pos)**2 / fwhm**2)
+
+
+def gauss1d_int(pars, xlo, xhi):
+    fwhm, pos, ampl = pars
+    scale = np.sqrt(GFACTOR) / fwhm
+    norm = ampl * fwhm * np.sqrt(np.pi) / (2 * np.sqrt(GFACTOR))
+    return norm * (erf(scale * (xhi - pos)) -
+                   erf(scale * (xlo - pos)))
+
+
+def ngauss1d(pars, x):
+    fwhm, pos, ampl = pars
+    norm = np.sqrt(np.pi / GFACTOR) * fwhm
+    return gauss1d([fwhm, pos, ampl / norm], x)
+
+
+def ngauss1d_int(pars, xlo, xhi):
+    fwhm, pos, ampl = pars
+    scale = np.sqrt(GFACTOR) / fwhm
+    return ampl * (erf(scale * (xhi - pos)) -
+                   erf(scale * (xlo - pos))) / 2
+
+
+def powlaw(pars, x):
+    gamma, ref, ampl = pars
+    return ampl * (x / ref)**(-gamma)
+
+
+def powlaw_int(pars, xlo, xhi):
+    gamma, ref, ampl = pars
+    if gamma == 1:
+        return ampl * ref * (np.log(xhi) - np.log(xlo))
+
+    norm = ampl / ref**(-gamma) / (1 - gamma)
+    return norm * (xhi**(1 - gamma) - xlo**(1 - gamma))
+
+
+def exp(pars, x):
+    offset, coeff, ampl = pars
+    return ampl * np.exp(coeff * (x - offset))
+
+
+def exp_int(pars, xlo, xhi):
+    offset, coeff, ampl = pars
+    return ampl * (np.exp(coeff * (xhi - offset)) -
+                   np.exp(coeff * (xlo - offset))) / coeff
+
+
+def exp10(pars, x):
+    offset, coeff, ampl = pars
+    return ampl * 10**(coeff * (x - offset))
+
+
+def exp10_int(pars, xlo, xhi):
+    offset, coeff, ampl = pars
+    return ampl * (10**(coeff * (xhi - offset)) -
+                   10**(coeff * (xlo - offset))) / coeff / np.log(10)
+
+
+def const1d(pars, x):
+    return np.full_like(x, pars[0])
+
+
+def const1d_int(pars, xlo, xhi):
+    return pars[0] * (xhi - xlo)
+
+
+def poly1d(pars, x):
+    return np.polynomial.polynomial.polyval(x - pars[9], pars[:9])
+
+
+def poly1d_int(pars, xlo, xhi):
+    coeffs = np.polynomial.polynomial.polyint(pars[:9])
+    return np.polynomial.polynomial.polyval(xhi - pars[9], coeffs) - \
+        np.polynomial.polynomial.polyval(xlo - pars[9], coeffs)
+
+
+# The models which have a vectorized kernel, the parameter values to
+# use, and the reference point and integrated versions.
+#
+VECTORIZED = [("const1d", [2.3], const1d, const1d_int),
+              ("exp", [1.2, -0.3, 4.5], exp, exp_int),
+              ("exp10", [1.2, -0.3, 4.5], exp10, exp10_int),
+              ("gauss1d", [2.3, 4.1, 12], gauss1d, gauss1d_int),
+              ("ngauss1d", [2.3, 4.1, 12], ngauss1d, ngauss1d_int),
+              ("poly1d", [1, -2, 0.3, 0.05, 0, 0, 0, 0, 0, 2.5],
+               poly1d, poly1d_int),
+              ("powlaw", [1.7, 1, 12], powlaw, powlaw_int),
+              ("powlaw", [1, 2, 12], powlaw, powlaw_int)]
+
+
+@pytest.mark.parametrize("name,pars,point,integ", VECTORIZED)
+def test_vectorized_point(name, pars, point, integ):
+    """The vectorized kernels match the model definition."""
+
+    x = np.linspace(0.1, 10, 1001)
+    func = getattr(_modelfcts, name)
+    got = func(pars, x)
+    assert got.dtype.type is SherpaFloat
+    assert got == pytest.approx(point(np.asarray(pars), x), rel=1e-12)
+
+
+@pytest.mark.parametrize("name,pars,point,integ", VECTORIZED)
+def test_vectorized_integrated(name, pars, point, integ):
+    """The vectorized kernels match the model definition."""
+
+    x = np.linspace(0.1, 10, 1001)
+    xlo = x[:-1]
+    xhi = x[1:]
+    func = getattr(_modelfcts, name)
+    got = func(pars, xlo, xhi)
+    expected = integ(np.asarray(pars), xlo, xhi)
+    assert got == pytest.approx(expected, rel=1e-10, abs=1e-14)
+
+
+@pytest.mark.parametrize("name,pars,point,integ", VECTORIZED)
+def test_vectorized_matches_integrate_false(name, pars, point, integ):
+    """integrate=False uses the point kernel even with xhi"""
+
+    x = np.linspace(0.1, 10, 21)
+    func = getattr(_modelfcts, name)
+    got = func(pars, x[:-1], x[1:], integrate=False)
+    np.testing.assert_array_equal(got, func(pars, x[:-1]))
+
+
+@pytest.mark.parametrize("name,pars,point,integ", VECTORIZED)
+def test_vectorized_strided(name, pars, point, integ):
+    """Non-contiguous grids are supported."""
+
+    x = np.linspace(0.1, 10, 1001)
+    func = getattr(_modelfcts, name)
+    np.testing.assert_array_equal(func(pars, x[::3]),
+                                  func(pars, x[::3].copy()))
+
+    xlo = x[:-1][::2]
+    xhi = x[1:][::2]
+    np.testing.assert_array_equal(func(pars, xlo, xhi),
+                                  func(pars, xlo.copy(), xhi.copy()))
+
+
+@pytest.mark.parametrize("name,pars,point,integ", VECTORIZED)
+def test_vectorized_empty(name, pars, point, integ):
+    """An empty grid returns an empty array."""
+
+    func = getattr(_modelfcts, name)
+    x = np.asarray([], dtype=SherpaFloat)
+    assert func(pars, x).size == 0
+    assert func(pars, x, x).size == 0
+
+
+@pytest.mark.parametrize("name", ["gauss1d", "ngauss1d"])
+def test_vectorized_invalid_fwhm(name):
+    """The parameter check is still applied."""
+
+    func = getattr(_modelfcts, name)
+    x = np.linspace(0.1, 10, 11)
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        func([0, 2, 3], x)
+
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        func([0, 2, 3], x[:-1], x[1:])
+
+
+def test_vectorized_powlaw_negative_x():
+    """A single negative point fails the whole evaluation."""
+
+    x = np.linspace(0.1, 10, 11)
+    x[7] = -1
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.powlaw([1.7, 1, 12], x)
+
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.powlaw([1.7, 1, 12], x[:-1], x[1:])
+
+
+def test_vectorized_powlaw_zero_xlo_gamma_one():
+    """The xlo=0 case is still handled."""
+
+    xlo = np.asarray([0, 1, 2])
+    xhi = np.asarray([1, 2, 3])
+    got = _modelfcts.powlaw([1, 1, 1], xlo, xhi)
+    assert np.isfinite(got).all()
+    assert got[1:] == pytest.approx(np.log(xhi[1:] / xlo[1:]))
+
+
+def test_scalar_fallback_unchanged():
+    """Models without a vectorized kernel still work."""
+
+    x = np.linspace(0.1, 10, 11)
+    got = _modelfcts.sin([4, 0.5, 2], x)
+    assert got == pytest.approx(2 * np.sin(2 * np.pi * (x - 0.5) / 4))
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("gauss1d", [2.3, 4.1, 12]),
+                          ("powlaw", [1.7, 1, 12]),
+                          ("sin", [4, 0.5, 2]),
+                          ("logparabola", [1, 1.2, 0.3, 10]),
+                          ("poisson", [3.2, 10])])
+@pytest.mark.parametrize("numcores", [1, 2, 3, 8])
+def test_numcores_1d(name, pars, numcores):
+    """Splitting the grid across threads does not change the answer."""
+
+    x = np.linspace(0.1, 10, 2001)
+    func = getattr(_modelfcts, name)
+
+    expected = func(pars, x)
+    got = func(pars, x, numcores=numcores)
+    np.testing.assert_array_equal(got, expected)
+
+    expected = func(pars, x[:-1], x[1:])
+    got = func(pars, x[:-1], x[1:], numcores=numcores)
+    np.testing.assert_array_equal(got, expected)
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("gauss2d", [4, 10, 12, 0, 0, 20]),
+                          ("gauss2d", [4, 10, 12, 0.3, 1.2, 20]),
+                          ("poly2d", [1, 2, 3, 4, 5, 6, 7, 8, 9])])
+@pytest.mark.parametrize("numcores", [1, 4])
+def test_numcores_2d(name, pars, numcores):
+    """Splitting the grid across threads does not change the answer."""
+
+    x0, x1 = np.meshgrid(np.arange(5, 15), np.arange(7, 18))
+    x0 = x0.flatten().astype(SherpaFloat)
+    x1 = x1.flatten().astype(SherpaFloat)
+    func = getattr(_modelfcts, name)
+
+    expected = func(pars, x0, x1)
+    got = func(pars, x0, x1, numcores=numcores)
+    np.testing.assert_array_equal(got, expected)
+
+    args = (x0 - 0.5, x1 - 0.5, x0 + 0.5, x1 + 0.5)
+    expected = func(pars, *args)
+    got = func(pars, *args, numcores=numcores)
+    np.testing.assert_array_equal(got, expected)
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("exp", [1, 0.3, 2]),
+                          ("exp", [1, 0, 2]),
+                          ("exp10", [1, 0.1, 2]),
+                          ("gauss1d", [2.3, 4.1, 12]),
+                          ("ngauss1d", [2.3, 4.1, 12]),
+                          ("powlaw", [1.7, 1, 12]),
+                          ("powlaw", [1, 1, 12])])
+def test_contiguous_grid_matches_bins(name, pars):
+    """Sharing the bin edges of a contiguous grid does not change the
+    answer, whether or not the grid has gaps."""
+
+    func = getattr(_modelfcts, name)
+    edges = np.linspace(0.1, 11, 1001)
+    xlo = edges[:-1]
+    xhi = edges[1:]
+
+    # Each bin on its own has no shared edges.
+    expected = np.asarray([func(pars, [lo], [hi])[0]
+                           for lo, hi in zip(xlo, xhi)])
+    np.testing.assert_array_equal(func(pars, xlo, xhi), expected)
+
+    # Remove some bins, so the grid has several contiguous sections.
+    keep = np.ones(xlo.size, dtype=bool)
+    keep[[0, 10, 11, 500, 998]] = False
+    got = func(pars, xlo[keep], xhi[keep])
+    np.testing.assert_array_equal(got, expected[keep])
+
+    # Every other bin.
+    got = func(pars, xlo[::2], xhi[::2])
+    np.testing.assert_array_equal(got, expected[::2])
+
+
+def test_contiguous_grid_failure():
+    """A negative edge is still an error for the power law."""
+
+    edges = np.linspace(-1, 10, 12)
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.powlaw([1.7, 1, 12], edges[:-1], edges[1:])
+
+
+def test_numcores_failure_in_later_block():
+    """A failure in any thread is reported."""
+
+    x = np.linspace(0.1, 10, 4000)
+    x[-3] = -1
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.powlaw([1.7, 1, 12], x, numcores=4)
+
+
+@pytest.mark.parametrize("name", ["gauss1d", "gauss2d"])
+def test_numcores_negative(name):
+    func = getattr(_modelfcts, name)
+    x = np.arange(1, 4)
+    pars = [1, 2, 3] if name == "gauss1d" else [1, 2, 3, 0, 0, 1]
+    args = (x, ) if name == "gauss1d" else (x, x)
+    with pytest.raises(ValueError,
+                       match="^numcores must be 0 or a positive integer$"):
+        func(pars, *args, numcores=-1)
+
+
+def test_numcores_model_attribute():
+    """The numcores attribute of a model is passed through."""
+
+    from sherpa.models.basic import Gauss1D
+
+    mdl = Gauss1D()
+    mdl.pos = 5
+    assert mdl.numcores is None
+
+    # Turn off the cache otherwise the model is not re-evaluated.
+    mdl._use_caching = False
+
+    x = np.linspace(0.1, 10, 2001)
+    expected = mdl(x)
+
+    mdl.numcores = 2
+    np.testing.assert_array_equal(mdl(x), expected)
+
+    # Check the value is actually used
+    mdl.numcores = -1
+    with pytest.raises(ValueError,
+                       match="^numcores must be 0 or a positive integer$"):
+        mdl(x)
+
+
+def test_numcores_python_threads():
+    """The GIL is released so Python threads can evaluate models."""
+
+    from concurrent.futures import ThreadPoolExecutor
+
+    x = np.linspace(0.1, 10, 20001)
+    pars = [[2.3, pos, 12] for pos in np.linspace(1, 9, 16)]
+    expected = [_modelfcts.gauss1d(p, x[:-1], x[1:]) for p in pars]
+
+    def run(p):
+        return _modelfcts.gauss1d(p, x[:-1], x[1:], numcores=1)
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        got = list(pool.map(run, pars))
+
+    for g, e in zip(got, expected):
+        np.testing.assert_array_equal(g, e)
+
+
+def erf_diff(z1, z2):
+    """erf(z2) - erf(z1), avoiding cancellation in the tails."""
+    out = erf(z2) - erf(z1)
+    upper = z1 > 0
+    out[upper] = erfc(z1[upper]) - erfc(z2[upper])
+    lower = z2 < 0
+    out[lower] = erfc(-z2[lower]) - erfc(-z1[lower])
+    return out
+
+
+def gauss2d_axis_int(lo, hi, pos, width):
+    """Integrate exp(-GFACTOR * ((x - pos) / width)^2) from lo to hi."""
+    scale = np.sqrt(GFACTOR) / width
+    return erf_diff(scale * (lo - pos), scale * (hi - pos)) / scale * \
+        np.sqrt(np.pi) / 2
+
+
+def make_pixels(lo, hi, step):
+    edges = np.arange(lo, hi + step / 2, step)
+    x0lo, x1lo = np.meshgrid(edges[:-1], edges[:-1])
+    x0hi, x1hi = np.meshgrid(edges[1:], edges[1:])
+    return x0lo.flatten(), x1lo.flatten(), x0hi.flatten(), x1hi.flatten()
+
+
+@pytest.mark.parametrize("theta,swap", [(0, False), (np.pi, False),
+                                        (np.pi / 2, True),
+                                        (3 * np.pi / 2, True)])
+def test_gauss2d_integrated_aligned(theta, swap):
+    """The axis-aligned case is a product of erf differences."""
+
+    fwhm, xpos, ypos, ellip, ampl = 2.3, 10.2, 11.7, 0.4, 20
+    wide, narrow = fwhm, fwhm * (1 - ellip)
+    w0, w1 = (narrow, wide) if swap else (wide, narrow)
+
+    x0lo, x1lo, x0hi, x1hi = make_pixels(5, 17, 0.7)
+    got = _modelfcts.gauss2d([fwhm, xpos, ypos, ellip, theta, ampl],
+                             x0lo, x1lo, x0hi, x1hi)
+    expected = ampl * gauss2d_axis_int(x0lo, x0hi, xpos, w0) * \
+        gauss2d_axis_int(x1lo, x1hi, ypos, w1)
+    assert got == pytest.approx(expected, rel=1e-12, abs=1e-300)
+
+
+def test_sigmagauss2d_integrated_aligned():
+
+    sa, sb, xpos, ypos, ampl = 1.2, 3.1, 10.2, 11.7, 20
+    x0lo, x1lo, x0hi, x1hi = make_pixels(5, 17, 0.7)
+    got = _modelfcts.sigmagauss2d([sa, sb, xpos, ypos, 0, ampl],
+                                  x0lo, x1lo, x0hi, x1hi)
+
+    # sigma = fwhm / sqrt(2 * GFACTOR)
+    scale = np.sqrt(2 * GFACTOR)
+    expected = ampl * gauss2d_axis_int(x0lo, x0hi, xpos, sa * scale) * \
+        gauss2d_axis_int(x1lo, x1hi, ypos, sb * scale)
+    assert got == pytest.approx(expected, rel=1e-12, abs=1e-300)
+
+
+@pytest.mark.parametrize("pars", [[2.3, 10.2, 11.7, 0.4, 0.7, 20],
+                                  [2.3, 10.2, 11.7, 0.8, 2.4, 20],
+                                  [0.3, 10.2, 11.7, 0.6, -0.9, 20]])
+def test_gauss2d_integrated_rotated(pars):
+    """Compare the rotated case to a fine midpoint sum of the point values."""
+
+    x0lo, x1lo, x0hi, x1hi = make_pixels(8, 14, 1.0)
+    got = _modelfcts.gauss2d(pars, x0lo, x1lo, x0hi, x1hi)
+
+    nsub = 600
+    frac = (np.arange(nsub) + 0.5) / nsub
+    expected = []
+    for lo0, lo1, hi0, hi1 in zip(x0lo, x1lo, x0hi, x1hi):
+        s0, s1 = np.meshgrid(lo0 + frac * (hi0 - lo0),
+                             lo1 + frac * (hi1 - lo1))
+        vals = _modelfcts.gauss2d(pars, s0.flatten(), s1.flatten())
+        expected.append(vals.mean() * (hi0 - lo0) * (hi1 - lo1))
+
+    assert got == pytest.approx(expected, rel=2e-4, abs=1e-8 * pars[-1])
+
+
+@pytest.mark.parametrize("name", ["gauss2d", "sigmagauss2d"])
+@pytest.mark.parametrize("theta", [0, 0.3, 1.1, 2.5])
+def test_gauss2d_integrated_total(name, theta):
+    """The pixel values sum to the analytic total, even for sources
+    much smaller than a pixel."""
+
+    if name == "gauss2d":
+        fwhm, ellip, ampl = 0.4, 0.7, 20
+        pars = [fwhm, 10.2, 11.7, ellip, theta, ampl]
+        total = ampl * np.pi / GFACTOR * fwhm**2 * (1 - ellip)
+    else:
+        sa, sb, ampl = 0.1, 0.6, 20
+        pars = [sa, sb, 10.2, 11.7, theta, ampl]
+        total = ampl * 2 * np.pi * sa * sb
+
+    x0lo, x1lo, x0hi, x1hi = make_pixels(4, 18, 1.0)
+    got = getattr(_modelfcts, name)(pars, x0lo, x1lo, x0hi, x1hi)
+    assert got.sum() == pytest.approx(total, rel=1e-10)
+    assert got.min() >= 0
+
+
+def test_ngauss2d_integrated():
+    """ngauss2d is gauss2d scaled by the normalization."""
+
+    fwhm, ellip, ampl = 2.3, 0.4, 20
+    gpars = [fwhm, 10.2, 11.7, ellip, 0.7, ampl]
+    norm = np.pi / GFACTOR * fwhm**2 * np.sqrt(1 - ellip**2)
+
+    x0lo, x1lo, x0hi, x1hi = make_pixels(5, 17, 0.7)
+    expected = _modelfcts.gauss2d(gpars, x0lo, x1lo, x0hi, x1hi) / norm
+    got = _modelfcts.ngauss2d(gpars, x0lo, x1lo, x0hi, x1hi)
+    assert got == pytest.approx(expected, rel=1e-14)
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("gauss2d", [0, 1, 1, 0, 0, 1]),
+                          ("gauss2d", [1, 1, 1, 1, 0.5, 1]),
+                          ("ngauss2d", [0, 1, 1, 0, 0, 1]),
+                          ("sigmagauss2d", [0, 1, 1, 1, 0, 1]),
+                          ("sigmagauss2d", [1, 0, 1, 1, 0, 1])])
+def test_gauss2d_integrated_invalid(name, pars):
+    x0lo, x1lo, x0hi, x1hi = make_pixels(0, 3, 1.0)
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        getattr(_modelfcts, name)(pars, x0lo, x1lo, x0hi, x1hi)
+
+
+@pytest.mark.parametrize("name,pars,xmax",
+                         [("poisson", [2, 1], 6),
+                          ("logparabola", [1, 1.3, 0.2, 10], 20)])
+@pytest.mark.parametrize("intorder", [1, 2, 8, 20])
+def test_intorder(name, pars, xmax, intorder):
+    """Gauss-Legendre integration matches the adaptive integrator.
+
+    The adaptive integrator uses an absolute tolerance of ~1e-7, so
+    the comparison can not be any tighter than this.
+    """
+
+    func = getattr(_modelfcts, name)
+    x = np.linspace(0.5, xmax, 401)
+    expected = func(pars, x[:-1], x[1:], intorder=0)
+    got = func(pars, x[:-1], x[1:], intorder=intorder)
+
+    # A 1-point rule is the midpoint rule; only the bins where the
+    # model varies quickly are guaranteed to be refined.
+    rel = 1e-3 if intorder == 1 else 1e-6
+    assert got == pytest.approx(expected, rel=rel, abs=1e-7)
+
+    # The default is the adaptive integrator.
+    np.testing.assert_array_equal(func(pars, x[:-1], x[1:]), expected)
+
+
+def test_intorder_matches_analytic():
+    """logparabola(x) with ref=1 is ampl * x^(-c1 - c2 log10(x)),
+    so with c2 = 0 it is a power law, which can be integrated
+    analytically."""
+
+    x = np.linspace(0.5, 10, 97)
+    got = _modelfcts.logparabola([1, 1.7, 0, 12], x[:-1], x[1:],
+                                 intorder=8)
+    expected = powlaw_int([1.7, 1, 12], x[:-1], x[1:])
+    assert got == pytest.approx(expected, rel=1e-10)
+
+
+def test_intorder_point_failure_falls_back():
+    """If a point evaluation fails the bin is integrated adaptively."""
+
+    # logparabola fails for x <= 0, which the adaptive integrator
+    # ignores.
+    pars = [1, 1.3, 0.2, 10]
+    xlo = np.asarray([-1, -0.5, 0.5, 1])
+    xhi = np.asarray([-0.5, -0.25, 1, 2])
+    expected = _modelfcts.logparabola(pars, xlo, xhi, intorder=0)
+    got = _modelfcts.logparabola(pars, xlo, xhi, intorder=8)
+    assert got[:2] == pytest.approx([0, 0])
+    assert got == pytest.approx(expected, rel=1e-6)
+
+
+def test_intorder_negative():
+    x = np.arange(1, 5)
+    with pytest.raises(ValueError,
+                       match="^intorder must be 0 or a positive integer$"):
+        _modelfcts.poisson([2, 1], x[:-1], x[1:], intorder=-1)
+
+
+@pytest.mark.parametrize("intorder", [0, 8])
+@pytest.mark.parametrize("numcores", [1, 4])
+def test_intorder_numcores(intorder, numcores):
+    x = np.linspace(0.5, 6, 4001)
+    pars = [2, 1]
+    expected = _modelfcts.poisson(pars, x[:-1], x[1:], intorder=intorder)
+    got = _modelfcts.poisson(pars, x[:-1], x[1:], intorder=intorder,
+                             numcores=numcores)
+    np.testing.assert_array_equal(got, expected)
+
+
+class CountingModel:
+    """Record the calls made to a Python model."""
+
+    def __init__(self, func):
+        self.func = func
+        self.sizes = []
+
+    def __call__(self, pars, x):
+        self.sizes.append(len(x))
+        return self.func(pars, x)
+
+
+@pytest.mark.parametrize("batchsize,ncalls", [(None, 1), (1024, 1),
+                                              (100, 4), (1, 400)])
+def test_integrate1d_batch(batchsize, ncalls):
+    """The Gauss-Kronrod nodes of many bins are sent in one call."""
+
+    pars = np.asarray([2.3, 4.1, 12.0])
+    x = np.linspace(0.5, 10, 401)
+    mdl = CountingModel(gauss1d)
+
+    kwargs = {} if batchsize is None else {"batchsize": batchsize}
+    got = _modelfcts.integrate1d(mdl, pars, x[:-1], x[1:], **kwargs)
+    assert got == pytest.approx(gauss1d_int(pars, x[:-1], x[1:]),
+                                rel=1e-12)
+
+    # The bins are narrow enough that no refinement is needed.
+    assert len(mdl.sizes) == ncalls
+    assert sum(mdl.sizes) == 21 * 400
+
+
+def test_integrate1d_batch_matches_per_bin():
+    """The per-bin and batched modes give the same answer, including
+    for the bins which need to be refined."""
+
+    # Wide bins, some of which need the 43 and 87-point rules.
+    pars = np.asarray([0.4, 4.1, 12.0])
+    x = np.linspace(0, 10, 11)
+
+    batched = CountingModel(gauss1d)
+    expected = _modelfcts.integrate1d(gauss1d, pars, x[:-1], x[1:],
+                                      batchsize=0)
+    got = _modelfcts.integrate1d(batched, pars, x[:-1], x[1:])
+    np.testing.assert_array_equal(got, expected)
+
+    # One batched call and then extra calls for the refined bins.
+    assert batched.sizes[0] == 21 * 10
+    assert 1 < len(batched.sizes) < 10
+    assert set(batched.sizes[1:]) <= {1, 21, 22}
+
+
+def test_integrate1d_batch_empty():
+    got = _modelfcts.integrate1d(gauss1d, [1, 2, 3], [], [])
+    assert len(got) == 0
+
+
+def test_integrate1d_batch_model_error():
+
+    def bad(pars, x):
+        raise ValueError("oops")
+
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.integrate1d(bad, [1, 2, 3], [1, 2], [2, 3])
+
+
+def test_integrate1d_batch_negative():
+    with pytest.raises(ValueError,
+                       match="^batchsize must be 0 or a positive integer$"):
+        _modelfcts.integrate1d(gauss1d, [1, 2, 3], [1, 2], [2, 3],
+                               batchsize=-1)
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("gauss1d", [2.3, 4.1, 12]),
+                          ("powlaw", [1.7, 1, 12]),
+                          ("poisson", [2, 1]),
+                          ("box1d", [2, 6, 3])])
+@pytest.mark.parametrize("integrated", [False, True])
+@pytest.mark.parametrize("numcores", [0, 3])
+def test_batch_pars_1d(name, pars, integrated, numcores):
+    """A 2D parameter array evaluates each row."""
+
+    func = getattr(_modelfcts, name)
+    rng = np.random.default_rng(3842)
+    sets = np.asarray(pars) * rng.uniform(0.8, 1.2, size=(7, len(pars)))
+
+    x = np.linspace(0.5, 10, 501)
+    args = (x[:-1], x[1:]) if integrated else (x, )
+
+    got = func(sets, *args, numcores=numcores)
+    assert got.shape == (7, len(args[0]))
+    for row, vals in zip(sets, got):
+        np.testing.assert_array_equal(vals, func(row, *args))
+
+
+@pytest.mark.parametrize("integrated", [False, True])
+def test_batch_pars_2d(integrated):
+
+    rng = np.random.default_rng(2397)
+    pars = np.asarray([4, 10, 12, 0.3, 1.2, 20])
+    sets = pars * rng.uniform(0.8, 1.2, size=(5, 6))
+
+    x0, x1 = np.meshgrid(np.arange(5, 15), np.arange(7, 18))
+    x0 = x0.flatten().astype(SherpaFloat)
+    x1 = x1.flatten().astype(SherpaFloat)
+    args = (x0 - 0.5, x1 - 0.5, x0 + 0.5, x1 + 0.5) if integrated \
+        else (x0, x1)
+
+    got = _modelfcts.gauss2d(sets, *args, numcores=2)
+    assert got.shape == (5, x0.size)
+    for row, vals in zip(sets, got):
+        np.testing.assert_array_equal(vals, _modelfcts.gauss2d(row, *args))
+
+
+def test_batch_pars_empty():
+    x = np.arange(1, 5)
+    assert _modelfcts.gauss1d(np.zeros((0, 3)), x).shape == (0, 4)
+    assert _modelfcts.gauss1d(np.ones((2, 3)), []).shape == (2, 0)
+
+
+def test_batch_pars_not_contiguous():
+    sets = np.asarray([[1, 2, 3, 4], [5, 6, 7, 8], [1, 2, 3, 4]]).T
+    x = np.arange(1, 5)
+    got = _modelfcts.gauss1d(sets[:, :3], x)
+    for row, vals in zip(sets[:, :3], got):
+        np.testing.assert_array_equal(vals, _modelfcts.gauss1d(row, x))
+
+
+def test_batch_pars_wrong_npars():
+    with pytest.raises(TypeError,
+                       match="^expected 3 parameters, got 2$"):
+        _modelfcts.gauss1d(np.ones((4, 2)), [1, 2])
+
+
+def test_batch_pars_too_many_dims():
+    with pytest.raises(TypeError,
+                       match="^pars must have 1 or 2 dimensions$"):
+        _modelfcts.gauss1d(np.ones((4, 2, 3)), [1, 2])
+
+
+def test_batch_pars_failure():
+    """A failure for any parameter set is reported."""
+
+    sets = np.ones((10, 3))
+    sets[7, 0] = 0
+    with pytest.raises(ValueError,
+                       match="^model evaluation failed$"):
+        _modelfcts.gauss1d(sets, np.arange(1, 5), numcores=3)
+
+
+def numeric_deriv(func, pars, args, step=1e-6):
+    """Central-difference derivatives, one row per parameter."""
+
+    pars = np.asarray(pars, dtype=SherpaFloat)
+    out = []
+    for idx, par in enumerate(pars):
+        delta = step * max(abs(par), 1)
+        hi = pars.copy()
+        lo = pars.copy()
+        hi[idx] += delta
+        lo[idx] -= delta
+        out.append((func(hi, *args) - func(lo, *args)) / (2 * delta))
+
+    return np.asarray(out)
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("const1d", [3.2]),
+                          ("exp", [1.5, 0.3, 2.1]),
+                          ("gauss1d", [2.3, 4.1, 12]),
+                          ("powlaw", [1.7, 1.2, 12]),
+                          ("powlaw", [1, 1.2, 12])])
+@pytest.mark.parametrize("integrated", [False, True])
+def test_deriv_1d(name, pars, integrated):
+    """The analytic derivatives match central differences."""
+
+    func = getattr(_modelfcts, name)
+    deriv = getattr(_modelfcts, f"{name}_deriv")
+
+    x = np.linspace(0.5, 10, 41)
+    args = (x[:-1], x[1:]) if integrated else (x, )
+
+    # The larger step avoids round-off in the integrated power law
+    # close to gamma=1, where the value is a ratio of small terms.
+    #
+    got = deriv(pars, *args)
+    assert got.shape == (len(pars), len(args[0]))
+    assert got == pytest.approx(numeric_deriv(func, pars, args, step=1e-4),
+                                rel=1e-5, abs=1e-8)
+
+
+def test_deriv_2d():
+
+    pars = [4, 10, 12, 0.3, 1.2, 20]
+    x0, x1 = np.meshgrid(np.arange(5, 15), np.arange(7, 18))
+    x0 = x0.flatten().astype(SherpaFloat)
+    x1 = x1.flatten().astype(SherpaFloat)
+
+    got = _modelfcts.gauss2d_deriv(pars, x0, x1)
+    assert got.shape == (6, x0.size)
+    assert got == pytest.approx(numeric_deriv(_modelfcts.gauss2d, pars,
+                                              (x0, x1)),
+                                rel=1e-5, abs=1e-8)
+
+
+def test_deriv_wrong_npars():
+    with pytest.raises(TypeError,
+                       match="^expected 3 parameters, got 2$"):
+        _modelfcts.gauss1d_deriv([1, 2], [1, 2])
+
+
+@pytest.mark.parametrize("name,pars",
+                         [("gauss1d", [2.3, 4.1, 12]),
+                          ("powlaw", [1.7, 1, 12]),
+                          ("poisson", [2, 1]),
+                          ("box1d", [2, 6, 3])])
+@pytest.mark.parametrize("integrated", [False, True])
+def test_single_1d(name, pars, integrated):
+    """Single-precision evaluation is close to double precision."""
+
+    func = getattr(_modelfcts, name)
+    x = np.linspace(0.5, 10, 501)
+    args = (x[:-1], x[1:]) if integrated else (x, )
+
+    expected = func(pars, *args)
+    got = func(pars, *args, single=True)
+
+    # The integrated poisson model has no analytic form, so it is
+    # evaluated in double precision.
+    #
+    if integrated and name == "poisson":
+        assert got.dtype == np.float64
+        np.testing.assert_array_equal(got, expected)
+    else:
+        # The tail of the poisson model is the exponential of a large
+        # negative number, so the relative error is larger than the
+        # precision of a float.
+        assert got.dtype == np.float32
+        assert got == pytest.approx(expected, rel=1e-4, abs=1e-30)
+
+    got = func(pars, *args, single=False)
+    assert got.dtype == SherpaFloat
+    np.testing.assert_array_equal(got, expected)
+
+
+@pytest.mark.parametrize("integrated", [False, True])
+def test_single_2d(integrated):
+
+    pars = [4, 10, 12, 0.3, 1.2, 20]
+    x0, x1 = np.meshgrid(np.arange(5, 15), np.arange(7, 18))
+    x0 = x0.flatten().astype(SherpaFloat)
+    x1 = x1.flatten().astype(SherpaFloat)
+    args = (x0 - 0.5, x1 - 0.5, x0 + 0.5, x1 + 0.5) if integrated \
+        else (x0, x1)
+
+    got = _modelfcts.gauss2d(pars, *args, single=True, numcores=2)
+    assert got.dtype == np.float32
+    assert got == pytest.approx(_modelfcts.gauss2d(pars, *args),
+                                rel=1e-5, abs=1e-30)
+
+
+@pytest.mark.parametrize("integrated", [False, True])
+@pytest.mark.parametrize("numcores", [0, 3])
+def test_fused1d(integrated, numcores):
+    """-(gauss1d + 2 * powlaw) * poisson / arr, evaluated in one pass."""
+
+    x = np.linspace(0.5, 10, 2001)
+    args = (x[:-1], x[1:]) if integrated else (x[:-1], )
+    arr = np.linspace(1, 2, x.size - 1)
+
+    gpars = np.asarray([2.1, 4.3, 3.0])
+    ppars = np.asarray([1.7, 1.0, 2.0])
+    opars = np.asarray([3.0, 1.0])
+    leaves = [(_modelfcts.kernel1d("gauss1d", integrated), gpars, True),
+              2.0,
+              (_modelfcts.kernel1d("powlaw", integrated), ppars, True),
+              (_modelfcts.kernel1d("poisson"), opars, False),
+              arr]
+    program = [0, 1, 2, -3, -1, -5, 3, -3, 4, -4]
+
+    got = _modelfcts.fused1d(program, leaves, *args, numcores=numcores)
+    expected = -(_modelfcts.gauss1d(gpars, *args) +
+                 2 * _modelfcts.powlaw(ppars, *args)) * \
+        _modelfcts.poisson(opars, args[0]) / arr
+    assert got == pytest.approx(expected, rel=1e-14)
+
+
+def test_kernel1d_no_integral():
+    assert _modelfcts.kernel1d("poisson", True) is None
+    assert _modelfcts.kernel1d("poisson", False) is not None
+
+    with pytest.raises(ValueError, match="^unknown model kernel: notamodel$"):
+        _modelfcts.kernel1d("notamodel")
+
+
+@pytest.mark.parametrize("program", [[], [0, 0], [0, -1], [1], [0, -7]])
+def test_fused1d_invalid_program(program):
+    x = np.arange(1, 5)
+    with pytest.raises(ValueError, match="^invalid fused program$"):
+        _modelfcts.fused1d(program, [1.0], x)
+
+
+def test_fused1d_invalid_leaf():
+    x = np.arange(1, 5)
+    leaves = [(_modelfcts.kernel1d("gauss1d"), [1, 2], True)]
+    with pytest.raises(TypeError,
+                       match="^gauss1d: expected 3 parameters, got 2$"):
+        _modelfcts.fused1d([0], leaves, x)
+
+    with pytest.raises(TypeError,
+                       match="^fused model leaf has 3 elements, expected 4$"):
+        _modelfcts.fused1d([0], [np.ones(3)], x)
@@ -114,13 +114,14 @@ import numpy as np
 
 from sherpa.utils import NoNewAttributesAfterInit, \
     get_keyword_names, get_keyword_defaults, print_fields
-from sherpa.optmethods.optfcts import grid_search, lmdif, montecarlo, \
-    neldermead
+from sherpa.optmethods.optfcts import cmaes, grid_search, lbfgsb, lmdif, \
+    montecarlo, neldermead, neldermead_multistart
 
 warning = logging.getLogger(__name__).warning
 
 
-__all__ = ('GridSearch', 'OptMethod', 'LevMar', 'MonCar', 'NelderMead')
+__all__ = ('CMAES', 'GridSearch', 'OptMethod', 'LBFGSB', 'LevMar', 'MonCar',
+           'NelderMead', 'NelderMeadMultiStart')
 
 
 class OptMethod(NoNewAttributesAfterInit):
@@ -237,6 +238,24 @@ class OptMethod(NoNewAttributesAfterInit):
         def cb(pars):
             return statfunc(pars, *statargs, **statkwargs)
 
+        # Pass on the derivatives of the per-bin statistic, and of the
+        # statistic, and the compiled form of the statistic, when
+        # provided, for the optimizers that can use them.
+        #
+        jacfunc = getattr(statfunc, 'jacobian', None)
+        if jacfunc is not None:
+            cb.jacobian = lambda pars: jacfunc(pars, *statargs, **statkwargs)
+
+        gradfunc = getattr(statfunc, 'gradient', None)
+        if gradfunc is not None:
+            cb.gradient = lambda pars: gradfunc(pars, *statargs, **statkwargs)
+
+        # The compiled form can not be sent the extra arguments.
+        #
+        native = getattr(statfunc, 'native', None)
+        if native is not None and not statargs and not statkwargs:
+            cb.native = native
+
         output = self._optfunc(cb, pars, parmins, parmaxes, **self.config)
 
         success = output[0]
@@ -253,6 +272,68 @@ class OptMethod(NoNewAttributesAfterInit):
         return output
 
 
+class CMAES(OptMethod):
+    """Covariance matrix adaptation evolution strategy.
+
+    The CMA-ES method [1]_ samples each generation from a multi-variate
+    normal distribution, and then moves the mean, and adapts the
+    covariance and overall scale of the distribution, using the best
+    half of the generation. As the covariance follows the shape of the
+    statistic surface the method copes with strongly correlated, or
+    badly scaled, parameters, such as the absorbing column and photon
+    index of an absorbed power law. The search is restarted from a
+    random point near the starting point (drawn using the initial
+    spread), with double the population size each time, up to
+    `nrestart` times, and the best location found is returned
+    (IPOP-CMA-ES [2]_).
+
+    Attributes
+    ----------
+    ftol : number
+       A search stops when the statistic values of the recent
+       generations lie within ``ftol * max(abs(stat), 1)``, or when
+       the spread of every parameter is at most
+       ``ftol * max(abs(par), 1)``; the default is FLT_EPSILON
+       ~ 1.19209289551e-07.
+    maxfev : int or `None`
+       The maximum number of function evaluations; the default value
+       of `None` means to use ``8192 * n``, where `n` is the number of
+       free parameters.
+    step : sequence of number or `None`
+       The initial standard deviation of each parameter. The default
+       of `None` means to use the absolute value of the parameter (or
+       1 if it is 0), limited to 0.3 of the allowed range.
+    population_size : int or `None`
+       The number of points in each generation of the first search. A
+       value of `None` means to use ``4 + 3 * log(n)``.
+    nrestart : int
+       The number of times the search is restarted; the default is 3.
+    seed : int
+       The seed for the random number generator.
+    numcores : int
+       The number of CPU cores used to evaluate each generation. The
+       default is `1`.
+    verbose: int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    References
+    ----------
+
+    .. [1] N. Hansen, "The CMA Evolution Strategy: A Tutorial",
+           arXiv:1604.00772 (2016).
+
+    .. [2] A. Auger and N. Hansen, "A Restart CMA Evolution Strategy
+           With Increasing Population Size", Proceedings of the IEEE
+           Congress on Evolutionary Computation (2005), pages
+           1769-1776.
+
+    """
+
+    def __init__(self, name='cmaes'):
+        OptMethod.__init__(self, name, cmaes)
+
+
 # ## DOC-TODO: better description of the sequence argument; what happens
 # ##           with multiple free parameters.
 # ## DOC-TODO: what does the method attribute take: string or class instance?
@@ -536,6 +617,16 @@ class LevMar(OptMethod):
        The amount of information to print during the fit. The default
        is `0`, which means no output.
 
+    Notes
+    -----
+    When the statistic is one of the chi-square statistics, other
+    than `sherpa.stats.Chi2ModVar`, and every component of the model
+    expression provides analytic derivatives (see
+    `sherpa.models.model.Model.calc_deriv`), the jacobian is
+    calculated from the derivatives and the MINPACK subroutine lmder
+    is used. The `epsfcn` and `numcores` settings are not used in
+    this case.
+
     References
     ----------
 
@@ -549,6 +640,75 @@ class LevMar(OptMethod):
         OptMethod.__init__(self, name, lmdif)
 
 
+class LBFGSB(OptMethod):
+    """Limited-memory quasi-Newton optimization method with bounds.
+
+    A limited-memory BFGS method for bound-constrained problems,
+    following Byrd et al [1]_. The inverse Hessian is approximated
+    from the last `m` updates [2]_, and the parameters that are at a
+    limit, with the gradient pointing out of the allowed range, are
+    held fixed at each iteration. It does not assume that the
+    statistic is a sum of squares, so it is suited to the likelihood
+    statistics, such as `sherpa.stats.Cash` and `sherpa.stats.CStat`,
+    as well as the chi-square statistics.
+
+    Attributes
+    ----------
+    ftol : number
+       The search stops when two successive iterations each reduce the
+       statistic by at most ``ftol * max(abs(stat), 1)``; the default
+       is ``1e7 * DBL_EPSILON`` ~ 2.22e-9.
+    gtol : number
+       The search stops when no component of the projected gradient
+       is larger than `gtol` in absolute value; the default is
+       FLT_EPSILON ~ 1.19209289551e-07.
+    maxfev : int or `None`
+       The maximum number of function evaluations; the default value
+       of `None` means to use ``1024 * n``, where `n` is the number of
+       free parameters.
+    m : int
+       The number of updates used to approximate the inverse Hessian;
+       the default is 10.
+    epsfcn : number
+       This is used in determining a suitable step length for the
+       forward-difference approximation of the gradient; the default
+       is DBL_EPSILON ~ 2.22e-16. A value of FLT_EPSILON is better
+       when the model is calculated in single precision.
+    numcores : int
+       The number of CPU cores to use when calculating the
+       forward-difference gradient. The default is `1`.
+    verbose: int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    Notes
+    -----
+    When the statistic provides its derivative with respect to the
+    model (see `sherpa.stats.Stat.calc_stat_grad`) and every
+    component of the model expression provides analytic derivatives
+    (see `sherpa.models.model.Model.calc_deriv`), the gradient is
+    calculated from the derivatives rather than by forward
+    differences, and the `epsfcn` and `numcores` settings are not
+    used.
+
+    References
+    ----------
+
+    .. [1] R. H. Byrd, P. Lu, J. Nocedal and C. Zhu, "A Limited Memory
+           Algorithm for Bound Constrained Optimization", SIAM Journal
+           on Scientific Computing, Vol. 16, No. 5 (1995), pages
+           1190-1208.
+
+    .. [2] J. Nocedal, "Updating Quasi-Newton Matrices with Limited
+           Storage", Mathematics of Computation, Vol. 35, No. 151
+           (1980), pages 773-782.
+
+    """
+
+    def __init__(self, name='lbfgsb'):
+        OptMethod.__init__(self, name, lbfgsb)
+
+
 class MonCar(OptMethod):
     """Monte Carlo optimization method.
 
@@ -598,6 +758,11 @@ class MonCar(OptMethod):
        efficiency.
     numcores : int
        The number of CPU cores to use. The default is `1`.
+    generational : bool
+       When `True`, the differential-evolution steps evaluate each
+       generation of trial vectors as a batch, which is split over
+       `numcores` processes, and the result does not depend on
+       `numcores`. The default is `False`.
 
     References
     ----------
@@ -818,6 +983,45 @@ class NelderMead(OptMethod):
         OptMethod.__init__(self, name, neldermead)
 
 
+class NelderMeadMultiStart(OptMethod):
+    """Run several Nelder-Mead Simplex searches and return the best.
+
+    The first search starts at the current parameter values and the
+    others at a Latin-hypercube sample of the parameter limits, so
+    the limits should be finite and reasonably tight. Each search is
+    the simplex stage of `NelderMead`; the final refinement made by
+    `NelderMead` is not run.
+
+    Attributes
+    ----------
+    ftol : number
+       The function tolerance to terminate each search; the default
+       is FLT_EPSILON ~ 1.19209289551e-07.
+    maxfev : int or `None`
+       The maximum number of function evaluations for each search;
+       the default value of `None` means to use ``1024 * n``, where
+       `n` is the number of free parameters.
+    initsimplex, finalsimplex, step
+       See `NelderMead`.
+    nstart : int
+       The number of searches; the default is 8.
+    seed : int
+       The seed for the random number generator used to select the
+       starting points.
+    numcores : int
+       The number of CPU cores to use. The searches are spread across
+       them, and the result does not depend on this setting. The
+       default is `1`.
+    verbose : int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    """
+
+    def __init__(self, name='neldermeadmultistart'):
+        OptMethod.__init__(self, name, neldermead_multistart)
+
+
 ###############################################################################
 
 # # from sherpa.optmethods.fminpowell import *
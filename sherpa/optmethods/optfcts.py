@@ -42,6 +42,17 @@ Each optimizer has certain classes of problem where it is more, or
 less, successful. For instance, the `neldermead` function should
 only be used with chi-square based statistics.
 
+The `cmaes`, `difevo`, `difevo_lm`, `difevo_nm`, `lbfgsb`, `lmdif`,
+`minim`, `neldermead`, and `neldermead_multistart` functions also
+accept a native objective - a capsule created by a compiled extension
+that wraps a C++ function (see
+``sherpa/include/sherpa/native_objective.hh``) - in place of the
+callback. The optimizer then runs without calling back into Python,
+and with the GIL released, and a numcores setting uses threads. A
+Python callback can not be called from several threads, so instead
+each batch of evaluations is sent to
+`sherpa.utils.parallel.parallel_map` with one call.
+
 Examples
 --------
 
@@ -73,7 +84,7 @@ import numpy as np
 from sherpa.optmethods.ncoresde import ncoresDifEvo
 from sherpa.optmethods.ncoresnm import ncoresNelderMead
 
-from sherpa.utils import FuncCounter
+from sherpa.utils import FuncCounter, stat_value_func
 from sherpa.utils.parallel import parallel_map
 from sherpa.utils._utils import sao_fcmp  # type: ignore
 from sherpa.utils import random
@@ -81,14 +92,16 @@ from sherpa.utils.types import ArrayType
 
 from . import _saoopt  # type: ignore
 
-__all__ = ('difevo', 'difevo_lm', 'difevo_nm', 'grid_search', 'lmdif',
-           'minim', 'montecarlo', 'neldermead')
+__all__ = ('cmaes', 'difevo', 'difevo_lm', 'difevo_nm', 'grid_search',
+           'lbfgsb', 'lmdif', 'minim', 'montecarlo', 'neldermead',
+           'neldermead_multistart')
 
 
 #
 # Use FLT_EPSILON as default tolerance
 #
 EPSILON = np.float64(np.finfo(np.float32).eps)
+DBL_EPSILON = np.finfo(np.float64).eps
 
 #
 # Maximum callback function value, used to indicate that the optimizer
@@ -98,6 +111,27 @@ EPSILON = np.float64(np.finfo(np.float32).eps)
 FUNC_MAX = np.finfo(np.float64).max
 
 
+def _is_native(fcn) -> bool:
+    """Is fcn a native objective rather than a Python function?"""
+    return _saoopt.native_size(fcn) is not None
+
+
+def _use_native(fcn, numcores: int = 1):
+    """The native objective to use in place of fcn, if any.
+
+    A Python function can provide a native objective which calculates
+    the same statistic with a ``native`` attribute. This is called with
+    the number of threads which may use the objective at once, and
+    returns the objective or `None`.
+    """
+    native = getattr(fcn, 'native', None)
+    if native is None:
+        return fcn
+
+    obj = native(max(int(numcores), 1))
+    return fcn if obj is None else obj
+
+
 def _check_args(x0: ArrayType,
                 xmin: ArrayType,
                 xmax: ArrayType
@@ -178,9 +212,74 @@ def _outside_limits(x, xmin, xmax):
     return (np.any(x < xmin) or np.any(x > xmax))
 
 
+def _difevo_numcores(generational: bool, numcores: int) -> int:
+    """The numcores argument for the _saoopt difevo routines.
+
+    This is 0 for the original algorithm. Otherwise the generational
+    form is used, where each generation of trial vectors is evaluated
+    as a batch; the batch is split across numcores threads for a
+    native objective, or numcores processes for a Python function
+    (see _difevo_batch).
+    """
+    if not generational:
+        return 0
+
+    return max(int(numcores), 1)
+
+
+def _stat_batch(fcn, numcores: int):
+    """The batch argument for the _saoopt routines.
+
+    A Python function can not be called from several threads, so
+    when numcores > 1 the parameter values are sent to this function
+    as a (ntrials, npar) array, and the statistic values are
+    calculated with parallel_map. This is None for a native objective
+    or when the batch is not needed.
+    """
+    if numcores < 2 or _is_native(fcn):
+        return None
+
+    def batch(pars):
+        return np.asarray(parallel_map(fcn, list(pars), numcores),
+                          np.float64)
+
+    return batch
+
+
+def _difevo_batch(fcn, generational: bool, numcores: int):
+    """The batch argument for the _saoopt difevo routines.
+
+    Each generation of the generational form is sent to the batch
+    (see _stat_batch).
+    """
+    if not generational:
+        return None
+
+    return _stat_batch(fcn, numcores)
+
+
+def _lmdif_batch(fcn, numcores: int):
+    """The batch argument for _saoopt.cpp_lmdif.
+
+    A Python function can not be called from several threads, so
+    when numcores > 1 the parameter values for all the columns of
+    each forward-difference jacobian are sent to this function as
+    a (npar, npar) array, and the per-bin values are calculated
+    with parallel_map. This is None for a native objective or when
+    the batch is not needed.
+    """
+    if numcores < 2 or _is_native(fcn):
+        return None
+
+    def batch(pars):
+        return np.concatenate(parallel_map(fcn, list(pars), numcores))
+
+    return batch
+
+
 def difevo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
            seed=2005815, population_size=None, xprob=0.9,
-           weighting_factor=0.8):
+           weighting_factor=0.8, generational=False, numcores=1):
 
     x, xmin, xmax = _check_args(x0, xmin, xmax)
 
@@ -196,8 +295,11 @@ def difevo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
     if maxfev is None:
         maxfev = 1024 * x.size
 
+    fcn = _use_native(fcn, numcores)
     de = _saoopt.difevo(verbose, maxfev, seed, population_size, ftol, xprob,
-                        weighting_factor, xmin, xmax, x, fcn)
+                        weighting_factor, xmin, xmax, x, fcn,
+                        _difevo_numcores(generational, numcores),
+                        _difevo_batch(fcn, generational, numcores))
     fval = de[1]
     nfev = de[2]
     ierr = de[3]
@@ -211,7 +313,7 @@ def difevo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
 
 def difevo_lm(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
               seed=2005815, population_size=None, xprob=0.9,
-              weighting_factor=0.8):
+              weighting_factor=0.8, generational=False, numcores=1):
 
     x, xmin, xmax = _check_args(x0, xmin, xmax)
 
@@ -230,9 +332,24 @@ def difevo_lm(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
     # TODO: can we not just call x.size rather than
     #       np.asanyarray(fcn(x)).size for the last argument?
     #
+    fcn = _use_native(fcn, numcores)
+    mfct = _saoopt.native_size(fcn)
+    batch = None
+    if mfct is None:
+        mfct = np.asanyarray(fcn(x)).size
+
+        # The trial vectors are compared using the sum of the squared
+        # residuals.
+        def stat_cb0(pars):
+            fvec = np.asarray(fcn(pars), np.float64)
+            return np.dot(fvec, fvec)
+
+        batch = _difevo_batch(stat_cb0, generational, numcores)
+
     de = _saoopt.lm_difevo(verbose, maxfev, seed, population_size, ftol,
                            xprob, weighting_factor, xmin, xmax,
-                           x, fcn, np.asanyarray(fcn(x)).size)
+                           x, fcn, mfct,
+                           _difevo_numcores(generational, numcores), batch)
     fval = de[1]
     nfev = de[2]
     ierr = de[3]
@@ -242,10 +359,11 @@ def difevo_lm(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
 
 
 def difevo_nm(fcn, x0, xmin, xmax, ftol, maxfev, verbose, seed,
-              population_size, xprob, weighting_factor):
+              population_size, xprob, weighting_factor, generational=False,
+              numcores=1):
 
-    def stat_cb0(pars):
-        return fcn(pars)[0]
+    fcn = _use_native(fcn, numcores)
+    stat_cb0 = fcn if _is_native(fcn) else stat_value_func(fcn)
 
     x, xmin, xmax = _check_args(x0, xmin, xmax)
 
@@ -263,7 +381,9 @@ def difevo_nm(fcn, x0, xmin, xmax, ftol, maxfev, verbose, seed,
 
     de = _saoopt.nm_difevo(verbose, maxfev, seed, population_size,
                            ftol, xprob, weighting_factor, xmin, xmax,
-                           x, stat_cb0)
+                           x, stat_cb0,
+                           _difevo_numcores(generational, numcores),
+                           _difevo_batch(stat_cb0, generational, numcores))
     fval = de[1]
     nfev = de[2]
     ierr = de[3]
@@ -328,8 +448,10 @@ def grid_search(fcn, x0, xmin, xmax, num=16, sequence=None, numcores=1,
 
     npar = len(x)
 
+    statval = stat_value_func(fcn)
+
     def func(pars):
-        aaa = fcn(pars)[0]
+        aaa = statval(pars)
         if verbose:
             print(f'f{pars}={aaa:g}')
         return aaa
@@ -416,10 +538,16 @@ def minim(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, step=None,
     if maxfev is None:
         maxfev = 512 * len(x)
 
-    def stat_cb0(x_new):
-        if np.isnan(x_new).any() or _outside_limits(x_new, xmin, xmax):
-            return FUNC_MAX
-        return fcn(x_new)[0]
+    fcn = _use_native(fcn)
+    if _is_native(fcn):
+        stat_cb0 = fcn
+    else:
+        statval = stat_value_func(fcn)
+
+        def stat_cb0(x_new):
+            if np.isnan(x_new).any() or _outside_limits(x_new, xmin, xmax):
+                return FUNC_MAX
+            return statval(x_new)
 
     init = 0
     x, fval, neval, ifault = _saoopt.minim(reflect, verbose, maxfev, init, \
@@ -444,7 +572,8 @@ def minim(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, step=None,
 #
 def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
                seed=74815, population_size=None, xprob=0.9,
-               weighting_factor=0.8, numcores=1, rng=None):
+               weighting_factor=0.8, numcores=1, rng=None,
+               generational=False):
     """Monte Carlo optimization method.
 
     This is an implementation of the differential-evolution algorithm
@@ -507,6 +636,13 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
        Determines how the random numbers are created. If set to None
        then the routines from `numpy.random` are used, and so can be
        controlled by calling `numpy.random.seed`.
+    generational : bool, optional
+       When set, the differential-evolution steps use the
+       generational form of the algorithm, where each generation of
+       trial vectors is evaluated as a batch, split over `numcores`
+       processes, rather than using the `ncoresDifEvo` and
+       `ncoresNelderMead` classes. The result does not depend on
+       `numcores`.
 
     References
     ----------
@@ -519,8 +655,7 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
 
     """
 
-    def stat_cb0(pars):
-        return fcn(pars)[0]
+    stat_cb0 = stat_value_func(fcn)
 
     x, xmin, xmax = _check_args(x0, xmin, xmax)
 
@@ -565,7 +700,7 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
         else:
             mystep = 1.2 * x
 
-        if 1 == numcores:
+        if 1 == numcores or generational:
             result = neldermead(myfcn, x, xmin, xmax, maxfev=mymaxfev,
                                 ftol=ftol, finalsimplex=9, step=mystep)
             x = np.asarray(result[1], np.float64)
@@ -584,9 +719,10 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
         ############################## nmDifEvo #############################
         xmin, xmax = _narrow_limits(4 * factor, x, xmin, xmax)
         mymaxfev = min(maxfev_per_iter, maxfev - nfev)
-        if 1 == numcores:
+        if 1 == numcores or generational:
             result = difevo_nm(myfcn, x, xmin, xmax, ftol, mymaxfev, verbose,
-                               seed, pop, xprob, weight)
+                               seed, pop, xprob, weight,
+                               generational=generational, numcores=numcores)
             nfev += result[4].get('nfev')
             x = np.asarray(result[1], np.float64)
             nfval = result[2]
@@ -615,10 +751,12 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
             y = random_start(xmin, xmax)
             mymaxfev = min(maxfev_per_iter, maxfev - nfev)
 
-            if numcores == 1:
+            if numcores == 1 or generational:
                 # TODO: should this update the seed somehow?
                 result = difevo_nm(myfcn, y, xmin, xmax, ftol, mymaxfev,
-                                   verbose, seed, pop, xprob, weight)
+                                   verbose, seed, pop, xprob, weight,
+                                   generational=generational,
+                                   numcores=numcores)
                 nfev += result[4].get('nfev')
                 if result[2] < nfval:
                     nfval = result[2]
@@ -646,7 +784,7 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
         else:
             mystep = 1.2 * x
 
-        if 1 == numcores:
+        if 1 == numcores or generational:
             result = neldermead(fcn, x, xmin, xmax,
                                 maxfev=min(512*len(x), maxfev - nfev),
                                 ftol=ftol, finalsimplex=9, step=mystep)
@@ -675,6 +813,51 @@ def montecarlo(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, verbose=0,
 #
 # Nelder Mead
 #
+def _finalsimplex_array(finalsimplex) -> np.ndarray:
+    """Convert the finalsimplex option into the stopping criteria."""
+
+    if np.isscalar(finalsimplex) and not np.iterable(finalsimplex):
+        farg = int(finalsimplex)
+        if 0 == farg:
+            finalsimplex_ary = [1]
+        elif 1 == farg:
+            finalsimplex_ary = [2]
+        elif 2 == farg:
+            finalsimplex_ary = [0, 0]
+        elif 3 == farg:
+            finalsimplex_ary = [0, 1]
+        elif 4 == farg:
+            finalsimplex_ary = [0, 1, 0]
+        elif 5 == farg:
+            finalsimplex_ary = [0, 2, 0]
+        elif 6 == farg:
+            finalsimplex_ary = [1, 1, 0]
+        elif 7 == farg:
+            finalsimplex_ary = [2, 1, 0]
+        elif 8 == farg:
+            finalsimplex_ary = [1, 2, 0]
+        elif 9 == farg:
+            finalsimplex_ary = [0, 1, 1]
+        elif 10 == farg:
+            finalsimplex_ary = [0, 2, 1]
+        elif 11 == farg:
+            finalsimplex_ary = [1, 1, 1]
+        elif 12 == farg:
+            finalsimplex_ary = [1, 2, 1]
+        elif 13 == farg:
+            finalsimplex_ary = [2, 1, 1]
+        else:
+            finalsimplex_ary = [2, 2, 2]
+    elif (not np.isscalar(finalsimplex) and np.iterable(finalsimplex)):
+        # support for finalsimplex being a sequence is not documented
+        # and not tested
+        finalsimplex_ary = finalsimplex
+    else:
+        finalsimplex_ary = [2, 2, 2]
+
+    return np.asarray(finalsimplex_ary, np.int_)
+
+
 def neldermead(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None,
                initsimplex=0, finalsimplex=9, step=None, iquad=1,
                verbose=0, reflect=True):
@@ -891,51 +1074,18 @@ def neldermead(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None,
 
     # A safeguard just in case the initial simplex is outside the bounds
     #
-    def stat_cb0(x_new):
-        if np.isnan(x_new).any() or _outside_limits(x_new, xmin, xmax):
-            return FUNC_MAX
-        return fcn(x_new)[0]
-
-    if np.isscalar(finalsimplex) and not np.iterable(finalsimplex):
-        farg = int(finalsimplex)
-        if 0 == farg:
-            finalsimplex_ary = [1]
-        elif 1 == farg:
-            finalsimplex_ary = [2]
-        elif 2 == farg:
-            finalsimplex_ary = [0, 0]
-        elif 3 == farg:
-            finalsimplex_ary = [0, 1]
-        elif 4 == farg:
-            finalsimplex_ary = [0, 1, 0]
-        elif 5 == farg:
-            finalsimplex_ary = [0, 2, 0]
-        elif 6 == farg:
-            finalsimplex_ary = [1, 1, 0]
-        elif 7 == farg:
-            finalsimplex_ary = [2, 1, 0]
-        elif 8 == farg:
-            finalsimplex_ary = [1, 2, 0]
-        elif 9 == farg:
-            finalsimplex_ary = [0, 1, 1]
-        elif 10 == farg:
-            finalsimplex_ary = [0, 2, 1]
-        elif 11 == farg:
-            finalsimplex_ary = [1, 1, 1]
-        elif 12 == farg:
-            finalsimplex_ary = [1, 2, 1]
-        elif 13 == farg:
-            finalsimplex_ary = [2, 1, 1]
-        else:
-            finalsimplex_ary = [2, 2, 2]
-    elif (not np.isscalar(finalsimplex) and np.iterable(finalsimplex)):
-        # support for finalsimplex being a sequence is not documented
-        # and not tested
-        finalsimplex_ary = finalsimplex
+    fcn = _use_native(fcn)
+    if _is_native(fcn):
+        stat_cb0 = fcn
     else:
-        finalsimplex_ary = [2, 2, 2]
+        statval = stat_value_func(fcn)
 
-    fsimplex = np.asarray(finalsimplex_ary, np.int_)
+        def stat_cb0(x_new):
+            if np.isnan(x_new).any() or _outside_limits(x_new, xmin, xmax):
+                return FUNC_MAX
+            return statval(x_new)
+
+    fsimplex = _finalsimplex_array(finalsimplex)
 
     if maxfev is None:
         maxfev = 1024 * len(x)
@@ -999,6 +1149,114 @@ def neldermead(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None,
     return (status, x, fval, msg, imap)
 
 
+def neldermead_multistart(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None,
+                          initsimplex=0, finalsimplex=9, step=None,
+                          nstart=8, seed=74815, numcores=1, verbose=0):
+    """Run several Nelder-Mead Simplex searches and return the best.
+
+    The first search starts at `x0` and the others at a
+    Latin-hypercube sample of the space defined by `xmin` and `xmax`,
+    so these limits should be finite and reasonably tight. Each search
+    is the same as the simplex stage of `neldermead`; the `minim`
+    refinement used by `neldermead` is not run.
+
+    Parameters
+    ----------
+    fcn : function reference
+       Returns the current statistic and per-bin statistic value when
+       given the model parameters.
+    x0, xmin, xmax : sequence of number
+       The starting point, minimum, and maximum values for each
+       parameter.
+    ftol : number
+       The function tolerance to terminate each search.
+    maxfev : int or `None`
+       The maximum number of function evaluations for each search;
+       the default value of `None` means to use ``1024 * n``, where
+       `n` is the number of free parameters.
+    initsimplex, finalsimplex, step
+       See `neldermead`.
+    nstart : int
+       The number of searches, which must be at least 1.
+    seed : int
+       The seed for the random number generator used to select the
+       starting points.
+    numcores : int
+       The number of CPU cores to use; it does not change the result.
+       For a native objective the searches are spread across threads,
+       and when there are more threads than searches the spare threads
+       evaluate the vertices of the initial simplex, and of each
+       shrink step, in parallel. For a Python callback the searches
+       are instead spread across processes, with one call to
+       `sherpa.utils.parallel.parallel_map`, and when there is only
+       one search it is the vertices that are spread.
+    verbose : int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    See Also
+    --------
+    neldermead
+
+    """
+
+    x, xmin, xmax = _check_args(x0, xmin, xmax)
+
+    if step is None or (np.iterable(step) and len(step) != len(x)):
+        step = np.full(x.shape, 1.2, dtype=np.float64)
+    elif np.isscalar(step):
+        step = np.full(x.shape, step, dtype=np.float64)
+
+    fcn = _use_native(fcn, numcores)
+    if _is_native(fcn):
+        stat_cb0 = fcn
+    else:
+        statval = stat_value_func(fcn)
+
+        def stat_cb0(x_new):
+            if np.isnan(x_new).any() or _outside_limits(x_new, xmin, xmax):
+                return FUNC_MAX
+            return statval(x_new)
+
+    fsimplex = _finalsimplex_array(finalsimplex)
+
+    if maxfev is None:
+        maxfev = 1024 * len(x)
+
+    def search_batch(func):
+        """Run each search in a separate process.
+
+        Each search is the same as the one made by nm_multistart, so
+        the result does not depend on numcores.
+        """
+        if nstart < 2 or numcores < 2 or _is_native(func):
+            return None
+
+        def search(start):
+            xx, ff, nf, er = _saoopt.neldermead(0, maxfev, initsimplex,
+                                                fsimplex, ftol, step, xmin,
+                                                xmax, np.array(start), func)
+            return np.append(xx, ff), er, nf
+
+        def batch(starts):
+            found, ierrs, nfevs = zip(*parallel_map(search, list(starts),
+                                                    numcores))
+            return np.concatenate(found), ierrs, nfevs
+
+        return batch
+
+    x, fval, nfev, ier = _saoopt.nm_multistart(verbose, maxfev, initsimplex,
+                                               fsimplex, ftol, step, xmin,
+                                               xmax, x, stat_cb0, nstart,
+                                               seed, numcores,
+                                               search_batch(stat_cb0),
+                                               _stat_batch(stat_cb0,
+                                                           numcores))
+
+    status, msg = _get_saofit_msg(maxfev, ier)
+    return (status, x, fval, msg, {'info': status, 'nfev': nfev})
+
+
 def lmdif(fcn, x0, xmin, xmax, ftol=EPSILON, xtol=EPSILON, gtol=EPSILON,
           maxfev=None, epsfcn=EPSILON, factor=100.0, numcores=1, verbose=0):
     """Levenberg-Marquardt optimization method.
@@ -1055,11 +1313,25 @@ def lmdif(fcn, x0, xmin, xmax, ftol=EPSILON, xtol=EPSILON, gtol=EPSILON,
        euclidean norm of diag*x if nonzero, or else to factor itself.
        In most cases, `factor` should be from the interval (.1,100.).
     numcores : int
-       The number of CPU cores to use. The default is `1`.
+       The number of CPU cores to use when calculating the jacobian.
+       The default is `1`. The columns are calculated in separate
+       processes for a Python callback, with one call to
+       `sherpa.utils.parallel.parallel_map` per jacobian, and in
+       separate threads for a native objective.
     verbose: int
        The amount of information to print during the fit. The default
        is `0`, which means no output.
 
+    Notes
+    -----
+    If `fcn` has a ``jacobian`` attribute, which returns the
+    derivatives of the per-bin statistic values with respect to each
+    parameter as an array of shape (npars, nbins), or `None` if they
+    are not available, then the MINPACK lmder routine is used in
+    place of lmdif. This avoids the finite-difference approximation
+    of the jacobian, so the `epsfcn` and `numcores` settings are not
+    used.
+
     References
     ----------
 
@@ -1070,40 +1342,6 @@ def lmdif(fcn, x0, xmin, xmax, ftol=EPSILON, xtol=EPSILON, gtol=EPSILON,
 
     """
 
-    class fdJac:
-
-        def __init__(self, func, fvec, pars):
-            self.func = func
-            self.fvec = fvec
-            epsmch = np.finfo(float).eps
-            self.eps = np.sqrt(max(epsmch, epsfcn))
-            self.h = self.calc_h(pars)
-            self.pars = np.copy(pars)
-
-        def __call__(self, param):
-            wa = self.func(param[1:])
-            return (wa - self.fvec) / self.h[int(param[0])]
-
-        def calc_h(self, pars):
-            nn = len(pars)
-            h = np.empty((nn,))
-            for ii in range(nn):
-                h[ii] = self.eps * pars[ii]
-                if h[ii] == 0.0:
-                    h[ii] = self.eps
-                if pars[ii] + h[ii] > xmax[ii]:
-                    h[ii] = - h[ii]
-            return h
-
-        def calc_params(self):
-            params = []
-            for ii in range(len(self.h)):
-                tmp_pars = np.copy(self.pars)
-                tmp_pars[ii] += self.h[ii]
-                tmp_pars = np.append(ii, tmp_pars)
-                params.append(tmp_pars)
-            return tuple(params)
-
     x, xmin, xmax = _check_args(x0, xmin, xmax)
 
     if maxfev is None:
@@ -1112,24 +1350,52 @@ def lmdif(fcn, x0, xmin, xmax, ftol=EPSILON, xtol=EPSILON, gtol=EPSILON,
     def stat_cb1(pars):
         return fcn(pars)[1]
 
-    def fcn_parallel(pars, fvec):
-        fd_jac = fdJac(stat_cb1, fvec, pars)
-        params = fd_jac.calc_params()
-        fjac = parallel_map(fd_jac, params, numcores)
-        return np.concatenate(fjac)
+    # Use the analytic jacobian when it is available. It is returned
+    # with one row per parameter, which is the column-major order
+    # used by MINPACK.
+    #
+    jacobian = getattr(fcn, 'jacobian', None)
+    if jacobian is not None and jacobian(x) is None:
+        jacobian = None
 
-    fcn_parallel_counter = FuncCounter(fcn_parallel)
+    if jacobian is None:
+        fcn = _use_native(fcn, numcores)
 
-    # TO DO: reduce 1 model eval by passing the resulting 'fvec' to cpp_lmdif
-    m = np.asanyarray(stat_cb1(x)).size
+    # A native objective is passed straight to cpp_lmdif, which then
+    # calculates the jacobian columns itself, in numcores threads.
+    # Otherwise the columns are sent to the batch function.
+    #
+    m = _saoopt.native_size(fcn)
+    if m is None:
+        # TO DO: reduce 1 model eval by passing the resulting 'fvec' to
+        # cpp_lmdif
+        m = np.asanyarray(stat_cb1(x)).size
+        resid_cb = stat_cb1
+    else:
+        resid_cb = fcn
 
     n = len(x)
     fjac = np.empty((m*n,))
 
-    x, fval, nfev, info, fjac = \
-        _saoopt.cpp_lmdif(stat_cb1, fcn_parallel_counter, numcores, m, x, ftol,
-                          xtol, gtol, maxfev, epsfcn, factor, verbose, xmin,
-                          xmax, fjac)
+    batch = _lmdif_batch(resid_cb, numcores)
+    if batch is not None:
+        batch = FuncCounter(batch)
+
+    njev = 0
+    if jacobian is None:
+        x, fval, nfev, info, fjac = \
+            _saoopt.cpp_lmdif(resid_cb, batch, numcores, m, x,
+                              ftol, xtol, gtol, maxfev, epsfcn, factor,
+                              verbose, xmin, xmax, fjac)
+    else:
+        def stat_cb_der(pars, iflag):
+            if iflag == 2:
+                return np.ravel(jacobian(pars))
+            return stat_cb1(pars)
+
+        x, fval, nfev, njev, info, fjac = \
+            _saoopt.cpp_lmder(stat_cb_der, m, x, ftol, xtol, gtol, maxfev,
+                              factor, verbose, xmin, xmax, fjac)
 
     if info > 0:
         fjac = np.reshape(np.ravel(fjac, order='F'), (m, n), order='F')
@@ -1156,8 +1422,228 @@ def lmdif(fcn, x0, xmin, xmax, ftol=EPSILON, xtol=EPSILON, gtol=EPSILON,
     status, msg = _get_saofit_msg(maxfev, info)
 
     imap = {'info': info, 'nfev': nfev,
-            'num_parallel_map': fcn_parallel_counter.nfev}
+            'num_parallel_map': 0 if batch is None else batch.nfev}
+    if jacobian is not None:
+        imap['njev'] = njev
     if info == 0:
         imap['covar'] = covar
 
     return (status, x, fval, msg, imap)
+
+
+#
+# L-BFGS-B
+#
+def lbfgsb(fcn, x0, xmin, xmax, ftol=1.0e7 * DBL_EPSILON, gtol=EPSILON,
+           maxfev=None, m=10, epsfcn=DBL_EPSILON, numcores=1, verbose=0):
+    """Limited-memory quasi-Newton optimization with bounds.
+
+    A limited-memory BFGS method for bound-constrained problems,
+    following Byrd et al [1]_. Each iteration holds the parameters
+    that are at a limit, with the gradient pointing out of the
+    allowed range, fixed, calculates the quasi-Newton search direction
+    for the remaining parameters from the last `m` updates [2]_, and
+    then performs a backtracking line search along the projection of
+    this direction onto the parameter limits.
+
+    Unlike `lmdif` it does not assume the statistic is a sum of
+    squares, so it is suited to the likelihood statistics.
+
+    Parameters
+    ----------
+    fcn : function reference
+       Returns the current statistic and per-bin statistic value when
+       given the model parameters.
+    x0, xmin, xmax : sequence of number
+       The starting point, minimum, and maximum values for each
+       parameter.
+    ftol : number
+       The search stops when two successive iterations each reduce the
+       statistic by at most ``ftol * max(abs(stat), 1)``. The default
+       is ``1e7 * DBL_EPSILON`` ~ 2.22e-9, as used by the original
+       L-BFGS-B code; the likelihood statistics can have a large
+       offset, so FLT_EPSILON is too large.
+    gtol : number
+       The search stops when no component of the projected gradient
+       is larger than `gtol` in absolute value.
+    maxfev : int or `None`
+       The maximum number of function evaluations; the default value
+       of `None` means to use ``1024 * n``, where `n` is the number of
+       free parameters.
+    m : int
+       The number of updates used to approximate the inverse Hessian.
+    epsfcn : number
+       This is used in determining a suitable step length for the
+       forward-difference approximation of the gradient, as with
+       `lmdif`. The default is DBL_EPSILON ~ 2.22e-16, which is too
+       small when the model is calculated in single precision, where
+       FLT_EPSILON is a better choice.
+    numcores : int
+       The number of CPU cores used to calculate the forward-difference
+       gradient. The components are calculated in separate processes
+       for a Python callback, with one call to
+       `sherpa.utils.parallel.parallel_map` per gradient, and in
+       separate threads for a native objective.
+    verbose : int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    Notes
+    -----
+    If `fcn` has a ``gradient`` attribute, which returns the statistic
+    and its derivative with respect to each parameter (or `None` if
+    this can not be calculated), then the derivatives are used rather
+    than forward differences, and the `epsfcn` and `numcores` settings
+    are not used. Each gradient call counts as a function evaluation,
+    including the call made at `x0` to check that it is available.
+
+    References
+    ----------
+
+    .. [1] R. H. Byrd, P. Lu, J. Nocedal and C. Zhu, "A Limited Memory
+           Algorithm for Bound Constrained Optimization", SIAM Journal
+           on Scientific Computing, Vol. 16, No. 5 (1995), pages
+           1190-1208.
+
+    .. [2] J. Nocedal, "Updating Quasi-Newton Matrices with Limited
+           Storage", Mathematics of Computation, Vol. 35, No. 151
+           (1980), pages 773-782.
+
+    """
+
+    x, xmin, xmax = _check_args(x0, xmin, xmax)
+
+    if maxfev is None:
+        maxfev = 1024 * len(x)
+
+    # Checking that the gradient is available evaluates the
+    # statistic, so the call is counted.
+    #
+    gradient = None
+    nprobe = 0
+    gradfunc = getattr(fcn, 'gradient', None)
+    if gradfunc is not None and gradfunc(x) is not None:
+        nprobe = 1
+
+        def gradient(pars):
+            return gradfunc(pars)[1]
+    else:
+        fcn = _use_native(fcn, numcores)
+
+    if _is_native(fcn):
+        stat_cb0 = fcn
+    else:
+        stat_cb0 = stat_value_func(fcn)
+
+    batch = None if gradient is not None else _stat_batch(stat_cb0, numcores)
+    x, fval, nfev, info = _saoopt.lbfgsb(verbose, maxfev - nprobe, m, ftol,
+                                         gtol, epsfcn, xmin, xmax, x,
+                                         stat_cb0, numcores, gradient, batch)
+    nfev += nprobe
+
+    status, msg = _get_saofit_msg(maxfev, info)
+    return (status, x, fval, msg, {'info': status, 'nfev': nfev})
+
+
+#
+# CMA-ES
+#
+def cmaes(fcn, x0, xmin, xmax, ftol=EPSILON, maxfev=None, step=None,
+          population_size=None, nrestart=3, seed=74815, numcores=1,
+          verbose=0):
+    """Covariance matrix adaptation evolution strategy.
+
+    The CMA-ES method [1]_ samples each generation from a multi-variate
+    normal distribution, and then moves the mean, and adapts the
+    covariance and overall scale of the distribution, using the best
+    half of the generation. This lets the search follow correlated and
+    badly-scaled parameters. After the search has stopped it is
+    restarted with double the population size, up to `nrestart`
+    times, which makes it more likely to find the global minimum
+    (IPOP-CMA-ES [2]_). Each restart begins at a point drawn from a
+    normal distribution about `x0`, with standard deviations `step`.
+    The best location found is returned.
+
+    Parameters
+    ----------
+    fcn : function reference
+       Returns the current statistic and per-bin statistic value when
+       given the model parameters.
+    x0, xmin, xmax : sequence of number
+       The starting point, minimum, and maximum values for each
+       parameter. A sampled point outside the limits is moved to the
+       nearest limit.
+    ftol : number
+       A search stops when the best statistic values over the last
+       ``10 + 30 * n / population_size`` generations, and the values
+       of the current generation, all lie within
+       ``ftol * max(abs(stat), 1)``, or when the spread of every
+       parameter is at most ``ftol * max(abs(par), 1)``. The default
+       is FLT_EPSILON ~ 1.19209289551e-07.
+    maxfev : int or `None`
+       The maximum number of function evaluations; the default value
+       of `None` means to use ``8192 * n``, where `n` is the number of
+       free parameters. Running out of evaluations during a restart is
+       not treated as an error.
+    step : sequence of number or `None`
+       The initial standard deviation of each parameter. The default
+       of `None` means to use ``abs(x0)``, or 1 when x0 is 0, limited
+       to ``0.3 * (xmax - xmin)``.
+    population_size : int or `None`
+       The number of points in each generation of the first search. A
+       value of `None` means to use ``4 + 3 * log(n)``.
+    nrestart : int
+       The number of times the search is restarted.
+    seed : int
+       The seed for the random number generator.
+    numcores : int
+       The number of CPU cores used to evaluate each generation. The
+       points are evaluated in separate processes for a Python
+       callback, with one call to `sherpa.utils.parallel.parallel_map`
+       per generation, and in separate threads for a native
+       objective. The result does not depend on it.
+    verbose : int
+       The amount of information to print during the fit. The default
+       is `0`, which means no output.
+
+    References
+    ----------
+
+    .. [1] N. Hansen, "The CMA Evolution Strategy: A Tutorial",
+           arXiv:1604.00772 (2016).
+
+    .. [2] A. Auger and N. Hansen, "A Restart CMA Evolution Strategy
+           With Increasing Population Size", Proceedings of the IEEE
+           Congress on Evolutionary Computation (2005), pages
+           1769-1776.
+
+    """
+
+    x, xmin, xmax = _check_args(x0, xmin, xmax)
+
+    if maxfev is None:
+        maxfev = 8192 * len(x)
+
+    if step is None:
+        step = np.where(x == 0.0, 1.0, np.abs(x))
+        step = np.minimum(step, 0.3 * (xmax - xmin))
+        step[step <= 0.0] = 1.0
+    else:
+        step = np.full(x.shape, step, dtype=np.float64)
+
+    if population_size is None:
+        population_size = 0
+
+    fcn = _use_native(fcn, numcores)
+    if _is_native(fcn):
+        stat_cb0 = fcn
+    else:
+        stat_cb0 = stat_value_func(fcn)
+
+    x, fval, nfev, info = _saoopt.cmaes(verbose, maxfev, ftol, step, xmin,
+                                        xmax, x, stat_cb0, population_size,
+                                        nrestart, seed, numcores,
+                                        _stat_batch(stat_cb0, numcores))
+
+    status, msg = _get_saofit_msg(maxfev, info)
+    return (status, x, fval, msg, {'info': status, 'nfev': nfev})
@@ -0,0 +1,525 @@
+#ifndef CMAES_hh
+#define CMAES_hh
+
+//
+//  Copyright (C) 2024  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+//
+// The covariance matrix adaptation evolution strategy, restarted with an
+// increasing population size (IPOP-CMA-ES).
+//
+// N. Hansen, "The CMA Evolution Strategy: A Tutorial", arXiv:1604.00772
+// (2016).
+//
+// A. Auger and N. Hansen, "A Restart CMA Evolution Strategy With
+// Increasing Population Size", Proceedings of the IEEE Congress on
+// Evolutionary Computation (2005), pages 1769-1776.
+//
+// Each generation samples lambda points from a multi-variate normal
+// distribution, whose mean, covariance, and overall scale are then
+// updated from the best half of the points, so the search adapts to
+// correlated and badly-scaled parameters. A point outside the bounds is
+// moved to the nearest point inside them. The points of a generation are
+// drawn first and then evaluated together in up to numcores threads, or
+// in one call to a TrialBatch; the random numbers are only drawn by the
+// calling thread, so the result does not depend on numcores.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "sherpa/MersenneTwister.h"
+#include "sherpa/myArray.hh"
+#include "sherpa/parallel.hh"
+
+#include "Opt.hh"
+#include "Simplex.hh"
+
+namespace sherpa {
+
+  template <typename Func, typename Data, typename real> class CMAES {
+
+  public:
+    CMAES(Func func, Data xdata, int n)
+      : usr_func(func), usr_data(xdata), npar(n), batch(0) {}
+
+    //
+    // Evaluate the points of each generation with trial_batch, rather
+    // than in numcores threads.
+    //
+    void set_batch(TrialBatch<real> *trial_batch) { batch = trial_batch; }
+
+    //
+    // Minimize the function starting at par, where step gives the
+    // initial spread of each parameter. A population size less than 2
+    // means 4 + 3 log(npar). After the first search stops, up to
+    // nrestart further searches are made, each with twice the
+    // population of the previous one and starting from a random point
+    // near par (see restart_mean). On exit par contains the best
+    // location found, with the function value in par[npar].
+    //
+    int operator()(int verbose, int maxnfev, real tol,
+                   const Array1D<real> &step,
+                   const sherpa::Bounds<real> &bounds, int popsize,
+                   int nrestart, int seed, int numcores, ParVal<real> &par,
+                   int &nfev) {
+
+      int ierr = EXIT_SUCCESS;
+      nfev = 0;
+
+      try {
+
+        if (bounds.are_pars_outside_limits(npar, par))
+          throw sherpa::OptErr(sherpa::OptErr::OutOfBound);
+
+        for (int ii = 0; ii < npar; ++ii)
+          if (!(step[ii] > 0.0))
+            throw sherpa::OptErr(sherpa::OptErr::Input);
+
+        if (popsize < 2)
+          popsize = 4 + static_cast<int>(3.0 * std::log(double(npar)));
+
+        MTRand mt_rand(seed);
+        const ParVal<real> start(par);
+        ParVal<real> mean(start);
+        std::vector< ParVal<real> > pop(1, par);
+        par[npar] = std::numeric_limits<real>::max();
+        evaluate(maxnfev, numcores, 1, pop, par, nfev);
+
+        for (int run = 0; run <= nrestart; ++run, popsize *= 2) {
+          try {
+            if (run > 0)
+              restart_mean(step, bounds, mt_rand, start, mean);
+            if (verbose > 0)
+              std::cout << "run " << run << "\tpopsize = " << popsize
+                        << '\n';
+            cmaes(verbose, maxnfev, tol, step, bounds, popsize, numcores,
+                  mt_rand, mean, par, nfev);
+          } catch (sherpa::OptErr &oe) {
+            // an earlier search has converged, so running out of
+            // evaluations in a restart is not an error
+            if (run > 0 && sherpa::OptErr::MaxFev == oe.err)
+              break;
+            throw;
+          }
+        }
+
+      } catch (sherpa::OptErr &oe) {
+        if (verbose)
+          std::cerr << oe << '\n';
+        ierr = oe.err;
+      } catch (std::runtime_error &re) {
+        if (verbose)
+          std::cerr << re.what() << '\n';
+        ierr = OptErr::Unknown;
+      } catch (std::exception &e) {
+        if (verbose)
+          std::cerr << e.what() << '\n';
+        ierr = OptErr::Unknown;
+      }
+      return ierr;
+
+    }
+
+  private:
+    Func usr_func;
+    Data usr_data;
+    const int npar;
+    TrialBatch<real> *batch;
+
+    typedef Array2D< Array1D<real>, real > Matrix;
+
+    //
+    // The starting point of a restart, drawn from the distribution
+    // of the first generation of the first search (a normal
+    // distribution about start with standard deviations step), and
+    // moved inside the bounds.
+    //
+    void restart_mean(const Array1D<real> &step,
+                      const sherpa::Bounds<real> &bounds, MTRand &mt_rand,
+                      const ParVal<real> &start, ParVal<real> &mean) const {
+
+      const Array1D<real> &low = bounds.get_lb();
+      const Array1D<real> &high = bounds.get_ub();
+      for (int ii = 0; ii < npar; ++ii)
+        mean[ii] = std::min(std::max(start[ii] + step[ii] * mt_rand.randNorm(),
+                                     low[ii]), high[ii]);
+
+    }
+
+    //
+    // Evaluate the points [begin, end) of a generation; a NaN
+    // function value is treated as the largest value.
+    //
+    class Evaluate {
+
+    public:
+      Evaluate(Func f, Data d, int n, std::vector< ParVal<real> > &p)
+        : func(f), data(d), npar(n), pop(p) {}
+
+      int operator()(int begin, int end) {
+        for (int ii = begin; ii < end; ++ii) {
+          int ierr = EXIT_SUCCESS;
+          func(npar, &pop[ii][0], pop[ii][npar], ierr, data);
+          if (EXIT_SUCCESS != ierr)
+            return EXIT_FAILURE;
+          if (std::isnan(pop[ii][npar]))
+            pop[ii][npar] = std::numeric_limits<real>::max();
+        }
+        return EXIT_SUCCESS;
+      }
+
+    private:
+      Func func;
+      Data data;
+      const int npar;
+      std::vector< ParVal<real> > &pop;
+    };
+
+    //
+    // Evaluate the first num points of pop, or as many as the
+    // remaining function evaluations allow, keeping the best point
+    // in par.
+    //
+    void evaluate(int maxnfev, int numcores, int num,
+                  std::vector< ParVal<real> > &pop, ParVal<real> &par,
+                  int &nfev) {
+
+      const int nleft = std::max(maxnfev - nfev, 0);
+      const int neval = std::min(num, nleft);
+      if (batch)
+        batch_evaluate(neval, pop);
+      else {
+        Evaluate func(usr_func, usr_data, npar, pop);
+        if (EXIT_SUCCESS !=
+            sherpa::parallel::parallel_for(neval, numcores, func))
+          throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+      }
+      nfev += neval;
+
+      for (int ii = 0; ii < neval; ++ii)
+        if (pop[ii] < par)
+          par = pop[ii];
+
+      if (neval < num || nfev >= maxnfev)
+        throw sherpa::OptErr(sherpa::OptErr::MaxFev);
+
+    }
+
+    //
+    // As Evaluate, but with the first num points of pop sent to batch
+    // in one call.
+    //
+    void batch_evaluate(int num, std::vector< ParVal<real> > &pop) {
+
+      if (num < 1)
+        return;
+
+      std::vector< ParVal<real> > trials(pop.begin(), pop.begin() + num);
+      if (EXIT_SUCCESS != (*batch)(npar, trials))
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+      for (int ii = 0; ii < num; ++ii) {
+        pop[ii][npar] = trials[ii][npar];
+        if (std::isnan(pop[ii][npar]))
+          pop[ii][npar] = std::numeric_limits<real>::max();
+      }
+
+    }
+
+    //
+    // The eigen-decomposition of the symmetric matrix a, by the cyclic
+    // Jacobi method: a = v diag(d) v^T. The matrix a is overwritten.
+    //
+    static void eigen(int n, Matrix &a, Matrix &v, std::vector<real> &d) {
+
+      for (int ii = 0; ii < n; ++ii)
+        for (int jj = 0; jj < n; ++jj)
+          v[ii][jj] = ii == jj ? 1.0 : 0.0;
+
+      for (int sweep = 0; sweep < 50; ++sweep) {
+
+        real off = 0.0, diag = 0.0;
+        for (int pp = 0; pp < n; ++pp) {
+          diag += a[pp][pp] * a[pp][pp];
+          for (int qq = pp + 1; qq < n; ++qq)
+            off += a[pp][qq] * a[pp][qq];
+        }
+        if (off <= std::numeric_limits<real>::epsilon() *
+            std::numeric_limits<real>::epsilon() * diag)
+          break;
+
+        for (int pp = 0; pp < n - 1; ++pp)
+          for (int qq = pp + 1; qq < n; ++qq) {
+
+            if (0.0 == a[pp][qq])
+              continue;
+
+            const real theta = (a[qq][qq] - a[pp][pp]) / (2.0 * a[pp][qq]);
+            real t = 1.0 / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+            if (theta < 0.0)
+              t = -t;
+            const real c = 1.0 / std::sqrt(t * t + 1.0);
+            const real s = t * c;
+
+            for (int kk = 0; kk < n; ++kk) {
+              const real akp = a[kk][pp], akq = a[kk][qq];
+              a[kk][pp] = c * akp - s * akq;
+              a[kk][qq] = s * akp + c * akq;
+            }
+            for (int kk = 0; kk < n; ++kk) {
+              const real apk = a[pp][kk], aqk = a[qq][kk];
+              a[pp][kk] = c * apk - s * aqk;
+              a[qq][kk] = s * apk + c * aqk;
+            }
+            for (int kk = 0; kk < n; ++kk) {
+              const real vkp = v[kk][pp], vkq = v[kk][qq];
+              v[kk][pp] = c * vkp - s * vkq;
+              v[kk][qq] = s * vkp + c * vkq;
+            }
+
+          }
+
+      }
+
+      for (int ii = 0; ii < n; ++ii)
+        d[ii] = a[ii][ii];
+
+    }
+
+    //
+    // A single search, starting at the mean start with standard
+    // deviations step, which stops when the function values over
+    // the last 10 + 30 npar / popsize generations differ by at most
+    // tol * max(|f|, 1), when the spread of the distribution is at
+    // most tol * max(|mean|, 1) in each parameter, when the
+    // distribution is too badly conditioned, or when a step along a
+    // principal axis no longer changes the mean.
+    //
+    void cmaes(int verbose, int maxnfev, real tol, const Array1D<real> &step,
+               const sherpa::Bounds<real> &bounds, int lambda, int numcores,
+               MTRand &mt_rand, const ParVal<real> &start, ParVal<real> &par,
+               int &nfev) {
+
+      const int n = npar;
+      const Array1D<real> &low = bounds.get_lb();
+      const Array1D<real> &high = bounds.get_ub();
+
+      // the strategy parameters, from Table 1 of Hansen (2016)
+      const int mu = lambda / 2;
+      std::vector<real> weights(mu);
+      real wsum = 0.0;
+      for (int ii = 0; ii < mu; ++ii) {
+        weights[ii] = std::log(mu + 0.5) - std::log(ii + 1.0);
+        wsum += weights[ii];
+      }
+      real w2sum = 0.0;
+      for (int ii = 0; ii < mu; ++ii) {
+        weights[ii] /= wsum;
+        w2sum += weights[ii] * weights[ii];
+      }
+      const real mueff = 1.0 / w2sum;
+
+      const real cs = (mueff + 2.0) / (n + mueff + 5.0);
+      const real ds = 1.0 + cs +
+        2.0 * std::max(real(0.0), std::sqrt((mueff - 1.0) / (n + 1.0)) - 1);
+      const real cc = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+      const real c1 = 2.0 / ((n + 1.3) * (n + 1.3) + mueff);
+      const real cmu = std::min(1.0 - c1,
+                                2.0 * (mueff - 2.0 + 1.0 / mueff) /
+                                ((n + 2.0) * (n + 2.0) + mueff));
+      const real chin = std::sqrt(real(n)) *
+        (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+      const int eigen_every =
+        std::max(1, static_cast<int>(lambda / (c1 + cmu) / n / 10.0));
+      const int nhistory = 10 + (30 * n + lambda - 1) / lambda;
+
+      // the distribution is mean + sigma * B D N(0, I)
+      real sigma = 1.0;
+      std::vector<real> mean(&start[0], &start[0] + n), oldmean(n);
+      std::vector<real> ps(n, 0.0), pc(n, 0.0), dd(n), ymean(n), tmp(n);
+      std::vector<real> zz(n);
+      Matrix bb(n, n), cov(n, n), work(n, n);
+      for (int ii = 0; ii < n; ++ii) {
+        dd[ii] = step[ii];
+        for (int jj = 0; jj < n; ++jj) {
+          bb[ii][jj] = ii == jj ? 1.0 : 0.0;
+          cov[ii][jj] = ii == jj ? step[ii] * step[ii] : 0.0;
+        }
+      }
+
+      std::vector< ParVal<real> > pop(lambda, ParVal<real>(n + 1));
+      std::vector<int> index(lambda);
+      std::deque<real> history;
+
+      for (int gen = 1;; ++gen) {
+
+        // sample the generation, then evaluate it in one batch
+        for (int kk = 0; kk < lambda; ++kk) {
+          for (int jj = 0; jj < n; ++jj)
+            zz[jj] = dd[jj] * mt_rand.randNorm();
+          for (int ii = 0; ii < n; ++ii) {
+            real sum = 0.0;
+            for (int jj = 0; jj < n; ++jj)
+              sum += bb[ii][jj] * zz[jj];
+            pop[kk][ii] = std::min(std::max(mean[ii] + sigma * sum,
+                                            low[ii]), high[ii]);
+          }
+        }
+        evaluate(maxnfev, numcores, lambda, pop, par, nfev);
+
+        for (int kk = 0; kk < lambda; ++kk)
+          index[kk] = kk;
+        std::stable_sort(index.begin(), index.end(), Compare(pop, n));
+
+        if (verbose > 1)
+          std::cout << "gen " << gen << "\tsigma = " << sigma << '\t'
+                    << pop[index[0]] << '\n';
+
+        // recombination: the mean is within the bounds
+        oldmean = mean;
+        for (int ii = 0; ii < n; ++ii) {
+          real sum = 0.0;
+          for (int kk = 0; kk < mu; ++kk)
+            sum += weights[kk] * pop[index[kk]][ii];
+          mean[ii] = sum;
+          ymean[ii] = (mean[ii] - oldmean[ii]) / sigma;
+        }
+
+        // the conjugate evolution path uses C^(-1/2) ymean
+        for (int jj = 0; jj < n; ++jj) {
+          real sum = 0.0;
+          for (int ii = 0; ii < n; ++ii)
+            sum += bb[ii][jj] * ymean[ii];
+          tmp[jj] = sum / dd[jj];
+        }
+        const real csn = std::sqrt(cs * (2.0 - cs) * mueff);
+        real psnorm = 0.0;
+        for (int ii = 0; ii < n; ++ii) {
+          real sum = 0.0;
+          for (int jj = 0; jj < n; ++jj)
+            sum += bb[ii][jj] * tmp[jj];
+          ps[ii] = (1.0 - cs) * ps[ii] + csn * sum;
+          psnorm += ps[ii] * ps[ii];
+        }
+        psnorm = std::sqrt(psnorm);
+
+        const bool hsig = psnorm /
+          std::sqrt(1.0 - std::pow(1.0 - cs, 2.0 * gen)) <
+          (1.4 + 2.0 / (n + 1.0)) * chin;
+        const real ccn = std::sqrt(cc * (2.0 - cc) * mueff);
+        for (int ii = 0; ii < n; ++ii)
+          pc[ii] = (1.0 - cc) * pc[ii] + (hsig ? ccn * ymean[ii] : 0.0);
+
+        // the rank-one and rank-mu updates of the covariance
+        const real decay = 1.0 - c1 - cmu +
+          (hsig ? 0.0 : c1 * cc * (2.0 - cc));
+        for (int ii = 0; ii < n; ++ii)
+          for (int jj = 0; jj <= ii; ++jj) {
+            real rankmu = 0.0;
+            for (int kk = 0; kk < mu; ++kk) {
+              const ParVal<real> &xx = pop[index[kk]];
+              rankmu += weights[kk] * (xx[ii] - oldmean[ii]) *
+                (xx[jj] - oldmean[jj]);
+            }
+            cov[ii][jj] = decay * cov[ii][jj] + c1 * pc[ii] * pc[jj] +
+              cmu * rankmu / (sigma * sigma);
+            cov[jj][ii] = cov[ii][jj];
+          }
+
+        sigma *= std::exp(std::min(real(1.0),
+                                   (cs / ds) * (psnorm / chin - 1.0)));
+
+        if (0 == gen % eigen_every) {
+          for (int ii = 0; ii < n; ++ii)
+            for (int jj = 0; jj < n; ++jj)
+              work[ii][jj] = cov[ii][jj];
+          eigen(n, work, bb, dd);
+          for (int ii = 0; ii < n; ++ii)
+            dd[ii] = std::sqrt(std::max(dd[ii],
+                                        std::numeric_limits<real>::min()));
+        }
+
+        // the stopping criteria
+        const real fbest = pop[index[0]][n];
+        history.push_back(fbest);
+        if (static_cast<int>(history.size()) > nhistory)
+          history.pop_front();
+        if (static_cast<int>(history.size()) == nhistory) {
+          real fmin = std::min(fbest,
+                               *std::min_element(history.begin(),
+                                                 history.end()));
+          real fmax = std::max(pop[index[lambda - 1]][n],
+                               *std::max_element(history.begin(),
+                                                 history.end()));
+          if (fmax - fmin <= tol * std::max(std::fabs(fmin), real(1.0)))
+            return;
+        }
+
+        bool small = true;
+        for (int ii = 0; ii < n; ++ii)
+          if (sigma * std::max(std::sqrt(cov[ii][ii]), std::fabs(pc[ii])) >
+              tol * std::max(std::fabs(mean[ii]), real(1.0)))
+            small = false;
+        if (small)
+          return;
+
+        const real dmax = *std::max_element(dd.begin(), dd.end());
+        const real dmin = *std::min_element(dd.begin(), dd.end());
+        if (dmax > 1.0e7 * dmin)
+          return;
+
+        const int axis = gen % n;
+        bool moved = false;
+        for (int ii = 0; ii < n; ++ii)
+          if (mean[ii] + 0.1 * sigma * dd[axis] * bb[ii][axis] != mean[ii])
+            moved = true;
+        if (!moved)
+          return;
+
+      } // for ( int gen = 1; ; ++gen )
+
+    } // cmaes
+
+    //
+    // Order the points by function value.
+    //
+    class Compare {
+
+    public:
+      Compare(const std::vector< ParVal<real> > &p, int n)
+        : pop(p), npar(n) {}
+
+      bool operator()(int lhs, int rhs) const {
+        return pop[lhs][npar] < pop[rhs][npar];
+      }
+
+    private:
+      const std::vector< ParVal<real> > &pop;
+      const int npar;
+    };
+
+  }; // class CMAES
+
+} // namespace sherpa
+
+#endif
@@ -62,7 +62,11 @@
 // Revision: 1.0
 //
 
+#include <climits>
+#include <vector>
+
 #include "sherpa/MersenneTwister.h"
+#include "sherpa/parallel.hh"
 
 #include "Opt.hh"
 #include "Simplex.hh"
@@ -94,20 +98,32 @@ namespace sherpa {
 
     DifEvo(Func func, Data xdata)
       : usr_func(func), usr_data(xdata), local_opt(func, xdata),
-        strategy_func_ptr(0) {}
+        local_num(0), strategy_func_ptr(0), batch(0) {}
 
     DifEvo(Func func, Data xdata, int num)
       : usr_func(func), usr_data(xdata), local_opt(func, xdata, num),
-        strategy_func_ptr(0) {}
+        local_num(num), strategy_func_ptr(0), batch(0) {}
+
+    //
+    // Evaluate each generation with batch, rather than in numcores
+    // threads, in the generational form of the algorithm.
+    //
+    void set_batch(TrialBatch<real> *trial_batch) { batch = trial_batch; }
 
     // DifEvo( Func func, Data xdata, int mfct )
     //   : Opt<Data, real>( xdata ), usr_func( func ), usr_data(xdata),
     //     local_opt( func, xdata, mfct ), strategy_func_ptr( 0 ) { }
 
+    //
+    // When numcores is 0 the original algorithm is used, where each
+    // trial vector is evaluated, and the population updated, in turn.
+    // Otherwise the generational form (difevo_generation) is used,
+    // with the trial vectors evaluated in up to numcores threads.
+    //
     int operator()(int verbose, int maxnfev, real tol, int population_size,
                    int seed, real cross_over_probability, real scale_factor,
                    const sherpa::Bounds<real> &bounds, int npar, ParVal<real> &par,
-                   int &nfev) {
+                   int &nfev, int numcores = 0) {
 
       int ierr = EXIT_SUCCESS;
       nfev = 0;
@@ -116,9 +132,14 @@ namespace sherpa {
 
         if (bounds.are_pars_outside_limits(npar, par))
           throw sherpa::OptErr(sherpa::OptErr::OutOfBound);
-        ierr = difevo(verbose, maxnfev, tol, population_size, seed,
-                      cross_over_probability, scale_factor, bounds, npar, par,
-                      nfev);
+        if (numcores > 0)
+          ierr = difevo_generation(verbose, maxnfev, tol, population_size,
+                                   seed, cross_over_probability, scale_factor,
+                                   bounds, npar, par, nfev, numcores);
+        else
+          ierr = difevo(verbose, maxnfev, tol, population_size, seed,
+                        cross_over_probability, scale_factor, bounds, npar,
+                        par, nfev);
 
       } catch (OptErr &oe) {
 
@@ -146,7 +167,105 @@ namespace sherpa {
     Func usr_func;
     Data usr_data;
     Algo local_opt;
+    const int local_num;
     StrategyFuncPtr strategy_func_ptr;
+    TrialBatch<real> *batch;
+
+    //
+    // Evaluate the trial vectors [begin, end), each block with its own
+    // copy of the local optimizer (which may hold work space). The
+    // function must be thread safe when more than one thread is used.
+    //
+    class EvalTrials {
+
+    public:
+      EvalTrials(Func f, Data d, int num, const sherpa::Bounds<real> &b,
+                 int n, std::vector< ParVal<real> > &t, std::vector<int> &e)
+        : func(f), data(d), local_num(num), bounds(b), npar(n), trials(t),
+          nevals(e) {}
+
+      int operator()(int begin, int end) {
+        Algo local(func, data, local_num);
+        try {
+          for (int ii = begin; ii < end; ++ii) {
+            int count = 0;
+            trials[ii][npar] =
+              local.eval_func(INT_MAX, bounds, npar, trials[ii], count);
+            nevals[ii] = count;
+          }
+        } catch (...) {
+          return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+      }
+
+    private:
+      Func func;
+      Data data;
+      const int local_num;
+      const sherpa::Bounds<real> &bounds;
+      const int npar;
+      std::vector< ParVal<real> > &trials;
+      std::vector<int> &nevals;
+    };
+
+    //
+    // Evaluate the first ntrials trial vectors and add the number of
+    // function evaluations to nfev.
+    //
+    void eval_trials(int ntrials, int numcores,
+                     const sherpa::Bounds<real> &bounds, int npar,
+                     std::vector< ParVal<real> > &trials, int &nfev) {
+
+      if (batch) {
+        eval_batch(ntrials, bounds, npar, trials, nfev);
+        return;
+      }
+
+      std::vector<int> nevals(ntrials, 0);
+      EvalTrials eval(usr_func, usr_data, local_num, bounds, npar, trials,
+                      nevals);
+      if (EXIT_SUCCESS !=
+          sherpa::parallel::parallel_for(ntrials, numcores, eval))
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+      for (int ii = 0; ii < ntrials; ++ii)
+        nfev += nevals[ii];
+
+    }
+
+    //
+    // As eval_trials but using batch. A trial outside the limits is
+    // not evaluated, as with the eval_func method of the local
+    // optimizer.
+    //
+    void eval_batch(int ntrials, const sherpa::Bounds<real> &bounds,
+                    int npar, std::vector< ParVal<real> > &trials,
+                    int &nfev) {
+
+      std::vector<int> index;
+      std::vector< ParVal<real> > inside;
+      for (int ii = 0; ii < ntrials; ++ii) {
+        if (bounds.are_pars_outside_limits(npar, trials[ii]))
+          trials[ii][npar] = std::numeric_limits<real>::max();
+        else {
+          index.push_back(ii);
+          inside.push_back(trials[ii]);
+        }
+      }
+
+      if (inside.empty())
+        return;
+
+      if (EXIT_SUCCESS != (*batch)(npar, inside))
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+      const int ninside = static_cast<int>(inside.size());
+      for (int ii = 0; ii < ninside; ++ii)
+        trials[index[ii]][npar] = inside[ii][npar];
+      nfev += ninside;
+
+    }
 
     void choose_strategy(int strategy) {
 
@@ -313,6 +432,105 @@ namespace sherpa {
 
     } // difevo
 
+    //
+    // The generational (synchronous) form of the algorithm. Each
+    // generation builds a trial vector for every member of the
+    // population, using the same strategy for all of them (cycling
+    // through the ten strategies from one generation to the next),
+    // evaluates the trials as one batch, and then replaces each
+    // member that its trial improves on. The best improvement is
+    // refined by the local optimizer, as in difevo. The trials only
+    // depend on the previous generation, so the batch can be split
+    // across numcores threads without changing the result.
+    //
+    int difevo_generation(int verbose, int maxnfev, real tol,
+                          int population_size, int seed,
+                          real cross_over_probability, real scale_factor,
+                          const sherpa::Bounds<real> &bounds, int npar,
+                          ParVal<real> &par, int &nfev, int numcores) {
+
+      int ierr = EXIT_SUCCESS;
+      par[npar] = std::numeric_limits<real>::max();
+      population_size = std::abs(population_size);
+
+      MTRand mt_rand(seed);
+
+      const Array1D<real> &low = bounds.get_lb();
+      const Array1D<real> &high = bounds.get_ub();
+      Simplex population(population_size, npar);
+      std::vector< ParVal<real> > trials(population_size,
+                                         ParVal<real>(npar + 1));
+      for (int ii = 0; ii < population_size; ++ii) {
+        for (int jj = 0; jj < npar; ++jj)
+          trials[ii][jj] =
+            low[jj] + (high[jj] - low[jj]) * mt_rand.randDblExc();
+        trials[ii][npar] = std::numeric_limits<real>::max();
+        population[ii] = trials[ii];
+      }
+
+      const real tol_sqr = tol * tol;
+      const int simplex_tst = 0;
+
+      // the local optimizer counts its own evaluations against the
+      // remaining budget
+      int local_nfev = 0;
+      ierr = local_opt.minimize(maxnfev - nfev, tol, bounds, npar, par,
+                                par[npar], local_nfev);
+      nfev += local_nfev;
+      if (EXIT_SUCCESS != ierr)
+        return ierr;
+
+      for (int generation = -1; nfev < maxnfev; ++generation) {
+
+        // the first generation is the random initial population
+        if (generation >= 0) {
+          choose_strategy(generation % 10);
+          for (int candidate = 0; candidate < population_size; ++candidate) {
+            trials[candidate] = population[candidate];
+            (this->*strategy_func_ptr)(candidate, cross_over_probability,
+                                       scale_factor, npar, population, par,
+                                       mt_rand, trials[candidate]);
+          }
+        }
+
+        const int ntrials = std::min(population_size, maxnfev - nfev);
+        eval_trials(ntrials, numcores, bounds, npar, trials, nfev);
+
+        int best = -1;
+        for (int candidate = 0; candidate < ntrials; ++candidate)
+          if (generation < 0 || trials[candidate] < population[candidate]) {
+            population[candidate] = trials[candidate];
+            if (best < 0 || trials[candidate] < trials[best])
+              best = candidate;
+          }
+
+        if (best >= 0 && trials[best] < par) {
+
+          local_nfev = 0;
+          ierr = local_opt.minimize(maxnfev - nfev, tol, bounds, npar,
+                                    trials[best], trials[best][npar],
+                                    local_nfev);
+          nfev += local_nfev;
+          if (EXIT_SUCCESS != ierr)
+            return ierr;
+
+          par = trials[best];
+
+          if (verbose > 0)
+            std::cout << par << '\n';
+
+        }
+
+        population.sort();
+        if (population.check_convergence(tol, tol_sqr, simplex_tst))
+          return EXIT_SUCCESS;
+
+      } // for ( int generation = -1; nfev < maxnfev; ++generation )
+
+      return sherpa::OptErr::MaxFev;
+
+    } // difevo_generation
+
     //
     // EXPONENTIAL CROSSOVER
     //
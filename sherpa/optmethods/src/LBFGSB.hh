@@ -0,0 +1,492 @@
+#ifndef LBFGSB_hh
+#define LBFGSB_hh
+
+//
+//  Copyright (C) 2024  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+//
+// A limited-memory quasi-Newton method for bound-constrained problems.
+//
+// R. H. Byrd, P. Lu, J. Nocedal and C. Zhu, "A Limited Memory Algorithm
+// for Bound Constrained Optimization", SIAM Journal on Scientific
+// Computing, Vol. 16, No. 5 (1995), pages 1190-1208.
+//
+// J. Nocedal, "Updating Quasi-Newton Matrices with Limited Storage",
+// Mathematics of Computation, Vol. 35, No. 151 (1980), pages 773-782.
+//
+// Rather than the generalized Cauchy point and subspace minimization of
+// Byrd et al, each iteration fixes the variables that are at a bound
+// with the gradient pointing out of the box, uses the two-loop recursion
+// to calculate the search direction for the remaining (free) variables,
+// and then searches along the projection of this direction onto the
+// box with a backtracking (Armijo) line search. The search direction
+// falls back to steepest descent, and the stored corrections are
+// dropped, whenever the quasi-Newton direction is not a descent
+// direction.
+//
+// The gradient is calculated by forward differences, with the columns
+// evaluated in up to numcores threads, unless the gradient method is
+// overridden (see LBFGSBGrad).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "sherpa/parallel.hh"
+
+#include "Opt.hh"
+#include "Simplex.hh"
+
+namespace sherpa {
+
+  template <typename Func, typename Data, typename real> class LBFGSB {
+
+  public:
+    LBFGSB(Func func, Data xdata, int m, int ncores = 1)
+      : usr_func(func), usr_data(xdata), mcorr(std::max(m, 1)),
+        numcores(ncores), batch(0) {}
+
+    virtual ~LBFGSB() {}
+
+    //
+    // Evaluate the forward differences of each gradient with
+    // trial_batch, rather than in numcores threads.
+    //
+    void set_batch(TrialBatch<real> *trial_batch) { batch = trial_batch; }
+
+    //
+    // Minimize the function, starting at par, storing up to m
+    // corrections. The search stops when the largest component of the
+    // projected gradient is at most gtol, when two successive
+    // iterations each reduce the function by at most
+    // ftol * max(|f|, 1), or when no step along the search direction
+    // reduces the function. On exit par contains the best parameters,
+    // with the function value in par[npar].
+    //
+    int operator()(int verbose, int maxnfev, real ftol, real gtol,
+                   real epsfcn, const sherpa::Bounds<real> &bounds, int npar,
+                   ParVal<real> &par, int &nfev) {
+
+      int ierr = EXIT_SUCCESS;
+      nfev = 0;
+
+      try {
+
+        if (bounds.are_pars_outside_limits(npar, par))
+          throw sherpa::OptErr(sherpa::OptErr::OutOfBound);
+
+        lbfgsb(verbose, maxnfev, ftol, gtol, epsfcn, bounds, npar, par,
+               nfev);
+
+      } catch (sherpa::OptErr &oe) {
+        if (verbose)
+          std::cerr << oe << '\n';
+        ierr = oe.err;
+      } catch (std::runtime_error &re) {
+        if (verbose)
+          std::cerr << re.what() << '\n';
+        ierr = OptErr::Unknown;
+      } catch (std::exception &e) {
+        if (verbose)
+          std::cerr << e.what() << '\n';
+        ierr = OptErr::Unknown;
+      }
+      return ierr;
+
+    }
+
+  protected:
+    Func usr_func;
+    Data usr_data;
+
+    real eval_func(int maxnfev, int npar, const real *x, int &nfev) {
+
+      real fval;
+      ++nfev;
+      int ierr = EXIT_SUCCESS;
+      usr_func(npar, const_cast<real *>(x), fval, ierr, usr_data);
+      if (EXIT_SUCCESS != ierr)
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+      if (nfev >= maxnfev)
+        throw sherpa::OptErr(sherpa::OptErr::MaxFev);
+      return fval;
+
+    }
+
+    //
+    // Set grad to the gradient at par, where par[npar] is the function
+    // value. Each component is a forward difference, or a backward
+    // difference when the forward step would cross the upper bound.
+    //
+    virtual void gradient(int maxnfev, real epsfcn,
+                          const sherpa::Bounds<real> &bounds, int npar,
+                          const ParVal<real> &par, Array1D<real> &grad,
+                          int &nfev) {
+
+      const real epsmch = std::numeric_limits<real>::epsilon();
+      const real eps = std::sqrt(std::max(epsfcn, epsmch));
+
+      if (batch)
+        batch_gradient(eps, bounds.get_ub(), npar, par, grad);
+      else {
+        Columns columns(usr_func, usr_data, npar, &par[0], par[npar], eps,
+                        bounds.get_ub(), grad);
+        if (EXIT_SUCCESS !=
+            sherpa::parallel::parallel_for(npar, numcores, columns))
+          throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+      }
+
+      nfev += npar;
+      if (nfev >= maxnfev)
+        throw sherpa::OptErr(sherpa::OptErr::MaxFev);
+
+    }
+
+  private:
+    const int mcorr;
+    const int numcores;
+    TrialBatch<real> *batch;
+
+    //
+    // The forward-difference step for a parameter, which is backwards
+    // when the forward step would cross the upper bound.
+    //
+    static real step(real x, real eps, real high) {
+      real h = eps * std::fabs(x);
+      if (0.0 == h)
+        h = eps;
+      if (x + h > high)
+        h = -h;
+      return h;
+    }
+
+    //
+    // As the threaded gradient, but with all the components sent to
+    // batch in one call.
+    //
+    void batch_gradient(real eps, const Array1D<real> &high, int npar,
+                        const ParVal<real> &par, Array1D<real> &grad) {
+
+      std::vector<real> h(npar);
+      std::vector< ParVal<real> > trials(npar, par);
+      for (int jj = 0; jj < npar; ++jj) {
+        h[jj] = step(par[jj], eps, high[jj]);
+        trials[jj][jj] = par[jj] + h[jj];
+      }
+
+      if (EXIT_SUCCESS != (*batch)(npar, trials))
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+      for (int jj = 0; jj < npar; ++jj)
+        grad[jj] = (trials[jj][npar] - par[npar]) / h[jj];
+
+    }
+
+    //
+    // Evaluate the gradient components [begin, end), with a copy of
+    // the parameters for each block.
+    //
+    class Columns {
+
+    public:
+      Columns(Func f, Data d, int n, const real *xx, real fv, real ee,
+              const Array1D<real> &hi, Array1D<real> &g)
+        : func(f), data(d), npar(n), x(xx), fval(fv), eps(ee), high(hi),
+          grad(g) {}
+
+      int operator()(int begin, int end) {
+
+        std::vector<real> xx(x, x + npar);
+        for (int jj = begin; jj < end; ++jj) {
+          const real temp = xx[jj];
+          const real h = step(temp, eps, high[jj]);
+          xx[jj] = temp + h;
+          real fh;
+          int ierr = EXIT_SUCCESS;
+          func(npar, &xx[0], fh, ierr, data);
+          if (EXIT_SUCCESS != ierr)
+            return EXIT_FAILURE;
+          xx[jj] = temp;
+          grad[jj] = (fh - fval) / h;
+        }
+        return EXIT_SUCCESS;
+
+      }
+
+    private:
+      Func func;
+      Data data;
+      const int npar;
+      const real *x;
+      const real fval;
+      const real eps;
+      const Array1D<real> &high;
+      Array1D<real> &grad;
+    };
+
+    static real dot(int npar, const Array1D<real> &a, const Array1D<real> &b) {
+      real sum = 0.0;
+      for (int ii = 0; ii < npar; ++ii)
+        sum += a[ii] * b[ii];
+      return sum;
+    }
+
+    //
+    // The largest component of the projected gradient,
+    // P( x - g ) - x, where P projects onto the bounds.
+    //
+    static real projected_gradient(int npar, const ParVal<real> &x,
+                                   const Array1D<real> &g,
+                                   const Array1D<real> &low,
+                                   const Array1D<real> &high) {
+      real pgnorm = 0.0;
+      for (int ii = 0; ii < npar; ++ii) {
+        const real xnew = std::min(std::max(x[ii] - g[ii], low[ii]),
+                                   high[ii]);
+        pgnorm = std::max(pgnorm, std::fabs(xnew - x[ii]));
+      }
+      return pgnorm;
+    }
+
+    //
+    // The typical size of each parameter, used to scale the steepest
+    // descent step when there is no curvature information: the
+    // parameter magnitude, or 1 for a parameter at 0.
+    //
+    static void typical_size(int npar, const ParVal<real> &x,
+                             Array1D<real> &size) {
+      for (int ii = 0; ii < npar; ++ii)
+        size[ii] = 0.0 == x[ii] ? 1.0 : std::fabs(x[ii]);
+    }
+
+    //
+    // The two-loop recursion, restricted to the free variables: those
+    // not held at a bound by the gradient. The fixed components of the
+    // direction are zero. Without any corrections this is steepest
+    // descent in the parameters divided by size.
+    //
+    void direction(int npar, const ParVal<real> &x, const Array1D<real> &g,
+                   const Array1D<real> &low, const Array1D<real> &high,
+                   const Array1D<real> &size,
+                   const std::deque< Array1D<real> > &s,
+                   const std::deque< Array1D<real> > &y,
+                   const std::deque<real> &rho, Array1D<real> &d) const {
+
+      Array1D<real> free(npar);
+      for (int ii = 0; ii < npar; ++ii) {
+        const bool fixed = (x[ii] <= low[ii] && g[ii] > 0.0) ||
+          (x[ii] >= high[ii] && g[ii] < 0.0);
+        free[ii] = fixed ? 0.0 : 1.0;
+        d[ii] = -g[ii] * free[ii];
+      }
+
+      const int num = static_cast<int>(s.size());
+      if (0 == num) {
+        for (int ii = 0; ii < npar; ++ii)
+          d[ii] *= size[ii] * size[ii];
+        return;
+      }
+
+      std::vector<real> alpha(num);
+      for (int kk = num - 1; kk >= 0; --kk) {
+        alpha[kk] = rho[kk] * dot(npar, s[kk], d);
+        for (int ii = 0; ii < npar; ++ii)
+          d[ii] -= alpha[kk] * y[kk][ii] * free[ii];
+      }
+
+      const real gamma = dot(npar, s[num - 1], y[num - 1]) /
+        dot(npar, y[num - 1], y[num - 1]);
+      for (int ii = 0; ii < npar; ++ii)
+        d[ii] *= gamma;
+
+      for (int kk = 0; kk < num; ++kk) {
+        const real beta = rho[kk] * dot(npar, y[kk], d);
+        for (int ii = 0; ii < npar; ++ii)
+          d[ii] += (alpha[kk] - beta) * s[kk][ii] * free[ii];
+      }
+
+    }
+
+    void lbfgsb(int verbose, int maxnfev, real ftol, real gtol, real epsfcn,
+                const sherpa::Bounds<real> &bounds, int npar,
+                ParVal<real> &par, int &nfev) {
+
+      const real c1 = 1.0e-4;
+      const int max_backtrack = 30;
+      const real epsmch = std::numeric_limits<real>::epsilon();
+
+      const Array1D<real> &low = bounds.get_lb();
+      const Array1D<real> &high = bounds.get_ub();
+
+      std::deque< Array1D<real> > s, y;
+      std::deque<real> rho;
+
+      Array1D<real> g(npar), gnew(npar), d(npar), size(npar);
+      ParVal<real> trial(par);
+
+      par[npar] = eval_func(maxnfev, npar, &par[0], nfev);
+      gradient(maxnfev, epsfcn, bounds, npar, par, g, nfev);
+
+      int nsmall = 0;
+      for (int iteration = 0;; ++iteration) {
+
+        if (verbose > 0)
+          std::cout << "@ iter = " << iteration << '\t' << par << '\n';
+
+        if (projected_gradient(npar, par, g, low, high) <= gtol)
+          return;
+
+        typical_size(npar, par, size);
+        direction(npar, par, g, low, high, size, s, y, rho, d);
+        real slope = dot(npar, g, d);
+        if (!(slope < 0.0)) {
+          // not a descent direction, so start again
+          s.clear();
+          y.clear();
+          rho.clear();
+          direction(npar, par, g, low, high, size, s, y, rho, d);
+          slope = dot(npar, g, d);
+          if (!(slope < 0.0))
+            return;
+        }
+
+        // Without curvature information the step is limited so that
+        // no parameter changes by more than its typical size.
+        real step = 1.0;
+        if (s.empty()) {
+          real dmax = 0.0;
+          for (int ii = 0; ii < npar; ++ii)
+            dmax = std::max(dmax, std::fabs(d[ii]) / size[ii]);
+          if (dmax > 1.0)
+            step = 1.0 / dmax;
+        }
+
+        bool accepted = false;
+        for (int nback = 0; nback < max_backtrack; ++nback, step *= 0.5) {
+
+          bool moved = false;
+          real decrease = 0.0;
+          for (int ii = 0; ii < npar; ++ii) {
+            trial[ii] = std::min(std::max(par[ii] + step * d[ii], low[ii]),
+                                 high[ii]);
+            if (trial[ii] != par[ii])
+              moved = true;
+            decrease += g[ii] * (trial[ii] - par[ii]);
+          }
+          if (!moved)
+            break;
+
+          trial[npar] = eval_func(maxnfev, npar, &trial[0], nfev);
+          if (trial[npar] <= par[npar] + c1 * decrease) {
+            accepted = true;
+            break;
+          }
+
+        }
+
+        if (!accepted) {
+          if (s.empty())
+            return;
+          // try again with steepest descent
+          s.clear();
+          y.clear();
+          rho.clear();
+          continue;
+        }
+
+        Array1D<real> snew(npar), ynew(npar);
+        for (int ii = 0; ii < npar; ++ii)
+          snew[ii] = trial[ii] - par[ii];
+
+        const real fold = par[npar];
+        par = trial;
+
+        gradient(maxnfev, epsfcn, bounds, npar, par, gnew, nfev);
+        for (int ii = 0; ii < npar; ++ii)
+          ynew[ii] = gnew[ii] - g[ii];
+        g = gnew;
+
+        const real sy = dot(npar, snew, ynew);
+        if (sy > epsmch * dot(npar, ynew, ynew)) {
+          if (static_cast<int>(s.size()) == mcorr) {
+            s.pop_front();
+            y.pop_front();
+            rho.pop_front();
+          }
+          s.push_back(snew);
+          y.push_back(ynew);
+          rho.push_back(1.0 / sy);
+        }
+
+        if (fold - par[npar] <=
+            ftol * std::max(std::max(std::fabs(fold), std::fabs(par[npar])),
+                            real(1.0))) {
+          if (++nsmall >= 2)
+            return;
+        } else
+          nsmall = 0;
+
+      } // for ( int iteration = 0; ; ++iteration )
+
+    } // lbfgsb
+
+  }; // class LBFGSB
+
+  //
+  // Use the gradient returned by the user function grad, called as
+  // grad( npar, x, gradient, ierr, grad_data ), rather than
+  // finite differences. Each call counts as a function evaluation.
+  //
+  template <typename Func, typename Grad, typename Data, typename real>
+  class LBFGSBGrad : public LBFGSB<Func, Data, real> {
+
+  public:
+    LBFGSBGrad(Func func, Data xdata, Grad grad, Data grad_data, int m)
+      : LBFGSB<Func, Data, real>(func, xdata, m), usr_grad(grad),
+        usr_grad_data(grad_data) {}
+
+  protected:
+    virtual void gradient(int maxnfev, real epsfcn,
+                          const sherpa::Bounds<real> &bounds, int npar,
+                          const ParVal<real> &par, Array1D<real> &grad,
+                          int &nfev) {
+
+      ++nfev;
+      int ierr = EXIT_SUCCESS;
+      usr_grad(npar, const_cast<real *>(&par[0]), &grad[0], ierr,
+               usr_grad_data);
+      if (EXIT_SUCCESS != ierr)
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+      if (nfev >= maxnfev)
+        throw sherpa::OptErr(sherpa::OptErr::MaxFev);
+
+    }
+
+  private:
+    Grad usr_grad;
+    Data usr_grad_data;
+
+  }; // class LBFGSBGrad
+
+} // namespace sherpa
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef MultiStart_hh
+#define MultiStart_hh
+
+//
+//  Copyright (C) 2024  Smithsonian Astrophysical Observatory
+//
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+//
+// Run several independent Nelder-Mead searches, from the user-supplied
+// starting point and from a Latin-hypercube sample of the parameter
+// space, and keep the best. The searches do not depend on each other,
+// so they are run in separate threads.
+//
+// M. D. McKay, R. J. Beckman, W. J. Conover, "A Comparison of Three
+// Methods for Selecting Values of Input Variables in the Analysis of
+// Output from a Computer Code", Technometrics, Vol. 21, No. 2 (1979),
+// pages 239-245.
+//
+
+#include <algorithm>
+#include <vector>
+
+#include "sherpa/MersenneTwister.h"
+#include "sherpa/parallel.hh"
+
+#include "NelderMead.hh"
+
+namespace sherpa {
+
+  //
+  // Runs a batch of searches in a single call: each of starts is
+  // replaced by the location found from it, with the statistic value,
+  // and ierrs and nfevs are set for each search. This is for a user
+  // function which can not be called from several threads but can
+  // spread the searches over several processes itself.
+  //
+  template <typename T> class SearchBatch {
+
+  public:
+    virtual ~SearchBatch() {}
+
+    virtual int operator()(int npar, std::vector< ParVal<T> > &starts,
+                           std::vector<int> &ierrs,
+                           std::vector<int> &nfevs) = 0;
+
+  };
+
+  template <typename Func, typename Data, typename T>
+  class NelderMeadMultiStart {
+
+  public:
+    NelderMeadMultiStart(Func func, Data xdata, int n)
+      : usr_func(func), usr_data(xdata), npar(n), search_batch(0),
+        trial_batch(0) {}
+
+    //
+    // Use batches in place of threads when numcores > 1: when there is
+    // more than one search they are all sent to searches, otherwise
+    // the simplex vertices are sent to trials. Either may be NULL.
+    //
+    void set_batch(SearchBatch<T> *searches, TrialBatch<T> *trials) {
+      search_batch = searches;
+      trial_batch = trials;
+    }
+
+    //
+    // Run nstart searches, each with up to maxnfev function
+    // evaluations, and return the best location in par and the total
+    // number of evaluations in nfev. The first search starts at par and
+    // the others at a Latin-hypercube sample of the bounds drawn from
+    // seed. The searches are run in up to numcores threads, and any
+    // cores left over evaluate the simplex vertices of each search, so
+    // the user function must be thread safe when numcores > 1. The
+    // result does not depend on numcores.
+    //
+    int operator()(int verbose, int maxnfev, T tol, int initsimplex,
+                   const std::vector<int> &finalsimplex,
+                   const Array1D<T> &step, const sherpa::Bounds<T> &bounds,
+                   int nstart, int seed, int numcores, ParVal<T> &par,
+                   int &nfev) {
+
+      if (nstart < 1)
+        throw sherpa::OptErr(sherpa::OptErr::Input);
+
+      std::vector< ParVal<T> > starts(nstart, par);
+      latin_hypercube(seed, bounds, starts);
+
+      std::vector<int> ierrs(nstart, EXIT_SUCCESS), nfevs(nstart, 0);
+      if (search_batch && nstart > 1 && numcores > 1) {
+        if (EXIT_SUCCESS != (*search_batch)(npar, starts, ierrs, nfevs))
+          throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+      } else {
+        // With a trial batch the user function can only be called from
+        // this thread, so the searches are run in turn and each sends
+        // its vertices to the batch.
+        const int nthreads = trial_batch ? 1 : numcores;
+        Searches searches(*this, maxnfev, tol, initsimplex, finalsimplex,
+                          step, bounds,
+                          trial_batch ? numcores
+                                      : std::max(numcores / nstart, 1),
+                          starts, ierrs, nfevs);
+        if (EXIT_SUCCESS !=
+            sherpa::parallel::parallel_for(nstart, nthreads, searches))
+          throw sherpa::OptErr(sherpa::OptErr::Unknown);
+      }
+
+      nfev = 0;
+      int best = 0;
+      for (int ii = 0; ii < nstart; ++ii) {
+        if (verbose > 0)
+          std::cout << "start " << ii << '\t' << starts[ii] << '\n';
+        nfev += nfevs[ii];
+        // an error in the user function stops the fit
+        if (sherpa::OptErr::UsrFunc == ierrs[ii]) {
+          par = starts[ii];
+          return ierrs[ii];
+        }
+        if (starts[ii] < starts[best])
+          best = ii;
+      }
+
+      par = starts[best];
+      return ierrs[best];
+
+    }
+
+  private:
+    Func usr_func;
+    Data usr_data;
+    const int npar;
+    SearchBatch<T> *search_batch;
+    TrialBatch<T> *trial_batch;
+
+    //
+    // Run the searches [begin, end) in turn, stopping at the first one
+    // whose user function fails.
+    //
+    class Searches {
+
+    public:
+      Searches(NelderMeadMultiStart &m, int maxf, T t, int init,
+               const std::vector<int> &fs, const Array1D<T> &st,
+               const sherpa::Bounds<T> &b, int cores,
+               std::vector< ParVal<T> > &s, std::vector<int> &ie,
+               std::vector<int> &nf)
+        : ms(m), maxnfev(maxf), tol(t), initsimplex(init), finalsimplex(fs),
+          step(st), bounds(b), numcores(cores), starts(s), ierrs(ie),
+          nfevs(nf) {}
+
+      int operator()(int begin, int end) {
+        try {
+          for (int ii = begin; ii < end; ++ii) {
+            NelderMead<Func, Data, T> nm(ms.usr_func, ms.usr_data, ms.npar);
+            nm.set_numcores(numcores);
+            nm.set_batch(ms.trial_batch);
+            ierrs[ii] = nm(0, maxnfev, tol, ms.npar, initsimplex,
+                           finalsimplex, step, bounds, starts[ii],
+                           nfevs[ii]);
+            if (sherpa::OptErr::UsrFunc == ierrs[ii])
+              break;
+          }
+        } catch (...) {
+          return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+      }
+
+    private:
+      NelderMeadMultiStart &ms;
+      const int maxnfev;
+      const T tol;
+      const int initsimplex;
+      const std::vector<int> &finalsimplex;
+      const Array1D<T> &step;
+      const sherpa::Bounds<T> &bounds;
+      const int numcores;
+      std::vector< ParVal<T> > &starts;
+      std::vector<int> &ierrs;
+      std::vector<int> &nfevs;
+    };
+
+    //
+    // Replace starts[1], ..., starts[nstart - 1] by a Latin-hypercube
+    // sample: each parameter range is split into nstart - 1 equal
+    // intervals, and each interval is used by exactly one start.
+    //
+    void latin_hypercube(int seed, const sherpa::Bounds<T> &bounds,
+                         std::vector< ParVal<T> > &starts) const {
+
+      const int num = static_cast<int>(starts.size()) - 1;
+      if (num < 1)
+        return;
+
+      MTRand mt_rand(seed);
+      const Array1D<T> &low = bounds.get_lb();
+      const Array1D<T> &high = bounds.get_ub();
+      std::vector<int> cell(num);
+      for (int jj = 0; jj < npar; ++jj) {
+
+        for (int ii = 0; ii < num; ++ii)
+          cell[ii] = ii;
+        for (int ii = num - 1; ii > 0; --ii)
+          std::swap(cell[ii], cell[mt_rand.randInt(ii)]);
+
+        const T width = (high[jj] - low[jj]) / num;
+        for (int ii = 0; ii < num; ++ii)
+          starts[ii + 1][jj] =
+            low[jj] + width * (cell[ii] + mt_rand.randDblExc());
+
+      }
+
+    } // latin_hypercube
+
+  }; // class NelderMeadMultiStart
+
+} // namespace sherpa
+
+#endif
@@ -60,7 +60,11 @@
 //          on a few problems sent in by the users.
 //
 
+#include <climits>
 #include <cmath>
+#include <vector>
+
+#include "sherpa/parallel.hh"
 
 #include "Opt.hh"
 #include "Simplex.hh"
@@ -84,9 +88,24 @@ namespace sherpa {
         centroid(n + 1), contraction(n + 1), expansion(n + 1), reflection(n + 1),
         contraction_coef(contractcoef), expansion_coef(expancoef),
         reflection_coef(refleccoef), shrink_coef(shrinkcoef),
-        rho_gamma(refleccoef * contractcoef), rho_chi(refleccoef * expancoef) {
+        rho_gamma(refleccoef * contractcoef), rho_chi(refleccoef * expancoef),
+        numcores(1), batch(0) {
       check_coefficients();
     }
+
+    //
+    // Evaluate the vertices of the initial simplex, and of each shrink
+    // step, in up to num threads; the user function must then be
+    // thread safe. The search itself does not depend on num.
+    //
+    void set_numcores(int num) { numcores = num; }
+
+    //
+    // Evaluate the vertices with trial_batch, rather than in numcores
+    // threads, when numcores is larger than 1.
+    //
+    void set_batch(TrialBatch<T> *trial_batch) { batch = trial_batch; }
+
     int operator()(int verbose, int maxnfev, T tol, int npar, int initsimplex,
                    const std::vector<int> &finalsimplex, const Array1D<T> &step,
                    const sherpa::Bounds<T> &bounds, ParVal<T> &par, int &nfev) {
@@ -164,7 +183,38 @@ namespace sherpa {
     ParVal<T> centroid, contraction, expansion, reflection;
     const T contraction_coef, expansion_coef, reflection_coef, shrink_coef;
     const T rho_gamma, rho_chi;
-    
+    int numcores;
+    TrialBatch<T> *batch;
+
+    //
+    // Evaluate the vertices [begin, end) of the simplex, counting the
+    // evaluations of each vertex separately.
+    //
+    class EvalVertices {
+
+    public:
+      EvalVertices(NelderMead &n, int f, const Bounds<T> &b,
+                   std::vector<int> &e)
+        : nm(n), first(f), bounds(b), nevals(e) {}
+
+      int operator()(int begin, int end) {
+        try {
+          for (int ii = begin; ii < end; ++ii)
+            nm.eval_func(INT_MAX, bounds, nm.npar, nm.simplex[first + ii],
+                         nevals[ii]);
+        } catch (...) {
+          return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+      }
+
+    private:
+      NelderMead &nm;
+      const int first;
+      const Bounds<T> &bounds;
+      std::vector<int> &nevals;
+    };
+
     void calculate_centroid() {
 
       for (int ii = 0; ii < npar; ++ii) {
@@ -306,11 +356,80 @@ namespace sherpa {
           }
         }
 
-      for (int ii = 0; ii <= npar; ++ii)
-        eval_func(maxnfev, bounds, npar, simplex[ii], nfev);
+      eval_vertices(0, maxnfev, bounds, nfev);
 
     } // eval_init_simplex
 
+    //
+    // Evaluate the vertices [first, npar] of the simplex. When threads
+    // are used each batch is limited to the remaining evaluations, so
+    // that nfev does not go past maxnfev. A vertex outside the limits
+    // is not counted, so more than one batch may be needed.
+    //
+    void eval_vertices(int first, int maxnfev, const Bounds<T> &bounds,
+                       int &nfev) {
+
+      if (numcores < 2) {
+        for (int ii = first; ii <= npar; ++ii)
+          eval_func(maxnfev, bounds, npar, simplex[ii], nfev);
+        return;
+      }
+
+      while (first <= npar) {
+
+        const int num = std::min(npar + 1 - first,
+                                 std::max(maxnfev - nfev, 1));
+        if (batch)
+          eval_batch(first, num, bounds, nfev);
+        else {
+          std::vector<int> nevals(num, 0);
+          EvalVertices eval(*this, first, bounds, nevals);
+          if (EXIT_SUCCESS !=
+              sherpa::parallel::parallel_for(num, numcores, eval))
+            throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+          for (int ii = 0; ii < num; ++ii)
+            nfev += nevals[ii];
+        }
+        if (nfev >= maxnfev)
+          throw sherpa::OptErr(sherpa::OptErr::MaxFev);
+
+        first += num;
+      }
+
+    } // eval_vertices
+
+    //
+    // Evaluate the vertices [first, first + num) of the simplex with
+    // batch. A vertex outside the limits is not sent, as with
+    // eval_func.
+    //
+    void eval_batch(int first, int num, const Bounds<T> &bounds, int &nfev) {
+
+      std::vector<int> index;
+      std::vector< ParVal<T> > inside;
+      for (int ii = first; ii < first + num; ++ii) {
+        if (bounds.are_pars_outside_limits(npar, simplex[ii]))
+          simplex[ii][npar] = std::numeric_limits<T>::max();
+        else {
+          index.push_back(ii);
+          inside.push_back(simplex[ii]);
+        }
+      }
+
+      if (inside.empty())
+        return;
+
+      if (EXIT_SUCCESS != (*batch)(npar, inside))
+        throw sherpa::OptErr(sherpa::OptErr::UsrFunc);
+
+      const int ninside = static_cast<int>(inside.size());
+      for (int ii = 0; ii < ninside; ++ii)
+        simplex[index[ii]][npar] = inside[ii][npar];
+      nfev += ninside;
+
+    } // eval_batch
+
     // 3.
     void expand(int verbose, int maxnfev, const Bounds<T> &bounds, int &nfev) {
 
@@ -553,10 +672,11 @@ namespace sherpa {
         for (int jj = 0; jj < npar; ++jj)
           simplex[ii][jj] = shrink_coef * simplex[ii][jj] +
             (1.0 - shrink_coef) * simplex[0][jj];
-        eval_func(maxnfev, bounds, npar, simplex[ii], nfev);
 
       } // for ( int ii = 0; ii <= npar; ++ii )
 
+      eval_vertices(1, maxnfev, bounds, nfev);
+
     } // void shrink
   }; // class NelderMead
 
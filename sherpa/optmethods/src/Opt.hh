@@ -24,6 +24,7 @@
 #include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <vector>
 
 #include "sherpa/myArray.hh"
 namespace sherpa {
@@ -75,7 +76,22 @@ namespace sherpa {
 
   // forward declaration
   template <typename T> class ParVal;
-  
+
+  //
+  // Evaluates a batch of trial vectors in a single call, setting
+  // trials[ii][npar] for each trial. This is for an objective which
+  // can not be called from several threads but can spread the batch
+  // over several processes itself.
+  //
+  template <typename real> class TrialBatch {
+
+  public:
+    virtual ~TrialBatch() {}
+
+    virtual int operator()(int npar, std::vector< ParVal<real> > &trials) = 0;
+
+  };
+
   template <typename Func, typename Data, typename real> class OptFunc {
 
   public:
@@ -21,13 +21,19 @@
 
 #include <sherpa/extension.hh>
 #include <sherpa/functor.hh>
+#include <sherpa/native_objective.hh>
 
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <memory>
 
 #include "DifEvo.hh"
+#include "LBFGSB.hh"
+#include "CMAES.hh"
 #include "minim.hh"
+#include "MultiStart.hh"
 #include "Opt.hh"
 #include "NelderMead.hh"
 
@@ -75,80 +81,323 @@ static void lmdif_callback_fcn( int mfct, int npar, double* xpars,
 
 }
 
-static void lmdif_callback_fdjac( int mfct, int npar, double* xpars,
-                                  double* fvec, double* fjac, int& ierr, PyObject* py_fcn ) {
+static bool same_size( int size1, int size2, const char* format ) {
 
-  DoubleArray pars_array;
-  npy_intp dims[1];
+  if ( size1 == size2 )
+    return true;
 
-  dims[0] = npar;
-  if ( EXIT_SUCCESS != pars_array.create( 1, dims, xpars ) ) {
-    ierr = EXIT_FAILURE;
-    return;
-  }
+  PyErr_Format( PyExc_ValueError, format, size1, size2 );
+  return false;
 
-  DoubleArray fvec_array;
-  dims[0] = mfct;
-  if ( EXIT_SUCCESS != fvec_array.create( 1, dims, fvec ) ) {
-    ierr = EXIT_FAILURE;
-    return;
-  }
-  
-  PyObject* rv = PyObject_CallFunction( py_fcn, (char*)"NN",
-                                        pars_array.new_ref(), fvec_array.new_ref() );
-  if ( NULL == rv ) {
-    ierr = EXIT_FAILURE;
-    return;
+}
+
+//
+// The callbacks for a native objective (see sherpa/native_objective.hh)
+// in place of a Python function. They are called with the GIL released.
+// LevMar only stops when the flag is negative.
+//
+static void native_lmdif_callback_fcn( int mfct, int npar, double* xpars,
+                                       double* fvec, int& ierr,
+                                       sherpa::NativeObjective* obj ) {
+
+  double fval;
+  if ( EXIT_SUCCESS != obj->fct( obj->ctx, npar, xpars, mfct, fvec, fval ) )
+    ierr = -1;
+
+}
+
+//
+// As with the Python wrapper created by optfcts, a NaN statistic is
+// replaced by the maximum value so the optimizer moves away from it.
+//
+static void native_callback_func( int npar, double* xpars, double& fval,
+                                  int& ierr, sherpa::NativeObjective* obj ) {
+
+  ierr = obj->fct( obj->ctx, npar, xpars, obj->mfct, NULL, fval );
+  if ( std::isnan( fval ) )
+    fval = std::numeric_limits< double >::max();
+
+}
+
+//
+// A native objective has no gradient, so this is never called; it
+// only completes the lbfgsb_fit call.
+//
+static void native_gradient_func( int npar, double* xpars, double* grad,
+                                  int& ierr, sherpa::NativeObjective* obj ) {
+
+  ierr = EXIT_FAILURE;
+
+}
+
+//
+// The native objective held by py_function, or NULL if it is a Python
+// function. When mfct is not negative the objective must return that
+// many values.
+//
+static bool get_native( PyObject* py_function, int mfct,
+                        sherpa::NativeObjective*& native ) {
+
+  native = sherpa::get_native_objective( py_function );
+  if ( NULL == native || mfct < 0 )
+    return true;
+
+  return same_size( native->mfct, mfct,
+                    "native objective size=%d != m=%d" );
+
+}
+
+//
+// The jacobian columns are evaluated in numcores threads when numcores
+// is larger than 1, so func must then be thread safe, or with a single
+// call to batch when it is set.
+//
+template< typename Func, typename Data >
+static int lmdif_fit( Func func, Data data, int numcores, int mfct, int npar,
+                      double ftol, double xtol, double gtol, int maxnfev,
+                      double epsfcn, double factor, int verbose,
+                      sherpa::Array1D<double>& mypar, int& nfev, double& fval,
+                      const sherpa::Bounds<double>& bounds,
+                      sherpa::Array1D<double>& jacobian,
+                      minpack::FunctionBatch<double>* batch = NULL ) {
+
+  if ( numcores > 1 || NULL != batch ) {
+    minpack::LevMarDifPar<Func, Data, double>
+      levmar( func, data, mfct, numcores, batch );
+    return levmar( npar, ftol, xtol, gtol, maxnfev, epsfcn, factor, verbose,
+                   mypar, nfev, fval, bounds, jacobian );
   }
 
-  DoubleArray vals_array;
-  int stat = vals_array.from_obj( rv );
-  Py_DECREF( rv );
-  if ( EXIT_SUCCESS != stat ) {
-    ierr = EXIT_FAILURE;
-    return;
+  minpack::LevMarDif<Func, Data, double> levmar( func, data, mfct );
+  return levmar( npar, ftol, xtol, gtol, maxnfev, epsfcn, factor, verbose,
+                 mypar, nfev, fval, bounds, jacobian );
+
+}
+
+//
+// When numcores is not 0 the generational form of DifEvo is used, and
+// the trial vectors are evaluated in numcores threads, so func must
+// then be thread safe if numcores is larger than 1.
+//
+template< template< typename, typename, typename > class LocalOpt,
+          typename Func, typename Data >
+static int difevo_fit( Func func, Data data, int num, int verbose,
+                       int maxnfev, double tol, int population_size, int seed,
+                       double xprob, double weighting_factor,
+                       const sherpa::Bounds<double>& bounds, int npar,
+                       sherpa::ParVal<double>& mypar, int& nfev,
+                       int numcores,
+                       sherpa::TrialBatch<double>* batch = NULL ) {
+
+  sherpa::DifEvo< Func, Data, LocalOpt< Func, Data, double >, double >
+    difevo( func, data, num );
+  difevo.set_batch( batch );
+  return difevo( verbose, maxnfev, tol, population_size, seed, xprob,
+                 weighting_factor, bounds, npar, mypar, nfev, numcores );
+
+}
+
+//
+// The numcores value to use: a Python function can only be called from
+// one thread, unless it is called with a batch of parameters (when it
+// is up to the batch function to use numcores).
+//
+static int check_numcores( int numcores,
+                                  const sherpa::NativeObjective* native,
+                                  bool batched=false ) {
+
+  if ( numcores < 0 ) {
+    PyErr_SetString( PyExc_ValueError, "numcores must not be negative" );
+    return -1;
   }
 
-  const int num = npar * mfct;
-  if ( vals_array.get_size() != num ) {
-    PyErr_SetString( PyExc_TypeError,
-                     "callback function returned wrong number of values" );
-    ierr = EXIT_FAILURE;
-    return;
+  if ( NULL == native && numcores > 1 && !batched )
+    return 1;
+
+  return numcores;
+
+}
+
+template< typename Func, typename Data >
+static int neldermead_fit( Func func, Data data, int verbose, int maxnfev,
+                           double tol, int npar, int initsimplex,
+                           std::vector<int>& finalsimplex,
+                           sherpa::Array1D<double>& step,
+                           const sherpa::Bounds<double>& bounds,
+                           sherpa::ParVal<double>& mypar, int& nfev,
+                           int numcores ) {
+
+  sherpa::NelderMead< Func, Data, double > nm( func, data, npar );
+  nm.set_numcores( numcores );
+  return nm( verbose, maxnfev, tol, npar, initsimplex, finalsimplex, step,
+             bounds, mypar, nfev );
+
+}
+
+//
+// The searches, and any spare threads the simplex vertices, are run in
+// numcores threads unless the batches are set (see
+// NelderMeadMultiStart::set_batch).
+//
+template< typename Func, typename Data >
+static int nm_multistart_fit( Func func, Data data, int verbose, int maxnfev,
+                              double tol, int npar, int initsimplex,
+                              std::vector<int>& finalsimplex,
+                              sherpa::Array1D<double>& step,
+                              const sherpa::Bounds<double>& bounds,
+                              int nstart, int seed, int numcores,
+                              sherpa::ParVal<double>& mypar, int& nfev,
+                              sherpa::SearchBatch<double>* searches = NULL,
+                              sherpa::TrialBatch<double>* trials = NULL ) {
+
+  sherpa::NelderMeadMultiStart< Func, Data, double > nm( func, data, npar );
+  nm.set_batch( searches, trials );
+  return nm( verbose, maxnfev, tol, initsimplex, finalsimplex, step, bounds,
+             nstart, seed, numcores, mypar, nfev );
+
+}
+
+//
+// The gradient is calculated by forward differences, in numcores
+// threads or with batch when it is set, unless grad_data is set.
+//
+template< typename Func, typename Grad, typename Data >
+static int lbfgsb_fit( Func func, Data data, Grad grad, Data grad_data,
+                       int verbose, int maxnfev, int m, double ftol,
+                       double gtol, double epsfcn, int numcores,
+                       const sherpa::Bounds<double>& bounds, int npar,
+                       sherpa::ParVal<double>& mypar, int& nfev,
+                       sherpa::TrialBatch<double>* batch = NULL ) {
+
+  if ( NULL == grad_data ) {
+    sherpa::LBFGSB< Func, Data, double > opt( func, data, m, numcores );
+    opt.set_batch( batch );
+    return opt( verbose, maxnfev, ftol, gtol, epsfcn, bounds, npar, mypar,
+                nfev );
   }
 
-  std::copy( &vals_array[0], &vals_array[0] + num, fjac );
+  sherpa::LBFGSBGrad< Func, Grad, Data, double >
+    opt( func, data, grad, grad_data, m );
+  return opt( verbose, maxnfev, ftol, gtol, epsfcn, bounds, npar, mypar,
+              nfev );
 
-  return;
+}
+
+//
+// The points of each generation are evaluated in numcores threads, or
+// with batch when it is set, so func must be thread safe when numcores
+// is larger than 1 and there is no batch.
+//
+template< typename Func, typename Data >
+static int cmaes_fit( Func func, Data data, int verbose, int maxnfev,
+                      double tol, sherpa::Array1D<double>& step,
+                      const sherpa::Bounds<double>& bounds, int npar,
+                      int popsize, int nrestart, int seed, int numcores,
+                      sherpa::ParVal<double>& mypar, int& nfev,
+                      sherpa::TrialBatch<double>* batch = NULL ) {
+
+  sherpa::CMAES< Func, Data, double > cmaes( func, data, npar );
+  cmaes.set_batch( batch );
+  return cmaes( verbose, maxnfev, tol, step, bounds, popsize, nrestart, seed,
+                numcores, mypar, nfev );
 
 }
 
-static bool same_size( int size1, int size2, const char* format ) {
+template< typename Func, typename Data >
+static void minim_fit( Func func, Data data, bool reflect,
+                       std::vector<double>& mypar, std::vector<double>& mystep,
+                       int npar, double& fval, int maxnfev, int verbose,
+                       double ftol, int iquad, double simp,
+                       std::vector<double>& vc, int& ierr, int& nfev,
+                       const sherpa::Bounds<double>& bounds ) {
 
-  if ( size1 == size2 )
-    return true;
+  sherpa::Minim<Func, Data, double>* nm = NULL;
+  if (reflect)
+    nm = new sherpa::Minim<Func, Data, double>( func, data );
+  else
+    nm = new sherpa::MinimNoReflect<Func, Data, double>( func, data );
 
-  PyErr_Format( PyExc_ValueError, format, size1, size2 );
-  return false;
+#if (__cplusplus < 201103L)
+  std::auto_ptr< sherpa::Minim<Func, Data, double> > minim(nm);
+#else
+  std::unique_ptr< sherpa::Minim<Func, Data, double> > minim(nm);
+#endif
+
+  minim->minim( mypar, mystep, npar, fval, maxnfev, verbose, ftol, iquad,
+                simp, vc, ierr, nfev, bounds);
 
 }
 
+//
+// Evaluate the lmdif jacobian columns with a single call to a Python
+// function. It is sent a (nvec, npar) array and returns the mfct
+// values for each row, one row after the other, so it can spread the
+// work over several processes (see sherpa.optmethods.optfcts).
+//
+class PyFunctionBatch : public minpack::FunctionBatch< double > {
+
+public:
+
+  explicit PyFunctionBatch( PyObject* py_batch ) : py_batch( py_batch ) { }
+
+  int operator()( int mfct, int npar, int nvec, const double* pars,
+                  double* fvecs ) {
+
+    // DoubleArray only supports one-dimensional arrays
+    npy_intp dims[2];
+    dims[0] = nvec;
+    dims[1] = npar;
+    PyObject* pars_array = PyArray_SimpleNew( 2, dims, NPY_DOUBLE );
+    if ( NULL == pars_array )
+      return EXIT_FAILURE;
+
+    std::copy( pars, pars + nvec * npar, static_cast< double* >
+               ( PyArray_DATA( (PyArrayObject*) pars_array ) ) );
+
+    PyObject* rv = PyObject_CallFunction( py_batch, (char*)"N", pars_array );
+    if ( NULL == rv )
+      return EXIT_FAILURE;
+
+    DoubleArray vals_array;
+    int stat = vals_array.from_obj( rv );
+    Py_DECREF( rv );
+    if ( EXIT_SUCCESS != stat )
+      return EXIT_FAILURE;
+
+    const int num = nvec * mfct;
+    if ( vals_array.get_size() != num ) {
+      PyErr_SetString( PyExc_TypeError,
+                       "batch function returned wrong number of values" );
+      return EXIT_FAILURE;
+    }
+
+    std::copy( &vals_array[0], &vals_array[0] + num, fvecs );
+    return EXIT_SUCCESS;
+
+  }
+
+private:
+
+  PyObject* py_batch;
+
+};
+
 //*****************************************************************************
 //
 // py_cpp_lmdif:  Python wrapper function for C++ function lmdif
 //
 //*****************************************************************************
-template< typename Func, typename Jac >
-static PyObject* py_cpp_lmdif( PyObject* self, PyObject* args, Func func, Jac fdjac ) {
+template< typename Func >
+static PyObject* py_cpp_lmdif( PyObject* self, PyObject* args, Func func ) {
 
   PyObject* py_function=NULL;
-  PyObject* py_jacobian=NULL;
+  PyObject* py_batch=NULL;
   DoubleArray par, lb, ub, fjac;
   int mfct, maxnfev, nfev, info, verbose, numcores;
   double fval, ftol, xtol, gtol, epsfcn, factor;
 
   if ( !PyArg_ParseTuple( args, (char*) "OOiiO&dddiddiO&O&O&",
-			  &py_function, &py_jacobian,
+			  &py_function, &py_batch,
 			  &numcores, &mfct,
 			  CONVERTME(DoubleArray), &par,
 			  &ftol, &xtol, &gtol, &maxnfev,
@@ -172,6 +421,20 @@ static PyObject* py_cpp_lmdif( PyObject* self, PyObject* args, Func func, Jac fd
   if ( !same_size( fjac.get_size( ), mn, "len(fjac)=%d != m * n =%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, mfct, native ) )
+    return NULL;
+
+  // The batch is only used for a Python function.
+  PyFunctionBatch function_batch( py_batch );
+  minpack::FunctionBatch< double >* batch = NULL;
+  if ( NULL == native && NULL != py_batch && Py_None != py_batch )
+    batch = &function_batch;
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
   try {
 
     sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
@@ -179,16 +442,15 @@ static PyObject* py_cpp_lmdif( PyObject* self, PyObject* args, Func func, Jac fd
     sherpa::Bounds<double> bounds( mylb, myub );
     sherpa::Array1D<double> mypar( &par[0], &par[0] + npar );
 
-    if ( 1 == numcores ) {
-      minpack::LevMarDif<Func, PyObject *, double>
-        levmar( func, py_function, mfct );
-      info = levmar( npar, ftol, xtol, gtol, maxnfev, epsfcn, factor, verbose,
-                     mypar, nfev, fval, bounds, jacobian );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      info = lmdif_fit( sherpa::fct_ptr( native_lmdif_callback_fcn ), native,
+                        numcores, mfct, npar, ftol, xtol, gtol, maxnfev, epsfcn, factor,
+                        verbose, mypar, nfev, fval, bounds, jacobian );
     } else {
-      minpack::LevMarDifJac<Func, Jac, PyObject *, double>
-        levmar( func, py_function, mfct, fdjac, py_jacobian );
-      info = levmar( npar, ftol, xtol, gtol, maxnfev, epsfcn, factor, verbose,
-                     mypar, nfev, fval, bounds, jacobian );
+      info = lmdif_fit( func, py_function, 1, mfct, npar, ftol, xtol, gtol,
+                        maxnfev, epsfcn, factor, verbose, mypar, nfev, fval,
+                        bounds, jacobian, batch );
     }
 
     // info > 0 means par needs to be updated
@@ -226,8 +488,7 @@ static PyObject* py_cpp_lmdif( PyObject* self, PyObject* args, Func func, Jac fd
 }
 static PyObject* py_lmdif( PyObject* self, PyObject* args ) {
 
-  return py_cpp_lmdif( self, args, sherpa::fct_ptr( lmdif_callback_fcn ),
-                       sherpa::fct_ptr( lmdif_callback_fdjac ) );
+  return py_cpp_lmdif( self, args, sherpa::fct_ptr( lmdif_callback_fcn ) );
 
 }
 //*****************************************************************************
@@ -376,6 +637,78 @@ static PyObject* py_lmder( PyObject* self, PyObject* args ) {
 //lmder//lmder//lmder//lmder//lmder//lmder//lmder//lmder//lmder//lmder//lmder//
 
 
+//
+// Evaluate a generation of difevo trial vectors with a single call to
+// a Python function. It is sent a (ntrials, npar) array and returns
+// the ntrials statistic values, so it can spread the work over several
+// processes (see sherpa.optmethods.optfcts).
+//
+class PyTrialBatch : public sherpa::TrialBatch< double > {
+
+public:
+
+  explicit PyTrialBatch( PyObject* py_batch ) : py_batch( py_batch ) { }
+
+  int operator()( int npar, std::vector< sherpa::ParVal< double > >& trials ) {
+
+    const int ntrials = static_cast< int >( trials.size() );
+
+    // DoubleArray only supports one-dimensional arrays
+    npy_intp dims[2];
+    dims[0] = ntrials;
+    dims[1] = npar;
+    PyObject* pars_array = PyArray_SimpleNew( 2, dims, NPY_DOUBLE );
+    if ( NULL == pars_array )
+      return EXIT_FAILURE;
+
+    double* pars = static_cast< double* >
+      ( PyArray_DATA( (PyArrayObject*) pars_array ) );
+    for ( int ii = 0; ii < ntrials; ++ii )
+      for ( int jj = 0; jj < npar; ++jj )
+        pars[ ii * npar + jj ] = trials[ ii ][ jj ];
+
+    PyObject* rv = PyObject_CallFunction( py_batch, (char*)"N", pars_array );
+    if ( NULL == rv )
+      return EXIT_FAILURE;
+
+    DoubleArray vals_array;
+    int stat = vals_array.from_obj( rv );
+    Py_DECREF( rv );
+    if ( EXIT_SUCCESS != stat )
+      return EXIT_FAILURE;
+
+    if ( vals_array.get_size() != ntrials ) {
+      PyErr_SetString( PyExc_TypeError,
+                       "batch function returned wrong number of values" );
+      return EXIT_FAILURE;
+    }
+
+    for ( int ii = 0; ii < ntrials; ++ii )
+      trials[ ii ][ npar ] = vals_array[ ii ];
+
+    return EXIT_SUCCESS;
+
+  }
+
+private:
+
+  PyObject* py_batch;
+
+};
+
+//
+// The batch to use for a Python function, if any.
+//
+static sherpa::TrialBatch< double >* get_batch( PyObject* py_batch,
+                                                PyTrialBatch& trial_batch ) {
+
+  if ( NULL == py_batch || Py_None == py_batch )
+    return NULL;
+
+  return &trial_batch;
+
+}
+
 //*****************************************************************************
 //
 // py_difevo_lm:  Python wrapper function for C++ function difevo
@@ -386,11 +719,13 @@ static PyObject* py_difevo_levmar( PyObject* self, PyObject* args,
 				   Func callback_func ) {
 
   PyObject* py_function=NULL;
+  PyObject* py_batch=NULL;
   DoubleArray par, step, lb, ub;
   int verbose, maxnfev, seed, population_size, mfcts, nfev, ierr;
+  int numcores = 0;
   double fval, tol, xprob, weighting_factor;
 
-  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&Oi",
+  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&Oi|iO",
 			  &verbose,
 			  &maxnfev,
 			  &seed,
@@ -401,7 +736,7 @@ static PyObject* py_difevo_levmar( PyObject* self, PyObject* args,
 			  CONVERTME(DoubleArray), &lb,
 			  CONVERTME(DoubleArray), &ub,
 			  CONVERTME(DoubleArray), &par,
-			  &py_function, &mfcts ) ) {
+			  &py_function, &mfcts, &numcores, &py_batch ) ) {
     return NULL;
   }
 
@@ -413,16 +748,34 @@ static PyObject* py_difevo_levmar( PyObject* self, PyObject* args,
   if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, mfcts, native ) )
+    return NULL;
+
+  PyTrialBatch trial_batch( py_batch );
+  sherpa::TrialBatch< double >* batch = get_batch( py_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
   try {
 
-    sherpa::DifEvo< Func, PyObject*, minpack::LevMarDif< Func, PyObject*, double >, double >
-      difevo( callback_func, py_function, mfcts );
     sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
     sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
     sherpa::Bounds<double> bounds( mylb, myub );
     sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
-    ierr = difevo( verbose, maxnfev, tol, population_size, seed, xprob,
-                   weighting_factor, bounds, npar, mypar, nfev );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = difevo_fit< minpack::LevMarDif >
+        ( sherpa::fct_ptr( native_lmdif_callback_fcn ), native, mfcts,
+          verbose, maxnfev, tol, population_size, seed, xprob,
+          weighting_factor, bounds, npar, mypar, nfev, numcores );
+    } else
+      ierr = difevo_fit< minpack::LevMarDif >
+        ( callback_func, py_function, mfcts, verbose, maxnfev, tol,
+          population_size, seed, xprob, weighting_factor, bounds, npar,
+          mypar, nfev, numcores, batch );
     mypar.get_results( &par[ 0 ], fval );
 
   } catch( sherpa::OptErr& oe ) {
@@ -502,6 +855,44 @@ static void sao_callback_func( int npar, double* xpars, double& fval,
 
 }
 
+static void sao_gradient_func( int npar, double* xpars, double* grad,
+                               int& ierr, PyObject* py_grad ) {
+
+  DoubleArray py_xpars;
+  npy_intp dim[1];
+
+  dim[0] = npar;
+  if ( EXIT_SUCCESS != py_xpars.create( 1, dim, xpars ) ) {
+    ierr = EXIT_FAILURE;
+    return;
+  }
+
+  PyObject* rv = PyObject_CallFunction( py_grad, (char*)"O",
+                                        py_xpars.borrowed_ref() );
+  if ( NULL == rv ) {
+    ierr = EXIT_FAILURE;
+    return;
+  }
+
+  DoubleArray vals_array;
+  int stat = vals_array.from_obj( rv );
+  Py_DECREF( rv );
+  if ( EXIT_SUCCESS != stat ) {
+    ierr = EXIT_FAILURE;
+    return;
+  }
+
+  if ( vals_array.get_size() != npar ) {
+    PyErr_SetString( PyExc_TypeError,
+		     "gradient function returned wrong number of values" );
+    ierr = EXIT_FAILURE;
+    return;
+  }
+
+  std::copy( &vals_array[0], &vals_array[0] + npar, grad );
+
+}
+
 //*****************************************************************************
 //
 // py_difevo_nm:  Python wrapper function for C++ function difevo
@@ -512,11 +903,13 @@ static PyObject* py_difevo_neldermead( PyObject* self, PyObject* args,
 				       Func func ) {
 
   PyObject* py_function=NULL;
+  PyObject* py_batch=NULL;
   DoubleArray par, step, lb, ub;
   int verbose, maxnfev, seed, population_size, nfev, ierr;
+  int numcores = 0;
   double fval, tol, xprob, weighting_factor;
 
-  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&O",
+  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&O|iO",
 			  &verbose,
 			  &maxnfev,
 			  &seed,
@@ -527,7 +920,7 @@ static PyObject* py_difevo_neldermead( PyObject* self, PyObject* args,
 			  CONVERTME(DoubleArray), &lb,
 			  CONVERTME(DoubleArray), &ub,
 			  CONVERTME(DoubleArray), &par,
-			  &py_function ) ) {
+			  &py_function, &numcores, &py_batch ) ) {
     return NULL;
   }
 
@@ -539,16 +932,34 @@ static PyObject* py_difevo_neldermead( PyObject* self, PyObject* args,
   if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  PyTrialBatch trial_batch( py_batch );
+  sherpa::TrialBatch< double >* batch = get_batch( py_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
   try {
 
-    sherpa::DifEvo< Func, PyObject*, sherpa::NelderMead< Func, PyObject*, double >,
-                    double > difevo( func, py_function, npar );
     sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
     sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
     sherpa::Bounds<double> bounds( mylb, myub);
     sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
-    ierr = difevo( verbose, maxnfev, tol, population_size, seed, xprob,
-                   weighting_factor, bounds, npar, mypar, nfev );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = difevo_fit< sherpa::NelderMead >
+        ( sherpa::fct_ptr( native_callback_func ), native, npar, verbose,
+          maxnfev, tol, population_size, seed, xprob, weighting_factor,
+          bounds, npar, mypar, nfev, numcores );
+    } else
+      ierr = difevo_fit< sherpa::NelderMead >
+        ( func, py_function, npar, verbose, maxnfev, tol, population_size,
+          seed, xprob, weighting_factor, bounds, npar, mypar, nfev, numcores,
+          batch );
     mypar.get_results( &par[ 0 ], fval );
 
   } catch( sherpa::OptErr& oe ) {
@@ -602,11 +1013,13 @@ template< typename Func >
 static PyObject* py_difevo( PyObject* self, PyObject* args, Func func ) {
 
   PyObject* py_function=NULL;
+  PyObject* py_batch=NULL;
   DoubleArray par, step, lb, ub;
   int verbose, maxnfev, seed, population_size, nfev, ierr;
+  int numcores = 0;
   double fval, tol, xprob, weighting_factor;
 
-  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&O",
+  if ( !PyArg_ParseTuple( args, (char*) "iiiidddO&O&O&O|iO",
 			  &verbose,
 			  &maxnfev,
 			  &seed,
@@ -617,7 +1030,7 @@ static PyObject* py_difevo( PyObject* self, PyObject* args, Func func ) {
 			  CONVERTME(DoubleArray), &lb,
 			  CONVERTME(DoubleArray), &ub,
 			  CONVERTME(DoubleArray), &par,
-			  &py_function ) ) {
+			  &py_function, &numcores, &py_batch ) ) {
     return NULL;
   }
 
@@ -629,16 +1042,34 @@ static PyObject* py_difevo( PyObject* self, PyObject* args, Func func ) {
   if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  PyTrialBatch trial_batch( py_batch );
+  sherpa::TrialBatch< double >* batch = get_batch( py_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
   try {
 
-    sherpa::DifEvo< Func, PyObject*, sherpa::OptFunc< Func, PyObject*, double >, double >
-      difevo( func, py_function );
     sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
     sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
     sherpa::Bounds<double> bounds( mylb, myub );
     sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
-    ierr = difevo( verbose, maxnfev, tol, population_size, seed, xprob,
-                   weighting_factor, bounds, npar, mypar, nfev );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = difevo_fit< sherpa::OptFunc >
+        ( sherpa::fct_ptr( native_callback_func ), native, 0, verbose,
+          maxnfev, tol, population_size, seed, xprob, weighting_factor,
+          bounds, npar, mypar, nfev, numcores );
+    } else
+      ierr = difevo_fit< sherpa::OptFunc >
+        ( func, py_function, 0, verbose, maxnfev, tol, population_size,
+          seed, xprob, weighting_factor, bounds, npar, mypar, nfev, numcores,
+          batch );
     mypar.get_results( &par[ 0 ], fval );
 
   } catch( sherpa::OptErr& oe ) {
@@ -696,9 +1127,10 @@ static PyObject* py_neldermead( PyObject* self, PyObject* args,
   DoubleArray par, step, lb, ub;
   IntArray finalsimplex;
   int verbose, maxnfev, nfev, initsimplex, ierr;
+  int numcores = 1;
   double fval, tol;
 
-  if ( !PyArg_ParseTuple( args, (char*) "iiiO&dO&O&O&O&O",
+  if ( !PyArg_ParseTuple( args, (char*) "iiiO&dO&O&O&O&O|i",
 			  &verbose,
 			  &maxnfev,
 			  &initsimplex,
@@ -708,7 +1140,7 @@ static PyObject* py_neldermead( PyObject* self, PyObject* args,
 			  CONVERTME(DoubleArray), &lb,
 			  CONVERTME(DoubleArray), &ub,
 			  CONVERTME(DoubleArray), &par,
-			  &py_function ) ) {
+			  &py_function, &numcores ) ) {
     return NULL;
   }
 
@@ -723,10 +1155,16 @@ static PyObject* py_neldermead( PyObject* self, PyObject* args,
   if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  numcores = check_numcores( numcores, native );
+  if ( numcores < 0 )
+    return NULL;
+
   try {
 
-    sherpa::NelderMead< Func, PyObject*, double >
-      nm( callback_func, py_function, npar );
     std::vector<int> myfinalsimplex( &finalsimplex[0],
                                      &finalsimplex[0] + finalsimplex.get_size( ) );
     sherpa::Array1D<double> mystep( &step[0], &step[0] + step.get_size() );
@@ -734,8 +1172,16 @@ static PyObject* py_neldermead( PyObject* self, PyObject* args,
     sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
     sherpa::Bounds<double> bounds( mylb, myub );
     sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
-    ierr = nm( verbose, maxnfev, tol, npar, initsimplex, myfinalsimplex, mystep,
-               bounds, mypar, nfev );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = neldermead_fit( sherpa::fct_ptr( native_callback_func ), native,
+                             verbose, maxnfev, tol, npar, initsimplex,
+                             myfinalsimplex, mystep, bounds, mypar, nfev,
+                             numcores );
+    } else
+      ierr = neldermead_fit( callback_func, py_function, verbose, maxnfev,
+                             tol, npar, initsimplex, myfinalsimplex, mystep,
+                             bounds, mypar, nfev, numcores );
     mypar.get_results( &par[ 0 ], fval );
 
   } catch( sherpa::OptErr& oe ) {
@@ -773,6 +1219,409 @@ static PyObject* py_nm( PyObject* self, PyObject* args ) {
   //
   return py_neldermead( self, args, sherpa::fct_ptr( sao_callback_func ) );
 
+}
+
+//
+// Run a batch of neldermead searches with a single call to a Python
+// function. It is sent a (nstart, npar) array of the starting points
+// and returns a tuple of the (nstart, npar + 1) array of the location
+// and statistic value found by each search, followed by the error
+// codes and the number of function evaluations of the searches (see
+// sherpa.optmethods.optfcts).
+//
+class PySearchBatch : public sherpa::SearchBatch< double > {
+
+public:
+
+  explicit PySearchBatch( PyObject* py_batch ) : py_batch( py_batch ) { }
+
+  int operator()( int npar, std::vector< sherpa::ParVal< double > >& starts,
+                  std::vector< int >& ierrs, std::vector< int >& nfevs ) {
+
+    const int nstart = static_cast< int >( starts.size() );
+
+    // DoubleArray only supports one-dimensional arrays
+    npy_intp dims[2];
+    dims[0] = nstart;
+    dims[1] = npar;
+    PyObject* pars_array = PyArray_SimpleNew( 2, dims, NPY_DOUBLE );
+    if ( NULL == pars_array )
+      return EXIT_FAILURE;
+
+    double* pars = static_cast< double* >
+      ( PyArray_DATA( (PyArrayObject*) pars_array ) );
+    for ( int ii = 0; ii < nstart; ++ii )
+      for ( int jj = 0; jj < npar; ++jj )
+        pars[ ii * npar + jj ] = starts[ ii ][ jj ];
+
+    PyObject* rv = PyObject_CallFunction( py_batch, (char*)"N", pars_array );
+    if ( NULL == rv )
+      return EXIT_FAILURE;
+
+    DoubleArray vals_array;
+    IntArray ierrs_array, nfevs_array;
+    int stat = PyArg_ParseTuple( rv, (char*)"O&O&O&",
+                                 CONVERTME(DoubleArray), &vals_array,
+                                 CONVERTME(IntArray), &ierrs_array,
+                                 CONVERTME(IntArray), &nfevs_array );
+    Py_DECREF( rv );
+    if ( !stat )
+      return EXIT_FAILURE;
+
+    if ( vals_array.get_size() != nstart * ( npar + 1 ) ||
+         ierrs_array.get_size() != nstart ||
+         nfevs_array.get_size() != nstart ) {
+      PyErr_SetString( PyExc_TypeError,
+                       "batch function returned wrong number of values" );
+      return EXIT_FAILURE;
+    }
+
+    for ( int ii = 0; ii < nstart; ++ii ) {
+      for ( int jj = 0; jj <= npar; ++jj )
+        starts[ ii ][ jj ] = vals_array[ ii * ( npar + 1 ) + jj ];
+      ierrs[ ii ] = ierrs_array[ ii ];
+      nfevs[ ii ] = nfevs_array[ ii ];
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+private:
+
+  PyObject* py_batch;
+
+};
+
+//*****************************************************************************
+//
+// py_nm_multistart: Python wrapper function for the C++ multi-start
+// neldermead driver
+//
+//*****************************************************************************
+template< typename Func >
+static PyObject* py_nm_multistart( PyObject* self, PyObject* args,
+                                   Func callback_func ) {
+
+  PyObject* py_function=NULL;
+  PyObject* py_search_batch=NULL;
+  PyObject* py_trial_batch=NULL;
+  DoubleArray par, step, lb, ub;
+  IntArray finalsimplex;
+  int verbose, maxnfev, nfev, initsimplex, nstart, seed, numcores, ierr;
+  double fval, tol;
+
+  if ( !PyArg_ParseTuple( args, (char*) "iiiO&dO&O&O&O&Oiii|OO",
+			  &verbose,
+			  &maxnfev,
+			  &initsimplex,
+			  CONVERTME(IntArray), &finalsimplex,
+			  &tol,
+			  CONVERTME(DoubleArray), &step,
+			  CONVERTME(DoubleArray), &lb,
+			  CONVERTME(DoubleArray), &ub,
+			  CONVERTME(DoubleArray), &par,
+			  &py_function, &nstart, &seed, &numcores,
+			  &py_search_batch, &py_trial_batch ) ) {
+    return NULL;
+  }
+
+  const int npar = par.get_size( );
+
+  if ( !same_size( step.get_size( ), npar, "len(step)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( !same_size( lb.get_size( ), npar, "len(lb)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( nstart < 1 ) {
+    PyErr_SetString( PyExc_ValueError, "nstart must be positive" );
+    return NULL;
+  }
+
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  // The batches are only used for a Python function, and the search
+  // batch is only needed when there is more than one search.
+  PySearchBatch search_batch( py_search_batch );
+  sherpa::SearchBatch< double >* searches = NULL;
+  if ( NULL == native && nstart > 1 && NULL != py_search_batch &&
+       Py_None != py_search_batch )
+    searches = &search_batch;
+
+  PyTrialBatch trial_batch( py_trial_batch );
+  sherpa::TrialBatch< double >* trials = NULL;
+  if ( NULL == native )
+    trials = get_batch( py_trial_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native,
+                             NULL != searches || NULL != trials );
+  if ( numcores < 0 )
+    return NULL;
+
+  try {
+
+    std::vector<int> myfinalsimplex( &finalsimplex[0],
+                                     &finalsimplex[0] + finalsimplex.get_size( ) );
+    sherpa::Array1D<double> mystep( &step[0], &step[0] + step.get_size() );
+    sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
+    sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
+    sherpa::Bounds<double> bounds( mylb, myub );
+    sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = nm_multistart_fit( sherpa::fct_ptr( native_callback_func ),
+                                native, verbose, maxnfev, tol, npar,
+                                initsimplex, myfinalsimplex, mystep, bounds,
+                                nstart, seed, numcores, mypar, nfev );
+    } else
+      ierr = nm_multistart_fit( callback_func, py_function, verbose, maxnfev,
+                                tol, npar, initsimplex, myfinalsimplex,
+                                mystep, bounds, nstart, seed, numcores,
+                                mypar, nfev, searches, trials );
+    mypar.get_results( &par[ 0 ], fval );
+
+  } catch( sherpa::OptErr& oe ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError,
+		       (char*) "The parameters are out of bounds\n" );
+    return NULL;
+
+  } catch( std::runtime_error& re ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*) re.what() );
+    return NULL;
+  } catch ( ... ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*)"Unknown exception caught" );
+    return NULL;
+  }
+
+  if ( ierr < 0 ) {
+    // Make sure an exception is set
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*)"function call failed" );
+    return NULL;
+  }
+
+  return Py_BuildValue( (char*)"(Ndii)", par.return_new_ref(), fval, nfev,
+			ierr );
+
+}
+static PyObject* py_nm_ms( PyObject* self, PyObject* args ) {
+
+  return py_nm_multistart( self, args,
+                           sherpa::fct_ptr( sao_callback_func ) );
+
+}
+
+//*****************************************************************************
+//
+// py_lbfgsb: Python wrapper function for C++ function LBFGSB
+//
+//*****************************************************************************
+static PyObject* py_lbfgsb( PyObject* self, PyObject* args ) {
+
+  PyObject* py_function=NULL;
+  PyObject* py_grad=Py_None;
+  PyObject* py_batch=NULL;
+  DoubleArray par, lb, ub;
+  int verbose, maxnfev, m, numcores, nfev, ierr;
+  double fval, ftol, gtol, epsfcn;
+
+  if ( !PyArg_ParseTuple( args, (char*) "iiidddO&O&O&Oi|OO",
+			  &verbose,
+			  &maxnfev,
+			  &m,
+			  &ftol,
+			  &gtol,
+			  &epsfcn,
+			  CONVERTME(DoubleArray), &lb,
+			  CONVERTME(DoubleArray), &ub,
+			  CONVERTME(DoubleArray), &par,
+			  &py_function, &numcores, &py_grad, &py_batch ) ) {
+    return NULL;
+  }
+
+  const int npar = par.get_size( );
+
+  if ( !same_size( lb.get_size( ), npar, "len(lb)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
+    return NULL;
+
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  if ( native && Py_None != py_grad ) {
+    PyErr_SetString( PyExc_ValueError,
+                     "a gradient function can not be used with a native "
+                     "objective" );
+    return NULL;
+  }
+
+  // The batch is only used for the forward differences of a Python
+  // function.
+  PyTrialBatch trial_batch( py_batch );
+  sherpa::TrialBatch< double >* batch = NULL;
+  if ( NULL == native && Py_None == py_grad )
+    batch = get_batch( py_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
+  try {
+
+    sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
+    sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
+    sherpa::Bounds<double> bounds( mylb, myub );
+    sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      sherpa::NativeObjective* nograd = NULL;
+      ierr = lbfgsb_fit( sherpa::fct_ptr( native_callback_func ), native,
+                         sherpa::fct_ptr( native_gradient_func ), nograd,
+                         verbose, maxnfev, m, ftol, gtol, epsfcn, numcores,
+                         bounds, npar, mypar, nfev );
+    } else {
+      PyObject* grad_data = Py_None == py_grad ? NULL : py_grad;
+      ierr = lbfgsb_fit( sherpa::fct_ptr( sao_callback_func ), py_function,
+                         sherpa::fct_ptr( sao_gradient_func ), grad_data,
+                         verbose, maxnfev, m, ftol, gtol, epsfcn, numcores,
+                         bounds, npar, mypar, nfev, batch );
+    }
+    mypar.get_results( &par[ 0 ], fval );
+
+  } catch( sherpa::OptErr& oe ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError,
+		       (char*) "The parameters are out of bounds\n" );
+    return NULL;
+
+  } catch( std::runtime_error& re ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*) re.what() );
+    return NULL;
+  } catch ( ... ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*)"Unknown exception caught" );
+    return NULL;
+  }
+
+  // an error in the user function
+  if ( PyErr_Occurred() )
+    return NULL;
+
+  return Py_BuildValue( (char*)"(Ndii)", par.return_new_ref(), fval, nfev,
+			ierr );
+
+}
+
+//*****************************************************************************
+//
+// py_cmaes: Python wrapper function for C++ function CMAES
+//
+//*****************************************************************************
+static PyObject* py_cmaes( PyObject* self, PyObject* args ) {
+
+  PyObject* py_function=NULL;
+  PyObject* py_batch=NULL;
+  DoubleArray par, step, lb, ub;
+  int verbose, maxnfev, popsize, nrestart, seed, numcores, nfev, ierr;
+  double fval, tol;
+
+  if ( !PyArg_ParseTuple( args, (char*) "iidO&O&O&O&Oiiii|O",
+			  &verbose,
+			  &maxnfev,
+			  &tol,
+			  CONVERTME(DoubleArray), &step,
+			  CONVERTME(DoubleArray), &lb,
+			  CONVERTME(DoubleArray), &ub,
+			  CONVERTME(DoubleArray), &par,
+			  &py_function, &popsize, &nrestart, &seed,
+			  &numcores, &py_batch ) ) {
+    return NULL;
+  }
+
+  const int npar = par.get_size( );
+
+  if ( !same_size( step.get_size( ), npar, "len(step)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( !same_size( lb.get_size( ), npar, "len(lb)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
+    return NULL;
+
+  if ( nrestart < 0 ) {
+    PyErr_SetString( PyExc_ValueError, "nrestart must not be negative" );
+    return NULL;
+  }
+
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
+  // The batch is only used for a Python function.
+  PyTrialBatch trial_batch( py_batch );
+  sherpa::TrialBatch< double >* batch = NULL;
+  if ( NULL == native )
+    batch = get_batch( py_batch, trial_batch );
+
+  numcores = check_numcores( numcores, native, NULL != batch );
+  if ( numcores < 0 )
+    return NULL;
+
+  try {
+
+    sherpa::Array1D<double> mystep( &step[0], &step[0] + npar );
+    sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
+    sherpa::Array1D<double> myub( &ub[0], &ub[0] + npar );
+    sherpa::Bounds<double> bounds( mylb, myub );
+    sherpa::ParVal<double> mypar( npar + 1, npar, &par[0] );
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      ierr = cmaes_fit( sherpa::fct_ptr( native_callback_func ), native,
+                        verbose, maxnfev, tol, mystep, bounds, npar, popsize,
+                        nrestart, seed, numcores, mypar, nfev );
+    } else
+      ierr = cmaes_fit( sherpa::fct_ptr( sao_callback_func ), py_function,
+                        verbose, maxnfev, tol, mystep, bounds, npar, popsize,
+                        nrestart, seed, numcores, mypar, nfev, batch );
+    mypar.get_results( &par[ 0 ], fval );
+
+  } catch( sherpa::OptErr& oe ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError,
+		       (char*) "The parameters are out of bounds\n" );
+    return NULL;
+
+  } catch( std::runtime_error& re ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*) re.what() );
+    return NULL;
+  } catch ( ... ) {
+    if ( NULL == PyErr_Occurred() )
+      PyErr_SetString( PyExc_RuntimeError, (char*)"Unknown exception caught" );
+    return NULL;
+  }
+
+  // an error in the user function
+  if ( PyErr_Occurred() )
+    return NULL;
+
+  return Py_BuildValue( (char*)"(Ndii)", par.return_new_ref(), fval, nfev,
+			ierr );
+
 }
 //*****************************************************************************
 //
@@ -823,6 +1672,10 @@ static PyObject* py_minim( PyObject* self, PyObject* args,
   if ( !same_size( ub.get_size( ), npar, "len(ub)=%d != len(par)=%d" ) )
     return NULL;
 
+  sherpa::NativeObjective* native;
+  if ( !get_native( py_function, -1, native ) )
+    return NULL;
+
   try {
 
     sherpa::Array1D<double> mylb( &lb[0], &lb[0] + npar );
@@ -832,20 +1685,15 @@ static PyObject* py_minim( PyObject* self, PyObject* args,
     std::vector<double> mystep( &step[0], &step[0] + step.get_size( ) );
     std::vector<double> vc( npar * (npar + 1) / 2 );
 
-    sherpa::Minim<Func, PyObject*, double>* nm = NULL;
-    if (reflect)
-      nm = new sherpa::Minim<Func, PyObject*, double>( callback_func, py_function );
-    else
-      nm = new sherpa::MinimNoReflect<Func, PyObject*, double>( callback_func, py_function );
-
-#if (__cplusplus < 201103L)
-    std::auto_ptr< sherpa::Minim<Func, PyObject*, double> > minim(nm);
-#else
-    std::unique_ptr< sherpa::Minim<Func, PyObject*, double> > minim(nm);
-#endif
-
-    minim->minim( mypar, mystep, npar, fval, maxnfev, verbose, ftol, iquad,
-                  simp, vc, ierr, nfev, bounds);
+    if ( native ) {
+      sherpa::NativeThreads threads;
+      minim_fit( sherpa::fct_ptr( native_callback_func ), native, reflect,
+                 mypar, mystep, npar, fval, maxnfev, verbose, ftol, iquad,
+                 simp, vc, ierr, nfev, bounds );
+    } else
+      minim_fit( callback_func, py_function, reflect, mypar, mystep, npar,
+                 fval, maxnfev, verbose, ftol, iquad, simp, vc, ierr, nfev,
+                 bounds );
     std::copy( &mypar[0], &mypar[0] + npar, &par[0] );
 
     // {
@@ -900,6 +1748,27 @@ static PyObject* py_nm_minim( PyObject* self, PyObject* args ) {
 //*****************************************************************************
 //??
 
+//*****************************************************************************
+//
+// py_native_size: the number of values returned by a native objective,
+// or None if the argument is not one.
+//
+//*****************************************************************************
+static PyObject* py_native_size( PyObject* self, PyObject* args ) {
+
+  PyObject* py_function=NULL;
+
+  if ( !PyArg_ParseTuple( args, (char*) "O", &py_function ) )
+    return NULL;
+
+  sherpa::NativeObjective* native = sherpa::get_native_objective( py_function );
+  if ( NULL == native )
+    Py_RETURN_NONE;
+
+  return Py_BuildValue( (char*)"i", native->mfct );
+
+}
+
 //*****************************************************************************
 //
 // Module initialization
@@ -914,7 +1783,11 @@ static PyMethodDef WrapperFcts[] = {
   FCTSPEC(cpp_lmder, py_lmder),
   FCTSPEC(cpp_lmdif, py_lmdif),
   FCTSPEC(neldermead, py_nm),
+  FCTSPEC(nm_multistart, py_nm_ms),
+  FCTSPEC(lbfgsb, py_lbfgsb),
+  FCTSPEC(cmaes, py_cmaes),
   FCTSPEC(minim, py_nm_minim),
+  FCTSPEC(native_size, py_native_size),
   { NULL, NULL, 0, NULL }
 
 };
@@ -835,8 +835,20 @@ namespace sherpa {
       return;
     }
 
+    //
+    // The parameters are not reflected back into the limits, so a
+    // point outside them is given the maximum value rather than being
+    // evaluated.
+    //
     virtual void eval_usr_func( int npar, std::vector<real>& par, real& fval,
                                 const sherpa::Bounds<real>& limits ) {
+      const sherpa::Array1D<real>& lb = limits.get_lb();
+      const sherpa::Array1D<real>& ub = limits.get_ub();
+      for ( int ii = 0; ii < npar; ++ii )
+        if ( par[ ii ] < lb[ ii ] || par[ ii ] > ub[ ii ] ) {
+          fval = std::numeric_limits< real >::max();
+          return;
+        }
       int ierr = EXIT_SUCCESS;
       this->usr_func( npar, &par[0], fval, ierr, Minim<Func, Data, real>::usr_data );
       if ( EXIT_SUCCESS != ierr )
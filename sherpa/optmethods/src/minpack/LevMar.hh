@@ -64,7 +64,12 @@
 // }
 //
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
+
+#include <sherpa/parallel.hh>
+
 #include "../Opt.hh"
 namespace minpack {
 
@@ -79,6 +84,23 @@ namespace minpack {
   */
 
 
+  //
+  // Evaluates the function for nvec parameter vectors in a single call.
+  // The vectors are stored one after the other in pars, and the m
+  // values for each are written, in the same order, to fvecs. This is
+  // for a function which can not be called from several threads but
+  // can spread the batch over several processes itself.
+  //
+  template <typename real> class FunctionBatch {
+
+  public:
+    virtual ~FunctionBatch() {}
+
+    virtual int operator()(int m, int n, int nvec, const real *pars,
+                           real *fvecs) = 0;
+
+  };
+
   template <typename Func, typename Data, typename real >
   class LevMar {
 
@@ -2191,6 +2213,134 @@ namespace minpack {
     }
     
   }; // class LevMarDifJac
+
+  //
+  // LevMarDif with the columns of the forward-difference jacobian
+  // evaluated concurrently, in up to numcores threads. The function
+  // must be safe to call from several threads at once, and must not
+  // need the GIL (e.g. a native objective). When a batch is given the
+  // columns are instead evaluated with a single call to it, which is
+  // how a Python function is used. Each column is calculated exactly
+  // as fdjac2 does, so the results do not depend on numcores.
+  //
+  template < typename Func, typename Data, typename real >
+  class LevMarDifPar : public LevMarDif<Func, Data, real> {
+
+  public:
+
+    LevMarDifPar( Func func, Data xdata, int mfct, int ncores,
+                  FunctionBatch<real>* fbatch=NULL )
+      : LevMarDif<Func, Data, real>( func, xdata, mfct ),
+        numcores( ncores ), batch( fbatch ) { }
+
+  private:
+
+    int numcores;
+    FunctionBatch<real>* batch;
+
+    //
+    // The forward-difference step for a parameter, which is backwards
+    // if the parameter would otherwise go beyond the upper boundary.
+    //
+    static real step( real x, real eps, real high ) {
+      real h = eps * fabs( x );
+      if ( h == 0. )
+        h = eps;
+      if ( x + h > high )
+        h = - h;
+      return h;
+    }
+
+    //
+    // Evaluate the columns [begin, end) of the jacobian, with a copy
+    // of the parameters and a work array for each block.
+    //
+    class Columns {
+
+    public:
+
+      Columns( Func f, int mm, int nn, const real* xx, const real* fv,
+               real* fj, int ld, real ee, Data xp,
+               const sherpa::Array1D<real>& hi )
+        : fcn( f ), m( mm ), n( nn ), x( xx ), fvec( fv ), fjac( fj ),
+          ldfjac( ld ), eps( ee ), xptr( xp ), high( hi ) { }
+
+      int operator()( int begin, int end ) {
+
+        std::vector< real > xx( x, x + n ), wa( m );
+        for ( int j = begin; j < end; ++j ) {
+          real temp = xx[ j ];
+          real h = step( temp, eps, high[ j ] );
+          xx[ j ] = temp + h;
+          int iflag = 0;
+          fcn( m, n, &xx[ 0 ], &wa[ 0 ], iflag, xptr );
+          if ( iflag < 0 )
+            return EXIT_FAILURE;
+          xx[ j ] = temp;
+          for ( int i = 0; i < m; ++i )
+            fjac[ i + j * ldfjac ] = ( wa[ i ] - fvec[ i ] ) / h;
+        }
+        return EXIT_SUCCESS;
+
+      }
+
+    private:
+
+      Func fcn;
+      const int m, n;
+      const real* x;
+      const real* fvec;
+      real* fjac;
+      const int ldfjac;
+      const real eps;
+      Data xptr;
+      const sherpa::Array1D<real>& high;
+
+    };
+
+    //
+    // Evaluate all the columns of the jacobian with one call to batch.
+    //
+    int batch_fdjac2( int m, int n, const real *x, const real *fvec,
+                      real *fjac, int ldfjac, real eps,
+                      const sherpa::Array1D<real>& high ) {
+
+      std::vector< real > h( n ), pars( n * n ), fvecs( n * m );
+      for ( int j = 0; j < n; ++j ) {
+        h[ j ] = step( x[ j ], eps, high[ j ] );
+        std::copy( x, x + n, &pars[ j * n ] );
+        pars[ j * n + j ] = x[ j ] + h[ j ];
+      }
+
+      if ( EXIT_SUCCESS != ( *batch )( m, n, n, &pars[ 0 ], &fvecs[ 0 ] ) )
+        return -1;
+
+      for ( int j = 0; j < n; ++j )
+        for ( int i = 0; i < m; ++i )
+          fjac[ i + j * ldfjac ] = ( fvecs[ j * m + i ] - fvec[ i ] ) / h[ j ];
+      return 0;
+
+    }
+
+    int fdjac2( Func fcn, int m, int n, real *x, real *fvec, real *fjac,
+                int ldfjac, real epsfcn, real *wa, Data xptr,
+                const sherpa::Array1D<real>& high ) {
+
+      real epsmch = std::numeric_limits< real >::epsilon( );
+      real eps = sqrt( ( std::max( epsfcn, epsmch ) ) );
+
+      if ( batch )
+        return batch_fdjac2( m, n, x, fvec, fjac, ldfjac, eps, high );
+
+      Columns columns( fcn, m, n, x, fvec, fjac, ldfjac, eps, xptr, high );
+      if ( EXIT_SUCCESS !=
+           sherpa::parallel::parallel_for( n, numcores, columns ) )
+        return -1;
+      return 0;
+
+    }
+
+  }; // class LevMarDifPar
   
   template < typename Func, typename Data, typename real >
   class LevMarDer : public LevMar<Func, Data, real> {
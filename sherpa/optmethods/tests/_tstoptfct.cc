@@ -24,6 +24,7 @@
 #include <Python.h>
 
 #include <sherpa/extension.hh>
+#include <sherpa/native_objective.hh>
 #include "tstoptfct.hh"
 
 static PyObject *Ackley( PyObject *self, PyObject *args ) {
@@ -2331,11 +2332,86 @@ static PyObject *init_optfcn( PyObject *self, PyObject *args ) {
 
 }
 
+typedef void (*tst_vec_fct)( int, int, double*, double*, int&, void* );
+typedef void (*tst_fct)( int, double*, double&, int&, void* );
+typedef void (*tst_init_fct)( int, int&, double&, double*, double*,
+                              double* );
+
+// The test function as a native objective for the optimizers.
+template< tst_vec_fct VecFct, tst_fct Fct >
+static int native_tst_fct( void* ctx, int npar, const double* pars,
+                           int mfct, double* fvec, double& fval ) {
+
+  int ierr = EXIT_SUCCESS;
+  double* x = const_cast< double* >( pars );
+  if ( fvec ) {
+    VecFct( mfct, npar, x, fvec, ierr, NULL );
+    fval = 0.0;
+    for ( int ii = mfct - 1; ii >= 0; --ii )
+      fval += fvec[ ii ] * fvec[ ii ];
+  } else
+    Fct( npar, x, fval, ierr, NULL );
+  return ierr;
+
+}
+
+template< tst_vec_fct VecFct, tst_fct Fct, tst_init_fct Init >
+static PyObject* native_tst( int npar ) {
+
+  std::vector< double > xpar( npar ), lo( npar ), hi( npar );
+  int mfct;
+  double answer;
+  try {
+    Init( npar, mfct, answer, &xpar[0], &lo[0], &hi[0] );
+  } catch( std::runtime_error& re ) {
+    PyErr_SetString( PyExc_ValueError, re.what() );
+    return NULL;
+  }
+
+  return sherpa::native_objective_capsule( native_tst_fct< VecFct, Fct >,
+                                           NULL, mfct, NULL );
+
+}
+
+#define NATIVETST(name, fct) \
+  if ( 0 == strcmp( name, #fct ) ) \
+    return native_tst< tstoptfct::fct<double,void*>, \
+                       tstoptfct::fct<double,void*>, \
+                       tstoptfct::fct##Init<double> >( npar )
+
+static PyObject *native_objective( PyObject *self, PyObject *args ) {
+
+  int npar;
+  char* name;
+
+  if ( !PyArg_ParseTuple( args, "si", &name, &npar ) )
+    return NULL;
+
+  if ( npar < 1 ) {
+    PyErr_SetString( PyExc_ValueError, "npar must be positive" );
+    return NULL;
+  }
+
+  NATIVETST( name, Beale );
+  NATIVETST( name, FreudensteinRoth );
+  NATIVETST( name, HelicalValley );
+  NATIVETST( name, PowellSingular );
+  NATIVETST( name, Rosenbrock );
+  NATIVETST( name, Wood );
+
+  PyErr_Format( PyExc_ValueError,
+                "no native objective for the test function '%s'", name );
+  return NULL;
+
+}
+
 // A listing of our methods/functions:
 static PyMethodDef _tstoptfct_methods[] = {
   // name, function, argument type, docstring
 
   { "init", init_optfcn, METH_VARARGS, "init starting params and bounds" },
+  { "native_objective", native_objective, METH_VARARGS,
+    "test function as a native objective for the optimizers" },
   { "Ackley", Ackley, METH_VARARGS, "ackley function vector" },
   { "Booth", Booth, METH_VARARGS, "booth function vector" },
   { "Bohachevsky1", Bohachevsky1, METH_VARARGS, "bohachevsky1 function vector" },
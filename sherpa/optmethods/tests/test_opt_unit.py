@@ -23,7 +23,8 @@ import numpy as np
 
 import pytest
 
-from sherpa.optmethods import GridSearch, LevMar, MonCar, NelderMead
+from sherpa.optmethods import CMAES, GridSearch, LBFGSB, LevMar, MonCar, \
+    NelderMead, NelderMeadMultiStart, _saoopt, _tstoptfct, optfcts
 from sherpa.optmethods.opt import SimplexRandom
 
 
@@ -100,7 +101,9 @@ def test_is_simplexbase_repeatable_post_117():
 
 
 @pytest.mark.parametrize("cls,name,altname",
-                         [(GridSearch, "GridSearch", None),
+                         [(CMAES, "CMAES", None),
+                          (GridSearch, "GridSearch", None),
+                          (LBFGSB, "LBFGSB", None),
                           (LevMar, "LevMar", None),
                           (MonCar, "MonCar", None),
                           (NelderMead, "NelderMead", "simplex")])
@@ -114,7 +117,8 @@ def test_optmethod_repr(cls, name, altname):
     assert repr(m) == f"<{name} optimization method instance '{altname}'>"
 
 
-@pytest.mark.parametrize("cls", [GridSearch, LevMar, MonCar, NelderMead])
+@pytest.mark.parametrize("cls", [CMAES, GridSearch, LBFGSB, LevMar,
+                                 MonCar, NelderMead])
 def test_optmethod_getattr(cls):
     """Check the call-through-to-config option works"""
 
@@ -123,7 +127,8 @@ def test_optmethod_getattr(cls):
         assert getattr(opt, key) == pytest.approx(value)
 
 
-@pytest.mark.parametrize("cls", [GridSearch, LevMar, MonCar, NelderMead])
+@pytest.mark.parametrize("cls", [CMAES, GridSearch, LBFGSB, LevMar,
+                                 MonCar, NelderMead])
 def test_optmethod_setattr(cls):
     """Check the call-through-to-config option works"""
 
@@ -141,3 +146,659 @@ def test_optmethod_setattr(cls):
     # which would mean changing newval
     #
     assert oldval != pytest.approx(newval)
+
+
+@pytest.mark.parametrize("name,npar", [("Rosenbrock", 2),
+                                       ("PowellSingular", 4),
+                                       ("Wood", 4)])
+@pytest.mark.parametrize("optname", ["lmdif", "neldermead", "minim",
+                                     "difevo", "difevo_lm"])
+def test_native_objective_matches_callback(optname, name, npar):
+    """The optimizers give the same answer with a native objective"""
+
+    pyname = {"Rosenbrock": "rosenbrock",
+              "PowellSingular": "powell_singular",
+              "Wood": "wood"}[name]
+    pyfunc = getattr(_tstoptfct, pyname)
+    x0, xmin, xmax, _ = _tstoptfct.init(pyname, npar)
+
+    # difevo wants the statistic and difevo_lm the residuals
+    if optname == "difevo":
+        def callback(x):
+            return pyfunc(x)[0]
+    elif optname == "difevo_lm":
+        def callback(x):
+            return pyfunc(x)[1]
+    else:
+        callback = pyfunc
+
+    native = _tstoptfct.native_objective(name, npar)
+    assert _saoopt.native_size(native) == len(pyfunc(x0)[1])
+    assert _saoopt.native_size(callback) is None
+
+    opt = getattr(optfcts, optname)
+    expected = opt(callback, x0, xmin, xmax)
+    got = opt(native, x0, xmin, xmax)
+
+    assert got[0] == expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+
+
+@pytest.mark.parametrize("optname,kwargs",
+                         [("minim", {"reflect": False}),
+                          ("minim", {"reflect": True}),
+                          ("neldermead", {})])
+def test_native_objective_matches_callback_limits(optname, kwargs):
+    """The limits are applied to a native objective.
+
+    The Rosenbrock minimum, at (1, 1), is excluded by the limits.
+    """
+
+    native = _tstoptfct.native_objective("Rosenbrock", 2)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    xmax = np.asarray([0.9, 0.9])
+
+    opt = getattr(optfcts, optname)
+    expected = opt(_tstoptfct.rosenbrock, x0.copy(), xmin, xmax, **kwargs)
+    got = opt(native, x0.copy(), xmin, xmax, **kwargs)
+
+    assert got[0] == expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+    assert np.all(got[1] <= xmax)
+
+
+def test_native_objective_wrong_size():
+    """A native objective must return as many values as requested"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 2)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    fjac = np.empty(6)
+    with pytest.raises(ValueError,
+                       match="^native objective size=2 != m=3$"):
+        _saoopt.cpp_lmdif(native, None, 1, 3, x0, 1e-7, 1e-7, 1e-7, 100,
+                          1e-7, 100.0, 0, xmin, xmax, fjac)
+
+
+@pytest.mark.parametrize("numcores", [2, 3, 8])
+def test_native_objective_lmdif_numcores(numcores):
+    """The threaded jacobian does not change the lmdif results"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 10)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 10)
+
+    expected = optfcts.lmdif(native, x0, xmin, xmax)
+    got = optfcts.lmdif(native, x0, xmin, xmax, numcores=numcores)
+
+    assert got[0] == expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+    assert got[4]["covar"] == pytest.approx(expected[4]["covar"],
+                                            rel=0, abs=0)
+
+
+def test_lmdif_batch():
+    """Each jacobian of a Python function is sent to the batch function"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[1]
+
+    sizes = []
+
+    def batch(pars):
+        assert pars.ndim == 2
+        sizes.append(pars.shape)
+        return np.concatenate([callback(p) for p in pars])
+
+    fjac = np.empty(16)
+    expected = _saoopt.cpp_lmdif(callback, None, 1, 4, x0.copy(), 1e-7,
+                                 1e-7, 1e-7, 1000, 1e-7, 100.0, 0, xmin,
+                                 xmax, fjac.copy())
+    got = _saoopt.cpp_lmdif(callback, batch, 2, 4, x0.copy(), 1e-7, 1e-7,
+                            1e-7, 1000, 1e-7, 100.0, 0, xmin, xmax,
+                            fjac.copy())
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1] == expected[1]
+    assert got[2] == expected[2]
+    assert got[4] == pytest.approx(expected[4], rel=0, abs=0)
+
+    # There is one call per jacobian, with a row per parameter, and
+    # these evaluations are included in nfev.
+    assert len(sizes) > 1
+    assert set(sizes) == {(4, 4)}
+    assert got[2] > 4 * len(sizes)
+
+
+@pytest.mark.parametrize("numcores", [1, 2])
+def test_lmdif_python_numcores(numcores):
+    """The jacobian of a Python function uses one parallel_map call"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    expected = optfcts.lmdif(_tstoptfct.rosenbrock, x0, xmin, xmax)
+    got = optfcts.lmdif(_tstoptfct.rosenbrock, x0, xmin, xmax,
+                        numcores=numcores)
+
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+    if numcores == 1:
+        assert got[4]["num_parallel_map"] == 0
+    else:
+        assert got[4]["num_parallel_map"] > 0
+
+
+@pytest.mark.parametrize("numcores", [1, 2, 5])
+def test_difevo_generational_numcores(numcores):
+    """The generational difevo does not depend on the number of threads"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 4)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[0]
+
+    expected = optfcts.difevo(callback, x0, xmin, xmax, maxfev=40000,
+                              generational=True)
+    got = optfcts.difevo(native, x0, xmin, xmax, maxfev=40000,
+                         generational=True, numcores=numcores)
+
+    assert expected[0]
+    assert expected[2] == pytest.approx(0, abs=1e-6)
+    assert got[0] == expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+
+
+@pytest.mark.parametrize("optname", ["difevo", "difevo_lm", "difevo_nm"])
+def test_difevo_generational_python_numcores(optname):
+    """The generational difevo can use several processes for a Python function"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+    if optname == "difevo":
+        def callback(x):
+            return _tstoptfct.rosenbrock(x)[0]
+    elif optname == "difevo_lm":
+        def callback(x):
+            return _tstoptfct.rosenbrock(x)[1]
+    else:
+        callback = _tstoptfct.rosenbrock
+
+    opt = getattr(optfcts, optname)
+    if optname == "difevo_nm":
+        args = (1e-7, 4000, 0, 23, None, 0.9, 0.8)
+    else:
+        args = ()
+
+    expected = opt(callback, x0, xmin, xmax, *args, generational=True)
+    got = opt(callback, x0, xmin, xmax, *args, generational=True,
+              numcores=2)
+
+    assert got[0] == expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4]["nfev"] == expected[4]["nfev"]
+
+
+def test_difevo_batch():
+    """Each generation is sent to the batch function"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[0]
+
+    sizes = []
+
+    def batch(pars):
+        assert pars.ndim == 2
+        assert pars.shape[1] == 2
+        sizes.append(pars.shape[0])
+        return [callback(p) for p in pars]
+
+    expected = _saoopt.difevo(0, 1000, 1, 16, 1e-7, 0.9, 0.8, xmin, xmax,
+                              x0.copy(), callback, 1)
+    got = _saoopt.difevo(0, 1000, 1, 16, 1e-7, 0.9, 0.8, xmin, xmax,
+                         x0.copy(), callback, 2, batch)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1] == expected[1]
+    assert got[2] == expected[2]
+
+    # The trials are evaluated in batches of up to 16 (those outside
+    # the limits are not sent), and the remaining evaluations are made
+    # by the local optimizer.
+    assert sum(sizes) < got[2]
+    assert max(sizes) <= 16
+    assert len(sizes) > 1
+
+
+def test_difevo_negative_numcores():
+    """numcores can not be negative"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    native = _tstoptfct.native_objective("Rosenbrock", 2)
+    with pytest.raises(ValueError,
+                       match="^numcores must not be negative$"):
+        _saoopt.difevo(0, 100, 1, 16, 1e-7, 0.9, 0.8, xmin, xmax, x0,
+                       native, -1)
+
+
+@pytest.mark.parametrize("numcores", [2, 3, 8])
+def test_neldermead_numcores(numcores):
+    """Evaluating the simplex vertices in threads does not change the fit"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 6)
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 6)
+    xmin = np.full(6, -5.0)
+    xmax = np.full(6, 5.0)
+    step = np.full(6, 1.2)
+    final = np.asarray([0, 1, 1])
+
+    # the parameter array is changed in place
+    expected = _saoopt.neldermead(0, 6000, 0, final, 1e-7, step, xmin,
+                                  xmax, x0.copy(), native)
+    got = _saoopt.neldermead(0, 6000, 0, final, 1e-7, step, xmin, xmax,
+                             x0.copy(), native, numcores)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1:] == expected[1:]
+
+
+@pytest.mark.parametrize("numcores", [1, 2, 3, 8])
+@pytest.mark.parametrize("maxnfev", [3, 7, 1183, 1584])
+def test_neldermead_numcores_maxnfev(numcores, maxnfev):
+    """The threaded evaluation does not go past maxnfev"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 6)
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 6)
+    xmin = np.full(6, -5.0)
+    xmax = np.full(6, 5.0)
+    step = np.full(6, 1.2)
+    final = np.asarray([0, 1, 1])
+
+    expected = _saoopt.neldermead(0, maxnfev, 0, final, 1e-7, step, xmin,
+                                  xmax, x0.copy(), native)
+    got = _saoopt.neldermead(0, maxnfev, 0, final, 1e-7, step, xmin, xmax,
+                             x0.copy(), native, numcores)
+
+    assert got[2] == maxnfev
+    assert got[1:] == expected[1:]
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+
+
+@pytest.mark.parametrize("optname", ["neldermead_multistart", "lbfgsb",
+                                     "cmaes"])
+def test_info_is_status(optname):
+    """The info field matches the status, as with neldermead"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    opt = getattr(optfcts, optname)
+
+    res = opt(_tstoptfct.rosenbrock, x0, xmin, xmax)
+    assert res[0]
+    assert res[4]["info"] is True
+
+    res = opt(_tstoptfct.rosenbrock, x0, xmin, xmax, maxfev=5)
+    assert not res[0]
+    assert res[4]["info"] is False
+
+
+@pytest.mark.parametrize("numcores", [1, 3, 16])
+def test_neldermead_multistart(numcores):
+    """The multi-start search does not depend on the number of threads"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 6)
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 6)
+    xmin = np.full(6, -5.0)
+    xmax = np.full(6, 5.0)
+
+    expected = optfcts.neldermead_multistart(_tstoptfct.rosenbrock, x0,
+                                             xmin, xmax)
+    got = optfcts.neldermead_multistart(native, x0, xmin, xmax,
+                                        numcores=numcores)
+
+    assert expected[0]
+    assert expected[1] == pytest.approx(np.ones(6), abs=1e-3)
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+@pytest.mark.parametrize("nstart", [1, 4])
+def test_neldermead_multistart_python_numcores(nstart):
+    """The processes used for a Python function do not change the result"""
+
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 4)
+    xmin = np.full(4, -5.0)
+    xmax = np.full(4, 5.0)
+
+    expected = optfcts.neldermead_multistart(_tstoptfct.rosenbrock, x0,
+                                             xmin, xmax, nstart=nstart)
+    got = optfcts.neldermead_multistart(_tstoptfct.rosenbrock, x0,
+                                        xmin, xmax, nstart=nstart,
+                                        numcores=2)
+
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+def test_neldermead_multistart_batch():
+    """The searches, or the vertices of one search, are sent as batches"""
+
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 4)
+    xmin = np.full(4, -5.0)
+    xmax = np.full(4, 5.0)
+    step = np.full(4, 1.2)
+    fsimplex = np.asarray([0, 1, 1], np.int_)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[0]
+
+    nvertices = []
+
+    def trial_batch(pars):
+        nvertices.append(len(pars))
+        return [callback(p) for p in pars]
+
+    def args(nstart):
+        return (0, 3000, 0, fsimplex, 1e-7, step, xmin, xmax, x0.copy(),
+                callback, nstart, 2, 2)
+
+    expected = _saoopt.nm_multistart(*args(1)[:-1], 1)
+    got = _saoopt.nm_multistart(*args(1), None, trial_batch)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1:] == expected[1:]
+    assert len(nvertices) > 0
+    assert max(nvertices) <= 5
+
+    nstarts = []
+
+    def search_batch(starts):
+        nstarts.append(len(starts))
+        found, ierrs, nfevs = [], [], []
+        for start in starts:
+            x, fval, nfev, ierr = _saoopt.neldermead(0, 3000, 0, fsimplex,
+                                                     1e-7, step, xmin, xmax,
+                                                     start.copy(), callback)
+            found.append(np.append(x, fval))
+            ierrs.append(ierr)
+            nfevs.append(nfev)
+
+        return np.concatenate(found), ierrs, nfevs
+
+    expected = _saoopt.nm_multistart(*args(5)[:-1], 1)
+    got = _saoopt.nm_multistart(*args(5), search_batch, trial_batch)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1:] == expected[1:]
+    assert nstarts == [5]
+
+
+def test_neldermead_multistart_optmethod():
+    """The multi-start search is available as an OptMethod"""
+
+    opt = NelderMeadMultiStart()
+    assert opt.name == "neldermeadmultistart"
+    assert opt.nstart == 8
+    assert opt.numcores == 1
+
+    x0, _, _, _ = _tstoptfct.init("rosenbrock", 2)
+    xmin = np.full(2, -5.0)
+    xmax = np.full(2, 5.0)
+
+    opt.nstart = 3
+    expected = optfcts.neldermead_multistart(_tstoptfct.rosenbrock, x0,
+                                             xmin, xmax, nstart=3)
+    got = opt.fit(_tstoptfct.rosenbrock, x0, xmin, xmax)
+
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+
+
+def test_neldermead_multistart_nstart():
+    """There must be at least one search"""
+
+    with pytest.raises(ValueError, match="^nstart must be positive$"):
+        optfcts.neldermead_multistart(_tstoptfct.rosenbrock, [1, 1],
+                                      [-2, -2], [2, 2], nstart=0)
+
+
+@pytest.mark.parametrize("name,npar", [("Rosenbrock", 4), ("Wood", 4),
+                                       ("HelicalValley", 3)])
+def test_lbfgsb(name, npar):
+    """The native objective and the Python callback give the same fit"""
+
+    fname = {"HelicalValley": "helical_valley"}.get(name, name.lower())
+    x0, xmin, xmax, _ = _tstoptfct.init(fname, npar)
+    native = _tstoptfct.native_objective(name, npar)
+
+    expected = optfcts.lbfgsb(getattr(_tstoptfct, fname), x0, xmin, xmax)
+    got = optfcts.lbfgsb(native, x0, xmin, xmax)
+
+    assert expected[0]
+    assert expected[2] == pytest.approx(0, abs=1e-6)
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+@pytest.mark.parametrize("numcores", [2, 3, 8])
+def test_lbfgsb_numcores(numcores):
+    """Evaluating the gradient in threads does not change the fit"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 20)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 20)
+
+    expected = optfcts.lbfgsb(native, x0, xmin, xmax)
+    got = optfcts.lbfgsb(native, x0, xmin, xmax, numcores=numcores)
+
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+def test_lbfgsb_python_numcores():
+    """The processes used for a Python function do not change the fit"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    expected = optfcts.lbfgsb(_tstoptfct.rosenbrock, x0, xmin, xmax)
+    got = optfcts.lbfgsb(_tstoptfct.rosenbrock, x0, xmin, xmax,
+                         numcores=2)
+
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+def test_lbfgsb_batch():
+    """Each forward-difference gradient is sent to the batch function"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[0]
+
+    sizes = []
+
+    def batch(pars):
+        assert pars.shape == (4, 4)
+        sizes.append(len(pars))
+        return [callback(p) for p in pars]
+
+    expected = _saoopt.lbfgsb(0, 1000, 10, 1e-9, 1e-7, 1e-7, xmin, xmax,
+                              x0.copy(), callback, 1)
+    got = _saoopt.lbfgsb(0, 1000, 10, 1e-9, 1e-7, 1e-7, xmin, xmax,
+                         x0.copy(), callback, 2, None, batch)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1:] == expected[1:]
+    assert len(sizes) > 1
+    assert got[2] > 4 * len(sizes)
+
+
+def test_lbfgsb_gradient_nfev():
+    """Every call to the statistic, or its gradient, is counted"""
+
+    class Stat:
+
+        def __init__(self):
+            self.ncalls = 0
+
+        def __call__(self, x):
+            self.ncalls += 1
+            return _tstoptfct.rosenbrock(x)
+
+        def gradient(self, x):
+            self.ncalls += 1
+            x0, x1 = x
+            grad = [-400 * x0 * (x1 - x0 * x0) - 2 * (1 - x0),
+                    200 * (x1 - x0 * x0)]
+            return _tstoptfct.rosenbrock(x)[0], np.asarray(grad)
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    stat = Stat()
+    got = optfcts.lbfgsb(stat, x0, xmin, xmax)
+
+    assert got[0]
+    assert got[1] == pytest.approx([1, 1], abs=1e-4)
+    assert got[4]["nfev"] == stat.ncalls
+
+
+def test_lbfgsb_bounds():
+    """The solution is kept within the bounds"""
+
+    x0 = np.asarray([0.5, 2.0])
+    xmin = np.asarray([-2.0, 1.5])
+    xmax = np.asarray([2.0, 3.0])
+    got = optfcts.lbfgsb(_tstoptfct.rosenbrock, x0, xmin, xmax)
+
+    # On x[1] = 1.5 the gradient with respect to x[0] is zero at
+    # a root of 400 x^3 - 598 x - 2.
+    #
+    assert got[0]
+    assert got[1] == pytest.approx([1.22437075, 1.5], abs=1e-6)
+
+
+def test_lbfgsb_native_gradient():
+    """A gradient can not be combined with a native objective"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 2)
+    native = _tstoptfct.native_objective("Rosenbrock", 2)
+    with pytest.raises(ValueError,
+                       match="^a gradient function can not be used with "
+                       "a native objective$"):
+        _saoopt.lbfgsb(0, 100, 10, 1e-9, 1e-7, 1e-7, xmin, xmax, x0,
+                       native, 1, lambda x: np.zeros(2))
+
+
+@pytest.mark.parametrize("name,npar", [("Ackley", 4), ("Hansen", 2),
+                                       ("Shekel10", 4), ("wood", 4)])
+def test_cmaes(name, npar):
+    """The global minimum is found"""
+
+    x0, xmin, xmax, fmin = _tstoptfct.init(name, npar)
+    got = optfcts.cmaes(getattr(_tstoptfct, name), x0, xmin, xmax)
+
+    assert got[0]
+    assert got[2] == pytest.approx(fmin, rel=1e-3, abs=1e-3)
+    assert got[4]["nfev"] <= 8192 * npar
+
+
+@pytest.mark.parametrize("numcores", [1, 3, 8])
+def test_cmaes_numcores(numcores):
+    """Evaluating each generation in threads does not change the fit"""
+
+    native = _tstoptfct.native_objective("Rosenbrock", 6)
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 6)
+
+    expected = optfcts.cmaes(_tstoptfct.rosenbrock, x0, xmin, xmax)
+    got = optfcts.cmaes(native, x0, xmin, xmax, numcores=numcores)
+
+    assert expected[0]
+    assert expected[1] == pytest.approx(np.ones(6), abs=1e-3)
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+def test_cmaes_python_numcores():
+    """The processes used for a Python function do not change the fit"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+
+    expected = optfcts.cmaes(_tstoptfct.rosenbrock, x0, xmin, xmax)
+    got = optfcts.cmaes(_tstoptfct.rosenbrock, x0, xmin, xmax, numcores=2)
+
+    assert expected[0]
+    assert got[1] == pytest.approx(expected[1], rel=0, abs=0)
+    assert got[2] == expected[2]
+    assert got[4] == expected[4]
+
+
+def test_cmaes_batch():
+    """Each generation is sent to the batch function"""
+
+    x0, xmin, xmax, _ = _tstoptfct.init("rosenbrock", 4)
+    step = np.ones(4)
+
+    def callback(x):
+        return _tstoptfct.rosenbrock(x)[0]
+
+    sizes = []
+
+    def batch(pars):
+        assert pars.shape[1] == 4
+        sizes.append(len(pars))
+        return [callback(p) for p in pars]
+
+    expected = _saoopt.cmaes(0, 4000, 1e-7, step, xmin, xmax, x0.copy(),
+                             callback, 0, 1, 1234, 1)
+    got = _saoopt.cmaes(0, 4000, 1e-7, step, xmin, xmax, x0.copy(),
+                        callback, 0, 1, 1234, 2, batch)
+
+    assert got[0] == pytest.approx(expected[0], rel=0, abs=0)
+    assert got[1:] == expected[1:]
+
+    # the starting point, then one call per generation
+    assert sizes[0] == 1
+    assert sizes[1] == 8
+    assert sum(sizes) == got[2]
+
+
+def test_cmaes_bounds():
+    """The sampled points are kept within the bounds"""
+
+    xmin = np.asarray([-2.0, 1.5])
+    xmax = np.asarray([2.0, 3.0])
+
+    def func(x):
+        assert np.all(x >= xmin)
+        assert np.all(x <= xmax)
+        return _tstoptfct.rosenbrock(x)
+
+    got = optfcts.cmaes(func, [0.5, 2.0], xmin, xmax)
+
+    # see test_lbfgsb_bounds
+    assert got[0]
+    assert got[1] == pytest.approx([1.22437075, 1.5], abs=1e-5)
+
+
+def test_cmaes_nrestart():
+    """The number of restarts can not be negative"""
+
+    with pytest.raises(ValueError,
+                       match="^nrestart must not be negative$"):
+        optfcts.cmaes(_tstoptfct.rosenbrock, [1, 1], [-2, -2], [2, 2],
+                      nrestart=-1)
@@ -270,17 +270,17 @@ def test_splitcontour(setup_contour):
 
 def test_interval_projection(setup_confidence):
     _ipx = numpy.array(
-        [15.60720526,  15.92784424,  16.24848322,  16.56912221,
-         16.88976119,  17.21040017,  17.53103916,  17.85167814,
-         18.17231712,  18.49295611,  18.81359509,  19.13423407,
-         19.45487306,  19.77551204,  20.09615102,  20.41679001,
-         20.73742899,  21.05806798,  21.37870696,  21.69934594])
+        [15.60664760,  15.92727500,  16.24790240,  16.56852980,
+         16.88915719,  17.20978459,  17.53041199,  17.85103939,
+         18.17166678,  18.49229418,  18.81292158,  19.13354898,
+         19.45417638,  19.77480377,  20.09543117,  20.41605857,
+         20.73668597,  21.05731336,  21.37794076,  21.69856816])
     _ipy = numpy.array(
-        [40.09661435,  39.18194614,  38.37963283,  37.68723716,
-         37.10218543,  36.62179549,  36.2432939,  35.96383078,
-         35.78049297,  35.69031588,  35.69029438,  35.77739294,
-         35.94855493,  36.20071145,  36.53078937,  36.9357187,
-         37.41243938,  37.95790737,  38.56910025,  39.24302218])
+        [40.09830316,  39.18346290,  38.38098108,  37.68841314,
+         37.10318594,  36.62261778,  36.24393580,  35.96429058,
+         35.78076940,  35.69040812,  35.69020204,  35.77711605,
+         35.94809398,  36.20006730,  36.52996321,  36.93471204,
+         37.41125400,  37.95654533,  38.56756385,  39.24131387])
 
     setup_confidence.ip.fac = 2
     setup_confidence.ip.calc(setup_confidence.f,
@@ -293,18 +293,18 @@ def test_interval_projection(setup_confidence):
 
 def test_interval_uncertainty(setup_confidence):
     _iux = numpy.array(
-        [15.60720526,  15.92784424,  16.24848322,  16.56912221,
-         16.88976119,  17.21040017,  17.53103916,  17.85167814,
-         18.17231712,  18.49295611,  18.81359509,  19.13423407,
-         19.45487306,  19.77551204,  20.09615102,  20.41679001,
-         20.73742899,  21.05806798,  21.37870696,  21.69934594])
+        [15.60664760,  15.92727500,  16.24790240,  16.56852980,
+         16.88915719,  17.20978459,  17.53041199,  17.85103939,
+         18.17166678,  18.49229418,  18.81292158,  19.13354898,
+         19.45417638,  19.77480377,  20.09543117,  20.41605857,
+         20.73668597,  21.05731336,  21.37794076,  21.69856816])
 
     _iuy = numpy.array(
-        [42.2582845,  40.96299483,  39.80577195,  38.78821363,
-         37.91185112,  37.17815809,  36.58855785,  36.14442877,
-         35.84710827,  35.69789528,  35.69805141,  35.84880111,
-         36.15133085,  36.60678759,  37.21627669,  37.98085933,
-         38.90154977,  39.97931233,  41.21505839,  42.60964342])
+        [42.25971931,  40.96430875,  39.80695785,  38.78926439,
+         37.91275966,  37.17891735,  36.58916074,  36.14486823,
+         35.84737724,  35.69798668,  35.69795819,  35.84851621,
+         36.15084724,  36.60609825,  37.21537465,  37.97973765,
+         38.90020158,  39.97773083,  41.21323685,  42.60757523])
 
     setup_confidence.iu.fac = 2
     setup_confidence.iu.calc(setup_confidence.f, setup_confidence.g1.fwhm)
@@ -315,75 +315,75 @@ def test_interval_uncertainty(setup_confidence):
 
 def test_region_projection(setup_confidence):
     _rpx0 = numpy.array(
-        [11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146,
-         11.03809974,  12.73036104,  14.42262235,  16.11488365, 17.80714495,
-         19.49940625,  21.19166755,  22.88392885,  24.57619016, 26.26845146])
+        [11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857,
+         11.03770719,  12.72990734,  14.42210750,  16.11430765,  17.80650780,
+         19.49870796,  21.19090811,  22.88310827,  24.57530842,  26.26750857])
 
     _rpx1 = numpy.array(
-        [8.75749218,   8.75749218,   8.75749218,   8.75749218, 8.75749218,
-         8.75749218,   8.75749218,   8.75749218,   8.75749218, 8.75749218,
-         10.54556708,  10.54556708,  10.54556708,  10.54556708, 10.54556708,
-         10.54556708,  10.54556708,  10.54556708,  10.54556708, 10.54556708,
-         12.33364199,  12.33364199,  12.33364199,  12.33364199, 12.33364199,
-         12.33364199,  12.33364199,  12.33364199,  12.33364199, 12.33364199,
-         14.12171689,  14.12171689,  14.12171689,  14.12171689, 14.12171689,
-         14.12171689,  14.12171689,  14.12171689,  14.12171689, 14.12171689,
-         15.9097918,  15.9097918,  15.9097918,  15.9097918, 15.9097918,
-         15.9097918,  15.9097918,  15.9097918,  15.9097918, 15.9097918,
-         17.6978667,  17.6978667,  17.6978667,  17.6978667, 17.6978667,
-         17.6978667,  17.6978667,  17.6978667,  17.6978667, 17.6978667,
-         19.48594161,  19.48594161,  19.48594161,  19.48594161, 19.48594161,
-         19.48594161,  19.48594161,  19.48594161,  19.48594161, 19.48594161,
-         21.27401651,  21.27401651,  21.27401651,  21.27401651, 21.27401651,
-         21.27401651,  21.27401651,  21.27401651,  21.27401651, 21.27401651,
-         23.06209142,  23.06209142,  23.06209142,  23.06209142, 23.06209142,
-         23.06209142,  23.06209142,  23.06209142,  23.06209142, 23.06209142,
-         24.85016632,  24.85016632,  24.85016632,  24.85016632, 24.85016632,
-         24.85016632,  24.85016632,  24.85016632,  24.85016632, 24.85016632])
+        [8.75791691,  8.75791691,  8.75791691,  8.75791691,  8.75791691,
+         8.75791691,  8.75791691,  8.75791691,  8.75791691,  8.75791691,
+         10.54599768,  10.54599768,  10.54599768,  10.54599768,  10.54599768,
+         10.54599768,  10.54599768,  10.54599768,  10.54599768,  10.54599768,
+         12.33407845,  12.33407845,  12.33407845,  12.33407845,  12.33407845,
+         12.33407845,  12.33407845,  12.33407845,  12.33407845,  12.33407845,
+         14.12215923,  14.12215923,  14.12215923,  14.12215923,  14.12215923,
+         14.12215923,  14.12215923,  14.12215923,  14.12215923,  14.12215923,
+         15.91024000,  15.91024000,  15.91024000,  15.91024000,  15.91024000,
+         15.91024000,  15.91024000,  15.91024000,  15.91024000,  15.91024000,
+         17.69832078,  17.69832078,  17.69832078,  17.69832078,  17.69832078,
+         17.69832078,  17.69832078,  17.69832078,  17.69832078,  17.69832078,
+         19.48640155,  19.48640155,  19.48640155,  19.48640155,  19.48640155,
+         19.48640155,  19.48640155,  19.48640155,  19.48640155,  19.48640155,
+         21.27448232,  21.27448232,  21.27448232,  21.27448232,  21.27448232,
+         21.27448232,  21.27448232,  21.27448232,  21.27448232,  21.27448232,
+         23.06256310,  23.06256310,  23.06256310,  23.06256310,  23.06256310,
+         23.06256310,  23.06256310,  23.06256310,  23.06256310,  23.06256310,
+         24.85064387,  24.85064387,  24.85064387,  24.85064387,  24.85064387,
+         24.85064387,  24.85064387,  24.85064387,  24.85064387,  24.85064387])
 
     _rpy = numpy.array(
-        [121.18227727,  109.21389788,   98.48751045,   89.15211989,
-         81.31437819,   75.0489422,   70.40478381,   67.40903363,
-         66.06931267,   66.37505662,  107.09555406,   93.85962337,
-         82.2173972,   72.37069659,   64.46288283,   58.59635882,
-         54.8420303,   53.24411902,   53.82255037,   56.57387709,
-         95.08597997,   80.98176715,   68.85606392,   58.97098329,
-         51.51170797,   46.61282359,   44.37139326,   44.85269567,
-         48.09257852,   54.09778178,   85.15342677,   70.58027832,
-         58.4035077,   48.95296874,   42.46079117,   39.0982177,
-         38.99272007,   42.23460729,   48.87925026,   58.9466444,
-         77.29778983,   62.65512325,   50.85972221,   42.31664458,
-         37.31008905,   36.05245858,   38.70590422,   45.38974383,
-         56.18246641,   71.12038263,   71.51901508,   57.20627498,
-         46.22471072,   39.06200464,   36.0595698,   37.4754866,
-         43.51086985,   54.31802734,   70.00215676,   90.6189382,
-         67.81704451,   54.23371422,   44.49847032,   39.18904432,
-         38.70920964,   43.36725746,   53.40756108,   69.01940099,
-         90.33827068,  117.44226953,   66.19183538,   53.73742613,
-         45.68100001,   42.6977601,   45.25899046,   53.72773755,
-         68.39593576,   89.49382219,  117.19077045,  151.59034586,
-         66.64335816,   55.71739907,   49.77229917,   49.58814921,
-         55.70889825,   68.55690091,   88.47596148,  115.74125836,
-         150.55962734,  193.06314386,   69.17158712,   60.17362372,
-         56.77236574,   59.86020953,   70.05892198,   87.8547272,
-         113.64761294,  147.76168412,  190.44481909,  241.86064553])
+        [121.18159015,  109.21300619,  98.48635863,  89.15065974,
+         81.31257017,  75.04675729,  70.40219775,  67.40603471,
+         66.06589318,  66.37122672,  107.09564647,  93.85956937,
+         82.21710685,  72.37009100,  64.46189244,  58.59492376,
+         54.84009933,  53.24165101,  53.81951747,  56.57026512,
+         95.08677477,  80.98245596,  68.85651635,  58.97108596,
+         51.51135608,  46.61192204,  44.36985727,  44.85045156,
+         48.08956612,  54.09395806,  85.15484733,  70.58161530,
+         58.40458364,  48.95363271,  42.46089915,  39.09763394,
+         38.99132008,  42.23227881,  48.87589645,  58.94218777,
+         77.29976804,  62.65701299,  50.86130675,  42.31772278,
+         37.31047777,  36.05197668,  38.70438176,  45.38702413,
+         56.17840974,  71.11487142,  71.52146913,  57.20862267,
+         46.22668350,  39.06334987,  36.06005998,  37.47489026,
+         43.50896630,  54.31460972,  69.99703662,  90.61195222,
+         67.81989881,  54.23642414,  44.50071306,  39.19050941,
+         38.70962196,  43.36633019,  53.40501754,  69.01497845,
+         90.33172639,  117.43338841,  66.19501410,  53.74040059,
+         45.68339433,  42.69919781,  45.25914559,  53.72626280,
+         68.39249320,  89.48808763,  117.18244086,  151.57914923,
+         66.64678563,  55.72054168,  49.77472658,  49.58941234,
+         55.70861684,  68.55466211,  88.47136077,  115.73390455,
+         150.54915141,  193.04921077,  69.17518725,  60.17683709,
+         56.77470825,  59.86115083,  70.05802469,  87.85150775,
+         113.64159490,  147.75240376,  190.43183566,  241.84355526])
 
     setup_confidence.rp.fac = 5
     setup_confidence.rp.calc(setup_confidence.f,
@@ -397,75 +397,75 @@ def test_region_projection(setup_confidence):
 
 def test_region_uncertainty(setup_confidence):
     _rux0 = numpy.array(
-        [12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629,
-         12.56113491,  13.91494395,  15.268753,  16.62256204, 17.97637108,
-         19.33018012,  20.68398916,  22.0377982,  23.39160724, 24.74541629])
+        [12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843,
+         12.56068733,  13.91444745,  15.26820757,  16.62196770,  17.97572782,
+         19.32948794,  20.68324807,  22.03700819,  23.39076831,  24.74452843])
 
     _rux1 = numpy.array(
-        [10.36675959,  10.36675959,  10.36675959,  10.36675959, 10.36675959,
-         10.36675959,  10.36675959,  10.36675959,  10.36675959, 10.36675959,
-         11.79721952,  11.79721952,  11.79721952,  11.79721952, 11.79721952,
-         11.79721952,  11.79721952,  11.79721952,  11.79721952, 11.79721952,
-         13.22767944,  13.22767944,  13.22767944,  13.22767944, 13.22767944,
-         13.22767944,  13.22767944,  13.22767944,  13.22767944, 13.22767944,
-         14.65813936,  14.65813936,  14.65813936,  14.65813936, 14.65813936,
-         14.65813936,  14.65813936,  14.65813936,  14.65813936, 14.65813936,
-         16.08859929,  16.08859929,  16.08859929,  16.08859929, 16.08859929,
-         16.08859929,  16.08859929,  16.08859929,  16.08859929, 16.08859929,
-         17.51905921,  17.51905921,  17.51905921,  17.51905921, 17.51905921,
-         17.51905921,  17.51905921,  17.51905921,  17.51905921, 17.51905921,
-         18.94951914,  18.94951914,  18.94951914,  18.94951914, 18.94951914,
-         18.94951914,  18.94951914,  18.94951914,  18.94951914, 18.94951914,
-         20.37997906,  20.37997906,  20.37997906,  20.37997906, 20.37997906,
-         20.37997906,  20.37997906,  20.37997906,  20.37997906, 20.37997906,
-         21.81043898,  21.81043898,  21.81043898,  21.81043898, 21.81043898,
-         21.81043898,  21.81043898,  21.81043898,  21.81043898, 21.81043898,
-         23.24089891,  23.24089891,  23.24089891,  23.24089891, 23.24089891,
-         23.24089891,  23.24089891,  23.24089891,  23.24089891, 23.24089891])
+        [10.36718960,  10.36718960,  10.36718960,  10.36718960,  10.36718960,
+         10.36718960,  10.36718960,  10.36718960,  10.36718960,  10.36718960,
+         11.79765422,  11.79765422,  11.79765422,  11.79765422,  11.79765422,
+         11.79765422,  11.79765422,  11.79765422,  11.79765422,  11.79765422,
+         13.22811884,  13.22811884,  13.22811884,  13.22811884,  13.22811884,
+         13.22811884,  13.22811884,  13.22811884,  13.22811884,  13.22811884,
+         14.65858346,  14.65858346,  14.65858346,  14.65858346,  14.65858346,
+         14.65858346,  14.65858346,  14.65858346,  14.65858346,  14.65858346,
+         16.08904808,  16.08904808,  16.08904808,  16.08904808,  16.08904808,
+         16.08904808,  16.08904808,  16.08904808,  16.08904808,  16.08904808,
+         17.51951270,  17.51951270,  17.51951270,  17.51951270,  17.51951270,
+         17.51951270,  17.51951270,  17.51951270,  17.51951270,  17.51951270,
+         18.94997732,  18.94997732,  18.94997732,  18.94997732,  18.94997732,
+         18.94997732,  18.94997732,  18.94997732,  18.94997732,  18.94997732,
+         20.38044194,  20.38044194,  20.38044194,  20.38044194,  20.38044194,
+         20.38044194,  20.38044194,  20.38044194,  20.38044194,  20.38044194,
+         21.81090656,  21.81090656,  21.81090656,  21.81090656,  21.81090656,
+         21.81090656,  21.81090656,  21.81090656,  21.81090656,  21.81090656,
+         23.24137117,  23.24137117,  23.24137117,  23.24137117,  23.24137117,
+         23.24137117,  23.24137117,  23.24137117,  23.24137117,  23.24137117])
 
     _ruy = numpy.array(
-        [96.58117835,   87.02838072,   78.58324208,   71.31800953,
-         65.28984102,   60.54431967,   57.11719555,   55.03459229,
-         54.31255884,   54.95668786,   85.96169801,   75.9815896,
-         67.33096852,   60.09842943,   54.35398817,   50.15439725,
-         47.54566158,   46.56317725,   47.23082527,   49.56009821,
-         76.90300053,   66.7116158,   58.0882768,   51.13947262,
-         45.94928247,   42.58681159,   41.10961032,   41.56372169,
-         43.98222109,   48.38374461,   69.40508592,   59.21845932,
-         50.85516692,   44.4411391,   40.07572392,   37.84156267,
-         37.80904175,   40.0362256,   44.56674629,   51.42762706,
-         63.46795418,   53.50212017,   45.63163889,   40.00342886,
-         36.73331252,   35.91865051,   37.6439559,   41.980689,
-         48.98440089,   58.69174556,   59.09160531,   49.56259833,
-         42.41769271,   37.82634191,   35.92204826,   36.8180751,
-         40.61435275,   47.39711188,   57.23518487,   70.1761001,
-         56.27603931,   47.39989381,   41.21332836,   37.90987826,
-         37.64193114,   40.53983645,   46.7202323,   56.28549424,
-         69.31909824,   85.88069069,   55.02125618,   47.01400662,
-         42.01854587,   40.25403789,   41.89296118,   47.08393454,
-         55.96159455,   68.64583609,   85.236141,  105.80551733,
-         55.32725591,   48.40493674,   44.83334521,   44.85882081,
-         48.67513836,   56.45036939,   68.33843951,   84.47813741,
-         104.98631314,  129.95058002,   57.19403852,   51.57268419,
-         49.6577264,   51.72422701,   57.98846268,   68.63914099,
-         83.85076718,  103.78239821,  128.56961467,  158.31587876])
+        [96.58108943,  87.02810227,  78.58272910,  71.31722046,
+         65.28873733,  60.54286583,  57.11535969,  55.03234738,
+         54.30988394,  54.95356924,  85.96222322,  75.98193010,
+         67.33106225,  60.09821833,  54.35341726,  50.15341426,
+         47.54421765,  46.56122840,  47.22833414,  49.55703563,
+         76.90408141,  66.71250483,  58.08889310,  51.13973989,
+         45.94912753,  42.58616351,  41.10840114,  41.56188820,
+         43.97970713,  48.38050318,  69.40666402,  59.21982647,
+         50.85622166,  44.44178517,  40.07586815,  37.84111358,
+         37.80791015,  40.03432679,  44.56400292,  51.42397189,
+         63.46997103,  53.50389502,  45.63304792,  40.00435415,
+         36.73363912,  35.91826447,  37.64274468,  41.97854415,
+         48.98122151,  58.68744176,  59.09400246,  49.56471048,
+         42.41937189,  37.82744683,  35.92244044,  36.81761616,
+         40.61290474,  47.39454030,  57.23136290,  70.17091279,
+         56.27875829,  47.40227284,  41.21519357,  37.91106323,
+         37.64227211,  40.53916868,  46.71839032,  56.28231524,
+         69.31442708,  85.87438499,  55.02423853,  47.01658211,
+         42.02051295,  40.25520333,  41.89313413,  47.08292201,
+         55.95920142,  68.64186895,  85.23041406,  105.79785835,
+         55.33044319,  48.40763829,  44.83533004,  44.85986713,
+         48.67502649,  56.44887616,  68.33533804,  84.47320145,
+         104.97932384,  129.94133287,  57.19737225,  51.57544138,
+         49.65964484,  51.72505465,  57.98794920,  68.63703113,
+         83.84680018,  103.77631273,  128.56115642,  158.30480855])
 
     setup_confidence.ru.fac = 4
     setup_confidence.ru.calc(setup_confidence.f,
@@ -528,7 +528,7 @@ def test_resample_supports_data1d(caplog, check_str):
     assert lname == "sherpa"
     assert lvl == logging.INFO
     check_str(msg,
-              ["mdl.c0 : avg = 1.0343987745935705 , std = 0.5208696279243179  # doctest: +FLOAT_CMP"])
+              ["mdl.c0 : avg = 1.0343987745935765 , std = 0.5208696279243179  # doctest: +FLOAT_CMP"])
 
 
 def test_resample_fails_unsupported_data():
@@ -43,21 +43,21 @@ _eps = np.finfo(np.float32).eps
 
 
 _fit_results_bench = {
-    'rstat': 89.29503933428586,
+    'rstat': 89.2950392347538,
     'qval': 0.0,
     'succeeded': 1,
     'numpoints': 100,
     'dof': 95,
-    'nfev': 93,
-    'statval': 8483.0287367571564,
+    'nfev': 18,
+    'statval': 8483.028727301611,
     'parnames': ['p1.gamma', 'p1.ampl', 'g1.fwhm',
                  'g1.pos', 'g1.ampl'],
     'parvals': np.array(
-        [1.0701938169914813,
-         9.1826254677279469,
-         2.5862083052721028,
-         2.601619746022207,
-         47.262657692418749])
+        [1.0701803642164727,
+         9.182893234200318,
+         2.5861948957216923,
+         2.601623068682691,
+         47.26256360242114])
     }
 
 _x = np.arange(0.1, 10.1, 0.1)
@@ -141,52 +141,52 @@ def setup():
 # information (e.g. all-but-the-first column).
 #
 EXPECTED_T = np.asarray(
-    [[8.48554745e+03, 1.06405130, 9.27921234, 2.58664931, 2.59985055, 4.72032018e+01],
-     [8.49039767e+03, 1.07407403, 9.05126945, 2.59679740, 2.60386838, 4.73836300e+01],
-     [8.48487406e+03, 1.07593411, 9.09514664, 2.59122066, 2.60017483, 4.72314632e+01],
-     [8.49161845e+03, 1.08176457, 8.99021849, 2.58955534, 2.60555871, 4.73149762e+01],
-     [8.48500890e+03, 1.07345136, 9.10233367, 2.59110813, 2.59826504, 4.71895128e+01],
-     [8.48768940e+03, 1.07931966, 9.04095922, 2.58360678, 2.59945504, 4.73628249e+01],
-     [8.48965960e+03, 1.06198138, 9.36079509, 2.57625718, 2.59810196, 4.71039215e+01],
-     [8.49112060e+03, 1.06906602, 9.21644535, 2.57147393, 2.60053414, 4.75622912e+01],
-     [8.48414894e+03, 1.07225846, 9.13799921, 2.58982250, 2.59983239, 4.71818523e+01],
-     [8.48467565e+03, 1.07387648, 9.12069098, 2.59440151, 2.60188040, 4.71716468e+01]])
+    [[8.48555044e+03, 1.06403810, 9.27947772, 2.58663610, 2.59985382, 4.72031064e+01],
+     [8.49039594e+03, 1.07406021, 9.05154144, 2.59678364, 2.60387180, 4.73835374e+01],
+     [8.48487127e+03, 1.07592054, 9.09541451, 2.59120716, 2.60017818, 4.72313708e+01],
+     [8.49161283e+03, 1.08175070, 8.99048941, 2.58954160, 2.60556212, 4.73148851e+01],
+     [8.48500738e+03, 1.07343785, 9.10260045, 2.59109470, 2.59826837, 4.71894206e+01],
+     [8.48768493e+03, 1.07930583, 9.04123081, 2.58359308, 2.59945844, 4.73627327e+01],
+     [8.48966347e+03, 1.06196843, 9.36105726, 2.57624423, 2.59810515, 4.71038253e+01],
+     [8.49112103e+03, 1.06905228, 9.21672007, 2.57146025, 2.60053753, 4.75621947e+01],
+     [8.48414797e+03, 1.07224501, 9.13826545, 2.58980912, 2.59983571, 4.71817595e+01],
+     [8.48467389e+03, 1.07386303, 9.12095714, 2.59438811, 2.60188373, 4.71715543e+01]])
 
 EXPECTED_UNIFORM = np.asarray(
-    [[8.92261355e+03, 1.07123512, 8.57093063, 2.61429088, 2.61114484, 4.73497877e+01],
-     [9.82725325e+03, 1.09710009, 9.65477406, 2.59719719, 2.60793168, 4.75320785e+01],
-     [9.26055735e+03, 1.08617397, 9.65589944, 2.55228604, 2.59058740, 4.74161153e+01],
-     [8.89791148e+03, 1.05709447, 8.93723905, 2.54271093, 2.60441234, 4.73194803e+01],
-     [8.57046575e+03, 1.05340130, 9.29276194, 2.62471517, 2.59089248, 4.69458349e+01],
-     [9.30936360e+03, 1.08140402, 9.77082772, 2.55498773, 2.58937941, 4.70072160e+01],
-     [8.50747533e+03, 1.05015625, 9.60690127, 2.57938039, 2.61121593, 4.72686196e+01],
-     [9.07680066e+03, 1.06371906, 8.64790722, 2.57283955, 2.60058787, 4.71609855e+01],
-     [8.50393051e+03, 1.07730034, 8.93027393, 2.61841172, 2.59182705, 4.72459725e+01],
-     [8.65618143e+03, 1.06489218, 8.92190134, 2.57999046, 2.60300976, 4.77114146e+01]])
+    [[8.92257624e+03, 1.07122162, 8.57120920, 2.61427704, 2.61114803, 4.73496939e+01],
+     [9.82711619e+03, 1.09708545, 9.65503348, 2.59718361, 2.60793492, 4.75319852e+01],
+     [9.26047766e+03, 1.08615982, 9.65615884, 2.55227315, 2.59059087, 4.74160216e+01],
+     [8.89788751e+03, 1.05708160, 8.93751115, 2.54269820, 2.60441562, 4.73193863e+01],
+     [8.57046968e+03, 1.05338858, 9.29302776, 2.62470116, 2.59089595, 4.69457399e+01],
+     [9.30928300e+03, 1.08139008, 9.77108509, 2.55497481, 2.58938290, 4.70071212e+01],
+     [8.50748447e+03, 1.05014368, 9.60716154, 2.57936709, 2.61121913, 4.72685255e+01],
+     [9.07675638e+03, 1.06370590, 8.64818443, 2.57282635, 2.60059121, 4.71608911e+01],
+     [8.50392658e+03, 1.07728657, 8.93054616, 2.61839781, 2.59183051, 4.72458784e+01],
+     [8.65617054e+03, 1.06487896, 8.92217372, 2.57997715, 2.60301306, 4.77113218e+01]])
 
 EXPECTED_NORMAL = np.asarray(
-    [[8.48932906e+03, 1.07521274, 9.12922751, 2.58401110, 2.60674560, 4.72643098e+01],
-     [8.51403222e+03, 1.07038805, 9.28561349, 2.59758807, 2.60327743, 4.73778582e+01],
-     [8.49257783e+03, 1.06434242, 9.23215258, 2.59206666, 2.60425951, 4.73144299e+01],
-     [8.51807534e+03, 1.07733205, 9.19189905, 2.59504891, 2.60874881, 4.73133218e+01],
-     [8.48944871e+03, 1.07547372, 9.02226669, 2.58883295, 2.59963583, 4.72538788e+01],
-     [8.60701037e+03, 1.06228469, 9.02741627, 2.57583942, 2.59915910, 4.72570650e+01],
-     [8.49815729e+03, 1.06742811, 9.25051210, 2.58472492, 2.59254295, 4.73907749e+01],
-     [8.50229908e+03, 1.06163471, 9.35611275, 2.60000339, 2.60215199, 4.72510835e+01],
-     [8.75384863e+03, 1.06024498, 8.90014878, 2.58809846, 2.60381520, 4.72108582e+01],
-     [8.51787451e+03, 1.08352963, 9.03835426, 2.57289213, 2.60153812, 4.71947163e+01]])
+    [[8.48932625e+03, 1.07519907, 9.12949622, 2.58399772, 2.60674885, 4.72642157e+01],
+     [8.51403023e+03, 1.07037459, 9.28587944, 2.59757448, 2.60328073, 4.73777645e+01],
+     [8.49258030e+03, 1.06432923, 9.23241947, 2.59205316, 2.60426280, 4.73143360e+01],
+     [8.51806902e+03, 1.07731829, 9.19216665, 2.59503537, 2.60875204, 4.73132278e+01],
+     [8.48944588e+03, 1.07546004, 9.02253729, 2.58881950, 2.59963918, 4.72537847e+01],
+     [8.60700427e+03, 1.06227158, 9.02768677, 2.57582618, 2.59916246, 4.72569709e+01],
+     [8.49815818e+03, 1.06741478, 9.25077866, 2.58471154, 2.59254640, 4.73906811e+01],
+     [8.50230270e+03, 1.06162163, 9.35637746, 2.59998976, 2.60215531, 4.72509893e+01],
+     [8.75383085e+03, 1.06023197, 8.90042154, 2.58808502, 2.60381849, 4.72107640e+01],
+     [8.51786617e+03, 1.08351559, 9.03862458, 2.57287893, 2.60154144, 4.71946220e+01]])
 
 EXPECTED_NORMAL2 = np.asarray(
-    [[8.48548565e+03, 1.06412678, 9.27802554, 2.58664389, 2.59987229, 4.72039324e+01],
-     [8.49055139e+03, 1.07411404, 9.04991502, 2.59690659, 2.60389156, 4.73848773e+01],
-     [8.48477491e+03, 1.07577639, 9.09755020, 2.59108294, 2.60021453, 4.72323203e+01],
-     [8.48969939e+03, 1.08038114, 9.01322326, 2.58915516, 2.60508776, 4.73087209e+01],
-     [8.48517760e+03, 1.07358732, 9.09898261, 2.59131263, 2.59812503, 4.71864601e+01],
-     [8.48702560e+03, 1.07863842, 9.05153453, 2.58380099, 2.59961664, 4.73553475e+01],
-     [8.48985527e+03, 1.06186041, 9.36341964, 2.57611060, 2.59805014, 4.71015833e+01],
-     [8.49014958e+03, 1.06913589, 9.21435006, 2.57238678, 2.60060140, 4.75437276e+01],
-     [8.48425884e+03, 1.07235749, 9.13585873, 2.58999586, 2.59974666, 4.71779765e+01],
-     [8.48460130e+03, 1.07379213, 9.12210957, 2.59421385, 2.60187443, 4.71737314e+01]])
+    [[8.48548861e+03, 1.06411357, 9.27829095, 2.58663068, 2.59987556, 4.72038370e+01],
+     [8.49054964e+03, 1.07410021, 9.05018706, 2.59689282, 2.60389499, 4.73847848e+01],
+     [8.48477219e+03, 1.07576282, 9.09781807, 2.59106945, 2.60021788, 4.72322279e+01],
+     [8.48969444e+03, 1.08036732, 9.01349381, 2.58914146, 2.60509116, 4.73086294e+01],
+     [8.48517602e+03, 1.07357380, 9.09924934, 2.59129920, 2.59812836, 4.71863679e+01],
+     [8.48702145e+03, 1.07862462, 9.05180583, 2.58378730, 2.59962003, 4.73552551e+01],
+     [8.48985920e+03, 1.06184746, 9.36368172, 2.57609765, 2.59805333, 4.71014870e+01],
+     [8.49014998e+03, 1.06912217, 9.21462436, 2.57237312, 2.60060478, 4.75436313e+01],
+     [8.48425782e+03, 1.07234404, 9.13612490, 2.58998248, 2.59974998, 4.71778838e+01],
+     [8.48459958e+03, 1.07377868, 9.12237576, 2.59420044, 2.60187776, 4.71736388e+01]])
 
 
 def test_student_t(setup):
@@ -200,7 +200,7 @@ def test_cauchy(setup):
     out = sim.multivariate_cauchy(setup.mu, setup.cov, setup.num,
                                   rng=setup.rng)
 
-    expected = [1.04452632, 9.58622941, 2.58805112, 2.59422687, 47.01421166]
+    expected = [1.0445139, 9.58648717, 2.58803855, 2.59422998, 47.01411211]
 
     assert out == pytest.approx(np.asarray(expected))
 
@@ -235,7 +235,7 @@ def test_parameter_scale_vector(setup):
     ps = sim.ParameterScaleVector()
     out = ps.get_scales(setup.fit)
 
-    expected = [0.00752475, 0.15368132, 0.01088586, 0.00362169, 0.12308473]
+    expected = [0.00752442, 0.15367861, 0.01088569, 0.00362164, 0.12308508]
 
     assert out == pytest.approx(np.asarray(expected))
 
@@ -244,11 +244,11 @@ def test_parameter_scale_matrix(setup):
     ps = sim.ParameterScaleMatrix()
     out = ps.get_scales(setup.fit)
 
-    expected = [[ 5.66219290e-05, -1.13204057e-03,  5.74775798e-05, -1.41279846e-05,   3.89927955e-04],
-                [-1.13204057e-03,  2.36179487e-02, -1.24335374e-03,  3.07465479e-04,  -7.64855819e-03],
-                [ 5.74775798e-05, -1.24335374e-03,  1.18501872e-04, -1.78172521e-05,  -8.27934918e-05],
-                [-1.41279846e-05,  3.07465479e-04, -1.78172521e-05,  1.31166529e-05,  -8.41924293e-05],
-                [ 3.89927955e-04, -7.64855819e-03, -8.27934918e-05, -8.41924293e-05,   1.51498514e-02]]
+    expected = [[ 5.66169606e-05, -1.13196874e-03,  5.74733980e-05, -1.41267003e-05,   3.89913846e-04],
+                [-1.13196874e-03,  2.36171142e-02, -1.24330047e-03,  3.07447172e-04,  -7.64847619e-03],
+                [ 5.74733980e-05, -1.24330047e-03,  1.18498181e-04, -1.78160856e-05,  -8.27993529e-05],
+                [-1.41267003e-05,  3.07447172e-04, -1.78160856e-05,  1.31162963e-05,  -8.41894883e-05],
+                [ 3.89913846e-04, -7.64847619e-03, -8.27993529e-05, -8.41894883e-05,   1.51499358e-02]]
 
     assert out == pytest.approx(np.asarray(expected))
 
@@ -462,7 +462,7 @@ def test_mh(setup, caplog):
     # Check outfile; expect
     #     nfev statistic pl.gamma pl.ampl g1.fwhm g1.pos g1.ampl
     #
-    row0 = np.asarray([0, -8975.692, 1.070194, 9.182625, 2.586208, 2.601620, 47.26266])
+    row0 = np.asarray([0, -8975.692, 1.070180, 9.182893, 2.586195, 2.601623, 47.26256])
     row19 = np.asarray([19, -8975.953, 1.069763, 9.219122,  2.570933, 2.586584,  47.36504])
     row20 = row19.copy()
     row20[0] = 20
@@ -528,7 +528,7 @@ def test_metropolisMH(setup, caplog):
     # Check outfile; expect
     #     nfev statistic pl.gamma pl.ampl g1.fwhm g1.pos g1.ampl
     #
-    row0 = np.asarray([0, 98.83959, 1.070194, 9.182625, 2.586208, 2.601620, 47.26266])
+    row0 = np.asarray([0, 98.83958, 1.070180, 9.182893, 2.586195, 2.601623, 47.26256])
     row19 = np.asarray([19, 98.5784, 1.069763, 9.219122, 2.570933, 2.586584, 47.36504])
     row20 = row19.copy()
     row20[0] = 20
@@ -29,7 +29,8 @@ from sherpa import get_config
 from sherpa.data import Data, DataSimulFit
 from sherpa.models import Model, SimulFitModel
 from sherpa.utils import NoNewAttributesAfterInit, igamc
-from sherpa.utils.err import FitErr, StatErr
+from sherpa.utils.err import DataErr, FitErr, StatErr
+from sherpa.utils.numeric_types import SherpaFloat
 from sherpa.utils.types import StatFunc, StatResults
 
 from . import _statfcts  # type: ignore
@@ -37,7 +38,7 @@ from . import _statfcts  # type: ignore
 __all__ = ('Stat', 'Cash', 'CStat', 'LeastSq',
            'Chi2Gehrels', 'Chi2ConstVar', 'Chi2DataVar', 'Chi2ModVar',
            'Chi2XspecVar', 'Chi2',
-           'UserStat', 'WStat')
+           'UserStat', 'WStat', 'PreparedStat', 'PreparedChi2')
 
 
 config = ConfigParser()
@@ -70,10 +71,92 @@ class Stat(NoNewAttributesAfterInit):
     #
     _calc: Optional[StatFunc] = None
 
+    # The value-only form of _calc: it takes the same arguments but
+    # returns just the statistic, so the per-bin values are never
+    # created. It is optional.
+    #
+    _calc_value: Optional[Callable[..., float]] = None
+
+    # The multi-dataset forms of _calc and _calc_value: each array
+    # argument is replaced by a sequence of arrays, one per dataset,
+    # and they return the statistic and the per-dataset values (and
+    # then the per-bin values for _calc_sets). The arguments come from
+    # _get_calc_sets_args. They are optional.
+    #
+    _calc_sets: Optional[Callable[..., tuple]] = None
+    _calc_value_sets: Optional[Callable[..., tuple]] = None
+
+    # The gradient form of _calc: it takes the same arguments but
+    # returns the statistic and its derivative with respect to each
+    # model value. It is optional.
+    #
+    _calc_grad: Optional[StatFunc] = None
+
+    # The prepared forms of _calc and _calc_value, used by the
+    # PreparedStat object returned by prepare. They are optional.
+    #
+    _calc_prepared: Optional[StatFunc] = None
+    _calc_prepared_value: Optional[Callable[..., float]] = None
+
+    # The name of the statistic in a compiled fit plan (see
+    # sherpa.models._modelfcts.fitplan1d), when it can be used.
+    #
+    _fitplan: Optional[str] = None
+
     # Can the statistic calculate rstat and qvalue values?
     #
     _can_calculate_rstat: bool = False
 
+    numcores: Optional[int] = None
+    """The number of threads used to calculate a compiled statistic.
+
+    When `None` the statistic is calculated on the calling thread. A
+    positive value releases the Python GIL during the calculation and
+    splits the bins across this many threads. The bins are summed in
+    fixed-size blocks, and the block sums are always combined in the
+    same order, so the statistic does not depend on this setting. It
+    is only used by the compiled statistics, such as `Chi2` and
+    `Cash`.
+    """
+
+    def __init_subclass__(cls, **kwargs) -> None:
+        super().__init_subclass__(**kwargs)
+
+        # A sub-class which changes how the statistic is calculated,
+        # but does not say how to calculate just the value, has to
+        # fall back to calc_stat for calc_stat_value.
+        #
+        if ("_calc" in cls.__dict__ and "_calc_value" not in cls.__dict__) or \
+           ("calc_stat" in cls.__dict__ and "_get_calc_args" not in cls.__dict__):
+            cls._calc_value = None
+
+        if ("_calc" in cls.__dict__ and "_calc_grad" not in cls.__dict__) or \
+           ("calc_stat" in cls.__dict__ and "_get_calc_args" not in cls.__dict__):
+            cls._calc_grad = None
+
+        # The same applies to the multi-dataset routines, which fall
+        # back to concatenating the datasets.
+        #
+        changed = ["_calc", "_calc_value", "calc_stat", "_get_calc_args"]
+        if any(name in cls.__dict__ for name in changed) and \
+           "_calc_sets" not in cls.__dict__ and \
+           "_get_calc_sets_args" not in cls.__dict__:
+            cls._calc_sets = None
+            cls._calc_value_sets = None
+
+        # and to the prepared routines, which fall back to calc_stat.
+        #
+        if any(name in cls.__dict__ for name in changed) and \
+           "_calc_prepared" not in cls.__dict__:
+            cls._calc_prepared = None
+            cls._calc_prepared_value = None
+
+        # The fit plan calculates the statistic itself.
+        #
+        if any(name in cls.__dict__ for name in changed) and \
+           "_fitplan" not in cls.__dict__:
+            cls._fitplan = None
+
     def __init__(self, name: str) -> None:
         self.name = name
         super().__init__()
@@ -238,6 +321,26 @@ class Stat(NoNewAttributesAfterInit):
 
         return fitdata, modeldata
 
+    def _get_fit_model_data_sets(self,
+                                 data: Union[Data, DataSimulFit],
+                                 model: Model
+                                 ) -> tuple[list[tuple[np.ndarray, Optional[np.ndarray], Optional[np.ndarray]]],
+                                            list[np.ndarray]]:
+        """The per-dataset form of _get_fit_model_data."""
+
+        data, model = self._validate_inputs(data, model)
+        fitdata = data.to_fit_sets(staterrfunc=self.calc_staterror)
+        modeldata = data.eval_model_to_fit_sets(model)
+
+        return fitdata, modeldata
+
+    def _use_calc_sets(self,
+                       data: Union[Data, DataSimulFit]) -> bool:
+        """Should the multi-dataset routines be used for the data?"""
+
+        return self._calc_sets is not None and \
+            isinstance(data, DataSimulFit) and len(data.datasets) > 1
+
     # TODO:
     #  - should this accept sherpa.data.Data input instead of
     #    "raw" data (i.e. to match calc_stat)
@@ -293,10 +396,248 @@ class Stat(NoNewAttributesAfterInit):
         fvec : array of numbers
             The per-bin "statistic" value.
 
+        See Also
+        --------
+        calc_stat_value
+
+        """
+
+        # Multiple datasets are passed to the statistic separately,
+        # rather than being concatenated.
+        #
+        if self._use_calc_sets(data):
+            statval, _, fvec = self.calc_stat_datasets(data, model)
+            return statval, fvec
+
+        assert self._calc is not None  # for typing
+        return self._calc(*self._get_calc_args(data, model),
+                          **self._get_calc_kwargs())
+
+    def calc_stat_value(self,
+                        data: Union[Data, DataSimulFit],
+                        model: Model
+                        ) -> float:
+        """Return the statistic value for the data and model.
+
+        This is the first element of the `calc_stat` return value,
+        but the per-bin values are not calculated when the statistic
+        supports this, which makes it cheaper to call when only the
+        statistic is needed (for instance by the optimizers that do
+        not use the per-bin values).
+
+        Parameters
+        ----------
+        data : `sherpa.data.Data` or `sherpa.data.DataSimulFit`
+            The data set, or sets, to use.
+        model :  `sherpa.models.model.Model` or `sherpa.models.model.SimulFitModel`
+            The model expression, or expressions. If a
+            `sherpa.models.model.SimulFitModel`
+            is given then it must match the number of data sets in the
+            data parameter.
+
+        Returns
+        -------
+        statval : number
+            The value of the statistic.
+
+        See Also
+        --------
+        calc_stat
+
+        """
+
+        if self._use_calc_sets(data):
+            assert self._calc_value_sets is not None  # for typing
+            return self._calc_value_sets(*self._get_calc_sets_args(data, model),
+                                         **self._get_calc_kwargs())[0]
+
+        if self._calc_value is None:
+            return self.calc_stat(data, model)[0]
+
+        return self._calc_value(*self._get_calc_args(data, model),
+                                **self._get_calc_kwargs())
+
+    def calc_stat_grad(self,
+                       data: Union[Data, DataSimulFit],
+                       model: Model
+                       ) -> Optional[tuple[float, np.ndarray]]:
+        """Return the statistic and its derivative with respect to the model.
+
+        The derivative of the statistic with respect to a parameter
+        is the sum over the bins of the values returned here
+        multiplied by the derivative of the model with respect to
+        the parameter.
+
+        Parameters
+        ----------
+        data : `sherpa.data.Data` or `sherpa.data.DataSimulFit`
+            The data set, or sets, to use.
+        model :  `sherpa.models.model.Model` or `sherpa.models.model.SimulFitModel`
+            The model expression, or expressions. If a
+            `sherpa.models.model.SimulFitModel`
+            is given then it must match the number of data sets in the
+            data parameter.
+
+        Returns
+        -------
+        statval, grad : number, array of numbers or None
+            The value of the statistic and its derivative with
+            respect to the model value of each bin. The value is
+            `None` when the statistic does not support this.
+
+        See Also
+        --------
+        calc_deriv, calc_stat
+
+        """
+
+        if self._calc_grad is None:
+            return None
+
+        return self._calc_grad(*self._get_calc_args(data, model),
+                               **self._get_calc_kwargs())
+
+    def calc_stat_datasets(self,
+                           data: Union[Data, DataSimulFit],
+                           model: Model
+                           ) -> tuple[float, np.ndarray, np.ndarray]:
+        """Return the statistic value for each dataset.
+
+        The datasets are passed to the compiled statistics without
+        being combined, and they are calculated together (so the
+        bins of all the datasets are split between the threads
+        when `numcores` is set). Other statistics are calculated
+        separately for each dataset.
+
+        Parameters
+        ----------
+        data : `sherpa.data.Data` or `sherpa.data.DataSimulFit`
+            The data set, or sets, to use.
+        model :  `sherpa.models.model.Model` or `sherpa.models.model.SimulFitModel`
+            The model expression, or expressions. If a
+            `sherpa.models.model.SimulFitModel`
+            is given then it must match the number of data sets in the
+            data parameter.
+
+        Returns
+        -------
+        statval : number
+            The value of the statistic, which is the sum of the
+            per-dataset values.
+        stats : array of numbers
+            The statistic for each dataset.
+        fvec : array of numbers
+            The per-bin "statistic" value, for all the datasets.
+
+        See Also
+        --------
+        calc_stat
+
         """
 
+        if self._calc_sets is not None:
+            return self._calc_sets(*self._get_calc_sets_args(data, model),
+                                   **self._get_calc_kwargs())
+
+        data, model = self._bundle_inputs(data, model)
+        self._check_sizes_match(data, model)
+        stats = []
+        fvecs = []
+        for dset, mexpr in zip(data.datasets, model.parts):
+            statval, fvec = self.calc_stat(dset, mexpr)
+            stats.append(statval)
+            fvecs.append(fvec)
+
+        stats = np.asarray(stats)
+        return stats.sum(), stats, np.concatenate(fvecs)
+
+    def prepare(self,
+                data: Union[Data, DataSimulFit],
+                model: Model
+                ) -> "PreparedStat":
+        """Return an object that evaluates the statistic during a fit.
+
+        During a fit only the model parameters change, so any values
+        that depend only on the data, such as the errors used by the
+        chi-square statistics, can be calculated once rather than on
+        each evaluation.
+
+        Parameters
+        ----------
+        data : `sherpa.data.Data` or `sherpa.data.DataSimulFit`
+            The data set, or sets, to use.
+        model :  `sherpa.models.model.Model` or `sherpa.models.model.SimulFitModel`
+            The model expression, or expressions. If a
+            `sherpa.models.model.SimulFitModel`
+            is given then it must match the number of data sets in the
+            data parameter.
+
+        Returns
+        -------
+        prepared : PreparedStat
+            The object. Its `~PreparedStat.update` method must be
+            called if the data, or its filter, changes.
+
+        """
+
+        if self._calc_prepared is None:
+            return PreparedStat(self, data, model)
+
+        return PreparedChi2(self, data, model)
+
+    def _get_calc_args(self,
+                       data: Union[Data, DataSimulFit],
+                       model: Model
+                       ) -> tuple:
+        """Return the arguments for the _calc and _calc_value routines."""
+
         raise NotImplementedError
 
+    def _get_calc_sets_args(self,
+                            data: Union[Data, DataSimulFit],
+                            model: Model
+                            ) -> tuple:
+        """Return the arguments for the _calc_sets and _calc_value_sets routines."""
+
+        raise NotImplementedError
+
+    def _get_calc_kwargs(self) -> dict[str, int]:
+        """Return the keyword arguments for the _calc and _calc_value routines."""
+
+        if self.numcores is None:
+            return {}
+
+        return {"numcores": int(self.numcores)}
+
+    def calc_deriv(self,
+                   data: Union[Data, DataSimulFit],
+                   model: Model
+                   ) -> Optional[np.ndarray]:
+        """Return the derivatives of the per-bin statistic values.
+
+        Parameters
+        ----------
+        data : `sherpa.data.Data` or `sherpa.data.DataSimulFit`
+            The data set, or sets, to use.
+        model :  `sherpa.models.model.Model` or `sherpa.models.model.SimulFitModel`
+            The model expression, or expressions. If a
+            `sherpa.models.model.SimulFitModel`
+            is given then it must match the number of data sets in the
+            data parameter.
+
+        Returns
+        -------
+        deriv : array of numbers or None
+            The derivative of the fvec value returned by `calc_stat`
+            with respect to each thawed parameter of the model, with
+            shape (nthawed, nbins). The value is `None` when the
+            statistic, or the model, does not support analytic
+            derivatives.
+
+        """
+
+        return None
+
     def goodness_of_fit(self,
                         statval: float,
                         dof: int
@@ -342,6 +683,121 @@ class Stat(NoNewAttributesAfterInit):
         return np.nan, np.nan
 
 
+class PreparedStat:
+    """Evaluate a statistic for data that does not change.
+
+    This is returned by `Stat.prepare`. This version just calls the
+    `Stat.calc_stat` and `Stat.calc_stat_value` methods of the
+    statistic.
+
+    """
+
+    def __init__(self,
+                 stat: Stat,
+                 data: Union[Data, DataSimulFit],
+                 model: Model
+                 ) -> None:
+        self.stat = stat
+        self.data = data
+        self.model = model
+        self.update()
+
+    def update(self) -> None:
+        """Recalculate the values that depend on the data."""
+
+    def calc_stat(self) -> StatResults:
+        """Return the statistic value and per-bin values.
+
+        See Also
+        --------
+        Stat.calc_stat
+
+        """
+
+        return self.stat.calc_stat(self.data, self.model)
+
+    def calc_stat_value(self) -> float:
+        """Return the statistic value.
+
+        See Also
+        --------
+        Stat.calc_stat_value
+
+        """
+
+        return self.stat.calc_stat_value(self.data, self.model)
+
+    def fitplan_args(self) -> Optional[dict]:
+        """The statistic arguments for a compiled fit plan.
+
+        Returns
+        -------
+        args : dict or None
+            The stat, data, and scale or trunc_value arguments for
+            `sherpa.models._modelfcts.fitplan1d`, or `None` if the
+            statistic can not be calculated by a fit plan.
+
+        """
+
+        if self.stat._fitplan is None:
+            return None
+
+        data, _ = self.stat._validate_inputs(self.data, self.model)
+        dep = data.to_fit(self.stat.calc_staterror)[0]
+        return {"stat": self.stat._fitplan,
+                "data": np.asarray(dep, dtype=SherpaFloat),
+                "trunc_value": truncation_value}
+
+
+class PreparedChi2(PreparedStat):
+    """Evaluate a chi-square statistic for data that does not change.
+
+    The errors are combined and inverted when the object is created,
+    or `update` is called, so each evaluation only needs the model
+    values.
+
+    """
+
+    def update(self) -> None:
+        data, model = self.stat._validate_inputs(self.data, self.model)
+        dep, staterror, syserror = data.to_fit(self.stat.calc_staterror)
+        if staterror is None:
+            raise StatErr('chi2noerr')
+
+        # Match the per-bin calculation of the chi2 statistic, where
+        # a zero error means the residual is not scaled.
+        #
+        error = np.asarray(staterror, dtype=SherpaFloat)
+        if syserror is not None:
+            error = np.sqrt(error * error + syserror * syserror)
+
+        self._fitdata = data
+        self._fitmodel = model
+        self._dep = np.asarray(dep, dtype=SherpaFloat)
+        self._scale = np.divide(1.0, error, out=np.ones_like(error),
+                                where=error != 0.0)
+
+    def calc_stat(self) -> StatResults:
+        assert self.stat._calc_prepared is not None  # for typing
+        modeldata = self._fitdata.eval_model_to_fit(self._fitmodel)
+        return self.stat._calc_prepared(self._dep, modeldata, self._scale,
+                                        **self.stat._get_calc_kwargs())
+
+    def calc_stat_value(self) -> float:
+        assert self.stat._calc_prepared_value is not None  # for typing
+        modeldata = self._fitdata.eval_model_to_fit(self._fitmodel)
+        return self.stat._calc_prepared_value(self._dep, modeldata,
+                                              self._scale,
+                                              **self.stat._get_calc_kwargs())
+
+    def fitplan_args(self) -> Optional[dict]:
+        if self.stat._fitplan is None:
+            return None
+
+        return {"stat": self.stat._fitplan, "data": self._dep,
+                "scale": self._scale}
+
+
 class Likelihood(Stat):
     """Likelihood functions"""
 
@@ -386,15 +842,20 @@ class Likelihood(Stat):
         self._check_background_subtraction(data)
         return data, model
 
-    def calc_stat(self,
-                  data: Union[Data, DataSimulFit],
-                  model: Model
-                  ) -> StatResults:
+    def _get_calc_args(self,
+                       data: Union[Data, DataSimulFit],
+                       model: Model
+                       ) -> tuple:
         fitdata, modeldata = self._get_fit_model_data(data, model)
+        return (fitdata[0], modeldata, None, truncation_value)
 
-        assert self._calc is not None  # for typing
-        return self._calc(fitdata[0], modeldata, None,
-                          truncation_value)
+    def _get_calc_sets_args(self,
+                            data: Union[Data, DataSimulFit],
+                            model: Model
+                            ) -> tuple:
+        fitdata, modeldata = self._get_fit_model_data_sets(data, model)
+        return ([fit[0] for fit in fitdata], modeldata, None,
+                truncation_value)
 
 
 # DOC-TODO: where is the truncate/trunc_value stored for objects
@@ -470,6 +931,11 @@ class Cash(Likelihood):
     """
 
     _calc = _statfcts.calc_cash_stat
+    _calc_value = _statfcts.calc_cash_stat_value
+    _calc_sets = _statfcts.calc_cash_stat_sets
+    _calc_value_sets = _statfcts.calc_cash_stat_value_sets
+    _calc_grad = _statfcts.calc_cash_stat_grad
+    _fitplan = "cash"
 
     def __init__(self, name: str = 'cash') -> None:
         super().__init__(name=name)
@@ -542,6 +1008,11 @@ class CStat(Likelihood):
     """
 
     _calc = _statfcts.calc_cstat_stat
+    _calc_value = _statfcts.calc_cstat_stat_value
+    _calc_sets = _statfcts.calc_cstat_stat_sets
+    _calc_value_sets = _statfcts.calc_cstat_stat_value_sets
+    _calc_grad = _statfcts.calc_cstat_stat_grad
+    _fitplan = "cstat"
     _can_calculate_rstat = True
 
     def __init__(self, name: str = 'cstat') -> None:
@@ -609,6 +1080,13 @@ class Chi2(Stat):
     """
 
     _calc = _statfcts.calc_chi2_stat
+    _calc_value = _statfcts.calc_chi2_stat_value
+    _calc_sets = _statfcts.calc_chi2_stat_sets
+    _calc_value_sets = _statfcts.calc_chi2_stat_value_sets
+    _calc_grad = _statfcts.calc_chi2_stat_grad
+    _calc_prepared = _statfcts.calc_chi2_stat_prepared
+    _calc_prepared_value = _statfcts.calc_chi2_stat_prepared_value
+    _fitplan = "chi2"
     _can_calculate_rstat = True
 
     def __init__(self, name: str = 'chi2') -> None:
@@ -618,17 +1096,53 @@ class Chi2(Stat):
     def calc_staterror(data: np.ndarray) -> np.ndarray:
         raise StatErr('chi2noerr')
 
-    def calc_stat(self,
-                  data: Union[Data, DataSimulFit],
-                  model: Model
-                  ) -> StatResults:
+    def _get_calc_args(self,
+                       data: Union[Data, DataSimulFit],
+                       model: Model
+                       ) -> tuple:
         fitdata, modeldata = self._get_fit_model_data(data, model)
+        return (fitdata[0], modeldata,
+                fitdata[1], fitdata[2],
+                None,  # TODO: weights
+                truncation_value)
 
-        assert self._calc is not None  # for typing
-        return self._calc(fitdata[0], modeldata,
-                          fitdata[1], fitdata[2],
-                          None,  # TODO: weights
-                          truncation_value)
+    def _get_calc_sets_args(self,
+                            data: Union[Data, DataSimulFit],
+                            model: Model
+                            ) -> tuple:
+        fitdata, modeldata = self._get_fit_model_data_sets(data, model)
+
+        # As with DataSimulFit.to_fit, either all or none of the
+        # datasets must have a statistical error.
+        #
+        staterrors = [fit[1] for fit in fitdata]
+        nmissing = sum(staterror is None for staterror in staterrors)
+        if 0 < nmissing < len(staterrors):
+            raise DataErr('staterrsimulfit')
+
+        return ([fit[0] for fit in fitdata], modeldata,
+                staterrors, [fit[2] for fit in fitdata],
+                None,  # TODO: weights
+                truncation_value)
+
+    def calc_deriv(self,
+                   data: Union[Data, DataSimulFit],
+                   model: Model
+                   ) -> Optional[np.ndarray]:
+        data, model = self._validate_inputs(data, model)
+        deriv = data.eval_deriv_to_fit(model, model.get_thawed_pars())
+        if deriv is None:
+            return None
+
+        # fvec is (model - data) / error, where the error is
+        # calculated as in calc_stat.
+        #
+        _, staterror, syserror = data.to_fit(staterrfunc=self.calc_staterror)
+        error = np.asarray(staterror, dtype=SherpaFloat)
+        if syserror is not None:
+            error = np.sqrt(error * error + syserror * syserror)
+
+        return deriv / np.where(error == 0.0, 1.0, error)
 
     def calc_chisqr(self,
                     data: Union[Data, DataSimulFit],
@@ -666,6 +1180,10 @@ class LeastSq(Chi2):
     """
 
     _calc = _statfcts.calc_lsq_stat
+    _calc_value = _statfcts.calc_lsq_stat_value
+    _calc_sets = _statfcts.calc_lsq_stat_sets
+    _calc_value_sets = _statfcts.calc_lsq_stat_value_sets
+    _calc_grad = _statfcts.calc_lsq_stat_grad
     _can_calculate_rstat = False
 
     def __init__(self, name: str = 'leastsq') -> None:
@@ -675,6 +1193,14 @@ class LeastSq(Chi2):
     def calc_staterror(data: np.ndarray) -> np.ndarray:
         return np.ones_like(data)
 
+    def calc_deriv(self,
+                   data: Union[Data, DataSimulFit],
+                   model: Model
+                   ) -> Optional[np.ndarray]:
+        # fvec is model - data, whatever errors the data set has.
+        data, model = self._validate_inputs(data, model)
+        return data.eval_deriv_to_fit(model, model.get_thawed_pars())
+
 
 class Chi2Gehrels(Chi2):
     """Chi Squared with Gehrels variance.
@@ -830,6 +1356,10 @@ class Chi2ModVar(Chi2):
     """
 
     _calc = _statfcts.calc_chi2modvar_stat
+    _calc_value = _statfcts.calc_chi2modvar_stat_value
+    _calc_sets = _statfcts.calc_chi2modvar_stat_sets
+    _calc_value_sets = _statfcts.calc_chi2modvar_stat_value_sets
+    _calc_grad = _statfcts.calc_chi2modvar_stat_grad
 
     def __init__(self, name: str = 'chi2modvar') -> None:
         super().__init__(name=name)
@@ -839,6 +1369,13 @@ class Chi2ModVar(Chi2):
     def calc_staterror(data: np.ndarray) -> np.ndarray:
         return np.zeros_like(data)
 
+    # The error depends on the model.
+    def calc_deriv(self,
+                   data: Union[Data, DataSimulFit],
+                   model: Model
+                   ) -> Optional[np.ndarray]:
+        return None
+
 
 class Chi2XspecVar(Chi2):
     """Chi Squared with data variance (XSPEC style).
@@ -1013,15 +1550,38 @@ class WStat(Likelihood):
     """
 
     _calc = _statfcts.calc_wstat_stat
+    _calc_value = _statfcts.calc_wstat_stat_value
+    _calc_sets = _statfcts.calc_wstat_stat_sets
+    _calc_value_sets = _statfcts.calc_wstat_stat_value_sets
+    _calc_grad = _statfcts.calc_wstat_stat_grad
     _can_calculate_rstat = True
 
     def __init__(self, name: str = 'wstat') -> None:
         super().__init__(name=name)
 
-    def calc_stat(self,
-                  data: Union[Data, DataSimulFit],
-                  model: Model
-                  ) -> StatResults:
+    def _get_calc_args(self,
+                       data: Union[Data, DataSimulFit],
+                       model: Model
+                       ) -> tuple:
+
+        (data_src, data_model, exp_src, exp_bkg, data_bkg,
+         backscales) = self._get_calc_sets_args(data, model)[:6]
+
+        nelems = [y.size for y in data_src]
+        data_src = np.concatenate(data_src)
+        data_model = np.concatenate(data_model)
+        exp_src = np.concatenate(exp_src)
+        exp_bkg = np.concatenate(exp_bkg)
+        data_bkg = np.concatenate(data_bkg)
+        backscales = np.concatenate(backscales)
+
+        return (data_src, data_model, nelems, exp_src, exp_bkg,
+                data_bkg, backscales, truncation_value)
+
+    def _get_calc_sets_args(self,
+                            data: Union[Data, DataSimulFit],
+                            model: Model
+                            ) -> tuple:
 
         data, model = self._validate_inputs(data, model)
 
@@ -1030,15 +1590,9 @@ class WStat(Likelihood):
         # easy access to this via the Data API (in part because the
         # Data class has no knowledge of grouping or backscale values).
         #
-        # An alternative approach would be to just calculate the
-        # statistic for each dataset individually and then
-        # sum the statistics for the return value, but the
-        # original code used this approach.
-        #
         data_src = []
-        data_model = data.eval_model_to_fit(model)
+        data_model = data.eval_model_to_fit_sets(model)
         data_bkg = []
-        nelems = []
         exp_src = []
         exp_bkg = []
         backscales = []
@@ -1051,7 +1605,6 @@ class WStat(Likelihood):
 
             y = dset.to_fit(staterrfunc=None)[0]
             data_src.append(y)
-            nelems.append(y.size)
 
             try:
                 bids = dset.background_ids
@@ -1128,12 +1681,5 @@ class WStat(Likelihood):
 
             exp_bkg.append(bset.exposure * ascal)
 
-        data_src = np.concatenate(data_src)
-        exp_src = np.concatenate(exp_src)
-        exp_bkg = np.concatenate(exp_bkg)
-        data_bkg = np.concatenate(data_bkg)
-        backscales = np.concatenate(backscales)
-
-        assert self._calc is not None  # for typing
-        return self._calc(data_src, data_model, nelems, exp_src, exp_bkg,
-                          data_bkg, backscales, truncation_value)
+        return (data_src, data_model, exp_src, exp_bkg,
+                data_bkg, backscales, truncation_value)
@@ -40,6 +40,41 @@ static PyMethodDef StatFcts[] = {
   LKLHD_STATFCT( calc_cstat_stat ),
   WSTATFCT( calc_wstat_stat ),
 
+  STATVALFCT( calc_chi2_stat ),
+  STATVALFCT( calc_chi2modvar_stat ),
+  STATVALFCT( calc_lsq_stat ),
+
+  LKLHD_STATVALFCT( calc_cash_stat ),
+  LKLHD_STATVALFCT( calc_cstat_stat ),
+  WSTATVALFCT( calc_wstat_stat ),
+
+  STATGRADFCT( calc_chi2_stat ),
+  STATGRADFCT( calc_chi2modvar_stat ),
+  STATGRADFCT( calc_lsq_stat ),
+
+  LKLHD_STATGRADFCT( calc_cash_stat ),
+  LKLHD_STATGRADFCT( calc_cstat_stat ),
+  WSTATGRADFCT( calc_wstat_stat ),
+
+  PREPAREDSTATFCT( calc_chi2_stat ),
+  PREPAREDSTATVALFCT( calc_chi2_stat ),
+
+  STATSETSFCT( calc_chi2_stat ),
+  STATSETSFCT( calc_chi2modvar_stat ),
+  STATSETSFCT( calc_lsq_stat ),
+
+  LKLHD_STATSETSFCT( calc_cash_stat ),
+  LKLHD_STATSETSFCT( calc_cstat_stat ),
+  WSTATSETSFCT( calc_wstat_stat ),
+
+  STATVALSETSFCT( calc_chi2_stat ),
+  STATVALSETSFCT( calc_chi2modvar_stat ),
+  STATVALSETSFCT( calc_lsq_stat ),
+
+  LKLHD_STATVALSETSFCT( calc_cash_stat ),
+  LKLHD_STATVALSETSFCT( calc_cstat_stat ),
+  WSTATVALSETSFCT( calc_wstat_stat ),
+
   { NULL, NULL, 0, NULL }
 
 };
@@ -50,12 +50,13 @@ from sherpa.astro.data import DataPHA
 from sherpa.astro.instrument import create_delta_rmf
 from sherpa.data import Data1D, Data1DInt, Data2D, DataSimulFit
 from sherpa.models.model import SimulFitModel
-from sherpa.models.basic import Const1D, Polynom1D
+from sherpa.models.basic import Const1D, Polynom1D, TableModel
 from sherpa.astro.models import Lorentz2D
 from sherpa.utils.err import DataErr, FitErr, StatErr
 
 from sherpa.stats import LeastSq, Chi2, Chi2Gehrels, Chi2DataVar, \
-    Chi2ConstVar, Chi2ModVar, Chi2XspecVar, Cash, CStat, WStat, UserStat
+    Chi2ConstVar, Chi2ModVar, Chi2XspecVar, Cash, CStat, WStat, UserStat, \
+    PreparedChi2, PreparedStat
 
 
 def setup_single(stat, sys):
@@ -1315,3 +1316,388 @@ def test_stats_calc_stat_pha_multi(stat, usestat, usesys,
     # correct for the one missing bin in the second dataset
     expected = 2 * expected1 - delta
     assert_almost_equal(answer, expected)
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2, Chi2Gehrels, Chi2DataVar,
+                                  Chi2ConstVar, Chi2ModVar, Chi2XspecVar,
+                                  Cash, CStat])
+@pytest.mark.parametrize("usestat,usesys", [(True, True), (False, False)])
+def test_stats_calc_stat_value(stat, usestat, usesys):
+    """The value-only form matches calc_stat"""
+
+    if stat is Chi2 and not usestat:
+        pytest.skip("chi2 needs errors")
+
+    data, model = setup_multiple_pha(usestat, usesys, background=False)
+    statobj = stat()
+    expected, _ = statobj.calc_stat(data, model)
+    assert statobj.calc_stat_value(data, model) == expected
+
+
+def test_stats_calc_stat_value_wstat():
+    """The value-only form matches calc_stat"""
+
+    data, model = setup_multiple_pha(True, True, background=True)
+    statobj = WStat()
+    expected, _ = statobj.calc_stat(data, model)
+    assert statobj.calc_stat_value(data, model) == expected
+
+
+@pytest.mark.parametrize("stat", [Cash, CStat])
+def test_stats_calc_stat_likelihood_blocks(stat):
+    """Check the likelihood terms over several blocks of bins.
+
+    The bins include zero counts and model values that are
+    truncated, and the results are compared to a direct
+    calculation.
+    """
+
+    rng = np.random.default_rng(3827)
+    nbins = 1000
+    y = rng.poisson(5, size=nbins).astype(float)
+    mvals = rng.uniform(0.1, 10, size=nbins)
+    mvals[:5] = 0
+    mvals[-3:] = 1e-30
+
+    data = Data1D("blocks", np.arange(nbins), y)
+    model = TableModel()
+    model.load(None, mvals)
+
+    trunc = 1e-25
+    m = np.where(mvals <= 0, trunc, mvals)
+    logy = np.log(np.where(y > 0, y, 1))
+    cstat = m - y + np.where(y > 0, y * (logy - np.log(m)), 0)
+    if stat is Cash:
+        expected = 2 * np.sum(m - y * np.log(m))
+    else:
+        expected = 2 * np.sum(cstat)
+
+    # For both statistics the per-bin values are taken from CStat.
+    statobj = stat()
+    statval, fvec = statobj.calc_stat(data, model)
+    assert statval == pytest.approx(expected, rel=1e-13)
+    assert fvec == pytest.approx(np.sqrt(2 * np.abs(cstat)), rel=1e-14,
+                                 abs=1e-8)
+    assert statobj.calc_stat_value(data, model) == statval
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2, Chi2ModVar, Cash, CStat])
+def test_stats_numcores(stat):
+    """The statistic does not depend on the number of threads."""
+
+    rng = np.random.default_rng(9231)
+    nbins = 50000
+    y = rng.poisson(20, size=nbins).astype(float)
+    mvals = rng.uniform(10, 30, size=nbins)
+
+    data = Data1D("threads", np.arange(nbins), y,
+                  staterror=np.sqrt(y + 1),
+                  syserror=np.full(nbins, 0.1))
+    model = TableModel()
+    model.load(None, mvals)
+
+    statobj = stat()
+    expected, efvec = statobj.calc_stat(data, model)
+    expected_value = statobj.calc_stat_value(data, model)
+    assert expected_value == expected
+
+    for numcores in [1, 2, 5]:
+        statobj.numcores = numcores
+        statval, fvec = statobj.calc_stat(data, model)
+        assert statval == expected
+        assert_equal(fvec, efvec)
+        assert statobj.calc_stat_value(data, model) == expected
+
+
+def test_stats_numcores_invalid():
+    """numcores can not be negative"""
+
+    data, model = setup_single(True, False)
+    statobj = Chi2()
+    statobj.numcores = -1
+    with pytest.raises(ValueError,
+                       match="^numcores must be 0 or a positive integer$"):
+        statobj.calc_stat(data, model)
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2, Chi2Gehrels, Chi2DataVar,
+                                  Chi2ModVar, Cash, CStat, UserStat])
+@pytest.mark.parametrize("usestat,usesys", [(True, True), (False, False)])
+def test_stats_calc_stat_datasets(stat, usestat, usesys):
+    """The per-dataset statistics match calc_stat for each dataset"""
+
+    if stat is Chi2 and not usestat:
+        pytest.skip("chi2 needs errors")
+
+    data, model = setup_multiple_pha(usestat, usesys, background=False)
+    if stat is UserStat:
+        def statfunc(data, model, staterror=None, syserror=None,
+                     weight=None):
+            fvec = model - data
+            return np.sum(fvec * fvec), fvec
+
+        statobj = UserStat(statfunc, np.ones_like)
+    else:
+        statobj = stat()
+
+    statval, stats, fvec = statobj.calc_stat_datasets(data, model)
+
+    expected = [statobj.calc_stat(dset, mexpr)
+                for dset, mexpr in zip(data.datasets, model.parts)]
+    assert stats == pytest.approx([e[0] for e in expected], rel=1e-15)
+    assert statval == pytest.approx(np.sum(stats), rel=1e-15)
+    assert_equal(fvec, np.concatenate([e[1] for e in expected]))
+
+    # calc_stat returns the same values.
+    total, total_fvec = statobj.calc_stat(data, model)
+    assert total == statval
+    assert_equal(total_fvec, fvec)
+    assert statobj.calc_stat_value(data, model) == statval
+
+
+def test_stats_calc_stat_datasets_wstat():
+    """The per-dataset statistics match calc_stat for each dataset"""
+
+    data, model = setup_multiple_pha(True, True, background=True)
+    statobj = WStat()
+    statval, stats, fvec = statobj.calc_stat_datasets(data, model)
+
+    expected = [statobj.calc_stat(dset, mexpr)
+                for dset, mexpr in zip(data.datasets, model.parts)]
+    assert stats == pytest.approx([e[0] for e in expected], rel=1e-15)
+    assert statval == pytest.approx(np.sum(stats), rel=1e-15)
+    assert fvec.size == 5
+    assert statobj.calc_stat_value(data, model) == statval
+
+
+@pytest.mark.parametrize("stat", [Chi2, Cash, CStat])
+def test_stats_calc_stat_datasets_numcores(stat):
+    """Many datasets: the thread count does not change the values"""
+
+    rng = np.random.default_rng(4721)
+    datasets = []
+    models = []
+    for idx, nbins in enumerate([3, 700, 1, 5000, 256, 12000]):
+        y = rng.poisson(20, size=nbins).astype(float)
+        datasets.append(Data1D(f"d{idx}", np.arange(nbins), y,
+                               staterror=np.sqrt(y + 1)))
+        mdl = TableModel(f"m{idx}")
+        mdl.load(None, rng.uniform(10, 30, size=nbins))
+        models.append(mdl)
+
+    data = DataSimulFit("simul", datasets)
+    model = SimulFitModel("simul", models)
+
+    statobj = stat()
+    expected, estats, efvec = statobj.calc_stat_datasets(data, model)
+
+    # The concatenated data gives the same answer, to rounding.
+    cdata = Data1D("all", np.arange(efvec.size),
+                   np.concatenate([d.y for d in datasets]),
+                   staterror=np.concatenate([d.staterror for d in datasets]))
+    cmodel = TableModel()
+    cmodel.load(None, np.concatenate([m.get_y() for m in models]))
+    assert expected == pytest.approx(statobj.calc_stat(cdata, cmodel)[0],
+                                     rel=1e-12)
+
+    for numcores in [1, 2, 5]:
+        statobj.numcores = numcores
+        statval, stats, fvec = statobj.calc_stat_datasets(data, model)
+        assert statval == expected
+        assert_equal(stats, estats)
+        assert_equal(fvec, efvec)
+
+
+def test_stats_calc_stat_datasets_mismatch():
+    """The native routine checks the per-dataset sizes"""
+
+    y = [np.ones(3), np.ones(4)]
+    m = [np.ones(3), np.ones(5)]
+    with pytest.raises(TypeError,
+                       match="^statistic array mismatch: data size=4 model size=5$"):
+        Cash._calc_sets(y, m, None, 1e-25)
+
+    with pytest.raises(TypeError,
+                       match="^statistic input sequences do not match$"):
+        Cash._calc_sets(y, m[:1], None, 1e-25)
+
+
+def numeric_stat_grad(statobj, data, mvals):
+    """The central-difference derivative of the statistic."""
+
+    grad = np.zeros(mvals.size)
+    for idx in range(mvals.size):
+        h = 1e-6 * max(abs(mvals[idx]), 1)
+        vals = []
+        for delta in [h, -h]:
+            mdl = TableModel()
+            mdl.load(None, mvals + delta * (np.arange(mvals.size) == idx))
+            vals.append(statobj.calc_stat(data, mdl)[0])
+
+        grad[idx] = (vals[0] - vals[1]) / (2 * h)
+
+    return grad
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2, Chi2DataVar, Chi2ModVar,
+                                  Cash, CStat])
+def test_stats_calc_stat_grad(stat):
+    """The derivative with respect to the model values"""
+
+    rng = np.random.default_rng(6723)
+    nbins = 300
+    y = rng.poisson(4, size=nbins).astype(float)
+    mvals = rng.uniform(0.3, 8, size=nbins)
+
+    # The model value is truncated for the likelihood statistics, and
+    # the variance is fixed for Chi2ModVar, when the model is small.
+    mvals[:2] = [-1, 0.2]
+
+    data = Data1D("grad", np.arange(nbins), y,
+                  staterror=np.sqrt(y + 1),
+                  syserror=rng.uniform(0, 0.5, size=nbins))
+    model = TableModel()
+    model.load(None, mvals)
+
+    statobj = stat()
+    statval, grad = statobj.calc_stat_grad(data, model)
+    assert statval == statobj.calc_stat(data, model)[0]
+    assert grad.shape == (nbins, )
+
+    expected = numeric_stat_grad(statobj, data, mvals)
+    assert grad == pytest.approx(expected, rel=1e-6, abs=1e-6)
+
+    statobj.numcores = 3
+    statval3, grad3 = statobj.calc_stat_grad(data, model)
+    assert statval3 == statval
+    assert_equal(grad3, grad)
+
+
+def test_stats_calc_stat_grad_wstat():
+    """The derivative with respect to the model values: wstat"""
+
+    rng = np.random.default_rng(1273)
+    nbins = 200
+    src = rng.poisson(3, size=nbins).astype(float)
+    bkg = rng.poisson(2, size=nbins).astype(float)
+    mvals = rng.uniform(0.3, 8, size=nbins)
+    mvals[:2] = [-1, 0]
+
+    exp_src = np.full(nbins, 1000.0)
+    exp_bkg = np.full(nbins, 2000.0)
+    bscale = rng.uniform(0.2, 2, size=nbins)
+
+    def calc(mvals):
+        return WStat._calc(src, mvals, [nbins], exp_src, exp_bkg, bkg,
+                           bscale, 1e-25)[0]
+
+    statval, grad = WStat._calc_grad(src, mvals, [nbins], exp_src, exp_bkg,
+                                     bkg, bscale, 1e-25)
+    assert statval == calc(mvals)
+
+    h = 1e-6
+    expected = []
+    for idx in range(nbins):
+        delta = h * (np.arange(nbins) == idx)
+        expected.append((calc(mvals + delta) - calc(mvals - delta)) / (2 * h))
+
+    assert grad == pytest.approx(expected, rel=1e-6, abs=1e-6)
+
+
+def test_stats_calc_stat_grad_unsupported():
+    """Statistics which replace the calculation return None"""
+
+    class MyChi2(Chi2):
+        def calc_stat(self, data, model):
+            statval, fvec = super().calc_stat(data, model)
+            return statval + 10, fvec
+
+    data, model = setup_single(True, True)
+    assert MyChi2().calc_stat_grad(data, model) is None
+    assert UserStat().calc_stat_grad(data, model) is None
+    assert Chi2().calc_stat_grad(data, model) is not None
+
+
+@pytest.mark.parametrize("stat", [Chi2, Chi2Gehrels, Chi2DataVar,
+                                  Chi2ConstVar, Chi2XspecVar])
+@pytest.mark.parametrize("usestat,usesys", [(True, True), (False, False)])
+def test_stats_prepare_chi2(stat, usestat, usesys):
+    """The prepared chi-square statistic matches calc_stat"""
+
+    if stat is Chi2 and not usestat:
+        pytest.skip("chi2 needs errors")
+
+    data, model = setup_multiple(usestat, usesys)
+    statobj = stat()
+    prepared = statobj.prepare(data, model)
+    assert isinstance(prepared, PreparedChi2)
+
+    expected, efvec = statobj.calc_stat(data, model)
+    statval, fvec = prepared.calc_stat()
+    assert statval == pytest.approx(expected, rel=1e-14)
+    assert fvec == pytest.approx(efvec, rel=1e-14)
+    assert prepared.calc_stat_value() == statval
+
+    # Only the parameter values are read on each call.
+    for mdl in model.parts:
+        mdl.thawedpars = [p * 1.1 for p in mdl.thawedpars]
+
+    expected, _ = statobj.calc_stat(data, model)
+    assert prepared.calc_stat()[0] == pytest.approx(expected, rel=1e-14)
+
+    statobj.numcores = 2
+    assert prepared.calc_stat_value() == prepared.calc_stat()[0]
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2ModVar, Cash, CStat,
+                                  UserStat])
+def test_stats_prepare_fallback(stat):
+    """Statistics with model-dependent terms are not prepared"""
+
+    data, model = setup_single(True, True)
+    statobj = stat()
+    prepared = statobj.prepare(data, model)
+    assert type(prepared) is PreparedStat
+    if stat is not UserStat:
+        assert prepared.calc_stat()[0] == statobj.calc_stat(data, model)[0]
+
+
+def test_stats_prepare_subclass():
+    """A sub-class which replaces the statistic is not prepared"""
+
+    class MyChi2(Chi2):
+        def calc_stat(self, data, model):
+            statval, fvec = super().calc_stat(data, model)
+            return statval + 10, fvec
+
+    data, model = setup_single(True, True)
+    prepared = MyChi2().prepare(data, model)
+    assert type(prepared) is PreparedStat
+    assert prepared.calc_stat()[0] == \
+        pytest.approx(Chi2().calc_stat(data, model)[0] + 10)
+
+
+def test_stats_calc_stat_value_subclass():
+    """A sub-class which replaces the statistic is respected"""
+
+    class MyChi2(Chi2):
+        def calc_stat(self, data, model):
+            statval, fvec = super().calc_stat(data, model)
+            return statval + 10, fvec
+
+    class MyCash(Cash):
+        _calc = CStat._calc
+
+    data, model = setup_single(True, True)
+
+    statobj = MyChi2()
+    expected, _ = statobj.calc_stat(data, model)
+    assert statobj.calc_stat_value(data, model) == expected
+    assert expected == pytest.approx(Chi2().calc_stat(data, model)[0] + 10)
+
+    # MyCash uses the CStat routine but does not say how to calculate
+    # just the value.
+    statobj = MyCash()
+    assert MyCash._calc_value is None
+    assert statobj.calc_stat_value(data, model) == \
+        pytest.approx(CStat().calc_stat_value(data, model))
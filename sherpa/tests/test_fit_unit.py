@@ -96,13 +96,13 @@ import numpy as np
 
 import pytest
 
-from sherpa.fit import Fit, StatInfoResults
-from sherpa.data import Data1D, Data2D, DataSimulFit
+from sherpa.fit import Fit, IterCallback, StatInfoResults
+from sherpa.data import Data1D, Data1DInt, Data2D, DataSimulFit
 from sherpa.astro.data import DataPHA
 from sherpa.astro.instrument import create_delta_rmf
 from sherpa.models.model import SimulFitModel
 from sherpa.models.basic import Const1D, Const2D, Gauss1D, Polynom1D,\
-    Scale1D, StepLo1D
+    PowLaw1D, Scale1D, SigmaGauss2D, StepLo1D
 from sherpa.utils.err import DataErr, EstErr, FitErr, StatErr
 from sherpa.utils import poisson_noise
 
@@ -110,7 +110,8 @@ from sherpa.stats import LeastSq, Chi2, Chi2Gehrels, Chi2DataVar, \
     Chi2ConstVar, Chi2ModVar, Chi2XspecVar, Likelihood, \
     Cash, CStat, WStat, UserStat
 
-from sherpa.optmethods import LevMar, NelderMead, MonCar
+from sherpa.optmethods import CMAES, LBFGSB, LevMar, NelderMead, MonCar, \
+    _saoopt
 from sherpa.estmethods import Covariance, Confidence
 
 
@@ -1679,6 +1680,57 @@ def test_fit_calc_stat_error_no_cache():
     assert f.calc_stat() == pytest.approx(ans(1.0, 1.1))
 
 
+@pytest.mark.parametrize("stat", [Chi2, Cash, UserStat])
+def test_fit_callback_value(stat):
+    """The value-only callback matches the full callback."""
+
+    if stat is UserStat:
+        def calc(data, model, staterror, syserror, weight):
+            dy = (data - model) / staterror
+            return (dy * dy).sum(), dy
+
+        statobj = UserStat(statfunc=calc)
+    else:
+        statobj = stat()
+
+    fit = setup_stat_single(statobj, True, False)
+
+    out = StringIO()
+    cb = fit._iterfit._get_callback(fh=out)
+    pars = fit.model.thawedpars
+
+    statval, _ = cb(pars)
+    assert cb.value(pars) == statval
+    assert cb.nfev == 2
+
+    lines = out.getvalue().split("\n")
+    assert lines[0].split()[1:] == lines[1].split()[1:]
+
+
+@pytest.mark.parametrize("stat", [Chi2, Chi2DataVar, Chi2ModVar, Cash])
+def test_fit_callback_prepared(stat):
+    """The callback uses the prepared statistic, which tracks the filter."""
+
+    fit = setup_stat_single(stat(), True, True)
+    cb = fit._iterfit._get_callback()
+    pars = fit.model.thawedpars
+
+    statval, fvec = cb(pars)
+    expected, efvec = fit.stat.calc_stat(fit.data, fit.model)
+    assert statval == pytest.approx(expected, rel=1e-14)
+    assert fvec == pytest.approx(efvec, rel=1e-14)
+
+    # Changing the filter requires the stored values to be updated,
+    # as done by the sigma-rejection scheme.
+    fit.data.ignore(None, 1)
+    fit._iterfit._update_fit_data()
+    expected, efvec = fit.stat.calc_stat(fit.data, fit.model)
+    statval, fvec = cb(pars)
+    assert statval == pytest.approx(expected, rel=1e-14)
+    assert fvec.size == efvec.size
+    assert cb.value(pars) == statval
+
+
 @pytest.mark.parametrize("stat", [
     LeastSq, Chi2, Chi2DataVar, Cash, CStat, WStat, UserStat
 ])
@@ -2914,7 +2966,7 @@ def test_fit_results_with_iteration_str(check_str):
                "qval           = 0.23114006377865534   # doctest: +FLOAT_CMP",
                "rstat          = 1.4322916666666667    # doctest: +FLOAT_CMP",
                "message        = successful termination",
-               "nfev           = 8"])
+               "nfev           = 4"])
 
 
 def test_fit_results_bool_true():
@@ -3354,3 +3406,284 @@ def test_repeated_model_expression(setup_ldata):
     # Just as a safety check
     assert mdl1.fwhm.val == pytest.approx(LPAR_FWHM)
     assert mdl1.ampl.val == pytest.approx(LPAR_AMPL / 2)
+
+
+@pytest.mark.parametrize("stat", [Chi2, LeastSq])
+def test_fit_levmar_analytic_jacobian(stat):
+    """LevMar uses the model derivatives and agrees with lmdif."""
+
+    x = np.linspace(-5, 5, 201)
+    y = 5 * np.exp(-0.5 * (x - 1.2)**2 / 0.8**2) + 1.3
+    y += np.random.RandomState(2371).normal(0, 0.1, x.size)
+    data = Data1D("x", x, y, staterror=np.full(x.size, 0.1))
+
+    def make_model():
+        gmdl = Gauss1D()
+        gmdl.pos = 1
+        gmdl.ampl = 4
+        return gmdl + Const1D()
+
+    mdl = make_model()
+    fit = Fit(data, mdl, stat=stat(), method=LevMar())
+    res = fit.fit()
+    assert res.succeeded
+    assert res.extra_output["njev"] > 0
+
+    # Hide the derivatives of one component so the finite
+    # difference version is used.
+    #
+    orig = make_model()
+    orig.rhs.calc_deriv = lambda *args, **kwargs: None
+    ofit = Fit(data, orig, stat=stat(), method=LevMar())
+    ores = ofit.fit()
+    assert ores.succeeded
+    assert "njev" not in ores.extra_output
+
+    assert res.nfev < ores.nfev
+    assert res.statval == pytest.approx(ores.statval, rel=1e-7)
+    assert res.parvals == pytest.approx(ores.parvals, rel=1e-4)
+
+
+@pytest.mark.parametrize("method", [LevMar, LBFGSB])
+def test_fit_sigmagauss2d(method):
+    """SigmaGauss2D does not use the Gauss2D derivatives."""
+
+    x0, x1 = np.meshgrid(np.linspace(-3, 3, 25), np.linspace(-3, 3, 25))
+    truth = SigmaGauss2D()
+    truth.sigma_a = 1.2
+    truth.sigma_b = 0.8
+    truth.xpos = 0.2
+    truth.ypos = -0.3
+    truth.ampl = 5
+    y = truth(x0.ravel(), x1.ravel())
+    data = Data2D("x", x0.ravel(), x1.ravel(), y)
+
+    mdl = SigmaGauss2D()
+    mdl.sigma_a = 1
+    mdl.sigma_b = 1
+    mdl.ampl = 4
+    res = Fit(data, mdl, stat=LeastSq(), method=method()).fit()
+    assert res.succeeded
+    assert res.statval == pytest.approx(0, abs=1e-8)
+    assert res.parvals == pytest.approx([1.2, 0.8, 0.2, -0.3, 5], rel=1e-4)
+
+
+def test_fit_levmar_modvar_no_jacobian():
+    """The model-variance statistic falls back to finite differences."""
+
+    data = Data1D("x", [1, 2, 3, 4, 5], [2, 4, 12, 3, 4])
+    fit = Fit(data, Const1D(), stat=Chi2ModVar(), method=LevMar())
+    res = fit.fit()
+    assert res.succeeded
+    assert "njev" not in res.extra_output
+
+
+@pytest.mark.parametrize("stat", [Cash, Chi2])
+def test_fit_lbfgsb_analytic_gradient(stat):
+    """LBFGSB uses the statistic gradient and agrees with simplex."""
+
+    x = np.linspace(-5, 5, 201)
+    y = 5 * np.exp(-0.5 * (x - 1.2)**2 / 0.8**2) + 1.3
+    y = np.random.RandomState(8123).poisson(y).astype(float)
+    data = Data1D("x", x, y, staterror=np.sqrt(y + 1))
+
+    def make_model():
+        gmdl = Gauss1D()
+        gmdl.pos = 1
+        gmdl.ampl = 4
+        return gmdl + Const1D()
+
+    mdl = make_model()
+    res = Fit(data, mdl, stat=stat(), method=LBFGSB()).fit()
+    assert res.succeeded
+
+    # Hide the derivatives of one component so the finite
+    # difference version is used.
+    #
+    orig = make_model()
+    orig.rhs.calc_deriv = lambda *args, **kwargs: None
+    ores = Fit(data, orig, stat=stat(), method=LBFGSB()).fit()
+    assert ores.succeeded
+    assert res.nfev < ores.nfev
+
+    smdl = make_model()
+    sres = Fit(data, smdl, stat=stat(), method=NelderMead()).fit()
+    assert res.statval == pytest.approx(sres.statval, rel=1e-6)
+    assert res.parvals == pytest.approx(sres.parvals, rel=1e-3)
+
+
+@pytest.fixture
+def setup_pgdata():
+    """Create the data for the power-law plus gaussian tests."""
+
+    x = np.linspace(1, 100, 200)
+    y = 2000 * x**-1.5 + 40 * np.exp(-4 * np.log(2) * (x - 40)**2 / 25)
+    y = np.random.RandomState(8123).poisson(y).astype(float)
+    return Data1D("x", x, y, staterror=np.sqrt(np.maximum(y, 1)))
+
+
+# The best-fit statistic for setup_pgdata
+PG_STAT = 183.8026
+
+
+def test_fit_lbfgsb_unequal_scales(setup_pgdata):
+    """LBFGSB handles parameters with very different sizes.
+
+    The first step used to move each parameter by the same amount, so
+    the gaussian was driven to a very small FWHM.
+    """
+
+    def make_model():
+        pmdl = PowLaw1D()
+        pmdl.ampl = 1000
+        gmdl = Gauss1D()
+        gmdl.pos = 38
+        gmdl.fwhm = 8
+        gmdl.ampl = 10
+        return pmdl + gmdl
+
+    data = setup_pgdata
+    res = Fit(data, make_model(), stat=Chi2(), method=LBFGSB()).fit()
+    lres = Fit(data, make_model(), stat=Chi2(), method=LevMar()).fit()
+
+    assert res.succeeded
+    assert lres.succeeded
+    assert lres.statval == pytest.approx(PG_STAT, rel=1e-6)
+    assert res.statval == pytest.approx(lres.statval, rel=1e-6)
+    assert res.parvals == pytest.approx(lres.parvals, rel=1e-3)
+
+
+def test_fit_cmaes_restarts(setup_pgdata):
+    """CMAES finds the same minimum as MonCar from a poor start.
+
+    The restarts used to begin at the starting point, where the
+    gaussian is far from the line, and all stopped at a local
+    minimum.
+    """
+
+    data = setup_pgdata
+    res = Fit(data, PowLaw1D() + Gauss1D(), stat=Chi2(),
+              method=CMAES()).fit()
+    mres = Fit(data, PowLaw1D() + Gauss1D(), stat=Chi2(),
+               method=MonCar()).fit()
+
+    assert res.succeeded
+    assert mres.succeeded
+    assert mres.statval == pytest.approx(PG_STAT, rel=1e-6)
+    assert res.statval == pytest.approx(mres.statval, rel=1e-6)
+    assert res.parvals == pytest.approx(mres.parvals, rel=1e-3)
+
+
+def test_fit_moncar_generational_numcores():
+    """The generational MonCar fit does not depend on numcores."""
+
+    x = np.linspace(-5, 5, 51)
+    y = 5 * np.exp(-0.5 * (x - 1.2)**2 / 0.8**2) + 1.3
+    data = Data1D("x", x, y)
+
+    def fit(numcores):
+        gmdl = Gauss1D()
+        gmdl.pos = 1
+        gmdl.pos.min = -5
+        gmdl.pos.max = 5
+        gmdl.ampl = 4
+        gmdl.ampl.min = 0
+        gmdl.ampl.max = 10
+        gmdl.fwhm.max = 10
+        cmdl = Const1D()
+        cmdl.c0.max = 10
+        method = MonCar()
+        method.generational = True
+        method.numcores = numcores
+        method.maxfev = 2000
+        return Fit(data, gmdl + cmdl, stat=LeastSq(), method=method).fit()
+
+    expected = fit(1)
+    got = fit(2)
+
+    assert got.statval == expected.statval
+    assert got.parvals == expected.parvals
+    assert got.nfev == expected.nfev
+    assert got.statval == pytest.approx(0, abs=1e-6)
+
+
+def make_plan_data(integrated):
+    """A power law and gaussian dataset for the fit plan tests."""
+
+    x = np.linspace(1, 100, 200)
+    y = 2000 * x**-1.5 + 40 * np.exp(-4 * np.log(2) * (x - 40)**2 / 25)
+    y = np.random.RandomState(8123).poisson(y).astype(float)
+    staterror = np.sqrt(np.maximum(y, 1))
+    if integrated:
+        return Data1DInt("x", x - 0.25, x + 0.25, y, staterror=staterror)
+
+    return Data1D("x", x, y, staterror=staterror)
+
+
+def make_plan_model():
+    gmdl = Gauss1D()
+    gmdl.pos = 35
+    gmdl.fwhm = 4
+    gmdl.ampl = 30
+    return PowLaw1D() + gmdl
+
+
+@pytest.mark.parametrize("integrated", [False, True])
+@pytest.mark.parametrize("stat", [Chi2, Cash, CStat])
+def test_fit_native_plan(integrated, stat, monkeypatch):
+    """A fit of compiled models is made without calling back to Python.
+
+    The result matches the fit made with the callback.
+    """
+
+    data = make_plan_data(integrated)
+    fit = Fit(data, make_plan_model(), stat=stat(), method=NelderMead())
+
+    fit.model.startup()
+    native = fit._iterfit._get_callback().native()
+    fit.model.teardown()
+    assert _saoopt.native_size(native) == 200
+
+    res = fit.fit()
+
+    monkeypatch.setattr(IterCallback, "native",
+                        lambda self, numcores=1: None)
+    expected = Fit(data, make_plan_model(), stat=stat(),
+                   method=NelderMead()).fit()
+
+    assert res.succeeded
+    assert res.statval == pytest.approx(expected.statval, rel=1e-10)
+    assert res.parvals == pytest.approx(expected.parvals, rel=1e-10)
+
+
+def test_fit_native_plan_linked():
+    """A parameter linked to another parameter can be used."""
+
+    data = make_plan_data(False)
+    g1 = Gauss1D("g1")
+    g2 = Gauss1D("g2")
+    g2.fwhm = g1.fwhm
+    g2.pos = 60
+    g2.pos.freeze()
+    fit = Fit(data, PowLaw1D() + g1 + g2, stat=Chi2(), method=NelderMead())
+    assert fit._iterfit._get_callback().native() is not None
+
+    g2.pos = g1.pos + 20
+    assert fit._iterfit._get_callback().native() is None
+
+
+@pytest.mark.parametrize("stat", [LeastSq, Chi2ModVar])
+def test_fit_native_plan_unsupported_stat(stat):
+    """The statistic must be supported by the fit plan."""
+
+    fit = Fit(make_plan_data(False), make_plan_model(), stat=stat(),
+              method=NelderMead())
+    assert fit._iterfit._get_callback().native() is None
+
+
+def test_fit_native_plan_outfile():
+    """There is no fit plan when the parameters are written out."""
+
+    fit = Fit(make_plan_data(False), make_plan_model(), stat=Chi2(),
+              method=NelderMead())
+    assert fit._iterfit._get_callback(fh=StringIO()).native() is None
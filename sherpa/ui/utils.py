@@ -2295,7 +2295,8 @@ class Session(NoNewAttributesAfterInit):
         --------
 
         >>> list_methods()
-        ['gridsearch', 'levmar', 'moncar', 'neldermead', 'simplex']
+        ['cmaes', 'gridsearch', 'lbfgsb', 'levmar', 'moncar', 'neldermead',
+         'neldermeadmultistart', 'simplex']
 
         """
         keys = list(self._methods.keys())
@@ -2432,6 +2433,16 @@ class Session(NoNewAttributesAfterInit):
         -----
         The available methods include:
 
+        ``cmaes``
+           The covariance matrix adaptation evolution strategy, with
+           restarts of increasing population size [5]. It is a global
+           method which adapts to correlated parameters.
+
+        ``lbfgsb``
+           A limited-memory quasi-Newton method for problems with
+           parameter limits, based on [4]. It does not require the
+           statistic to be a sum of squares.
+
         ``levmar``
            The Levenberg-Marquardt method is an interface to the
            MINPACK subroutine lmdif to find the local minimum of
@@ -2445,6 +2456,11 @@ class Session(NoNewAttributesAfterInit):
            The implementation of the Nelder Mead Simplex direct search
            is based on [3].
 
+        ``neldermeadmultistart``
+           Several ``neldermead`` searches, started from a
+           Latin-hypercube sample of the parameter limits, returning
+           the best result.
+
         ``simplex``
            This is another name for ``neldermead``.
 
@@ -2466,6 +2482,16 @@ class Session(NoNewAttributesAfterInit):
            Simplex Algorithm in Low Dimensions", SIAM Journal on
            Optimization,Vol. 9, No. 1 (1998), pages 112-147.
 
+        4. R. H. Byrd, P. Lu, J. Nocedal and C. Zhu, "A Limited
+           Memory Algorithm for Bound Constrained Optimization", SIAM
+           Journal on Scientific Computing, Vol. 16, No. 5 (1995),
+           pages 1190-1208.
+
+        5. A. Auger and N. Hansen, "A Restart CMA Evolution Strategy
+           With Increasing Population Size", Proceedings of the IEEE
+           Congress on Evolutionary Computation (2005), pages
+           1769-1776.
+
         Examples
         --------
 
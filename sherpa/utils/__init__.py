@@ -2603,6 +2603,27 @@ class FuncCounter(Generic[T]):
         return self.func(*args)
 
 
+def stat_value_func(fcn: Callable) -> Callable[[np.ndarray], float]:
+    """Return a function that evaluates just the statistic value.
+
+    The statistic callbacks sent to the optimizers and error
+    estimators return both the statistic and the per-bin values. When
+    the callback provides a ``value`` method, as the callback used by
+    `sherpa.fit.Fit` does, it is used so that the per-bin values are
+    not calculated.
+
+    """
+
+    value = getattr(fcn, "value", None)
+    if callable(value):
+        return value
+
+    def stat_cb0(pars):
+        return fcn(pars)[0]
+
+    return stat_cb0
+
+
 def func_counter(func):
     """DEPRECATED.
 
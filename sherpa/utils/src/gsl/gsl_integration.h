@@ -184,6 +184,12 @@ int sao_integration_qng (int (*f)(double *x, int len, void *params),
 			 double epsabs, double epsrel,
 			 double * result, double * abserr, size_t * neval);
 
+void sao_integration_qk21_nodes (double a, double b, double * x);
+
+int sao_integration_qk21 (double a, double b, const double * fv,
+                          double epsabs, double epsrel,
+                          double * result, double * abserr);
+
 int gsl_integration_qag (const gsl_function * f,
                          double a, double b,
                          double epsabs, double epsrel, size_t limit,
@@ -398,3 +398,96 @@ sao_integration_qng (int (*f)(double *x, int len, void *params),
 
   GSL_ERROR("failed to reach tolerance with highest-order rule", GSL_ETOL) ;
 }
+
+/* The first (21-point) stage of sao_integration_qng split into two
+   parts, so that the nodes of many intervals can be evaluated with a
+   single call to the integrand. sao_integration_qk21_nodes fills x
+   with the 21 abscissae in the order used by sao_integration_qng, and
+   sao_integration_qk21 calculates the result and error estimate from
+   the function values at these nodes. The return value is GSL_SUCCESS
+   when the tolerance is met and GSL_ETOL otherwise; the error handler
+   is not called. */
+
+void
+sao_integration_qk21_nodes (double a, double b, double * x)
+{
+  const double half_length =  0.5 * (b - a);
+  const double center = 0.5 * (b + a);
+  int k;
+
+  x[0] = center;
+  for (k = 0; k < 5; k++)
+    {
+      double abscissa = half_length * x1[k];
+      x[2*k+1] = center + abscissa;
+      x[2*k+2] = center - abscissa;
+
+      abscissa = half_length * x2[k];
+      x[2*k+11] = center + abscissa;
+      x[2*k+12] = center - abscissa;
+    }
+}
+
+int
+sao_integration_qk21 (double a, double b, const double * fv,
+                      double epsabs, double epsrel,
+                      double * result, double * abserr)
+{
+  double res10, res21, resabs, resasc, result_kronrod, err;
+
+  const double half_length =  0.5 * (b - a);
+  const double abs_half_length = fabs (half_length);
+  const double f_center = fv[0];
+  int k;
+
+  res10 = 0;
+  res21 = w21b[5] * f_center;
+  resabs = w21b[5] * fabs (f_center);
+
+  for (k = 0; k < 5; k++)
+    {
+      const double fval1 = fv[2*k+1];
+      const double fval2 = fv[2*k+2];
+      const double fval = fval1 + fval2;
+      res10 += w10[k] * fval;
+      res21 += w21a[k] * fval;
+      resabs += w21a[k] * (fabs (fval1) + fabs (fval2));
+    }
+
+  for (k = 0; k < 5; k++)
+    {
+      const double fval1 = fv[2*k+11];
+      const double fval2 = fv[2*k+12];
+      const double fval = fval1 + fval2;
+      res21 += w21b[k] * fval;
+      resabs += w21b[k] * (fabs (fval1) + fabs (fval2));
+    }
+
+  resabs *= abs_half_length ;
+
+  {
+    const double mean = 0.5 * res21;
+
+    resasc = w21b[5] * fabs (f_center - mean);
+
+    for (k = 0; k < 5; k++)
+      {
+        resasc +=
+          (w21a[k] * (fabs (fv[2*k+1] - mean) + fabs (fv[2*k+2] - mean))
+          + w21b[k] * (fabs (fv[2*k+11] - mean) + fabs (fv[2*k+12] - mean)));
+      }
+    resasc *= abs_half_length ;
+  }
+
+  result_kronrod = res21 * half_length;
+
+  err = rescale_error ((res21 - res10) * half_length, resabs, resasc) ;
+
+  * result = result_kronrod ;
+  * abserr = err ;
+
+  if (err < epsabs || err < epsrel * fabs (result_kronrod))
+    return GSL_SUCCESS;
+
+  return GSL_ETOL;
+}
@@ -20,8 +20,10 @@
 #define _INTEGRATIONMODULE
 #include <Python.h>
 #include "sherpa/integration.hh"
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
 #include "gsl_errno.h"
 #include "gsl_integration.h"
 #include "adapt_integrate.h"
@@ -33,12 +35,46 @@ extern "C" {
 
 namespace sherpa { namespace integration {
 
-  static int gsl_int_flag = 1;
-  static int sao_int_flag = 1;
-  
+  //
+  // Count the calls made by adapt_integrate, which does not report
+  // the number of function evaluations.
+  //
+  struct CountedIntegrand {
+    integrand_Nd fct;
+    void* params;
+    unsigned long neval;
+  };
+
+  static double counted_integrand( unsigned int ndim, const double* x,
+				   void* params )
+  {
+    CountedIntegrand* counted = static_cast< CountedIntegrand* >( params );
+    ++counted->neval;
+    return counted->fct( ndim, x, counted->params );
+  }
+
+  struct CountedIntegrandVec {
+    integrand_Nd_vec fct;
+    void* params;
+    unsigned long neval;
+  };
+
+  static int counted_integrand_vec( unsigned int ndim, unsigned int npt,
+				    const double* x, void* params,
+				    double* fval )
+  {
+    CountedIntegrandVec* counted =
+      static_cast< CountedIntegrandVec* >( params );
+    counted->neval += npt;
+    return counted->fct( ndim, npt, x, counted->params, fval );
+  }
+
+  // The number of boxes sent to the integrand together by
+  // integrate_Nd_image; each uses 17 points in two dimensions.
+  static const int IMAGE_BATCHSIZE = 64;
+
   int integrate_1d( integrand_1d fct, void* params,
-		    double xlo, double xhi,
-		    unsigned int maxeval, double epsabs, double epsrel,
+		    double xlo, double xhi, Context& ctx,
 		    double& result, double& abserr )
   {
 
@@ -50,38 +86,28 @@ namespace sherpa { namespace integration {
     func.function = fct;
     func.params = params;
 
-    size_t neval = size_t( maxeval );
+    size_t neval = 0;
 
-    gsl_set_error_handler_off ();
- 
-    retval = gsl_integration_qng( &func, xlo, xhi, epsabs, epsrel, &result,
-				  &abserr, &neval );
-    
-    if (retval != EXIT_SUCCESS) {
-      if( gsl_int_flag ) {
-	std::cerr << "WARNING: Gauss-Kronrod integration failed "
-		  << "with tolerance " << epsabs << ", trying lower tolerance..."
-		  << std::endl;
-	
-	double tol = std::numeric_limits< float >::epsilon();
-	retval = gsl_integration_qng( &func, xlo, xhi, tol, epsrel, &result,
-				      &abserr, &neval );
-	
-	if (retval != EXIT_SUCCESS) {
-	  std::cerr << "integration failed with tolerance " << tol
-		    << ", resorting to trapezoid method"
-		    << std::endl;
-
-	  result = 0.5 * ( xhi - xlo ) * ( fct( xlo, params) + fct( xhi, params) );
-	}
-	else {
-	  std::cerr << "integration succeeded with tolerance " << tol
-		    << std::endl;
-	}
-	gsl_int_flag = 0;
-      }      
+    retval = gsl_integration_qng( &func, xlo, xhi, ctx.epsabs, ctx.epsrel,
+				  &result, &abserr, &neval );
+    ctx.neval += neval;
+
+    if ( retval != EXIT_SUCCESS ) {
+      ++ctx.nfail;
+
+      double tol = std::numeric_limits< float >::epsilon();
+      neval = 0;
+      retval = gsl_integration_qng( &func, xlo, xhi, tol, ctx.epsrel,
+				    &result, &abserr, &neval );
+      ctx.neval += neval;
+
+      if ( retval != EXIT_SUCCESS ) {
+	++ctx.ntrapezoid;
+	ctx.neval += 2;
+	result = 0.5 * ( xhi - xlo ) * ( fct( xlo, params) + fct( xhi, params) );
+      }
     }
-    
+
     return EXIT_SUCCESS;
 
   }
@@ -89,26 +115,109 @@ namespace sherpa { namespace integration {
 
   int integrate_Nd( integrand_Nd fct, void* params,
                     unsigned int ndim, const double* xlo, const double* xhi,
-                    unsigned int maxeval, double epsabs, double epsrel,
-                    double& result, double& abserr )
+                    Context& ctx, double& result, double& abserr )
   {
 
     if ( NULL == fct || NULL == xlo || NULL == xhi )
       return EXIT_FAILURE;
 
-    if ( 0 != adapt_integrate( fct, params, ndim, xlo, xhi, maxeval,
-			       epsabs, epsrel, &result, &abserr ) )
+    CountedIntegrand counted = { fct, params, 0 };
+    int retval = adapt_integrate( counted_integrand, &counted, ndim, xlo, xhi,
+				  ctx.maxeval, ctx.epsabs, ctx.epsrel,
+				  &result, &abserr );
+    ctx.neval += counted.neval;
+
+    if ( 0 != retval ) {
+      ++ctx.nfail;
       return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 
   }
 
+  int integrate_Nd_vec( integrand_Nd_vec fct, void* params,
+			unsigned int ndim, const double* xlo,
+			const double* xhi, Context& ctx,
+			double& result, double& abserr )
+  {
+
+    if ( NULL == fct || NULL == xlo || NULL == xhi )
+      return EXIT_FAILURE;
+
+    CountedIntegrandVec counted = { fct, params, 0 };
+    int retval = adapt_integrate_v( counted_integrand_vec, &counted, ndim,
+				    xlo, xhi, ctx.maxeval, ctx.epsabs,
+				    ctx.epsrel, &result, &abserr );
+    ctx.neval += counted.neval;
+
+    if ( 0 != retval ) {
+      ++ctx.nfail;
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
+  int integrate_Nd_image( integrand_Nd_vec fct, void* params,
+			  unsigned int ndim, int npix,
+			  const double* xlo, const double* xhi,
+			  Context& ctx, double* result )
+  {
+
+    if ( NULL == fct || NULL == xlo || NULL == xhi || ndim < 2 )
+      return EXIT_FAILURE;
+
+    CountedIntegrandVec counted = { fct, params, 0 };
+    std::vector< double > abserr( IMAGE_BATCHSIZE );
+    int status = EXIT_SUCCESS;
+
+    for ( int start = 0; start < npix; start += IMAGE_BATCHSIZE ) {
+
+      int nbatch = std::min( IMAGE_BATCHSIZE, npix - start );
+      const double* lo = xlo + std::size_t( start ) * ndim;
+      const double* hi = xhi + std::size_t( start ) * ndim;
+
+      if ( 0 != adapt_integrate_rule_v( counted_integrand_vec, &counted,
+					ndim, nbatch, lo, hi,
+					result + start, &abserr[0] ) ) {
+	status = EXIT_FAILURE;
+	break;
+      }
+
+      // The same test as the adaptive integration makes after its
+      // first step.
+      for ( int ii = 0; ii < nbatch; ii++ ) {
+	double val = result[ start + ii ];
+	double err = abserr[ ii ];
+	if ( err <= ctx.epsabs ||
+	     ( 0.0 != val && std::fabs( err / val ) <= ctx.epsrel ) )
+	  continue;
+
+	double ignore;
+	if ( EXIT_SUCCESS != integrate_Nd_vec( fct, params, ndim,
+					       lo + ii * ndim, hi + ii * ndim,
+					       ctx, result[ start + ii ],
+					       ignore ) ) {
+	  status = EXIT_FAILURE;
+	  break;
+	}
+      }
+
+      if ( EXIT_SUCCESS != status )
+	break;
+
+    }
+
+    ctx.neval += counted.neval;
+    return status;
+
+  }
+
   int py_integrate_1d( integrand_1d_vec fct, void* params,
-		       const double xlo, const double xhi,
-		       unsigned int maxeval, double epsabs, double epsrel,
-		       double &result, double& abserr, int errflag,
-		       std::ostringstream& err)
+		       const double xlo, const double xhi, Context& ctx,
+		       double &result, double& abserr )
   {
 
     if ( NULL == fct )
@@ -116,52 +225,96 @@ namespace sherpa { namespace integration {
 
     int retval;
 
-    size_t neval = size_t( maxeval );
+    size_t neval = 0;
+
+    retval = sao_integration_qng( fct, xlo, xhi, params, ctx.epsabs,
+				  ctx.epsrel, &result, &abserr, &neval );
+    ctx.neval += neval;
 
-    gsl_set_error_handler_off ();
- 
-    retval = sao_integration_qng( fct, xlo, xhi, params, epsabs, epsrel,
-				  &result, &abserr, &neval );
-    
     if (retval == -1) {
       return EXIT_FAILURE;
     }
-    
+
     if (retval != EXIT_SUCCESS) {
-      if (sao_int_flag) {
-	err << "Gauss-Kronrod integration failed "
-	    << "with tolerance " << epsabs << ", trying lower tolerance...";
-	
-	double tol = std::numeric_limits< float >::epsilon();
-	retval = sao_integration_qng( fct, xlo, xhi, params, tol, epsrel,
-				      &result, &abserr, &neval );
-	
-	if (retval != EXIT_SUCCESS) {
-	  err << std::endl << "integration failed with tolerance " << tol
-	      << ", resorting to trapezoid method";
-
-	  
-	  double loval[1], hival[1];
-	  loval[0] = xlo;
-	  hival[0] = xhi;
-	  if (-1 == fct(loval, 1, params) )
-	    return EXIT_FAILURE;
-	  
-	  if (-1 == fct(hival, 1, params) )
-	    return EXIT_FAILURE;
-	  
-	  result = 0.5 * ( xhi - xlo ) * ( loval[0] + hival[0] );
-	}
-	else {
-	  err << std::endl << "integration succeeded with tolerance " << tol;
-	}
+      ++ctx.nfail;
+
+      double tol = std::numeric_limits< float >::epsilon();
+      neval = 0;
+      retval = sao_integration_qng( fct, xlo, xhi, params, tol, ctx.epsrel,
+				    &result, &abserr, &neval );
+      ctx.neval += neval;
+
+      if (retval == -1) {
+	return EXIT_FAILURE;
+      }
+
+      if (retval != EXIT_SUCCESS) {
+	++ctx.ntrapezoid;
+
+	double loval[1], hival[1];
+	loval[0] = xlo;
+	hival[0] = xhi;
+	if (-1 == fct(loval, 1, params) )
+	  return EXIT_FAILURE;
+
+	if (-1 == fct(hival, 1, params) )
+	  return EXIT_FAILURE;
+
+	ctx.neval += 2;
+	result = 0.5 * ( xhi - xlo ) * ( loval[0] + hival[0] );
       }
-      sao_int_flag=0;
     }
     return EXIT_SUCCESS;
-    
+
   }
-    
+
+  int py_integrate_1d_batch( integrand_1d_vec fct, void* params,
+			     const double* xlo, const double* xhi,
+			     int nbins, int batchsize, Context& ctx,
+			     double* result )
+  {
+
+    if ( NULL == fct )
+      return EXIT_FAILURE;
+
+    if ( batchsize < 1 || batchsize > nbins )
+      batchsize = nbins;
+
+    std::vector< double > fv( 21 * std::size_t( batchsize ) );
+
+    for ( int start = 0; start < nbins; start += batchsize ) {
+
+      int nbatch = std::min( batchsize, nbins - start );
+      for ( int ii = 0; ii < nbatch; ii++ )
+	sao_integration_qk21_nodes( xlo[ start + ii ], xhi[ start + ii ],
+				    &fv[ 21 * ii ] );
+
+      // The integrand replaces the nodes with the function values.
+      if ( EXIT_SUCCESS != fct( &fv[0], 21 * nbatch, params ) )
+	return EXIT_FAILURE;
+      ctx.neval += 21 * nbatch;
+
+      for ( int ii = 0; ii < nbatch; ii++ ) {
+	int bin = start + ii;
+	double abserr;
+	if ( GSL_SUCCESS == sao_integration_qk21( xlo[ bin ], xhi[ bin ],
+						  &fv[ 21 * ii ],
+						  ctx.epsabs, ctx.epsrel,
+						  &result[ bin ], &abserr ) )
+	  continue;
+
+	if ( EXIT_SUCCESS != py_integrate_1d( fct, params, xlo[ bin ],
+					      xhi[ bin ], ctx, result[ bin ],
+					      abserr ) )
+	  return EXIT_FAILURE;
+      }
+
+    }
+
+    return EXIT_SUCCESS;
+
+  }
+
 }  }  /* namespace integration, namespace sherpa */
 
 static struct PyModuleDef integration = {
@@ -174,14 +327,22 @@ static struct PyModuleDef integration = {
 
 PyMODINIT_FUNC PyInit_integration(void) {
 
-  static void *Integration_API[3];
+  static void *Integration_API[6];
   Integration_API[0] = (void*)sherpa::integration::integrate_1d;
   Integration_API[1] = (void*)sherpa::integration::integrate_Nd;
   Integration_API[2] = (void*)sherpa::integration::py_integrate_1d;
+  Integration_API[3] = (void*)sherpa::integration::py_integrate_1d_batch;
+  Integration_API[4] = (void*)sherpa::integration::integrate_Nd_vec;
+  Integration_API[5] = (void*)sherpa::integration::integrate_Nd_image;
 
   PyObject *m;
   PyObject *api_cobject;
 
+  // The default GSL handler aborts; the routines check the status
+  // codes instead. This is process-wide, so set it once here rather
+  // than on every call.
+  gsl_set_error_handler_off();
+
   if ( NULL == ( m = PyModule_Create( &integration ) ) )
     return NULL;
 
@@ -23,6 +23,7 @@
  *
  */
 
+#include <string.h>
 #include "adapt_integrate.h"
 
 /* Adaptive multidimensional integration on hypercubes (or, really,
@@ -433,6 +434,95 @@ static rule *make_rule75genzmalik(unsigned dim)
      return (rule *) r;
 }
 
+/* The points of the Genz-Malik rule for the hypercube h, in the
+   order used by rule75genzmalik_sum: the center, the four points
+   (lambda2, lambda4) along each axis, the four points (lambda4,
+   lambda4) of each pair of axes and the 2^dim corners at lambda5.
+   pts must have room for num_points * dim values. */
+static void rule75genzmalik_points(const rule *r, const hypercube *h,
+				   double *pts)
+{
+     const double lambda2 = 0.3585685828003180919906451539079374954541;
+     const double lambda4 = 0.9486832980505137995996680633298155601160;
+     const double lambda5 = 0.6882472016116852977216287342936235251269;
+
+     unsigned i, j, k, dim = r->dim;
+     const double *c = h->data;
+     const double *w = h->data + dim;
+     const double sgn[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+     double *p = pts;
+
+     memcpy(p, c, sizeof(double) * dim);
+     p += dim;
+
+     for (i = 0; i < dim; ++i) {
+	  const double offset[4] = { -lambda2, lambda2, -lambda4, lambda4 };
+	  for (k = 0; k < 4; ++k, p += dim) {
+	       memcpy(p, c, sizeof(double) * dim);
+	       p[i] += offset[k] * w[i];
+	  }
+     }
+
+     for (i = 0; i < dim - 1; ++i)
+	  for (j = i + 1; j < dim; ++j)
+	       for (k = 0; k < 4; ++k, p += dim) {
+		    memcpy(p, c, sizeof(double) * dim);
+		    p[i] += sgn[k][0] * lambda4 * w[i];
+		    p[j] += sgn[k][1] * lambda4 * w[j];
+	       }
+
+     for (k = 0; k < (1U << dim); ++k, p += dim)
+	  for (i = 0; i < dim; ++i)
+	       p[i] = c[i] + ((k >> i) & 1 ? -lambda5 : lambda5) * w[i];
+}
+
+/* Apply the Genz-Malik rule to the function values fv at the points
+   from rule75genzmalik_points; this is rule75genzmalik_evalError
+   without the function calls. */
+static unsigned rule75genzmalik_sum(const rule *r_, const hypercube *h,
+				    const double *fv, esterr *ee)
+{
+     const double lambda2 = 0.3585685828003180919906451539079374954541;
+     const double lambda4 = 0.9486832980505137995996680633298155601160;
+     const double weight2 = 980. / 6561.;
+     const double weight4 = 200. / 19683.;
+     const double weightE2 = 245. / 486.;
+     const double weightE4 = 25. / 729.;
+     const double ratio = (lambda2 * lambda2) / (lambda4 * lambda4);
+
+     const rule75genzmalik *r = (const rule75genzmalik *) r_;
+     unsigned i, n, dimDiffMax = 0, dim = r_->dim;
+     double sum1, sum2 = 0, sum3 = 0, sum4 = 0, sum5 = 0, maxdiff = 0;
+     double result, res5th;
+
+     sum1 = *fv++;
+
+     for (i = 0; i < dim; ++i, fv += 4) {
+	  double diff = fabs(fv[0] + fv[1] - 2 * sum1
+			     - ratio * (fv[2] + fv[3] - 2 * sum1));
+	  sum2 += fv[0] + fv[1];
+	  sum3 += fv[2] + fv[3];
+	  if (diff > maxdiff) {
+	       maxdiff = diff;
+	       dimDiffMax = i;
+	  }
+     }
+
+     for (n = numRR0_0fs(dim); n > 0; --n)
+	  sum4 += *fv++;
+
+     for (n = numR_Rfs(dim); n > 0; --n)
+	  sum5 += *fv++;
+
+     result = h->vol * (r->weight1 * sum1 + weight2 * sum2 + r->weight3 * sum3 + weight4 * sum4 + r->weight5 * sum5);
+     res5th = h->vol * (r->weightE1 * sum1 + weightE2 * sum2 + r->weightE3 * sum3 + weightE4 * sum4);
+
+     ee->val = result;
+     ee->err = fabs(res5th - result);
+
+     return dimDiffMax;
+}
+
 /***************************************************************************/
 /* 1d 15-point Gaussian quadrature rule, based on qk15.c and qk.c in
    GNU GSL (which in turn is based on QUADPACK). */
@@ -697,6 +787,174 @@ static int ruleadapt_integrate(rule *r, integrand f, void *fdata, const hypercub
      return status;
 }
 
+/* The adaptive integration with a vectorized integrand. Instead of
+   splitting only the worst region on each iteration, the worst
+   regions are split until the error of the remaining regions meets
+   the tolerance, and the points of all the new regions are sent to
+   the integrand in a single call. */
+
+/* Evaluate the nR regions in R with a single call to f, using (and
+   growing as needed) the buffers pts and fv of *nbuf points. */
+static int eval_regions_v(rule *r, integrand_v f, void *fdata,
+			  region *R, unsigned nR,
+			  double **pts, double **fv, unsigned *nbuf)
+{
+     unsigned i, npts = r->num_points, dim = r->dim;
+
+     if (nR * npts > *nbuf) {
+	  *nbuf = nR * npts;
+	  *pts = (double *) realloc(*pts, sizeof(double) * dim * *nbuf);
+	  *fv = (double *) realloc(*fv, sizeof(double) * *nbuf);
+	  if (!*pts || !*fv)
+	       return -1;
+     }
+
+     for (i = 0; i < nR; ++i)
+	  rule75genzmalik_points(r, &R[i].h, *pts + i * npts * dim);
+
+     if (f(dim, nR * npts, *pts, fdata, *fv))
+	  return -1;
+
+     for (i = 0; i < nR; ++i)
+	  R[i].splitDim = rule75genzmalik_sum(r, &R[i].h, *fv + i * npts,
+					      &R[i].ee);
+     return 0;
+}
+
+static int ruleadapt_integrate_v(rule *r, integrand_v f, void *fdata, const hypercube *h, unsigned maxEval, double reqAbsError, double reqRelError, esterr *ee)
+{
+     unsigned npts = r->num_points;
+     unsigned nR = 1, nalloc = 2, nbuf = 0, neval = 0, i;
+     double *pts = 0, *fv = 0;
+     region *R;
+     heap regions;
+     int status = -1; /* = ERROR */
+
+     if (maxEval && npts > maxEval)
+	  return status;	/* ERROR */
+
+     regions = heap_alloc(1);
+     R = (region *) malloc(sizeof(region) * nalloc);
+     R[0] = make_region(h);
+
+     for (;;) {
+	  double tol;
+
+	  if (eval_regions_v(r, f, fdata, R, nR, &pts, &fv, &nbuf))
+	       break;
+	  neval += nR * npts;
+	  for (i = 0; i < nR; ++i)
+	       heap_push(&regions, R[i]);
+	  nR = 0;
+
+	  if (regions.ee.err <= reqAbsError
+	      || relError(regions.ee) <= reqRelError) {
+	       status = 0; /* converged! */
+	       break;
+	  }
+
+	  tol = fabs(regions.ee.val) * reqRelError;
+	  if (tol < reqAbsError)
+	       tol = reqAbsError;
+
+	  /* split the worst regions while the budget allows it */
+	  do {
+	       if (maxEval && neval + (nR + 2) * npts > maxEval)
+		    break;
+	       if (nR + 2 > nalloc) {
+		    nalloc *= 2;
+		    R = (region *) realloc(R, sizeof(region) * nalloc);
+	       }
+	       R[nR] = heap_pop(&regions);
+	       cut_region(&R[nR], &R[nR + 1]);
+	       nR += 2;
+	  } while (regions.n > 0 && regions.ee.err > tol);
+
+	  if (nR == 0)
+	       break;	/* out of evaluations */
+     }
+
+     ee->val = ee->err = 0;  /* re-sum integral and errors */
+     for (i = 0; i < regions.n; ++i) {
+	  ee->val += regions.items[i].ee.val;
+	  ee->err += regions.items[i].ee.err;
+	  destroy_region(&regions.items[i]);
+     }
+     for (i = 0; i < nR; ++i)
+	  destroy_region(&R[i]);
+     heap_free(&regions);
+     free(R);
+     free(pts);
+     free(fv);
+
+     return status;
+}
+
+int adapt_integrate_v(integrand_v f, void *fdata,
+		      unsigned dim, const double *xmin, const double *xmax,
+		      unsigned maxEval, double reqAbsError, double reqRelError,
+		      double *val, double *estimated_error)
+{
+     rule *r;
+     hypercube h;
+     esterr ee;
+     int status;
+     ee.err = 0;
+     ee.val = 0;
+
+     /* only the Genz-Malik rule is vectorized */
+     if (dim < 2)
+	  return -1;
+
+     r = make_rule75genzmalik(dim);
+     h = make_hypercube_range(dim, xmin, xmax);
+     status = ruleadapt_integrate_v(r, f, fdata, &h,
+				    maxEval, reqAbsError, reqRelError,
+				    &ee);
+     *val = ee.val;
+     *estimated_error = ee.err;
+     destroy_hypercube(&h);
+     destroy_rule(r);
+     return status;
+}
+
+int adapt_integrate_rule_v(integrand_v f, void *fdata,
+			   unsigned dim, unsigned n,
+			   const double *xmin, const double *xmax,
+			   double *val, double *estimated_error)
+{
+     rule *r;
+     region *R;
+     double *pts = 0, *fv = 0;
+     unsigned i, nbuf = 0;
+     int status;
+
+     if (dim < 2)
+	  return -1;
+
+     r = make_rule75genzmalik(dim);
+     R = (region *) malloc(sizeof(region) * n);
+     for (i = 0; i < n; ++i) {
+	  R[i].h = make_hypercube_range(dim, xmin + i * dim, xmax + i * dim);
+	  R[i].splitDim = 0;
+     }
+
+     status = eval_regions_v(r, f, fdata, R, n, &pts, &fv, &nbuf);
+
+     for (i = 0; i < n; ++i) {
+	  if (!status) {
+	       val[i] = R[i].ee.val;
+	       estimated_error[i] = R[i].ee.err;
+	  }
+	  destroy_region(&R[i]);
+     }
+     free(R);
+     free(pts);
+     free(fv);
+     destroy_rule(r);
+     return status;
+}
+
 int adapt_integrate(integrand f, void *fdata, 
 		    unsigned dim, const double *xmin, const double *xmax, 
 		    unsigned maxEval, double reqAbsError, double reqRelError, 
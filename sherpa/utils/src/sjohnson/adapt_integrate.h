@@ -19,6 +19,28 @@ int adapt_integrate(integrand f, void *fdata,
 		    double reqAbsError, double reqRelError, 
 		    double *val, double *estimated_error);
 
+/* The vectorized integrand evaluates the npt points stored in x, with
+   point i at x[i * ndim], writing the values to fval. It returns 0
+   on success. */
+typedef int (*integrand_v) ( unsigned ndim, unsigned npt, const double *x,
+			     void *, double *fval);
+
+int adapt_integrate_v(integrand_v f, void *fdata,
+		      unsigned dim, const double *xmin, const double *xmax,
+		      unsigned maxEval,
+		      double reqAbsError, double reqRelError,
+		      double *val, double *estimated_error);
+
+/* Apply the cubature rule once to each of the n hypercubes, where
+   hypercube i runs from xmin[i * dim] to xmax[i * dim], with a single
+   call to f. This is the first step of adapt_integrate_v, so the
+   hypercubes whose estimated error meets the tolerance need not be
+   integrated further. */
+int adapt_integrate_rule_v(integrand_v f, void *fdata,
+			   unsigned dim, unsigned n,
+			   const double *xmin, const double *xmax,
+			   double *val, double *estimated_error);
+
 #ifdef __cplusplus
 }
 #endif
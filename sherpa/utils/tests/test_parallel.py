@@ -240,7 +240,8 @@ def test_parallel_map_funcs2():
 
     def cmp_results(result, tol=1.0e-3):
         assert result.succeeded
-        parvals = (1.7555670572301785, 1.5092728216164186, 4.893136872267538)
+        # LevMar uses the analytic Gauss1D derivatives here.
+        parvals = (1.7555755152335657, 1.509272858424573, 4.893125084428293)
         assert result.numpoints == 200
 
         # use tol in approx?